@@ -46,7 +46,7 @@ CubitStatus CAUniqueId::actuate()
 
     // create a TDUniqueId for the entity, if it doesn't already
     // exist
-  TDUniqueId *uid = (TDUniqueId *) attrib_owner()->get_TD(&TDUniqueId::is_unique_id);
+  TDUniqueId *uid = (TDUniqueId *) attrib_owner()->get_TD(&TDUniqueId::is_unique_id, TDUniqueId::td_slot());
 
   if (uid != NULL) {
       // check to make sure it's the same unique id
@@ -100,7 +100,7 @@ CubitStatus CAUniqueId::update()
   hasUpdated = CUBIT_TRUE;
 
     // if the owner has a unique id, save it, otherwise delete this one
-  TDUniqueId *td_uid = (TDUniqueId *) attrib_owner()->get_TD(&TDUniqueId::is_unique_id);
+  TDUniqueId *td_uid = (TDUniqueId *) attrib_owner()->get_TD(&TDUniqueId::is_unique_id, TDUniqueId::td_slot());
 
   if (NULL == td_uid && autoUniqueId) 
     td_uid = new TDUniqueId(attrib_owner());
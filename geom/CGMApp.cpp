@@ -27,6 +27,7 @@
 #include "MergeTool.hpp"
 #include "OldUnmergeCode.hpp"
 #include "ModelQueryEngine.hpp"
+#include "CubitStdConcurrentApi.h"
 
 // TODO - I'm not sure this is the place to include all the attributes
 #include "CADefines.hpp"
@@ -76,6 +77,8 @@ CGMApp::CGMApp()
     caActuateFlgs = NULL;
     caWriteFlgs = NULL;
     caReadFlgs = NULL;
+
+    mConcurrent = NULL;
 }
 
 CGMApp::~CGMApp()
@@ -94,6 +97,11 @@ void CGMApp::startup(const std::vector<CubitString> &args)
      // register attributes
    register_attributes();
 
+     // install the built-in thread pool unless the application
+     // already provided a concurrency implementation
+   if (!CubitConcurrent::instance())
+     mConcurrent = new CubitStdConcurrent;
+
    mAppStarted = CUBIT_TRUE;
 }
 
@@ -109,6 +117,13 @@ void CGMApp::shutdown()
    ModelQueryEngine::delete_instance();
 
    DAG::delete_instance();
+
+   if (mConcurrent)
+   {
+     delete mConcurrent;
+     mConcurrent = NULL;
+   }
+
    mAppStarted = CUBIT_FALSE;
 }
 
@@ -122,7 +137,8 @@ void CGMApp::initialize_settings()
   SurfaceOverlapTool::initialize_settings();
   MergeTool::initialize_settings();
   OldUnmergeCode::initialize_settings();
-  
+  CubitStdConcurrent::initialize_settings();
+
 }
 
 void CGMApp::register_attributes()
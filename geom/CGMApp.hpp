@@ -42,6 +42,8 @@
 #include "CubitGeomConfigure.h"
 #include "DAG.hpp"
 
+class CubitConcurrent;
+
 class CUBIT_GEOM_EXPORT CGMApp
 {
 public:
@@ -75,6 +77,8 @@ private:
    static CGMApp* instance_;
    CubitBoolean mAppStarted;
    CubitAttribManager mAttribManager;
+   CubitConcurrent *mConcurrent;
+     //- thread pool installed by startup(), if no other was provided
 
    CGMApp();
 
@@ -0,0 +1,601 @@
+//- Class: CompactFacetMesh
+//- Description:  Index-based storage for a triangle mesh.
+//- Owner:
+//- Checked by:
+
+#include "CompactFacetMesh.hpp"
+#include "CubitPoint.hpp"
+#include "CubitPointData.hpp"
+#include "CubitFacet.hpp"
+#include "CubitFacetData.hpp"
+
+#include "CubitConcurrentApi.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <cstring>
+#include <math.h>
+
+namespace
+{
+  inline bool same_coords( const double *pa, const double *pb )
+  {
+    return pa[0] == pb[0] && pa[1] == pb[1] && pa[2] == pb[2];
+  }
+
+  inline unsigned long long mix_bits( unsigned long long h )
+  {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+  inline unsigned long long coord_hash( const double *xyz )
+  {
+    unsigned long long h = 0;
+    for( int k = 0; k < 3; k++ )
+    {
+      double v = xyz[k] + 0.0;   // so -0.0 hashes like 0.0
+      unsigned long long bits;
+      memcpy( &bits, &v, sizeof(bits) );
+      h = mix_bits( h ^ bits );
+    }
+    return h;
+  }
+
+  const int MERGE_SHARD_BITS = 6;
+  const int MERGE_PARALLEL_MIN = 100000;
+  // hashing a point is cheap, so a task hashes at least this many
+  const size_t MERGE_RANGE_MIN = 4096;
+
+  //-----------------------------------------------------------------
+  // Finds the first point with the same coordinates as each point.
+  // The points are hashed in chunks, split into shards by the top
+  // bits of the hash (keeping index order within a shard), and each
+  // shard looked up in its own open-addressing table, so chunks and
+  // shards may be run concurrently.
+  //-----------------------------------------------------------------
+  class CoincidentPointFinder
+  {
+  public:
+    CoincidentPointFinder( const double *coords, int num_points,
+                           std::vector<int> &keep )
+      : pointCoords(coords), numPoints(num_points), keepIndex(keep),
+        pointHash(num_points), shardStart((1 << MERGE_SHARD_BITS) + 1, 0),
+        shardPoints(num_points)
+    {}
+
+    void hash_range( std::pair<int,int> range )
+    {
+      for( int ii = range.first; ii < range.second; ii++ )
+        pointHash[ii] = coord_hash( pointCoords + 3*ii );
+    }
+
+    void split_shards()
+    {
+      int shift = 64 - MERGE_SHARD_BITS;
+      int ii;
+      for( ii = 0; ii < numPoints; ii++ )
+        shardStart[(pointHash[ii] >> shift) + 1]++;
+      for( ii = 0; ii < (1 << MERGE_SHARD_BITS); ii++ )
+        shardStart[ii+1] += shardStart[ii];
+      std::vector<int> fill( shardStart.begin(), shardStart.end() - 1 );
+      for( ii = 0; ii < numPoints; ii++ )
+        shardPoints[fill[pointHash[ii] >> shift]++] = ii;
+    }
+
+    void find_in_shard( int shard )
+    {
+      int first = shardStart[shard], last = shardStart[shard+1];
+      size_t size = 16;
+      while( size < 2*(size_t)(last - first) )
+        size *= 2;
+      std::vector<int> table( size, -1 );
+      for( int ii = first; ii < last; ii++ )
+      {
+        int pt = shardPoints[ii];
+        size_t slot = pointHash[pt] & (size - 1);
+        while( table[slot] >= 0 &&
+               !( pointHash[table[slot]] == pointHash[pt] &&
+                  same_coords( pointCoords + 3*table[slot],
+                               pointCoords + 3*pt ) ) )
+          slot = (slot + 1) & (size - 1);
+        if( table[slot] < 0 )
+          table[slot] = pt;
+        keepIndex[pt] = table[slot];
+      }
+    }
+
+  private:
+    const double *pointCoords;
+    int numPoints;
+    std::vector<int> &keepIndex;
+    std::vector<unsigned long long> pointHash;
+    std::vector<int> shardStart;
+    std::vector<int> shardPoints;
+  };
+
+  //-----------------------------------------------------------------
+  // Grid cell of a point for weld_points, computed exactly as
+  // GridSearchTree::fix does.
+  //-----------------------------------------------------------------
+  inline void weld_cell( const double *xyz, double tol, long cell[3],
+                         int offset[3] )
+  {
+    for( int k = 0; k < 3; k++ )
+    {
+      cell[k] = (long)(xyz[k]/(2*tol));
+      if( xyz[k] < 0 )
+        cell[k]--;
+      offset[k] = fabs(xyz[k] - cell[k]*2*tol) < tol ? -1 : 1;
+    }
+  }
+
+  inline unsigned long long cell_hash( long i, long j, long k )
+  {
+    return mix_bits( mix_bits( mix_bits( (unsigned long long)i ) ^
+                               (unsigned long long)j ) ^
+                     (unsigned long long)k );
+  }
+
+  //-----------------------------------------------------------------
+  // Grid cells of all points for weld_points, computed in chunks that
+  // may be run concurrently.
+  //-----------------------------------------------------------------
+  class WeldCellFinder
+  {
+  public:
+    WeldCellFinder( const double *coords, double tol, int num_points )
+      : pointCoords(coords), weldTol(tol),
+        pointCells(3*(size_t)num_points), cellOffsets(3*(size_t)num_points)
+    {}
+
+    void find_range( std::pair<int,int> range )
+    {
+      for( int ii = range.first; ii < range.second; ii++ )
+      {
+        int offset[3];
+        weld_cell( pointCoords + 3*ii, weldTol, &pointCells[3*ii], offset );
+        for( int k = 0; k < 3; k++ )
+          cellOffsets[3*ii+k] = (signed char)offset[k];
+      }
+    }
+
+    const long *cell( int index ) const
+      { return &pointCells[3*index]; }
+    const signed char *offset( int index ) const
+      { return &cellOffsets[3*index]; }
+
+  private:
+    const double *pointCoords;
+    double weldTol;
+    std::vector<long> pointCells;
+    std::vector<signed char> cellOffsets;
+  };
+}
+
+CompactFacetMesh::CompactFacetMesh()
+{
+}
+
+CompactFacetMesh::~CompactFacetMesh()
+{
+}
+
+void CompactFacetMesh::clear()
+{
+  pointCoords.clear();
+  triVerts.clear();
+  ptTriOffsets.clear();
+  ptTriIndices.clear();
+  heOpposite.clear();
+}
+
+void CompactFacetMesh::reserve( int num_pts, int num_tris )
+{
+  pointCoords.reserve( 3*num_pts );
+  triVerts.reserve( 3*num_tris );
+}
+
+void CompactFacetMesh::resize( int num_pts, int num_tris )
+{
+  pointCoords.resize( 3*(size_t)num_pts );
+  triVerts.resize( 3*(size_t)num_tris );
+  ptTriOffsets.clear();
+  ptTriIndices.clear();
+  heOpposite.clear();
+}
+
+//===========================================================================
+//Function Name: build
+//
+//Member Type:  PUBLIC
+//Description:  copy a list of pointer-based facets into the arrays
+//===========================================================================
+CubitStatus CompactFacetMesh::build( DLIList<CubitFacet*> &facet_list )
+{
+  clear();
+  reserve( facet_list.size() / 2 + 3, facet_list.size() );
+
+  std::unordered_map<CubitPoint*, int> point_index;
+  point_index.reserve( facet_list.size() );
+  facet_list.reset();
+  for( int ii = facet_list.size(); ii--; )
+  {
+    CubitFacet *facet = facet_list.get_and_step();
+    int verts[3];
+    for( int jj = 0; jj < 3; jj++ )
+    {
+      CubitPoint *pt = facet->point( jj );
+      if( !pt )
+        return CUBIT_FAILURE;
+      std::pair<std::unordered_map<CubitPoint*, int>::iterator, bool> ins =
+        point_index.insert( std::make_pair( pt, num_points() ) );
+      if( ins.second )
+        add_point( pt->x(), pt->y(), pt->z() );
+      verts[jj] = ins.first->second;
+    }
+    add_triangle( verts[0], verts[1], verts[2] );
+  }
+  return CUBIT_SUCCESS;
+}
+
+//===========================================================================
+//Function Name: merge_coincident_points
+//
+//Member Type:  PUBLIC
+//Description:  merge points with identical coordinates.  Each point is
+// looked up in a hash of the points before it in its shard, so the first
+// of each group of equal points is kept.
+//===========================================================================
+int CompactFacetMesh::merge_coincident_points()
+{
+  int npts = num_points();
+  if( npts < 2 )
+    return 0;
+
+  std::vector<int> keep( npts );
+  CoincidentPointFinder finder( &pointCoords[0], npts, keep );
+  CubitConcurrent::parallel_for_ranges( npts, finder, &CoincidentPointFinder::hash_range,
+                                        MERGE_RANGE_MIN );
+  finder.split_shards();
+
+  CubitConcurrent *concurrent = CubitConcurrent::instance();
+  if( concurrent && npts >= MERGE_PARALLEL_MIN )
+  {
+    std::vector<int> shards;
+    for( int shard = 0; shard < (1 << MERGE_SHARD_BITS); shard++ )
+      shards.push_back( shard );
+    CubitConcurrent::TaskGroup *group =
+      concurrent->create_and_schedule_group( finder, &CoincidentPointFinder::find_in_shard, shards );
+    concurrent->wait( group );
+    concurrent->delete_group( group );
+  }
+  else
+  {
+    for( int shard = 0; shard < (1 << MERGE_SHARD_BITS); shard++ )
+      finder.find_in_shard( shard );
+  }
+
+  return renumber_points( keep );
+}
+
+//===========================================================================
+//Function Name: weld_points
+//
+//Member Type:  PUBLIC
+//Description:  merge points within tolerance of an earlier kept point.
+// The kept points of each grid cell are chained in the order they were
+// kept; the cells are found through an open-addressing table holding the
+// first kept point of each cell.  The grid cells of the points are found
+// in parallel on the CubitConcurrent pool for large meshes; the welding
+// itself is serial, since whether a point is kept depends on every
+// earlier decision in its neighborhood.
+//===========================================================================
+int CompactFacetMesh::weld_points( double tolerance )
+{
+  int npts = num_points();
+  if( npts < 2 || tolerance <= 0.0 )
+    return 0;
+
+  WeldCellFinder cells( &pointCoords[0], tolerance, npts );
+  CubitConcurrent::parallel_for_ranges( npts, cells, &WeldCellFinder::find_range,
+                                        MERGE_RANGE_MIN );
+
+  size_t size = 16;
+  while( size < 2*(size_t)npts )
+    size *= 2;
+  std::vector<int> cell_first( size, -1 );
+  std::vector<int> cell_last( size, -1 );
+  std::vector<int> next_in_cell( npts, -1 );
+  std::vector<int> keep( npts );
+
+  for( int ii = 0; ii < npts; ii++ )
+  {
+    const double *xyz = &pointCoords[3*ii];
+    const long *cell = cells.cell( ii );
+    const signed char *offset = cells.offset( ii );
+
+    // the same cells, in the same order, as GridSearchTree::fix
+    double mindist = 2*tolerance;
+    int closest = -1;
+    size_t home_slot = 0;
+    for( int nn = 0; nn < 8; nn++ )
+    {
+      long ci = cell[0] + (nn < 4 ? offset[0] : 0);
+      long cj = cell[1] + ((nn & 2) ? 0 : offset[1]);
+      long ck = cell[2] + ((nn & 1) ? 0 : offset[2]);
+
+      size_t slot = cell_hash( ci, cj, ck ) & (size - 1);
+      for( ; cell_first[slot] >= 0; slot = (slot + 1) & (size - 1) )
+      {
+        const long *other = cells.cell( cell_first[slot] );
+        if( other[0] == ci && other[1] == cj && other[2] == ck )
+          break;
+      }
+      if( nn == 7 )
+        home_slot = slot;
+
+      for( int pt = cell_first[slot]; pt >= 0; pt = next_in_cell[pt] )
+      {
+        const double *other = &pointCoords[3*pt];
+        double dist = sqrt( (xyz[0]-other[0])*(xyz[0]-other[0]) +
+                            (xyz[1]-other[1])*(xyz[1]-other[1]) +
+                            (xyz[2]-other[2])*(xyz[2]-other[2]) );
+        if( dist < mindist )
+        {
+          closest = pt;
+          mindist = dist;
+        }
+      }
+    }
+
+    if( closest >= 0 && mindist <= tolerance )
+    {
+      keep[ii] = closest;
+      continue;
+    }
+
+    keep[ii] = ii;
+    if( cell_first[home_slot] < 0 )
+      cell_first[home_slot] = ii;
+    else
+      next_in_cell[cell_last[home_slot]] = ii;
+    cell_last[home_slot] = ii;
+  }
+
+  return renumber_points( keep );
+}
+
+int CompactFacetMesh::renumber_points( const std::vector<int> &keep )
+{
+  int npts = num_points();
+  std::vector<int> new_index( npts );
+  int nkept = 0;
+  int ii;
+  for( ii = 0; ii < npts; ii++ )
+  {
+    if( keep[ii] == ii )
+    {
+      new_index[ii] = nkept;
+      if( nkept != ii )
+      {
+        pointCoords[3*nkept]   = pointCoords[3*ii];
+        pointCoords[3*nkept+1] = pointCoords[3*ii+1];
+        pointCoords[3*nkept+2] = pointCoords[3*ii+2];
+      }
+      nkept++;
+    }
+    else
+      new_index[ii] = new_index[keep[ii]];
+  }
+  if( nkept == npts )
+    return 0;
+
+  pointCoords.resize( 3*nkept );
+  for( ii = 0; ii < (int)triVerts.size(); ii++ )
+    triVerts[ii] = new_index[triVerts[ii]];
+
+  ptTriOffsets.clear();
+  ptTriIndices.clear();
+  heOpposite.clear();
+  return npts - nkept;
+}
+
+int CompactFacetMesh::remove_degenerate_triangles()
+{
+  int ntris = num_triangles();
+  int nkept = 0;
+  for( int ii = 0; ii < ntris; ii++ )
+  {
+    int v0 = triVerts[3*ii], v1 = triVerts[3*ii+1], v2 = triVerts[3*ii+2];
+    if( v0 == v1 || v1 == v2 || v2 == v0 )
+      continue;
+    triVerts[3*nkept]   = v0;
+    triVerts[3*nkept+1] = v1;
+    triVerts[3*nkept+2] = v2;
+    nkept++;
+  }
+  if( nkept == ntris )
+    return 0;
+
+  triVerts.resize( 3*nkept );
+  ptTriOffsets.clear();
+  ptTriIndices.clear();
+  heOpposite.clear();
+  return ntris - nkept;
+}
+
+//===========================================================================
+//Function Name: build_adjacency
+//
+//Member Type:  PUBLIC
+//Description:  fill the point-to-triangle arrays, then pair each half-edge
+// with the other triangle sharing its end points, found among the
+// triangles of its start point.
+//===========================================================================
+void CompactFacetMesh::build_adjacency()
+{
+  int npts = num_points();
+  int ntris = num_triangles();
+  int ii, jj;
+
+  ptTriOffsets.assign( npts + 1, 0 );
+  for( ii = 0; ii < 3*ntris; ii++ )
+    ptTriOffsets[triVerts[ii] + 1]++;
+  for( ii = 0; ii < npts; ii++ )
+    ptTriOffsets[ii+1] += ptTriOffsets[ii];
+
+  ptTriIndices.resize( 3*ntris );
+  std::vector<int> fill( ptTriOffsets.begin(), ptTriOffsets.end() - 1 );
+  for( ii = 0; ii < ntris; ii++ )
+    for( jj = 0; jj < 3; jj++ )
+      ptTriIndices[fill[triVerts[3*ii+jj]]++] = ii;
+
+  heOpposite.assign( 3*ntris, -1 );
+  for( ii = 0; ii < ntris; ii++ )
+  {
+    for( jj = 0; jj < 3; jj++ )
+    {
+      int he = 3*ii + jj;
+      if( heOpposite[he] != -1 )
+        continue;
+      int va = triVerts[he];
+      int vb = triVerts[3*ii + (jj+1)%3];
+
+      int match = -1, num_matches = 0;
+      for( int kk = ptTriOffsets[va]; kk < ptTriOffsets[va+1]; kk++ )
+      {
+        int other = ptTriIndices[kk];
+        if( other == ii )
+          continue;
+        for( int ll = 0; ll < 3; ll++ )
+        {
+          int oa = triVerts[3*other+ll];
+          int ob = triVerts[3*other+(ll+1)%3];
+          if( (oa == vb && ob == va) || (oa == va && ob == vb) )
+          {
+            match = 3*other + ll;
+            num_matches++;
+          }
+        }
+      }
+      if( num_matches == 1 )
+      {
+        heOpposite[he] = match;
+        heOpposite[match] = he;
+      }
+    }
+  }
+}
+
+CubitVector CompactFacetMesh::normal( int index ) const
+{
+  const int *tri = triangle( index );
+  CubitVector p0 = point( tri[0] );
+  CubitVector norm = (point( tri[1] ) - p0) * (point( tri[2] ) - p0);
+  norm.normalize();
+  return norm;
+}
+
+double CompactFacetMesh::area( int index ) const
+{
+  const int *tri = triangle( index );
+  CubitVector p0 = point( tri[0] );
+  return 0.5 * ((point( tri[1] ) - p0) * (point( tri[2] ) - p0)).length();
+}
+
+CubitBox CompactFacetMesh::bounding_box() const
+{
+  int npts = num_points();
+  if( !npts )
+    return CubitBox();
+
+  CubitVector bmin = point( 0 ), bmax = point( 0 );
+  for( int ii = 1; ii < npts; ii++ )
+  {
+    const double *xyz = &pointCoords[3*ii];
+    if( xyz[0] < bmin.x() ) bmin.x( xyz[0] ); else if( xyz[0] > bmax.x() ) bmax.x( xyz[0] );
+    if( xyz[1] < bmin.y() ) bmin.y( xyz[1] ); else if( xyz[1] > bmax.y() ) bmax.y( xyz[1] );
+    if( xyz[2] < bmin.z() ) bmin.z( xyz[2] ); else if( xyz[2] > bmax.z() ) bmax.z( xyz[2] );
+  }
+  return CubitBox( bmin, bmax );
+}
+
+size_t CompactFacetMesh::memory_use() const
+{
+  return sizeof(double) * pointCoords.capacity() +
+         sizeof(int) * ( triVerts.capacity() + ptTriOffsets.capacity() +
+                         ptTriIndices.capacity() + heOpposite.capacity() );
+}
+
+//===========================================================================
+//Function Name: make_facets
+//
+//Member Type:  PUBLIC
+//Description:  create the pointer-based points and facets for the mesh
+//===========================================================================
+CubitStatus CompactFacetMesh::make_facets( DLIList<CubitPoint*> &point_list,
+                                           DLIList<CubitFacet*> &facet_list ) const
+{
+  std::vector<CubitPoint*> points;
+  make_points( points, point_list );
+  append_facets( points, facet_list );
+  return CUBIT_SUCCESS;
+}
+
+//===========================================================================
+//Function Name: convert_to_facets
+//
+//Member Type:  PUBLIC
+//Description:  make_facets, releasing each array once it has been used so
+// the compact and the pointer-based copies of the mesh are not both held
+// in full.
+//===========================================================================
+CubitStatus CompactFacetMesh::convert_to_facets( DLIList<CubitPoint*> &point_list,
+                                                 DLIList<CubitFacet*> &facet_list )
+{
+  std::vector<CubitPoint*> points;
+  make_points( points, point_list );
+  std::vector<double>().swap( pointCoords );
+  std::vector<int>().swap( ptTriOffsets );
+  std::vector<int>().swap( ptTriIndices );
+  std::vector<int>().swap( heOpposite );
+
+  append_facets( points, facet_list );
+  std::vector<int>().swap( triVerts );
+  return CUBIT_SUCCESS;
+}
+
+void CompactFacetMesh::make_points( std::vector<CubitPoint*> &points,
+                                    DLIList<CubitPoint*> &point_list ) const
+{
+  int npts = num_points();
+  points.resize( npts );
+  point_list.reserve( point_list.size() + npts );
+  for( int ii = 0; ii < npts; ii++ )
+  {
+    const double *xyz = &pointCoords[3*ii];
+    points[ii] = new CubitPointData( xyz[0], xyz[1], xyz[2] );
+    points[ii]->set_id( ii );
+    point_list.append( points[ii] );
+  }
+}
+
+void CompactFacetMesh::append_facets( const std::vector<CubitPoint*> &points,
+                                      DLIList<CubitFacet*> &facet_list ) const
+{
+  int ntris = num_triangles();
+  facet_list.reserve( facet_list.size() + ntris );
+  for( int ii = 0; ii < ntris; ii++ )
+  {
+    const int *tri = triangle( ii );
+    if( tri[0] == tri[1] || tri[1] == tri[2] || tri[2] == tri[0] )
+      continue;
+    facet_list.append( new CubitFacetData( points[tri[0]], points[tri[1]],
+                                           points[tri[2]] ) );
+  }
+}
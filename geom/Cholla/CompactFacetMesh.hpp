@@ -0,0 +1,175 @@
+//- Class: CompactFacetMesh
+//- Description:  Index-based storage for a triangle mesh: point coordinate
+//-               and triangle connectivity arrays, the triangles around each
+//-               point in compressed sparse row form and the opposite of
+//-               each half-edge.  It takes roughly 50 bytes per triangle,
+//-               against several hundred for CubitPointData/CubitFacetData.
+//-
+//-               It is used as a step on the way to the pointer-based
+//-               facets: binary STL import reads and merges its points
+//-               here, and FacetEvalTool builds its TriangleBVH from it.
+//-               FacetEvalTool, ChollaEngine and the facet geometry still
+//-               hold every mesh as CubitPoints and CubitFacets, so once a
+//-               model is loaded it still takes several hundred bytes per
+//-               triangle.
+//-
+//-               Half-edge h = 3*t+k of triangle t runs from its vertex k
+//-               to vertex (k+1)%3.  The arrays may be handed directly to
+//-               TriangleBVH::build.
+//- Owner:
+//- Checked by:
+
+#ifndef COMPACT_FACET_MESH_HPP
+#define COMPACT_FACET_MESH_HPP
+
+#include "CubitDefines.h"
+#include "CubitVector.hpp"
+#include "CubitBox.hpp"
+#include "DLIList.hpp"
+#include <vector>
+
+class CubitPoint;
+class CubitFacet;
+
+class CompactFacetMesh
+{
+public:
+
+  CompactFacetMesh();
+  ~CompactFacetMesh();
+
+  void clear();
+    //- Remove all points and triangles.
+
+  void reserve( int num_points, int num_triangles );
+
+  void resize( int num_points, int num_triangles );
+    //- Set the number of points and triangles, for filling the arrays
+    //- directly through coords() and connectivity().
+
+  int add_point( double x, double y, double z )
+    {
+      pointCoords.push_back( x );
+      pointCoords.push_back( y );
+      pointCoords.push_back( z );
+      return num_points() - 1;
+    }
+  int add_triangle( int v0, int v1, int v2 )
+    {
+      triVerts.push_back( v0 );
+      triVerts.push_back( v1 );
+      triVerts.push_back( v2 );
+      return num_triangles() - 1;
+    }
+    //- Append a point or triangle and return its index.  Adding either
+    //- discards the adjacency until build_adjacency is called again.
+
+  CubitStatus build( DLIList<CubitFacet*> &facet_list );
+    //- Replace the contents with the given facets.  Points are numbered
+    //- in the order they are first used by the facets.
+
+  int merge_coincident_points();
+    //- Merge points with exactly equal coordinates, keeping the first
+    //- of each, and renumber the rest in their original order.
+    //- Returns the number of points removed.  Large meshes are hashed
+    //- in parallel on the CubitConcurrent pool, if there is one.
+
+  int weld_points( double tolerance );
+    //- Merge each point into the closest earlier kept point within
+    //- tolerance, if any, the way GridSearchTree::fix does when fed
+    //- the points in order: grid cells are 2*tolerance wide and the
+    //- point's cell and the seven cells nearest it are searched.
+    //- Returns the number of points removed.  The result depends on
+    //- the order of the points, so only the grid cells are found in
+    //- parallel.  To match GridSearchTree fed every vertex read, call
+    //- it on the unmerged vertices, not after merge_coincident_points.
+
+  int remove_degenerate_triangles();
+    //- Remove triangles that use a point more than once.  Returns the
+    //- number removed.
+
+  void build_adjacency();
+    //- Compute the triangles around each point and the half-edge
+    //- opposites.
+
+  bool has_adjacency() const
+    { return !ptTriOffsets.empty(); }
+
+  int num_points() const
+    { return (int)pointCoords.size() / 3; }
+  int num_triangles() const
+    { return (int)triVerts.size() / 3; }
+
+  const double *coords() const
+    { return pointCoords.empty() ? NULL : &pointCoords[0]; }
+  const int *connectivity() const
+    { return triVerts.empty() ? NULL : &triVerts[0]; }
+  double *coords()
+    { return pointCoords.empty() ? NULL : &pointCoords[0]; }
+  int *connectivity()
+    { return triVerts.empty() ? NULL : &triVerts[0]; }
+    //- x,y,z per point and three point indices per triangle.
+
+  CubitVector point( int index ) const
+    { return CubitVector( &pointCoords[3*index] ); }
+  const int *triangle( int index ) const
+    { return &triVerts[3*index]; }
+
+  const int *point_triangles( int index, int &count ) const
+    {
+      count = ptTriOffsets[index+1] - ptTriOffsets[index];
+      return &ptTriIndices[0] + ptTriOffsets[index];
+    }
+    //- The triangles using a point.  Needs build_adjacency.
+
+  int opposite( int half_edge ) const
+    { return heOpposite[half_edge]; }
+    //- The half-edge of the neighboring triangle across half_edge, or
+    //- -1 if the edge is on the boundary or used by more than two
+    //- triangles.  Needs build_adjacency.
+
+  CubitVector normal( int index ) const;
+    //- Unit normal of a triangle, by the right hand rule.
+
+  double area( int index ) const;
+
+  CubitBox bounding_box() const;
+
+  size_t memory_use() const;
+    //- Bytes held by the arrays.
+
+  CubitStatus make_facets( DLIList<CubitPoint*> &point_list,
+                           DLIList<CubitFacet*> &facet_list ) const;
+    //- Create a CubitPointData for each point, with its index as id, and
+    //- a CubitFacetData for each triangle that does not use a point more
+    //- than once.  The new entities are appended to the lists.
+
+  CubitStatus convert_to_facets( DLIList<CubitPoint*> &point_list,
+                                 DLIList<CubitFacet*> &facet_list );
+    //- As make_facets, but the coordinates are released once the points
+    //- are made and the connectivity once the facets are, leaving the
+    //- mesh empty.  Used where the mesh is only a step towards the
+    //- pointer-based facets, to keep the peak memory down.
+
+private:
+
+  void make_points( std::vector<CubitPoint*> &points,
+                    DLIList<CubitPoint*> &point_list ) const;
+  void append_facets( const std::vector<CubitPoint*> &points,
+                      DLIList<CubitFacet*> &facet_list ) const;
+    //- The two halves of make_facets.
+
+  int renumber_points( const std::vector<int> &keep );
+    //- keep[i] is the point that point i merges into (i itself, or an
+    //- earlier kept point).  Removes the merged points, renumbers the
+    //- rest in order and returns the number removed.
+
+  std::vector<double> pointCoords;
+  std::vector<int> triVerts;
+
+  std::vector<int> ptTriOffsets;   // num_points()+1 offsets into ptTriIndices
+  std::vector<int> ptTriIndices;
+  std::vector<int> heOpposite;     // 3 per triangle
+};
+
+#endif
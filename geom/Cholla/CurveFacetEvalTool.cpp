@@ -1898,14 +1898,44 @@ CubitStatus CurveFacetEvalTool::save(
   NCubitFile::CIOWrapper cio(fp);
   typedef NCubitFile::UnsignedInt32 int32;
 
-    // write out "interpOrder" 
-  cio.Write(reinterpret_cast<int32*>(&interpOrder), 1);
+  std::vector<int> int_data, ids;
+  std::vector<double> double_data;
+  save( int_data, double_data, ids );
+
+    // write "interpOrder", the surface eval tool id, "curvSense",
+    // "goodCurveData" and "facetLength"
+  cio.Write(reinterpret_cast<int32*>(&int_data[0]), 4);
+  cio.Write( &double_data[0], 1 );
+
+    // write ids of facet edges in "myEdgeList" and points in "myPointList"
+  int ii, start = 0;
+  for (ii=0; ii<2; ii++)
+  {
+    int32 count = int_data[4+ii];
+    cio.Write(&count, 1);
+    if (count > 0)
+      cio.Write(reinterpret_cast<int32*>(&ids[start]), count);
+    start += count;
+  }
+
+  return CUBIT_SUCCESS;
+}
 
-   // write the associated facet eval tool id.  If there is none then write -1 
+//===========================================================================
+//Function Name: save
+//
+//Member Type:  PUBLIC
+//Description:  append the curve facet eval tool data to arrays
+//===========================================================================
+void CurveFacetEvalTool::save( 
+  std::vector<int> &int_data,
+  std::vector<double> &double_data,
+  std::vector<int> &ids )
+{
+   // the associated facet eval tool id.  If there is none then -1 
   int surf_tool_id = -1;
   if (surfFacetEvalTool != NULL)
     surf_tool_id = surfFacetEvalTool->get_output_id();
-  cio.Write(reinterpret_cast<int32*>(&surf_tool_id), 1);
 
     // convert "curvSense" in an int
   int sense;
@@ -1914,50 +1944,22 @@ CubitStatus CurveFacetEvalTool::save(
   else 
     sense = (curvSense == CUBIT_REVERSED) ? 1 : 0; 
 
-    // write "curveSense" and "goodCurveData"
-  cio.Write(reinterpret_cast<int32*>(&sense), 1);
-  int32 is_good = goodCurveData ? 1 : 0;
-  cio.Write(&is_good, 1);
- 
-    // write "facetLength"
-  cio.Write( &facetLength, 1 );
+  int_data.push_back( interpOrder );
+  int_data.push_back( surf_tool_id );
+  int_data.push_back( sense );
+  int_data.push_back( goodCurveData ? 1 : 0 );
+  int_data.push_back( myEdgeList.size() );
+  int_data.push_back( myPointList.size() );
+
+  double_data.push_back( facetLength );
 
-    // write ids of facet edges in "myEdgeList"
   int ii;
-  CubitFacetEdge *edge_ptr;
-  int nedges = myEdgeList.size();
-  int32* edge_id = new int32 [nedges];
   myEdgeList.reset();
-  for (ii=0; ii<nedges; ii++)
-  {
-    edge_ptr = myEdgeList.get_and_step();
-    edge_id[ii] = edge_ptr->id();
-  }
-  cio.Write(reinterpret_cast<int32*>(&nedges), 1);
-  if (nedges > 0)
-  {
-    cio.Write(edge_id, nedges);
-  }
-  delete [] edge_id;
-
-    // write ids of points in "myPointList" 
-  CubitPoint *point_ptr;
-  int npoints = myPointList.size();
-  int32* point_id = new int32 [npoints];
+  for (ii=myEdgeList.size(); ii--; )
+    ids.push_back( myEdgeList.get_and_step()->id() );
   myPointList.reset();
-  for (ii=0; ii<npoints; ii++)
-  {
-    point_ptr = myPointList.get_and_step();
-    point_id[ii] = point_ptr->id();
-  }
-  cio.Write(reinterpret_cast<int32*>(&npoints), 1);
-  if (npoints > 0)
-  {
-    cio.Write(point_id, npoints);
-  }
-  delete [] point_id;
-
-  return CUBIT_SUCCESS;
+  for (ii=myPointList.size(); ii--; )
+    ids.push_back( myPointList.get_and_step()->id() );
 }
 
 //===========================================================================
@@ -1981,9 +1983,48 @@ CubitStatus CurveFacetEvalTool::restore(FILE *fp,
 
     // read stuff about this eval tool
 
-  int ii;
-  int int_data[4];
+  int int_data[6];
   cio.Read(reinterpret_cast<int32*>(int_data), 4);
+  double facet_length;
+  cio.Read(&facet_length, 1);
+
+    // read the edge and point ids
+
+  std::vector<int> ids;
+  int ii;
+  for (ii=0; ii<2; ii++)
+  {
+    int count;
+    cio.Read(reinterpret_cast<int32*>(&count), 1);
+    if (count < 0)
+      return CUBIT_FAILURE;
+    int_data[4+ii] = count;
+    if (count > 0)
+    {
+      ids.resize( ids.size() + count );
+      cio.Read(reinterpret_cast<int32*>(&ids[ids.size() - count]), count);
+    }
+  }
+
+  return restore( int_data, &facet_length, ids.empty() ? NULL : &ids[0],
+                  num_edges, num_points, edges, points, num_fets, fet_array );
+}
+
+//===========================================================================
+//Function Name: restore
+//Member Type:  PUBLIC
+//Description:  restore curve eval tool from the arrays written by save
+//===========================================================================
+CubitStatus CurveFacetEvalTool::restore(const int *int_data,
+                      const double *double_data,
+                      const int *ids,
+                      int num_edges, 
+                      int num_points,
+                      CubitFacetEdge **edges, 
+                      CubitPoint **points,
+                      int num_fets,
+                      FacetEvalTool **fet_array)
+{
   interpOrder = int_data[0];
   int surf_tool_id = int_data[1]; 
 
@@ -1994,55 +2035,30 @@ CubitStatus CurveFacetEvalTool::restore(FILE *fp,
 
   goodCurveData = (int_data[3]==0) ? CUBIT_FALSE : CUBIT_TRUE;
 
-  if( surf_tool_id != -1 )
+  if( surf_tool_id >= 0 && surf_tool_id < num_fets )
     surfFacetEvalTool = fet_array[ surf_tool_id ]; 
   else
     surfFacetEvalTool = NULL; 
 
-  cio.Read(&facetLength, 1);
+  facetLength = double_data[0];
 
-    // read the edges
-
-  int nedges; 
-  cio.Read(reinterpret_cast<int32*>(&nedges), 1);
-  if (nedges > 0)
+  int ii, id;
+  int nedges = int_data[4];
+  for (ii=0; ii<nedges; ii++)
   {
-    int32* edge_id = new int32 [nedges];
-    cio.Read(edge_id, nedges);
-    int id;
-    for (ii=0; ii<nedges; ii++)
-    {
-      id = edge_id[ii];
-      if (id <0 || id >= num_edges)
-      {
-        delete [] edge_id;
-        return CUBIT_FAILURE;
-      }
-      myEdgeList.append(edges[id]);
-    }
-    delete [] edge_id;
+    id = *ids++;
+    if (id <0 || id >= num_edges)
+      return CUBIT_FAILURE;
+    myEdgeList.append(edges[id]);
   }
-  
-    // read the points
 
-  int npoints; 
-  cio.Read(reinterpret_cast<int32*>(&npoints), 1);
-  int id;
-  if (npoints > 0)
+  int npoints = int_data[5];
+  for (ii=0; ii<npoints; ii++)
   {
-    int32* point_id = new int32 [npoints];
-    cio.Read(point_id, npoints);
-    for (ii=0; ii<npoints; ii++)
-    {
-      id = point_id[ii];
-      if (id <0 || id >= num_points)
-      {
-        delete [] point_id;
-        return CUBIT_FAILURE;
-      }
-      myPointList.append(points[id]);
-    }
-    delete [] point_id;
+    id = *ids++;
+    if (id <0 || id >= num_points)
+      return CUBIT_FAILURE;
+    myPointList.append(points[id]);
   }
 
   bounding_box();
@@ -15,6 +15,7 @@
 
 #include "DLIList.hpp"
 #include <map>
+#include <vector>
 
 class CubitBox;
 class CubitPoint;
@@ -148,6 +149,22 @@ public:
                       CubitPoint **points,
                       int num_fets,
                       FacetEvalTool **fet_list);
+  void save(std::vector<int> &int_data,
+            std::vector<double> &double_data,
+            std::vector<int> &ids);
+    // append six ints (interpOrder, surface tool output id, sense,
+    // goodCurveData and the numbers of edges and points), facetLength and
+    // the edge and point ids to the arrays
+  CubitStatus restore(const int *int_data,
+                      const double *double_data,
+                      const int *ids,
+                      int num_edges, 
+                      int num_points,
+                      CubitFacetEdge **edges, 
+                      CubitPoint **points,
+                      int num_fets,
+                      FacetEvalTool **fet_list);
+    // restore from the data appended by save() above
 
   int get_output_id() { return output_id; }
   void set_output_id( int id ) { output_id = id; }
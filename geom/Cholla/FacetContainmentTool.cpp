@@ -0,0 +1,458 @@
+//- Class: FacetContainmentTool
+//- Description:  Point containment against a triangle bounded solid.
+//- Owner:
+//- Checked by:
+
+#include "FacetContainmentTool.hpp"
+#include "CubitFacet.hpp"
+#include "CubitPoint.hpp"
+#include "GeometryDefines.h"
+#include "CubitConcurrentApi.h"
+
+#include <algorithm>
+#include <math.h>
+
+// A node is replaced by its second order expansion once the point is
+// this many node radii from its center.  On a 6400 triangle ellipsoid
+// this keeps the winding number within 2e-3 of the exact sum, against
+// 3e-2 with the dipole term alone; a ratio of 3 gives 3e-4 at about
+// twice the cost.
+static const double FAR_FIELD_RATIO = 2.0;
+
+// Ray crossings this close to a triangle edge, in barycentric
+// coordinates, are not trusted for the crossing count.
+static const double EDGE_CROSSING_TOL = 1.0e-8;
+
+FacetContainmentTool::FacetContainmentTool()
+  : isClosed(false), boundaryTol(GEOMETRY_RESABS), nearDistance(0.0),
+    maxTriNear(0.0)
+{
+}
+
+FacetContainmentTool::~FacetContainmentTool()
+{
+}
+
+void FacetContainmentTool::add_facets( DLIList<CubitFacet*> &facet_list,
+                                       CubitSense sense, double near_factor )
+{
+  pointCoords.reserve( pointCoords.size() + 3*facet_list.size() );
+  triVerts.reserve( triVerts.size() + 3*facet_list.size() );
+  triNear.resize( num_triangles(), 0.0 );
+  facet_list.reset();
+  for (int ii = facet_list.size(); ii--; )
+  {
+    CubitFacet *facet = facet_list.get_and_step();
+    int verts[3];
+    for (int jj = 0; jj < 3; jj++)
+    {
+      CubitPoint *point = facet->point(jj);
+      std::pair<std::unordered_map<CubitPoint*,int>::iterator, bool> found =
+        pointIndex.insert( std::make_pair( point, (int)pointCoords.size()/3 ) );
+      if (found.second)
+      {
+        pointCoords.push_back( point->x() );
+        pointCoords.push_back( point->y() );
+        pointCoords.push_back( point->z() );
+      }
+      verts[jj] = found.first->second;
+    }
+
+    // orient the triangle by the facet normal, then by the sense
+    CubitVector p0 = facet->point(0)->coordinates();
+    CubitVector cross = (facet->point(1)->coordinates() - p0) *
+                        (facet->point(2)->coordinates() - p0);
+    bool flip = (cross % facet->normal()) < 0.0;
+    if (sense == CUBIT_REVERSED)
+      flip = !flip;
+    if (flip)
+      std::swap( verts[1], verts[2] );
+    triVerts.insert( triVerts.end(), verts, verts + 3 );
+
+    double longest = 0.0;
+    if (near_factor > 0.0)
+      for (int jj = 0; jj < 3; jj++)
+        longest = CUBIT_MAX( longest, facet->point(jj)->coordinates().distance_between(
+                                        facet->point((jj+1)%3)->coordinates() ) );
+    triNear.push_back( near_factor * longest );
+  }
+}
+
+void FacetContainmentTool::build( const double *coords, int num_points,
+                                  const int *connectivity, int num_triangles )
+{
+  pointCoords.assign( coords, coords + 3*num_points );
+  triVerts.assign( connectivity, connectivity + 3*num_triangles );
+  triNear.assign( num_triangles, 0.0 );
+  build();
+}
+
+void FacetContainmentTool::build()
+{
+  pointIndex.clear();
+  myTree.clear();
+  isClosed = false;
+  triNear.resize( num_triangles(), 0.0 );
+  maxTriNear = 0.0;
+  for (size_t ii = 0; ii < triNear.size(); ii++)
+    maxTriNear = CUBIT_MAX( maxTriNear, triNear[ii] );
+  if (triVerts.empty())
+    return;
+
+  myTree.build( &pointCoords[0], (int)pointCoords.size()/3,
+                &triVerts[0], num_triangles() );
+  find_closed();
+  compute_node_moments();
+}
+
+//===========================================================================
+//Function Name: find_closed
+//Description:  the shells are closed and manifold if every directed edge
+// appears once and its reverse once.
+//===========================================================================
+void FacetContainmentTool::find_closed()
+{
+  std::vector<std::pair<int,int> > half_edges;
+  half_edges.reserve( triVerts.size() );
+  for (size_t ii = 0; ii < triVerts.size(); ii += 3)
+    for (int jj = 0; jj < 3; jj++)
+      half_edges.push_back( std::make_pair( triVerts[ii+jj],
+                                            triVerts[ii+(jj+1)%3] ) );
+  std::sort( half_edges.begin(), half_edges.end() );
+
+  isClosed = true;
+  for (size_t ii = 0; isClosed && ii < half_edges.size(); ii++)
+  {
+    const std::pair<int,int> &edge = half_edges[ii];
+    if (edge.first == edge.second ||
+        (ii > 0 && half_edges[ii-1] == edge))
+      isClosed = false;
+    else
+    {
+      std::pair<std::vector<std::pair<int,int> >::iterator,
+                std::vector<std::pair<int,int> >::iterator> range =
+        std::equal_range( half_edges.begin(), half_edges.end(),
+                          std::make_pair( edge.second, edge.first ) );
+      isClosed = (range.second - range.first) == 1;
+    }
+  }
+}
+
+//===========================================================================
+//Function Name: compute_node_moments
+//Description:  sum the area-weighted normals of each tree node and their
+// first and second moments about the node's center, and find the sphere
+// around its triangles, children before parents.
+//===========================================================================
+void FacetContainmentTool::compute_node_moments()
+{
+  int num_nodes = myTree.num_nodes();
+  nodeNormal.assign( 3*num_nodes, 0.0 );
+  nodeCenter.assign( 3*num_nodes, 0.0 );
+  nodeMoment.assign( 9*num_nodes, 0.0 );
+  nodeSecondMoment.assign( 27*num_nodes, 0.0 );
+  nodeRadius.assign( num_nodes, 0.0 );
+  std::vector<double> node_area( num_nodes, 0.0 );
+
+  for (int node = num_nodes - 1; node >= 0; node--)
+  {
+    double *normal = &nodeNormal[3*node];
+    double *center = &nodeCenter[3*node];
+    double *moment = &nodeMoment[9*node];
+    double *second = &nodeSecondMoment[27*node];
+    const int *tris;
+    int count = myTree.leaf_triangles( node, tris );
+    if (count)
+    {
+      double area = 0.0;
+      int ii, jj;
+      for (ii = 0; ii < count; ii++)
+      {
+        const int *verts = &triVerts[3*tris[ii]];
+        CubitVector p0( &pointCoords[3*verts[0]] );
+        CubitVector p1( &pointCoords[3*verts[1]] );
+        CubitVector p2( &pointCoords[3*verts[2]] );
+        CubitVector area_normal = 0.5 * ((p1 - p0) * (p2 - p0));
+        double tri_area = area_normal.length();
+        CubitVector centroid = (p0 + p1 + p2) / 3.0;
+        for (jj = 0; jj < 3; jj++)
+        {
+          normal[jj] += area_normal[jj];
+          // degenerate triangles still count toward the center
+          center[jj] += (tri_area > 0.0 ? tri_area : CUBIT_DBL_MIN) * centroid[jj];
+        }
+        area += tri_area > 0.0 ? tri_area : CUBIT_DBL_MIN;
+      }
+      for (jj = 0; jj < 3; jj++)
+        center[jj] /= area;
+      node_area[node] = area;
+
+      // over a triangle with corners v relative to the center, the
+      // integral of d is area * sum(v) / 3 and that of d[j] d[k] is
+      // area * (sum(v[j] v[k]) + sum(v)[j] sum(v)[k]) / 12
+      CubitVector node_center( center );
+      double radius = 0.0;
+      for (ii = 0; ii < count; ii++)
+      {
+        const int *verts = &triVerts[3*tris[ii]];
+        CubitVector v[3];
+        for (jj = 0; jj < 3; jj++)
+        {
+          v[jj] = CubitVector( &pointCoords[3*verts[jj]] ) - node_center;
+          radius = CUBIT_MAX( radius, v[jj].length() );
+        }
+        CubitVector area_normal = 0.5 * ((v[1] - v[0]) * (v[2] - v[0]));
+        CubitVector sum = v[0] + v[1] + v[2];
+        for (jj = 0; jj < 9; jj++)
+          moment[jj] += area_normal[jj/3] * sum[jj%3] / 3.0;
+        for (jj = 0; jj < 27; jj++)
+        {
+          int j = (jj/3)%3, k = jj%3;
+          second[jj] += area_normal[jj/9] / 12.0 *
+            (v[0][j]*v[0][k] + v[1][j]*v[1][k] + v[2][j]*v[2][k] + sum[j]*sum[k]);
+        }
+      }
+      nodeRadius[node] = radius;
+    }
+    else
+    {
+      int left = myTree.left_child( node );
+      int right = myTree.right_child( node );
+      double area = node_area[left] + node_area[right];
+      for (int jj = 0; jj < 3; jj++)
+      {
+        normal[jj] = nodeNormal[3*left+jj] + nodeNormal[3*right+jj];
+        center[jj] = (node_area[left] * nodeCenter[3*left+jj] +
+                      node_area[right] * nodeCenter[3*right+jj]) / area;
+      }
+      node_area[node] = area;
+
+      // move the children's moments to this center: d = d' + offset
+      CubitVector node_center( center );
+      int children[2] = { left, right };
+      for (int cc = 0; cc < 2; cc++)
+      {
+        int child = children[cc];
+        const double *c_normal = &nodeNormal[3*child];
+        const double *c_moment = &nodeMoment[9*child];
+        const double *c_second = &nodeSecondMoment[27*child];
+        CubitVector offset = CubitVector( &nodeCenter[3*child] ) - node_center;
+        int jj;
+        for (jj = 0; jj < 9; jj++)
+          moment[jj] += c_moment[jj] + c_normal[jj/3] * offset[jj%3];
+        for (jj = 0; jj < 27; jj++)
+        {
+          int i = jj/9, j = (jj/3)%3, k = jj%3;
+          second[jj] += c_second[jj] + c_moment[3*i+j] * offset[k] +
+                        c_moment[3*i+k] * offset[j] +
+                        c_normal[i] * offset[j] * offset[k];
+        }
+      }
+      nodeRadius[node] = CUBIT_MAX(
+        node_center.distance_between( CubitVector( &nodeCenter[3*left] ) ) + nodeRadius[left],
+        node_center.distance_between( CubitVector( &nodeCenter[3*right] ) ) + nodeRadius[right] );
+    }
+  }
+}
+
+//===========================================================================
+//Function Name: far_field
+//Description:  the solid angle of a node's triangles seen from a point at
+// r = center - point, from the Taylor expansion of r/|r|^3 about the
+// center to second order, integrated against the node's moments.
+//===========================================================================
+double FacetContainmentTool::far_field( int node, const double r[3],
+                                        double dist_sq ) const
+{
+  const double *normal = &nodeNormal[3*node];
+  const double *moment = &nodeMoment[9*node];
+  const double *second = &nodeSecondMoment[27*node];
+  int ii, jj;
+
+  // order 0: n.r / |r|^3
+  double n_r = normal[0]*r[0] + normal[1]*r[1] + normal[2]*r[2];
+
+  // order 1: (trace(M) - 3 r.M.r / |r|^2) / |r|^3
+  double trace = moment[0] + moment[4] + moment[8];
+  double r_m_r = 0.0;
+  for (ii = 0; ii < 3; ii++)
+    for (jj = 0; jj < 3; jj++)
+      r_m_r += r[ii] * moment[3*ii+jj] * r[jj];
+
+  // order 2: (-3 (2 C_iik r_k + r_i C_ijj) / |r|^2
+  //           + 15 C_ijk r_i r_j r_k / |r|^4) / (2 |r|^3)
+  double c_iik_r = 0.0, r_c_ijj = 0.0, c_rrr = 0.0;
+  for (ii = 0; ii < 3; ii++)
+    for (jj = 0; jj < 3; jj++)
+    {
+      c_iik_r += second[9*ii+3*ii+jj] * r[jj];
+      r_c_ijj += r[ii] * second[9*ii+3*jj+jj];
+      for (int kk = 0; kk < 3; kk++)
+        c_rrr += second[9*ii+3*jj+kk] * r[ii] * r[jj] * r[kk];
+    }
+
+  double order_2 = 0.5 * (-3.0 * (2.0 * c_iik_r + r_c_ijj) / dist_sq +
+                          15.0 * c_rrr / (dist_sq * dist_sq));
+  return (n_r + trace - 3.0 * r_m_r / dist_sq + order_2) /
+         (dist_sq * sqrt( dist_sq ));
+}
+
+//===========================================================================
+//Function Name: triangle_solid_angle
+//Description:  signed solid angle of a triangle seen from point, positive
+// if the point is behind it (Van Oosterom and Strackee).
+//===========================================================================
+double FacetContainmentTool::triangle_solid_angle( int tri,
+                                                   const CubitVector &point ) const
+{
+  const int *verts = &triVerts[3*tri];
+  CubitVector a = CubitVector( &pointCoords[3*verts[0]] ) - point;
+  CubitVector b = CubitVector( &pointCoords[3*verts[1]] ) - point;
+  CubitVector c = CubitVector( &pointCoords[3*verts[2]] ) - point;
+  double la = a.length(), lb = b.length(), lc = c.length();
+  double numerator = a % (b * c);
+  double denominator = la*lb*lc + (a % b)*lc + (b % c)*la + (c % a)*lb;
+  return 2.0 * atan2( numerator, denominator );
+}
+
+double FacetContainmentTool::winding_number( const CubitVector &point ) const
+{
+  if (myTree.empty())
+    return 0.0;
+
+  double winding = 0.0;
+  std::vector<int> stack;
+  stack.reserve( 128 );
+  stack.push_back( 0 );
+  while (!stack.empty())
+  {
+    int node = stack.back();
+    stack.pop_back();
+
+    const double *center = &nodeCenter[3*node];
+    double dx = center[0] - point.x();
+    double dy = center[1] - point.y();
+    double dz = center[2] - point.z();
+    double dist_sq = dx*dx + dy*dy + dz*dz;
+    double far_dist = FAR_FIELD_RATIO * nodeRadius[node];
+    if (dist_sq > far_dist * far_dist)
+    {
+      double r[3] = { dx, dy, dz };
+      winding += far_field( node, r, dist_sq );
+      continue;
+    }
+
+    const int *tris;
+    int count = myTree.leaf_triangles( node, tris );
+    if (count)
+    {
+      for (int ii = 0; ii < count; ii++)
+        winding += triangle_solid_angle( tris[ii], point );
+    }
+    else
+    {
+      stack.push_back( myTree.right_child( node ) );
+      stack.push_back( myTree.left_child( node ) );
+    }
+  }
+  return winding / (4.0 * CUBIT_PI);
+}
+
+double FacetContainmentTool::exact_winding_number( const CubitVector &point ) const
+{
+  double winding = 0.0;
+  for (int ii = 0; ii < num_triangles(); ii++)
+    winding += triangle_solid_angle( ii, point );
+  return winding / (4.0 * CUBIT_PI);
+}
+
+bool FacetContainmentTool::ray_parity( const CubitVector &point,
+                                       int &crossings ) const
+{
+  // a direction no axis-aligned or diagonal face is parallel to
+  static const CubitVector direction( 0.331, 0.557, 0.761 );
+
+  std::vector<TriangleBVH::RayHit> hits;
+  myTree.fire_ray( point, direction, hits );
+  for (size_t ii = 0; ii < hits.size(); ii++)
+  {
+    const TriangleBVH::RayHit &hit = hits[ii];
+    if (hit.u < EDGE_CROSSING_TOL || hit.v < EDGE_CROSSING_TOL ||
+        1.0 - hit.u - hit.v < EDGE_CROSSING_TOL)
+      return false;
+    if (ii > 0 && hit.distance - hits[ii-1].distance <= boundaryTol)
+      return false;
+  }
+  crossings = (int)hits.size();
+  return true;
+}
+
+CubitPointContainment FacetContainmentTool::point_containment(
+  const CubitVector &point ) const
+{
+  if (myTree.empty())
+    return CUBIT_PNT_OUTSIDE;
+
+  CubitVector closest;
+  if (myTree.closest_triangle( point, closest,
+                               CUBIT_MAX( boundaryTol, nearDistance ) ) >= 0)
+  {
+    if (closest.distance_between( point ) <= boundaryTol)
+      return CUBIT_PNT_BOUNDARY;
+    return CUBIT_PNT_UNKNOWN;
+  }
+
+  // near distances given per triangle by add_facets
+  if (maxTriNear > nearDistance)
+  {
+    std::vector<int> near_tris;
+    myTree.triangles_within( point, maxTriNear, near_tris );
+    for (size_t ii = 0; ii < near_tris.size(); ii++)
+      if (myTree.distance( near_tris[ii], point ) <= triNear[near_tris[ii]])
+        return CUBIT_PNT_UNKNOWN;
+  }
+
+  int crossings;
+  if (isClosed && ray_parity( point, crossings ))
+    return (crossings % 2) ? CUBIT_PNT_INSIDE : CUBIT_PNT_OUTSIDE;
+
+  return winding_number( point ) > 0.5 ? CUBIT_PNT_INSIDE : CUBIT_PNT_OUTSIDE;
+}
+
+//-------------------------------------------------------------------------
+// Purpose       : Classifies a range of points for point_containment.
+//
+// Special Notes : the tool's tree and node moments are built by
+//                 add_facets and only read here, and each point's result
+//                 is written by the range holding it, so point_containment
+//                 can classify the ranges on the CubitConcurrent pool.
+//
+//-------------------------------------------------------------------------
+class FacetContainmentBatch
+{
+public:
+  FacetContainmentBatch( const FacetContainmentTool &tool, const double *xyz,
+                         CubitPointContainment *results )
+    : containTool(tool), inXYZ(xyz), outResults(results)
+  {}
+
+  void classify_range( std::pair<size_t,size_t> range )
+  {
+    for (size_t ii = range.first; ii < range.second; ii++)
+      outResults[ii] = containTool.point_containment(
+        CubitVector( &inXYZ[3*ii] ) );
+  }
+
+private:
+  const FacetContainmentTool &containTool;
+  const double *inXYZ;
+  CubitPointContainment *outResults;
+};
+
+void FacetContainmentTool::point_containment( const double *xyz,
+                                              size_t num_points,
+                                              CubitPointContainment *results ) const
+{
+  FacetContainmentBatch batch( *this, xyz, results );
+  CubitConcurrent::parallel_for_ranges( num_points, batch, &FacetContainmentBatch::classify_range );
+}
@@ -0,0 +1,129 @@
+//- Class: FacetContainmentTool
+//- Description:  Classifies points as inside, outside or on the boundary
+//-               of a solid bounded by triangles.  The triangles are put
+//-               in a TriangleBVH once and any number of points can then
+//-               be classified, several at once on the CubitConcurrent
+//-               pool.
+//-
+//-               Points within the boundary tolerance of a triangle are
+//-               on the boundary.  Otherwise, if the triangles form
+//-               closed manifold shells, a ray is fired and its crossings
+//-               counted; if the ray passes too close to a triangle edge,
+//-               or the shells are not closed, the generalized winding
+//-               number of the triangles around the point decides.  The
+//-               winding number is summed over the tree with distant
+//-               nodes replaced by a second order expansion about the
+//-               node's center, so it costs about as much as a
+//-               nearest-triangle query, and it degrades gracefully on
+//-               meshes with small holes or overlaps.
+//-
+//-               Triangles must be oriented with their normals pointing
+//-               out of the solid.  Shells bounding voids point into the
+//-               void, as usual for lumps.
+//- Owner:
+//- Checked by:
+
+#ifndef FACET_CONTAINMENT_TOOL_HPP
+#define FACET_CONTAINMENT_TOOL_HPP
+
+#include "CubitDefines.h"
+#include "CubitVector.hpp"
+#include "DLIList.hpp"
+#include "TriangleBVH.hpp"
+#include <vector>
+#include <unordered_map>
+
+class CubitFacet;
+class CubitPoint;
+
+class FacetContainmentTool
+{
+public:
+
+  FacetContainmentTool();
+  ~FacetContainmentTool();
+
+  void add_facets( DLIList<CubitFacet*> &facet_list, CubitSense sense,
+                   double near_factor = 0.0 );
+    //- Add facets oriented by CubitFacet::normal.  sense is the
+    //- surface's sense in its shell: CUBIT_REVERSED if the normals point
+    //- into the solid; any other sense is taken as forward.  Points
+    //- closer to a facet than near_factor times its longest edge, but
+    //- not on the boundary, are CUBIT_PNT_UNKNOWN; see set_near_distance.
+    //- Call build() after the last facets are added.
+
+  void build();
+    //- Build the tree over the facets added so far.
+
+  void build( const double *coords, int num_points,
+              const int *connectivity, int num_triangles );
+    //- Replace the contents with the given triangles, three point
+    //- indices each, and build the tree.
+
+  void set_boundary_tolerance( double tolerance )
+    { boundaryTol = tolerance; }
+    //- Points this close to a triangle are CUBIT_PNT_BOUNDARY.  The
+    //- default is GEOMETRY_RESABS.
+
+  void set_near_distance( double distance )
+    { nearDistance = distance; }
+    //- Points closer than this to any triangle, but not on the boundary,
+    //- are CUBIT_PNT_UNKNOWN, for the caller to classify against the
+    //- exact surfaces where the triangles only approximate them.  The
+    //- default is 0.  It is a minimum for the near distances given to
+    //- add_facets.
+
+  bool is_closed() const
+    { return isClosed; }
+    //- True if every edge is used once in each direction.
+
+  int num_triangles() const
+    { return (int)triVerts.size() / 3; }
+
+  CubitPointContainment point_containment( const CubitVector &point ) const;
+
+  void point_containment( const double *xyz, size_t num_points,
+                          CubitPointContainment *results ) const;
+    //- Classify x,y,z triples, in parallel on the CubitConcurrent pool
+    //- if there is one.
+
+  double winding_number( const CubitVector &point ) const;
+    //- About 1 inside the solid and 0 outside.
+
+  double exact_winding_number( const CubitVector &point ) const;
+    //- The winding number summed over every triangle, without the far
+    //- field expansion.
+
+private:
+
+  bool ray_parity( const CubitVector &point, int &crossings ) const;
+    //- Count the crossings of a ray from point.  False if the ray
+    //- passes too close to a triangle edge to be sure.
+
+  double triangle_solid_angle( int tri, const CubitVector &point ) const;
+
+  void find_closed();
+  void compute_node_moments();
+  double far_field( int node, const double r[3], double dist_sq ) const;
+
+  std::vector<double> pointCoords;
+  std::vector<int> triVerts;
+  std::unordered_map<CubitPoint*, int> pointIndex;  // used by add_facets
+
+  TriangleBVH myTree;
+  std::vector<double> triNear;      // near distance of each triangle
+  std::vector<double> nodeNormal;   // 3 per node: sum of area * normal
+  std::vector<double> nodeCenter;   // 3 per node: area-weighted centroid
+  std::vector<double> nodeMoment;   // 9 per node: integral of normal[i]
+                                    // * d[j], d = x - nodeCenter
+  std::vector<double> nodeSecondMoment;  // 27 per node: integral of
+                                         // normal[i] * d[j] * d[k]
+  std::vector<double> nodeRadius;   // node's triangles are within this
+                                    // distance of nodeCenter
+  bool isClosed;
+  double boundaryTol;
+  double nearDistance;
+  double maxTriNear;
+};
+
+#endif
@@ -17,7 +17,10 @@
 #include "GeometryDefines.h"
 #include "debug.hpp"
 #include "GfxDebug.hpp"
-#include "KDDTree.hpp"
+#include "CubitConcurrentApi.h"
+
+#include <vector>
+#include <algorithm>
 
 //===========================================================================
 //Function Name: edges_by_count
@@ -1343,25 +1346,22 @@ CubitStatus FacetDataUtil::split_into_shells(
     GfxDebug::mouse_xforms();
   }
 
-  // Go through the surfaceElemList and pull facets off one by one as we
-  // determine which surface it belongs to.  Continue until we have depleted
-  // the list
+  // Go through the facet list and start a new shell at each facet that is
+  // still marked.  get_adj_facets_on_shell unmarks the facets it collects,
+  // so the list is walked only once
 
-  int jj;
-  int num_surfs_created = 0;
-  int num_facets_remaining = facet_list.size();
-  while( num_facets_remaining > 0)
+  facet_list.reset();
+  for (ii=0; ii<facet_list.size(); ii++)
   {
-    // create a new shell to hold the face info
-
-    num_surfs_created++;
-    DLIList<CubitFacet *> *shell_ptr = new DLIList<CubitFacet *>;
+    CubitFacet *start_facet_ptr = facet_list.get_and_step();
+    if (start_facet_ptr->marked() == 0)
+      continue;
 
-    // start with the first facet and create a list of all elements
+    // create a new shell to hold the face info and add all elements
     // attached to the facet
 
+    DLIList<CubitFacet *> *shell_ptr = new DLIList<CubitFacet *>;
     CubitBoolean shell_is_water_tight = CUBIT_TRUE;
-    CubitFacet *start_facet_ptr = facet_list.get_and_step();
     stat = get_adj_facets_on_shell( start_facet_ptr, shell_ptr,
                                     shell_is_water_tight, mydebug );
     if (stat != CUBIT_SUCCESS)
@@ -1370,20 +1370,6 @@ CubitStatus FacetDataUtil::split_into_shells(
       is_water_tight = CUBIT_FALSE;
 
     shell_list.append( shell_ptr );
-
-    // remove the facets in this shell from the facet list
-
-    for( jj = facet_list.size(); jj > 0; jj-- )
-    {
-      facet_ptr = facet_list.get();
-      if (facet_ptr->marked() == 0)
-      {
-        facet_list.change_to( NULL );
-      }
-      facet_list.step();
-    }
-    facet_list.remove_all_with_value( NULL );
-    num_facets_remaining = facet_list.size();
   }
 
   return CUBIT_SUCCESS;
@@ -1945,6 +1931,161 @@ CubitStatus FacetDataUtil::merge_coincident_vertices( DLIList<CubitPoint*> &poin
 
 
 
+// Finds, for each of a set of points, the points within a tolerance box
+// of it.  The points are sorted into cubic cells the size of the
+// tolerance, so only the 27 cells around a point need to be searched,
+// and the points are searched in ranges on the CubitConcurrent pool.
+// Each point's neighbors, itself included, are listed in increasing
+// order, so the result does not depend on the number of threads.
+class CoincidentPointSearch
+{
+public:
+  CoincidentPointSearch( const std::vector<CubitVector> &coords, double tol );
+
+  void search();
+
+  int num_close( int pt ) const
+    { return closeStart[pt+1] - closeStart[pt]; }
+  const int *close_points( int pt ) const
+    { return &closeList[closeStart[pt]]; }
+
+  void range( size_t index, std::pair<size_t,size_t> pts );
+
+private:
+
+  struct Cell
+  {
+    long long ix, iy, iz;
+    int pt;
+    bool operator<( const Cell &other ) const
+    {
+      if (ix != other.ix) return ix < other.ix;
+      if (iy != other.iy) return iy < other.iy;
+      if (iz != other.iz) return iz < other.iz;
+      return pt < other.pt;
+    }
+  };
+
+  void cell_of( const CubitVector &coord, Cell &cell ) const;
+
+  const std::vector<CubitVector> &ptCoords;
+  double tolerance;
+  double cellSize;
+  std::vector<Cell> cellList;
+
+  std::vector<int> closeStart;
+  std::vector<int> closeList;
+  std::vector< std::vector<int> > rangeLists;  // per range: count, points, ...
+};
+
+CoincidentPointSearch::CoincidentPointSearch( const std::vector<CubitVector> &coords,
+                                              double tol )
+  : ptCoords( coords ), tolerance( tol )
+{
+  // a zero tolerance still needs a usable cell size; only exactly
+  // coincident points will be found
+  cellSize = tol;
+  if (cellSize <= 0.0)
+  {
+    double max_coord = 0.0;
+    for (size_t ii=0; ii<coords.size(); ii++)
+      for (int jj=0; jj<3; jj++)
+        max_coord = CUBIT_MAX( max_coord, fabs( coords[ii][jj] ) );
+    cellSize = max_coord > 0.0 ? 1.0e-6 * max_coord : 1.0;
+  }
+
+  cellList.resize( coords.size() );
+  for (size_t ii=0; ii<coords.size(); ii++)
+  {
+    cell_of( coords[ii], cellList[ii] );
+    cellList[ii].pt = (int)ii;
+  }
+  std::sort( cellList.begin(), cellList.end() );
+}
+
+void CoincidentPointSearch::cell_of( const CubitVector &coord, Cell &cell ) const
+{
+  cell.ix = (long long)floor( coord.x() / cellSize );
+  cell.iy = (long long)floor( coord.y() / cellSize );
+  cell.iz = (long long)floor( coord.z() / cellSize );
+}
+
+void CoincidentPointSearch::range( size_t index, std::pair<size_t,size_t> pts )
+{
+  std::vector<int> &close_list = rangeLists[index];
+  std::vector<int> found;
+  for (size_t ii=pts.first; ii<pts.second; ii++)
+  {
+    const CubitVector &coord = ptCoords[ii];
+    Cell center;
+    cell_of( coord, center );
+    found.clear();
+    for (long long dx=-1; dx<=1; dx++)
+    for (long long dy=-1; dy<=1; dy++)
+    for (long long dz=-1; dz<=1; dz++)
+    {
+      Cell key;
+      key.ix = center.ix + dx;
+      key.iy = center.iy + dy;
+      key.iz = center.iz + dz;
+      key.pt = -1;
+      std::vector<Cell>::const_iterator cell =
+        std::lower_bound( cellList.begin(), cellList.end(), key );
+      for (; cell != cellList.end() && cell->ix == key.ix &&
+             cell->iy == key.iy && cell->iz == key.iz; ++cell)
+      {
+        const CubitVector &other = ptCoords[cell->pt];
+        if (fabs( other.x() - coord.x() ) <= tolerance &&
+            fabs( other.y() - coord.y() ) <= tolerance &&
+            fabs( other.z() - coord.z() ) <= tolerance)
+          found.push_back( cell->pt );
+      }
+    }
+    std::sort( found.begin(), found.end() );
+
+    close_list.push_back( (int)found.size() );
+    close_list.insert( close_list.end(), found.begin(), found.end() );
+  }
+}
+
+void CoincidentPointSearch::search()
+{
+  size_t num_points = ptCoords.size();
+  rangeLists.resize( CubitConcurrent::num_ranges( num_points ) );
+  CubitConcurrent::parallel_for_ranges( num_points, *this, &CoincidentPointSearch::range );
+
+  // gather the ranges' lists in order
+  closeStart.resize( num_points + 1 );
+  closeStart[0] = 0;
+  closeList.clear();
+  size_t pt = 0;
+  for (size_t ii=0; ii<rangeLists.size(); ii++)
+  {
+    std::vector<int> &close_list = rangeLists[ii];
+    size_t jj = 0;
+    while (jj < close_list.size())
+    {
+      int count = close_list[jj++];
+      closeList.insert( closeList.end(), close_list.begin() + jj,
+                        close_list.begin() + jj + count );
+      jj += count;
+      pt++;
+      closeStart[pt] = (int)closeList.size();
+    }
+  }
+  rangeLists.clear();
+}
+
+static int find_shell( std::vector<int> &shell_parent, int shell )
+{
+  while (shell_parent[shell] != shell)
+  {
+    shell_parent[shell] = shell_parent[shell_parent[shell]];
+    shell = shell_parent[shell];
+  }
+  return shell;
+}
+
 //=============================================================================
 //Function:  merge_coincident_vertices (PRIVATE)
 //Description: merge vertices (and connected facets and edges) if they are
@@ -1962,13 +2103,13 @@ CubitStatus FacetDataUtil::merge_coincident_vertices(
   int mydebug = 0;
   npmerge = 0;
   nemerge = 0;
-  int ii, jj, kk, ll, shell_id;
-  KDDTree <CubitPoint*> kd_tree(tol, false);
+  int ii, jj, kk, shell_id;
   CubitPoint::set_box_tol( tol );
   shell_list.reset();
   DLIList<CubitFacet *> *shell_ptr = NULL;
   CubitPoint *pt;
-  DLIList<CubitPoint *>boundary_points;
+  std::vector<CubitPoint *> boundary_points;
+  std::vector<CubitVector> boundary_coords;
   DLIList<CubitPoint *> del_points;
   for (ii=0; ii<shell_list.size(); ii++)
   {
@@ -1981,42 +2122,44 @@ CubitStatus FacetDataUtil::merge_coincident_vertices(
     FacetDataUtil::get_boundary_points(*shell_ptr, shell_boundary_points);
 
     // mark each of the points with a shell id so we know when to merge shells
-    // and add them to the kdtree for fast spatial searching
 
     shell_id = ii+1;
     for(jj=0; jj<shell_boundary_points.size(); jj++)
     {
       pt = shell_boundary_points.get_and_step();
       pt->marked(shell_id);
-      kd_tree.add(pt);
-      boundary_points.append(pt);
+      boundary_points.push_back(pt);
+      boundary_coords.push_back(pt->coordinates());
     }
   }
-  kd_tree.balance();
 
-  // find points that are coincident
+  // find the points close to each point.  Points have been compared by
+  // overlapping their boxes, each tol about the point, within tol, so
+  // points up to 3*tol apart in each direction are close.  Merging keeps
+  // the coordinates of the surviving point, so these stay valid below
+
+  CoincidentPointSearch point_search( boundary_coords, 3.0 * tol );
+  point_search.search();
+
+  // shells joined by merged points are tracked as sets and combined at
+  // the end, shell_parent[id] leading towards the set's representative
+
+  std::vector<int> shell_parent( shell_list.size() + 1 );
+  for (ii=0; ii<(int)shell_parent.size(); ii++)
+    shell_parent[ii] = ii;
 
-  CubitBox ptbox;
-  CubitVector ptmin, ptmax, coord;
-  DLIList<CubitPoint *>close_points;
   CubitPoint *close_pt = NULL;
   CubitFacet *facet;
   DLIList<CubitPoint*>adj_pt_list;
 
-  for(ii=0; ii<boundary_points.size(); ii++)
+  for(ii=0; ii<(int)boundary_points.size(); ii++)
   {
-    pt = boundary_points.get_and_step();
+    pt = boundary_points[ii];
     if (pt->marked() < 0)  // has already been merged
       continue;
 
-    // find the closest points in the kdtree
-
-    coord = pt->coordinates();
-    ptmin.set( coord.x() - tol, coord.y() - tol, coord.z() - tol );
-    ptmax.set( coord.x() + tol, coord.y() + tol, coord.z() + tol );
-    ptbox.reset( ptmin, ptmax );
-    close_points.clean_out();
-    kd_tree.find(ptbox, close_points);
+    const int *close_points = point_search.close_points( ii );
+    int num_close = point_search.num_close( ii );
 
     // if it didn't find anything to merge with, then we aren't water-tight
 
@@ -2024,14 +2167,13 @@ CubitStatus FacetDataUtil::merge_coincident_vertices(
 
     // We did find something - go try to merge
 
-    for (jj=0; jj<close_points.size(); jj++)
+    for (jj=0; jj<num_close; jj++)
     {
-      close_pt = close_points.get_and_step();
+      close_pt = boundary_points[close_points[jj]];
       if (close_pt == pt)
         continue;
       if (close_pt->marked() < 0)  // has already been merged
         continue;
-      assert(close_points.size() >= 1);
 
       // make sure this point is not already one of its neighbors
       // so we don't collapse a triangle
@@ -2052,43 +2194,12 @@ CubitStatus FacetDataUtil::merge_coincident_vertices(
         npmerge++;
         was_merged = CUBIT_TRUE;
 
-        // see if shells need to merge and then merge
-
-        shell_id = pt->marked();
-        if (shell_id != close_pt->marked())
-        {
+        // the close point's shell joins this point's shell
 
-          // get the shell containing the close point.  Nullify the
-          // pointer in the shell list and move all of its facets
-          // to the other shell.
-
-          int delete_shell = close_pt->marked();
-          DLIList<CubitFacet *> *delete_shell_ptr = NULL;
-          shell_list.reset();
-          for (ll=0; ll<delete_shell; ll++)
-            delete_shell_ptr = shell_list.get_and_step();
-          shell_list.back();
-          shell_list.change_to(NULL);
-
-          // mark all the points on the delete_shell as now being part of
-          // the other shell.
-
-          for(ll=0; ll<delete_shell_ptr->size(); ll++)
-          {
-            facet = delete_shell_ptr->get_and_step();
-            facet->point( 0 )->marked( shell_id );
-            facet->point( 1 )->marked( shell_id );
-            facet->point( 2 )->marked( shell_id );
-          }
-
-          // append the two lists together
-
-          shell_list.reset();
-          for (ll=0; ll<shell_id; ll++)
-            shell_ptr = shell_list.get_and_step();
-          *shell_ptr += (*delete_shell_ptr);
-          delete delete_shell_ptr;
-        }
+        shell_id = find_shell( shell_parent, pt->marked() );
+        int close_shell_id = find_shell( shell_parent, close_pt->marked() );
+        if (shell_id != close_shell_id)
+          shell_parent[close_shell_id] = shell_id;
 
         // set the marked flag to negative to indicate that it has been
         // merged and it need to be deleted.
@@ -2106,7 +2217,7 @@ CubitStatus FacetDataUtil::merge_coincident_vertices(
     else
     {
       // check to see if it was already merged
-      if (close_points.size() == 1 && close_pt == pt)
+      if (num_close == 1 && close_pt == pt)
       {
         CubitFacetEdge *edge_ptr;
         DLIList<CubitFacetEdge *>adj_edges;
@@ -2137,6 +2248,27 @@ CubitStatus FacetDataUtil::merge_coincident_vertices(
     }
   }
 
+  // move the facets of each joined shell to its set's first shell
+
+  std::vector<DLIList<CubitFacet *> *> shells( shell_list.size() + 1 );
+  shell_list.reset();
+  for (ii=1; ii<(int)shells.size(); ii++)
+    shells[ii] = shell_list.get_and_step();
+  for (ii=1; ii<(int)shells.size(); ii++)
+  {
+    shell_id = find_shell( shell_parent, ii );
+    if (shell_id != ii)
+    {
+      *shells[shell_id] += *shells[ii];
+      delete shells[ii];
+      shells[ii] = NULL;
+    }
+  }
+  shell_list.clean_out();
+  for (ii=1; ii<(int)shells.size(); ii++)
+    if (shells[ii])
+      shell_list.append( shells[ii] );
+
   // compress the shell list
 
   shell_list.remove_all_with_value(NULL);
@@ -7,6 +7,7 @@
 //- Checked by: 
 
 #include <float.h>
+#include <algorithm>
 #include "CastTo.hpp"
 #include "CubitVector.hpp"
 #include "CubitPoint.hpp"
@@ -25,14 +26,16 @@
 #include "TDFacetBoundaryPoint.hpp"
 #include "GfxDebug.hpp"
 //#include "FacetParamTool.hpp"
-#include "KDDTree.hpp"
-#include "AbstractTree.hpp"
+#include "TriangleBVH.hpp"
+#include "CompactFacetMesh.hpp"
+#include "CubitConcurrentApi.h"
 #include "CubitFileIOWrapper.hpp"
 #include "FacetDataUtil.hpp"
 
 double FacetEvalTool::timeGridSearch = 0.0;
 double FacetEvalTool::timeFacetProject = 0.0;
 int FacetEvalTool::numEvals = 0;
+unsigned long FacetEvalTool::nextChangeStamp = 0;
 #define GRID_SEARCH_THRESHOLD 20
 
 //===========================================================================
@@ -49,6 +52,7 @@ FacetEvalTool::FacetEvalTool(
 {
   static int counter = 1;
   toolID = counter++;
+  changeStamp = ++nextChangeStamp;
   myFacetList = facet_list;
   myPointList = point_list;
   isParameterized = CUBIT_FALSE;
@@ -71,7 +75,7 @@ FacetEvalTool::FacetEvalTool(
 
   // set the bounding box and compareTol and setup grid search
   myBBox = NULL;
-  aTree = NULL;
+  facetTree = NULL;
   
   reset_bounding_box();
   
@@ -135,8 +139,9 @@ FacetEvalTool::FacetEvalTool()
 {
   static int counter = 1;
   toolID = counter++;
+  changeStamp = ++nextChangeStamp;
   myBBox = NULL;
-  aTree = NULL;
+  facetTree = NULL;
   lastFacet = NULL;
   isFlat = -999;
   myArea = -1.0;
@@ -161,8 +166,8 @@ FacetEvalTool::~FacetEvalTool()
     PRINT_INFO("timeGridSearch   = %f\n",timeGridSearch);
   }
 
-  if (aTree != NULL)
-    delete aTree;
+  if (facetTree != NULL)
+    delete facetTree;
 
   if (myBBox) delete myBBox;
   destroy_facets();
@@ -239,26 +244,29 @@ void FacetEvalTool::replace_facets( DLIList<CubitFacet *> &facet_list )
 //Function Name: set_up_grid_search
 //
 //Member Type:  PUBLIC
-//Descriptoin:  set up grid search if we have a lot of facets
+//Descriptoin:  set up a search tree if we have a lot of facets
 //===========================================================================
-void FacetEvalTool::set_up_grid_search(
-  double geom_factor )
+void FacetEvalTool::set_up_grid_search()
 {
-  if(aTree)
-    delete aTree;
+  if(facetTree)
+    delete facetTree;
+  facetTree = NULL;
+  treeFacets.clear();
   
-  if (myFacetList.size() < GRID_SEARCH_THRESHOLD)
+  if (myFacetList.size() >= GRID_SEARCH_THRESHOLD)
   {
-    aTree = NULL;
-  }
-  else
-  {
-    aTree = new KDDTree<CubitFacet*> (GEOMETRY_RESABS*geom_factor, false/*self-balancing off*/);
-    for ( int ii = myFacetList.size(); ii > 0; ii--  )
-    {
-      aTree->add(myFacetList.get_and_step());
-    }
-    aTree->balance();
+      // the triangles of the mesh are in the order of myFacetList
+    CompactFacetMesh mesh;
+    if ( mesh.build( myFacetList ) != CUBIT_SUCCESS )
+      return;
+    int num_facets = myFacetList.size();
+    treeFacets.resize( num_facets );
+    myFacetList.reset();
+    for ( int ii = 0; ii < num_facets; ii++ )
+      treeFacets[ii] = myFacetList.get_and_step();
+    facetTree = new TriangleBVH;
+    facetTree->build( mesh.coords(), mesh.num_points(),
+                      mesh.connectivity(), mesh.num_triangles() );
   }
 }
 
@@ -1791,6 +1799,7 @@ bool FacetEvalTool::have_data_to_calculate_bbox(void)
 //===========================================================================
 void FacetEvalTool::reset_bounding_box()
 {
+  changeStamp = ++nextChangeStamp;
   if(have_data_to_calculate_bbox())
   {
     if (myBBox != NULL)
@@ -1806,7 +1815,7 @@ void FacetEvalTool::reset_bounding_box()
                        sqr(myBBox->z_range()));
     compareTol = 1.0e-3 * diag;
 
-    set_up_grid_search( diag );
+    set_up_grid_search();
   }
 }
 
@@ -1922,7 +1931,6 @@ CubitStatus FacetEvalTool::closest_point(CubitVector &this_point,
   CubitBoolean trim = CUBIT_FALSE;
   CubitBoolean outside;
   CubitStatus rv = CUBIT_SUCCESS;
-  static int count = 0;  count++;
 
   int mydebug = 0;
   if (mydebug)
@@ -1962,58 +1970,262 @@ CubitFacet* FacetEvalTool::closest_facet( const CubitVector& point )
 }
 
 //===========================================================================
-//Function Name: facets_from_search_grid
+//Function Name: project_point
 //
 //Member Type:  PRIVATE
-//Description:  find the closest facets to the point in the search grid
-// by starting with a default tolerance and expanding until facets are found
+//Description:  Same projection as closest_point, but with the last facet
+// kept by the caller and the candidate facets in a local list, so it
+// can run on several threads at once.
+//===========================================================================
+CubitStatus FacetEvalTool::project_point(
+  const CubitVector &this_point,
+  CubitFacet *&last_facet,
+  CubitVector &close_point,
+  CubitVector *normal_ptr ) const
+{
+  DLIList<CubitFacet *> facet_list;
+  if (facetTree != NULL)
+  {
+    facets_from_search_tree( this_point, facet_list );
+    if (facet_list.size() == 0)
+      return CUBIT_FAILURE;
+  }
+  else
+    facet_list = myFacetList;
+
+  CubitBoolean outside;
+  return project_to_facets( facet_list, last_facet, interpOrder, compareTol,
+                            this_point, CUBIT_FALSE, &outside, &close_point,
+                            normal_ptr );
+}
+
+//-------------------------------------------------------------------------
+// Purpose       : Projects a range of points for closest_points.
+//
+// Special Notes : closest_points computes the facet planes and point
+//                 normals before starting, so the projections only read
+//                 the facets.  Each range keeps its own last facet, so
+//                 neighboring points in a range start from each other's
+//                 facet, and writes only its own points' results.
+//
+//-------------------------------------------------------------------------
+class FacetProjectBatch
+{
+public:
+  FacetProjectBatch( const FacetEvalTool &tool, const double *xyz,
+                     double *out_xyz, double *out_normals, size_t num_points )
+    : evalTool(tool), inXYZ(xyz), outXYZ(out_xyz), outNormals(out_normals),
+      failed(num_points, 0)
+  {}
+
+  void project_range( std::pair<size_t,size_t> range )
+  {
+    CubitFacet *last_facet = NULL;
+    CubitVector close_point, normal;
+    for (size_t ii = range.first; ii < range.second; ii++)
+    {
+      CubitVector point( inXYZ[3*ii], inXYZ[3*ii+1], inXYZ[3*ii+2] );
+      if (evalTool.project_point( point, last_facet, close_point,
+                                  outNormals ? &normal : NULL ) != CUBIT_SUCCESS)
+      {
+        failed[ii] = 1;
+        close_point = point;
+        normal.set( 0.0, 0.0, 0.0 );
+      }
+      close_point.get_xyz( &outXYZ[3*ii] );
+      if (outNormals)
+        normal.get_xyz( &outNormals[3*ii] );
+    }
+  }
+
+  bool any_failed() const
+  {
+    for (size_t ii = 0; ii < failed.size(); ii++)
+      if (failed[ii])
+        return true;
+    return false;
+  }
+
+private:
+  const FacetEvalTool &evalTool;
+  const double *inXYZ;
+  double *outXYZ;
+  double *outNormals;
+  std::vector<char> failed;
+};
+
 //===========================================================================
-void FacetEvalTool::facets_from_search_grid( 
-  CubitVector &this_point,
-  DLIList<CubitFacet *> &facet_list,
-  double &tol_used)
+//Function Name: closest_points
+//
+//Member Type:  PUBLIC
+//Description:  Project many points to the facets, in parallel if there
+// is a concurrency pool.  Points that fail to project are returned
+// unchanged with a zero normal, and CUBIT_FAILURE is returned.
+//===========================================================================
+CubitStatus FacetEvalTool::closest_points(
+  const double *xyz,
+  size_t num_points,
+  double *out_xyz,
+  double *out_normals ) const
+{
+  if (num_points == 0)
+    return CUBIT_SUCCESS;
+  if (myFacetList.size() == 0)
+    return CUBIT_FAILURE;
+
+  // the facet planes and point normals are computed on first use;
+  // compute them now so the projections below only read them
+  int ii;
+  for (ii = 0; ii < myFacetList.size(); ii++)
+    myFacetList[ii]->plane();
+  if (interpOrder != 0)
+  {
+    for (ii = 0; ii < myPointList.size(); ii++)
+      myPointList[ii]->normal();
+  }
+
+  FacetProjectBatch batch( *this, xyz, out_xyz, out_normals, num_points );
+  CubitConcurrent::parallel_for_ranges( num_points, batch, &FacetProjectBatch::project_range );
+
+  return batch.any_failed() ? CUBIT_FAILURE : CUBIT_SUCCESS;
+}
+
+//===========================================================================
+//Function Name: ray_facet_distance
+//
+//Description:  distance along the unit direction at which the ray
+// crosses the facet, within tolerance of its edges, or -CUBIT_DBL_MAX if
+// it misses.  The same test as TriangleBVH::fire_ray.
+//===========================================================================
+static double ray_facet_distance( const CubitVector &origin,
+                                  const CubitVector &dir,
+                                  CubitFacet *facet,
+                                  double tolerance )
 {
-  double tol = compareTol * 10;
-  while (facet_list.size() == 0)
+  CubitVector p0 = facet->point(0)->coordinates();
+  CubitVector e1 = facet->point(1)->coordinates() - p0;
+  CubitVector e2 = facet->point(2)->coordinates() - p0;
+  CubitVector p = dir * e2;
+  double det = e1 % p;
+  double area2 = (e1 * e2).length();
+  if (area2 < CUBIT_RESABS || fabs(det) < CUBIT_RESABS * area2)
+    return -CUBIT_DBL_MAX;
+
+  // barycentric slack equivalent to tolerance from the longest edge
+  double longest = CUBIT_MAX( e1.length_squared(), e2.length_squared() );
+  longest = CUBIT_MAX( longest, (e2 - e1).length_squared() );
+  double eps = tolerance * sqrt( longest ) / area2;
+
+  CubitVector tv = origin - p0;
+  double u = (tv % p) / det;
+  if (u < -eps || u > 1.0 + eps)
+    return -CUBIT_DBL_MAX;
+  CubitVector q = tv * e1;
+  double v = (dir % q) / det;
+  if (v < -eps || u + v > 1.0 + eps)
+    return -CUBIT_DBL_MAX;
+  double t = (e2 % q) / det;
+  return t < -tolerance ? -CUBIT_DBL_MAX : t;
+}
+
+//===========================================================================
+//Function Name: fire_ray
+//
+//Member Type:  PUBLIC
+//Description:  intersect a ray with the facets.  Surfaces with a search
+// tree fire the ray at the tree; smaller ones test every facet.
+//===========================================================================
+int FacetEvalTool::fire_ray( const CubitVector &origin,
+                             const CubitVector &direction,
+                             double tolerance,
+                             int max_hits,
+                             std::vector<double> &distances ) const
+{
+  double len = direction.length();
+  if (len < CUBIT_RESABS || myFacetList.size() == 0)
+    return 0;
+  CubitVector dir = direction / len;
+
+  if (myBBox != NULL)
   {
-    CubitVector ptmin( this_point.x() - tol, 
-                       this_point.y() - tol, 
-                       this_point.z() - tol );
-    CubitVector ptmax( this_point.x() + tol, 
-                       this_point.y() + tol, 
-                       this_point.z() + tol );
-    CubitBox ptbox(ptmin,ptmax);
-    aTree->find(ptbox,facet_list);
+    CubitVector tol_vec( tolerance, tolerance, tolerance );
+    CubitBox box( myBBox->minimum() - tol_vec, myBBox->maximum() + tol_vec );
+    if (!box.intersect( origin, dir ))
+      return 0;
+  }
 
-    if (0 == facet_list.size())
-      tol *= 2.0;
+  std::vector<double> hits;
+  if (facetTree != NULL)
+  {
+    // a ray through an edge hits both of its facets, so ask the tree for
+    // more hits until max_hits distinct ones are found or there are no more
+    std::vector<TriangleBVH::RayHit> tri_hits;
+    int num_wanted = max_hits;
+    for (;;)
+    {
+      tri_hits.clear();
+      int found = facetTree->fire_ray( origin, dir, tri_hits, tolerance,
+                                       num_wanted );
+      int distinct = 0;
+      for (int ii = 0; ii < found; ii++)
+        if (ii == 0 || tri_hits[ii].distance - tri_hits[ii-1].distance > tolerance)
+          distinct++;
+      if (max_hits <= 0 || found < num_wanted || distinct >= max_hits)
+        break;
+      num_wanted *= 2;
+    }
+    hits.reserve( tri_hits.size() );
+    for (size_t ii = 0; ii < tri_hits.size(); ii++)
+      hits.push_back( tri_hits[ii].distance );
+  }
+  else
+  {
+    for (int ii = 0; ii < myFacetList.size(); ii++)
+    {
+      double t = ray_facet_distance( origin, dir, myFacetList[ii], tolerance );
+      if (t != -CUBIT_DBL_MAX)
+        hits.push_back( t );
+    }
+    std::sort( hits.begin(), hits.end() );
   }
 
-  tol_used = tol;
+  size_t first = distances.size();
+  for (size_t ii = 0; ii < hits.size(); ii++)
+  {
+    if (max_hits > 0 && (int)(distances.size() - first) == max_hits)
+      break;
+    if (ii > 0 && hits[ii] - hits[ii-1] <= tolerance)
+      continue;
+    distances.push_back( CUBIT_MAX( hits[ii], 0.0 ) );
+  }
+  return (int)(distances.size() - first);
 }
 
 //===========================================================================
-//Function Name: facets_from_search_grid
+//Function Name: facets_from_search_tree
 //
 //Member Type:  PRIVATE
-//Description:  find the closest facets to the point in the search grid
-// for a given tolerance
-//===========================================================================
-void FacetEvalTool::facets_from_search_grid( 
-  CubitVector &this_point,
-  double compare_tol,
-  DLIList<CubitFacet *> &facet_list )
+//Description:  find the closest facets to the point in the search tree.
+// The interpolated surface may be closest on a neighbor of the nearest
+// linear facet, so facets within compareTol*10 of the nearest distance
+// are kept as well.
+//===========================================================================
+void FacetEvalTool::facets_from_search_tree( 
+  const CubitVector &this_point,
+  DLIList<CubitFacet *> &facet_list ) const
 {
-  double tol = compare_tol;
-
-  CubitVector ptmin( this_point.x() - tol, 
-                     this_point.y() - tol, 
-                     this_point.z() - tol );
-  CubitVector ptmax( this_point.x() + tol, 
-                     this_point.y() + tol, 
-                     this_point.z() + tol );
-  CubitBox ptbox(ptmin,ptmax);
-  aTree->find(ptbox,facet_list);
+  CubitVector closest;
+  int nearest = facetTree->closest_triangle( this_point, closest );
+  if (nearest < 0)
+    return;
+
+  std::vector<int> near_tris;
+  double distance = closest.distance_between( this_point );
+  facetTree->triangles_within( this_point, distance + compareTol * 10,
+                               near_tris );
+  facet_list.reserve( (int)near_tris.size() );
+  for (size_t ii = 0; ii < near_tris.size(); ii++)
+    facet_list.append( treeFacets[near_tris[ii]] );
 }
 
 //===========================================================================
@@ -2041,61 +2253,22 @@ FacetEvalTool::project_to_facets(CubitVector &this_point,
 
   CubitStatus rv = CUBIT_SUCCESS;
 
-  // if there are a lot of facets on this surface - use the grid search first 
+  // if there are a lot of facets on this surface - use the search tree first 
   // to narrow the selection
 
-  if (aTree != NULL)
+  if (facetTree != NULL)
   {
     DLIList<CubitFacet *> facet_list;
-    double search_tol = DBL_MAX;
-    facets_from_search_grid( this_point, facet_list, search_tol );
+    facets_from_search_tree( this_point, facet_list );
     if ( DEBUG_FLAG(110) )
       timeGridSearch += function_time.cpu_secs();
 
     if (facet_list.size())
     {
-      CubitVector grid_close_pt;
       rv = project_to_facets(facet_list,lastFacet,interpOrder,compareTol,
-                             this_point,trim,outside, &grid_close_pt,
+                             this_point,trim,outside,closest_point_ptr,
                              normal_ptr);
 
-      if (CUBIT_SUCCESS == rv)
-      {
-        if (closest_point_ptr)
-        {
-          *closest_point_ptr = grid_close_pt;
-        }
-
-        // when we do the projection, if we end up with the closest point being farther
-        // away than the grid search tolerance, we may have missed a closer facet
-        // so redo the grid search using the distance as a tolerance
-        double distance = grid_close_pt.distance_between( this_point );
-        if (distance > search_tol)
-        {
-          DLIList<CubitFacet*> facets_within_distance;
-          CubitVector grid_close_pt2;
-          facets_from_search_grid(this_point, distance, facets_within_distance);
-          if (facets_within_distance.size() &&
-              (facets_within_distance != facet_list) )
-          {
-            rv = project_to_facets(facets_within_distance, lastFacet, interpOrder, compareTol,
-                                   this_point, trim, outside, &grid_close_pt2,
-                                   normal_ptr);
-            if (CUBIT_SUCCESS == rv)
-            {
-              double distance2 = grid_close_pt2.distance_between( this_point );
-              if (distance2 < distance)
-              {
-                if (closest_point_ptr)
-                {
-                  *closest_point_ptr = grid_close_pt2;
-                }
-              }
-            }
-          }
-        }
-      }
-
       if ( DEBUG_FLAG(110) )
       {
         timeFacetProject += function_time.cpu_secs();
@@ -2184,16 +2357,14 @@ FacetEvalTool::project_to_facets(
     facet_list.reset();
   }
 
-  // so we don't evaluate a facet more than once - mark the facets
-  // as we evaluate them.  Put the evaluated facets on a used_facet_list
-  // so we clear the marks off when we are done.  Note: this assumes
-  // theat marks are initially cleared.
+  // so we don't evaluate a facet more than once - flag the facets by
+  // their position in the list as we evaluate them.  The facets
+  // themselves are not marked, so several threads may project to the
+  // same facets at once.
   
-  DLIList<CubitFacet *>used_facet_list;
-  for(ii=0; ii<facet_list.size(); ii++)
-    facet_list.get_and_step()->marked(0);
-
   int nfacets = facet_list.size();
+  std::vector<char> evaluated( nfacets, 0 );
+  int num_tol = 0;
   int nevald = 0;
   double tol = compare_tol * 10;
   const double atol = 0.001;
@@ -2216,8 +2387,9 @@ FacetEvalTool::project_to_facets(
     ncheck = 0;
     for ( ii = facet_list.size(); ii > 0 && !done; ii-- ) 
     {
+      int index = facet_list.get_index();
       facet = facet_list.get_and_step();
-      if (facet->marked())
+      if (evaluated[index])
         continue;
 
       // Try to trivially reject this facet with a bounding box test
@@ -2351,8 +2523,7 @@ FacetEvalTool::project_to_facets(
         }
         big_dist = 10.0 * mindist;
       }
-      facet->marked(1);
-      used_facet_list.append(facet);
+      evaluated[index] = 1;
     }
 
     // We are done if we found at least one triangle.  Otherwise
@@ -2372,7 +2543,7 @@ FacetEvalTool::project_to_facets(
             if (nincr < 10)
             {
               tol *= 2.0;
-              ntol++;
+              num_tol++;
             }
             else
             // getting here means that the compare_tol probably is too small
@@ -2394,7 +2565,7 @@ FacetEvalTool::project_to_facets(
           else
           {
             tol *= 2.0e0;
-            ntol++;
+            num_tol++;
           }
         }
       }
@@ -2444,16 +2615,9 @@ FacetEvalTool::project_to_facets(
   last_facet = best_facet;
 
 
-  // clear the marks from the used facets
-
-  for (ii=0; ii<used_facet_list.size(); ii++)
-  {
-    facet = used_facet_list.get_and_step();
-    facet->marked( 0 );
-  }
-
   if (mydebug) {
     nncheck+= ncheck;
+    ntol += num_tol;
     calls++;
     if (calls%100==0){
       PRINT_INFO("calls = %d, ckecks = %d, ntol = %d\n",calls,nncheck,ntol);
@@ -4268,68 +4432,59 @@ CubitStatus FacetEvalTool::save(
   NCubitFile::CIOWrapper cio(fp);
   typedef NCubitFile::UnsignedInt32 int32;
 
-  cio.Write(reinterpret_cast<int32*>(&interpOrder), 1);
-  cio.Write(reinterpret_cast<int32*>(&isFlat), 1);
-  int32 is_param = isParameterized ? 1 : 0;
-  cio.Write(&is_param, 1);
+  std::vector<int> int_data, ids;
+  std::vector<double> double_data;
+  save( int_data, double_data, ids );
 
-  cio.Write(&myArea, 1);
-  cio.Write(&minDot, 1);
+  cio.Write(reinterpret_cast<int32*>(&int_data[0]), 3);
+  cio.Write(&double_data[0], 2);
 
-   // write ids of facets that belong to this tool 
-  int ii;
-  CubitFacet *facet_ptr;
-  int32 nfacets = myFacetList.size();
-  int32* facet_id = new int32 [nfacets];
-  myFacetList.reset();
-  for (ii=0; ii<nfacets; ii++)
+   // write the ids of the facets, edges and points, each preceded by
+   // their number
+  int ii, start = 0;
+  for (ii=0; ii<3; ii++)
   {
-    facet_ptr = myFacetList.get_and_step();
-    facet_id[ii] = facet_ptr->id();
+    int32 count = int_data[3+ii];
+    cio.Write(&count, 1);
+    if (count > 0)
+      cio.Write(reinterpret_cast<int32*>(&ids[start]), count);
+    start += count;
   }
-  cio.Write(&nfacets, 1);
-  if (nfacets > 0)
-  {
-    cio.Write(facet_id, nfacets);
-  }
-  delete [] facet_id;
 
-   // write ids of edges that belong to this tool 
-  CubitFacetEdge *edge_ptr;
-  int32 nedges = myEdgeList.size();
-  int32* edge_id = new int32 [nedges];
-  myEdgeList.reset();
-  for (ii=0; ii<nedges; ii++)
-  {
-    edge_ptr = myEdgeList.get_and_step();
-    edge_id[ii] = edge_ptr->id();
-    volatile int test_int = edge_id[ii] + 1;   // this is a test line to look for uninitialized data rjm
-  }
-  cio.Write( &nedges, 1);
-  if (nedges > 0)
-  {
-    cio.Write(edge_id, nedges);
-  }
-  delete [] edge_id;
+  return CUBIT_SUCCESS;
+}
 
-   // write ids of points that belong to this tool
-  CubitPoint *point_ptr;
-  int32 npoints = myPointList.size();
-  int32* point_id = new int32 [npoints];
-  myPointList.reset();
-  for (ii=0; ii<npoints; ii++)
-  {
-    point_ptr = myPointList.get_and_step();
-    point_id[ii] = point_ptr->id();
-  }
-  cio.Write(&npoints, 1);
-  if (npoints > 0)
-  {
-    cio.Write(point_id, npoints);
-  }
-  delete [] point_id;
+//===========================================================================
+//Function Name: save
+//
+//Member Type:  PUBLIC
+//Description:  append the facet eval tool data to arrays
+//===========================================================================
+void FacetEvalTool::save( 
+  std::vector<int> &int_data,
+  std::vector<double> &double_data,
+  std::vector<int> &ids )
+{
+  int_data.push_back( interpOrder );
+  int_data.push_back( isFlat );
+  int_data.push_back( isParameterized ? 1 : 0 );
+  int_data.push_back( myFacetList.size() );
+  int_data.push_back( myEdgeList.size() );
+  int_data.push_back( myPointList.size() );
 
-  return CUBIT_SUCCESS;
+  double_data.push_back( myArea );
+  double_data.push_back( minDot );
+
+  int ii;
+  myFacetList.reset();
+  for (ii=myFacetList.size(); ii--; )
+    ids.push_back( myFacetList.get_and_step()->id() );
+  myEdgeList.reset();
+  for (ii=myEdgeList.size(); ii--; )
+    ids.push_back( myEdgeList.get_and_step()->id() );
+  myPointList.reset();
+  for (ii=myPointList.size(); ii--; )
+    ids.push_back( myPointList.get_and_step()->id() );
 }
 
 //===========================================================================
@@ -4352,85 +4507,88 @@ CubitStatus FacetEvalTool::restore(
   typedef NCubitFile::UnsignedInt32 int32;
 
   // read interpOrder, isFlat, isParameterized 
-  int int_data[3];
+  int int_data[6];
   cio.Read(reinterpret_cast<int32*>(int_data), 3);
-  interpOrder = int_data[0];
-  isFlat = int_data[1];
-  isParameterized = (int_data[2] != 0);
 
   // read myArea, minDot
   double double_data[2];
   cio.Read( double_data, 2);
+
+  // read the facet, edge and point ids
+  std::vector<int> ids;
+  int ii;
+  for (ii=0; ii<3; ii++)
+  {
+    int count;
+    cio.Read(reinterpret_cast<int32*>(&count), 1);
+    if (count < 0)
+      return CUBIT_FAILURE;
+    int_data[3+ii] = count;
+    if (count > 0)
+    {
+      ids.resize( ids.size() + count );
+      cio.Read(reinterpret_cast<int32*>(&ids[ids.size() - count]), count);
+    }
+  }
+
+  return restore( int_data, double_data, ids.empty() ? NULL : &ids[0],
+                  num_facets, num_edges, num_points, facets, edges, points );
+}
+
+//===========================================================================
+//Function Name: restore
+//
+//Member Type:  PUBLIC
+//Description:  restore a facetevaltool from the arrays written by save
+//===========================================================================
+CubitStatus FacetEvalTool::restore( 
+  const int *int_data,
+  const double *double_data,
+  const int *ids,
+  int num_facets, 
+  int num_edges, 
+  int num_points,
+  CubitFacet **facets, 
+  CubitFacetEdge **edges, 
+  CubitPoint **points )
+{
+  interpOrder = int_data[0];
+  isFlat = int_data[1];
+  isParameterized = (int_data[2] != 0);
+
   myArea = double_data[0];
   minDot  = double_data[1];
 
   lastFacet = NULL;
 
-  // read the facet ids and assign facets to this eval tool
-  int nfacets; 
-  cio.Read(reinterpret_cast<int32*>(&nfacets), 1);
-  int32 *facet_id = NULL;
-  if (nfacets > 0)
+  // assign the facets, edges and points to this eval tool
+  int ii, id;
+  int nfacets = int_data[3];
+  for(ii=0; ii<nfacets; ii++)
   {
-    facet_id = new int32 [nfacets];
-    cio.Read(facet_id, nfacets);
-    int ii, id;
-    for(ii=0; ii<nfacets; ii++)
-    {
-      id = facet_id[ii];
-      if (ii < 0 || ii >= num_facets)
-      {
-        delete [] facet_id;
-        return CUBIT_FAILURE;
-      }
-      myFacetList.append( facets[id] );
-      facets[id]->set_tool_id( toolID );
-    }
-    delete [] facet_id;
+    id = *ids++;
+    if (id < 0 || id >= num_facets)
+      return CUBIT_FAILURE;
+    myFacetList.append( facets[id] );
+    facets[id]->set_tool_id( toolID );
   }
 
-  // read the edges
-  int nedges; 
-  cio.Read(reinterpret_cast<int32*>(&nedges), 1);
-  int32 *edge_id = NULL;
-  if (nedges > 0)
+  int nedges = int_data[4];
+  for(ii=0; ii<nedges; ii++)
   {
-    edge_id = new int32 [nedges];
-    cio.Read(edge_id, nedges);
-    int ii, id;
-    for(ii=0; ii<nedges; ii++)
-    {
-      id = edge_id[ii];
-      if (ii < 0 || ii >= num_edges)
-      {
-        delete [] edge_id;
-        return CUBIT_FAILURE;
-      }
-      myEdgeList.append( edges[id] );
-    }
-    delete [] edge_id;
+    id = *ids++;
+    if (id < 0 || id >= num_edges)
+      return CUBIT_FAILURE;
+    myEdgeList.append( edges[id] );
   }
 
-  // read the points
-  int npoints; 
-  cio.Read(reinterpret_cast<int32*>(&npoints), 1);
-  int32 *point_id = NULL;
-  if (npoints > 0)
+  int npoints = int_data[5];
+  for(ii=0; ii<npoints; ii++)
   {
-    point_id = new int32 [npoints];
-    cio.Read(point_id, npoints);
-    int ii, id;
-    for(ii=0; ii<npoints; ii++)
-    {
-      id = point_id[ii];
-      if (ii < 0 || ii >= num_points)
-      {
-        delete [] point_id;
-        return CUBIT_FAILURE;
-      }
-      myPointList.append( points[id] );
-    }
-    delete [] point_id;
+    id = *ids++;
+    if (id < 0 || id >= num_points)
+      return CUBIT_FAILURE;
+    myPointList.append( points[id] );
   }
 
   bounding_box();
@@ -4480,10 +4638,14 @@ CubitStatus FacetEvalTool::get_intersections(CubitVector point1,
   
     //Find the facets that are intersected by the bbox that was just created.
   DLIList<CubitFacet*> search_facets;
-  if( aTree )
+  if( facetTree )
   {
       //Get the facets from the tree.
-    aTree->find( bbox, search_facets );
+    std::vector<int> tris;
+    facetTree->triangles_in_box( bbox, tris );
+    search_facets.reserve( (int)tris.size() );
+    for( size_t jj = 0; jj < tris.size(); jj++ )
+      search_facets.append( treeFacets[tris[jj]] );
   }
   else
       search_facets = myFacetList;
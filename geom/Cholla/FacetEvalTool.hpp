@@ -14,9 +14,8 @@
 #define SMOOTH_FACET_EVAL_TOOL_HPP
 
 #include "DLIList.hpp"
-#include "AbstractTree.hpp"
 #include "CubitFacet.hpp" //For inline function.
-template <class Y> class KDDTree;
+#include <vector>
 
 #define determ3(p1,q1,p2,q2,p3,q3) ((q3)*((p2)-(p1)) + (q2)*((p1)-(p3)) + (q1)*((p3)-(p2)))
 #define sqr(a) ((a)*(a))
@@ -29,6 +28,7 @@ class CubitFacet;
 class CubitPoint;
 class CubitVector;
 class CubitTransformMatrix;
+class TriangleBVH;
 
 class FacetEvalTool
 {
@@ -38,6 +38,8 @@ private:
   static int numEvals;
 
   int toolID;
+  unsigned long changeStamp;
+  static unsigned long nextChangeStamp;
   int interpOrder;
     //- interpolation order 0=linear, 1=gradient, 2=quadratic, 4=quartic Bezier
   DLIList<CubitFacet*> myFacetList;
@@ -49,8 +51,10 @@ private:
   DLIList<CubitFacetEdge*> myEdgeList;
   DLIList<DLIList<CubitFacetEdge*>*> myLoopList;
     //- edges only used for bezier interp
-  AbstractTree <CubitFacet*> *aTree;
-    //- used for surfaces with many facets
+  TriangleBVH *facetTree;
+  std::vector<CubitFacet*> treeFacets;
+    //- used for surfaces with many facets; treeFacets maps the
+    //- triangles of the tree back to facets
   CubitBox *myBBox;
     //- Bounding box of facets
   double myArea;
@@ -69,28 +73,30 @@ private:
 
   bool have_data_to_calculate_bbox(void);
 
-  void set_up_grid_search(double geom_factor);
-    //!@{
-    //! \brief get the closest facets using an expanding tolerance
+  void set_up_grid_search();
+    //- set up a search tree if we have lots of facets
+
+    //! \brief get the facets that may hold the closest point
     //! 
-    //! \param this_point The point near which we want to find facets
-    //! \param facet_list The list of facets near the point
-    //! \param tol_used The highest tolerance at which the search was performed
+    //! Finds the facet nearest to the point in the search tree, then
+    //! every facet within compareTol*10 of that distance, so the
+    //! interpolated projection can still pick a neighboring facet.
     //!
-  void facets_from_search_grid( CubitVector &this_point,
-                                DLIList<CubitFacet *> &facet_list,
-                                double &tol_used );
-    //!@{
-    //! \brief get the closest facets using a given tolerance
-    //! 
     //! \param this_point The point near which we want to find facets
-    //! \param compare_tol The tolerance at which the facets were found
     //! \param facet_list The list of facets near the point
     //!
-  void facets_from_search_grid( CubitVector &this_point,
-                                double compare_tol,
-                                DLIList<CubitFacet *> &facet_list );
-    //- set up a grid search data structure if we have lots of facets
+  void facets_from_search_tree( const CubitVector &this_point,
+                                DLIList<CubitFacet *> &facet_list ) const;
+
+  CubitStatus project_point( const CubitVector &this_point,
+                             CubitFacet *&last_facet,
+                             CubitVector &close_point,
+                             CubitVector *normal_ptr ) const;
+    //- closest_point without touching the tool; last_facet is the
+    //- caller's starting guess and is updated to the facet found.
+    //- Used by closest_points.
+
+  friend class FacetProjectBatch;
 
   CubitStatus get_points_from_facets(DLIList<CubitFacet*> &facet_list,
                                      DLIList<CubitPoint*> &point_list );
@@ -220,6 +226,12 @@ public:
   int tool_id()
     { return toolID; };
 
+  unsigned long change_stamp() const
+    { return changeStamp; }
+    //- A number that is new for each tool and whenever the bounding box
+    //- and search tree are reset after the facets change, for callers
+    //- that keep data built from the facets.
+
   CubitStatus reverse_facets();
   static CubitStatus reverse_facets(DLIList<CubitFacet *> &facets);
   
@@ -232,6 +244,17 @@ public:
                        int num_facets, int num_edges, 
                        int num_points, CubitFacet **facets, 
                        CubitFacetEdge **edges, CubitPoint **points );
+  void save( std::vector<int> &int_data, std::vector<double> &double_data,
+             std::vector<int> &ids );
+    // append six ints (interpOrder, isFlat, isParameterized and the
+    // numbers of facets, edges and points), two doubles (area and minDot)
+    // and the facet, edge and point ids to the arrays
+  CubitStatus restore( const int *int_data, const double *double_data,
+                       const int *ids, int num_facets, int num_edges,
+                       int num_points, CubitFacet **facets,
+                       CubitFacetEdge **edges, CubitPoint **points );
+    // restore from the data appended by save() above; the ids index
+    // the facets, edges and points arrays
   
     //- get and set the interpolation order
   CubitBox bounding_box();
@@ -271,6 +294,28 @@ public:
 
   CubitFacet* closest_facet( const CubitVector& point );
 
+  CubitStatus closest_points( const double *xyz, size_t num_points,
+                              double *out_xyz,
+                              double *out_normals = NULL ) const;
+    //- Projects num_points points to the facets, as closest_point
+    //- does one at a time.  (closest_point starts its search from the
+    //- facet it found last, which can change the result on small
+    //- surfaces; here each point starts from its predecessor's facet.)
+    //- Each array holds x,y,z per point; out_normals may be NULL.
+    //- The tool is not changed and the points are projected in
+    //- parallel on the CubitConcurrent pool, if there is one.
+
+  int fire_ray( const CubitVector &origin, const CubitVector &direction,
+                double tolerance, int max_hits,
+                std::vector<double> &distances ) const;
+    //- Append the distances along the ray (measured along the unit
+    //- direction) at which it crosses the facets, nearest first, and
+    //- return the number appended.  A ray through a facet edge or
+    //- vertex is reported once: hits within tolerance of the previous
+    //- one are dropped.  If max_hits > 0 only the nearest max_hits are
+    //- kept.  Uses the search tree if there is one; the tool is not
+    //- changed.
+
   int is_flat();
     //- Determine if the set of facets are flat (all in the same plane)
 
@@ -13,6 +13,16 @@
 #include "CastTo.hpp"
 #include "CubitTransformMatrix.hpp"
 #include "GfxDebug.hpp"
+#include "ToolDataUser.hpp"
+
+// looked up at every boundary point of a facet surface
+// registered the first time it is needed, which is before any is added
+int TDFacetBoundaryPoint::td_slot()
+{
+  static int slot = ToolDataUser::register_TD_type( &TDFacetBoundaryPoint::is_facet_boundary_point );
+  return slot;
+}
+
 TDFacetBoundaryPoint::TDFacetBoundaryPoint()
 {
 
@@ -41,7 +51,7 @@ CubitStatus TDFacetBoundaryPoint::add_facet_boundary_point(
   CubitPoint *point_ptr )
 {
   ToolData *td;
-  td = point_ptr->get_TD(&TDFacetBoundaryPoint::is_facet_boundary_point);
+  td = point_ptr->get_TD( &TDFacetBoundaryPoint::is_facet_boundary_point, TDFacetBoundaryPoint::td_slot() );
   if ( td == NULL )
   {
     TDFacetBoundaryPoint *td_gm = new TDFacetBoundaryPoint;
@@ -73,7 +83,7 @@ CubitStatus TDFacetBoundaryPoint::add_facet_boundary_point(
 {
   ToolData *td;
   TDFacetBoundaryPoint *td_gm = NULL;
-  td = point_ptr->get_TD(&TDFacetBoundaryPoint::is_facet_boundary_point);
+  td = point_ptr->get_TD( &TDFacetBoundaryPoint::is_facet_boundary_point, TDFacetBoundaryPoint::td_slot() );
   if ( td == NULL )
   {
     td_gm = new TDFacetBoundaryPoint;
@@ -116,7 +126,7 @@ CubitStatus TDFacetBoundaryPoint::add_facet_boundary_point(
 {
   ToolData *td;
   TDFacetBoundaryPoint *td_gm = NULL;
-  td = point_ptr->get_TD(&TDFacetBoundaryPoint::is_facet_boundary_point);
+  td = point_ptr->get_TD( &TDFacetBoundaryPoint::is_facet_boundary_point, TDFacetBoundaryPoint::td_slot() );
   if ( td == NULL )
   {
     td_gm = new TDFacetBoundaryPoint;
@@ -160,7 +170,7 @@ TDFacetBoundaryPoint* TDFacetBoundaryPoint::get_facet_boundary_point(
   CubitPoint *point_ptr )
 {
   ToolData *td;
-  td = point_ptr->get_TD(&TDFacetBoundaryPoint::is_facet_boundary_point);
+  td = point_ptr->get_TD( &TDFacetBoundaryPoint::is_facet_boundary_point, TDFacetBoundaryPoint::td_slot() );
   if ( td != NULL )
   {
     TDFacetBoundaryPoint *td_gm = CAST_TO(td, TDFacetBoundaryPoint);
@@ -764,7 +774,7 @@ CubitStatus TDFacetBoundaryPoint::new_facet_boundary_point(CubitPoint **points,
   CubitPoint *point_ptr = points[id];
   TDFacetBoundaryPoint::add_facet_boundary_point(point_ptr);
   TDFacetBoundaryPoint *td = (TDFacetBoundaryPoint *)
-    point_ptr->get_TD( &TDFacetBoundaryPoint::is_facet_boundary_point);
+    point_ptr->get_TD( &TDFacetBoundaryPoint::is_facet_boundary_point, TDFacetBoundaryPoint::td_slot() );
 
   td->initialize( facets, iidx, didx, int_data, double_data );
 
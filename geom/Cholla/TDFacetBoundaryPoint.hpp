@@ -57,6 +57,10 @@ public:
 
   static int is_facet_boundary_point(const ToolData* td)
      {return (CAST_TO(const_cast<ToolData*>(td), TDFacetBoundaryPoint) != NULL);}
+
+  static int td_slot();
+  int user_slot() const { return td_slot(); }
+    //- the slot ToolDataUser keeps for this type
   
   void add_surf(int new_id);
 
@@ -4,6 +4,7 @@
 //- Checked by:
 //- Version:
 #include "TDFacetboolData.hpp"
+#include "ToolDataUser.hpp"
 #include "CastTo.hpp"
 #include "TDFacetboolData.hpp"
 #include "CubitFacet.hpp"
@@ -23,10 +24,18 @@ int TDFacetboolData::is_facetbool_facet(const ToolData* td)
   return (CAST_TO(const_cast<ToolData*>(td), TDFacetboolData) != NULL);
 }
 
+// looked up for every facet during boolean operations
+// registered the first time it is needed, which is before any is added
+int TDFacetboolData::td_slot()
+{
+  static int slot = ToolDataUser::register_TD_type( &TDFacetboolData::is_facetbool_facet );
+  return slot;
+}
+
 CubitStatus TDFacetboolData::add_facetbool_facet( FacetEntity *facet_ptr )
 {
   TDFacetboolData* td = (TDFacetboolData*) 
-                           facet_ptr->get_TD( &TDFacetboolData::is_facetbool_facet );
+                           facet_ptr->get_TD( &TDFacetboolData::is_facetbool_facet, TDFacetboolData::td_slot() );
   if ( td == NULL )
   {
     td = new TDFacetboolData;
@@ -48,7 +57,7 @@ void TDFacetboolData::set(int sv, int e0v, int e1v, int e2v, bool parent, bool i
 TDFacetboolData* TDFacetboolData::get(CubitFacet *facet_ptr)
 {
   TDFacetboolData *td = (TDFacetboolData*) 
-                           facet_ptr->get_TD(&TDFacetboolData::is_facetbool_facet);
+                           facet_ptr->get_TD( &TDFacetboolData::is_facetbool_facet, TDFacetboolData::td_slot() );
   if ( td != NULL )
   {
     return td;
@@ -43,6 +43,10 @@ public:
 
   static int is_facetbool_facet(const ToolData* td);
 
+  static int td_slot();
+  int user_slot() const { return td_slot(); }
+    //- the slot ToolDataUser keeps for this type
+
   void set(int sv, int e0v, int e1v, int e2v, bool parent, bool is_reversed); 
 
   static TDFacetboolData* get(CubitFacet *facet_ptr);    
@@ -4,6 +4,7 @@
 //- Checked by:
 //- Version:
 #include "TDGeomFacet.hpp"
+#include "ToolDataUser.hpp"
 #include "CubitFacetEdge.hpp"
 #include "CubitFacet.hpp"
 #include "CastTo.hpp"
@@ -34,9 +35,17 @@ int TDGeomFacet::is_geom_facet(const ToolData* td)
   return (CAST_TO(const_cast<ToolData*>(td), TDGeomFacet) != NULL);
 }
 
+// looked up for every facet while building geometry from facets
+// registered the first time it is needed, which is before any is added
+int TDGeomFacet::td_slot()
+{
+  static int slot = ToolDataUser::register_TD_type( &TDGeomFacet::is_geom_facet );
+  return slot;
+}
+
 CubitStatus TDGeomFacet::add_geom_facet( FacetEntity *facet_ptr, int block_id )
 {
-  TDGeomFacet* td = (TDGeomFacet*) facet_ptr->get_TD( &TDGeomFacet::is_geom_facet );
+  TDGeomFacet* td = (TDGeomFacet*) facet_ptr->get_TD( &TDGeomFacet::is_geom_facet, TDGeomFacet::td_slot() );
   if ( td == NULL )
   {
     td = new TDGeomFacet;
@@ -48,7 +57,7 @@ CubitStatus TDGeomFacet::add_geom_facet( FacetEntity *facet_ptr, int block_id )
 
 CubitStatus TDGeomFacet::add_geom_facet( CubitFacet *facet_ptr, int block_id)
 {
-  TDGeomFacet *td = (TDGeomFacet*) facet_ptr->get_TD(&TDGeomFacet::is_geom_facet);
+  TDGeomFacet *td = (TDGeomFacet*) facet_ptr->get_TD( &TDGeomFacet::is_geom_facet, TDGeomFacet::td_slot() );
   if ( td == NULL )
   {
     td = new TDGeomFacet;
@@ -59,7 +68,7 @@ CubitStatus TDGeomFacet::add_geom_facet( CubitFacet *facet_ptr, int block_id)
 }
 CubitStatus TDGeomFacet::add_geom_facet( CubitFacetEdge *edge_ptr, int block_id )
 {
-  TDGeomFacet *td = (TDGeomFacet*) edge_ptr->get_TD(&TDGeomFacet::is_geom_facet);
+  TDGeomFacet *td = (TDGeomFacet*) edge_ptr->get_TD( &TDGeomFacet::is_geom_facet, TDGeomFacet::td_slot() );
   if ( td == NULL )
   {
     td = new TDGeomFacet;
@@ -70,7 +79,7 @@ CubitStatus TDGeomFacet::add_geom_facet( CubitFacetEdge *edge_ptr, int block_id
 }
 CubitStatus TDGeomFacet::add_geom_facet( CubitPoint *point_ptr, int block_id )
 {
-  TDGeomFacet* td = (TDGeomFacet*) point_ptr->get_TD(&TDGeomFacet::is_geom_facet);
+  TDGeomFacet* td = (TDGeomFacet*) point_ptr->get_TD( &TDGeomFacet::is_geom_facet, TDGeomFacet::td_slot() );
   if ( td == NULL )
   {
     td = new TDGeomFacet;
@@ -83,7 +92,7 @@ CubitStatus TDGeomFacet::add_geom_facet( CubitPoint *point_ptr, int block_id )
 
 TDGeomFacet* TDGeomFacet::get_geom_facet( FacetEntity *facet_ptr )
 {
-  TDGeomFacet* td = (TDGeomFacet*) facet_ptr->get_TD(&TDGeomFacet::is_geom_facet);
+  TDGeomFacet* td = (TDGeomFacet*) facet_ptr->get_TD( &TDGeomFacet::is_geom_facet, TDGeomFacet::td_slot() );
   if ( td != NULL )
   {
     return td;
@@ -92,7 +101,7 @@ TDGeomFacet* TDGeomFacet::get_geom_facet( FacetEntity *facet_ptr )
 }
 TDGeomFacet* TDGeomFacet::get_geom_facet( CubitPoint *point_ptr )
 {
-  TDGeomFacet *td = (TDGeomFacet*) point_ptr->get_TD(&TDGeomFacet::is_geom_facet);
+  TDGeomFacet *td = (TDGeomFacet*) point_ptr->get_TD( &TDGeomFacet::is_geom_facet, TDGeomFacet::td_slot() );
   if ( td != NULL )
   {
     return td;
@@ -101,7 +110,7 @@ TDGeomFacet* TDGeomFacet::get_geom_facet( CubitPoint *point_ptr )
 }
 TDGeomFacet* TDGeomFacet::get_geom_facet( CubitFacetEdge *edge_ptr )
 {
-  TDGeomFacet *td = (TDGeomFacet*) edge_ptr->get_TD(&TDGeomFacet::is_geom_facet);
+  TDGeomFacet *td = (TDGeomFacet*) edge_ptr->get_TD( &TDGeomFacet::is_geom_facet, TDGeomFacet::td_slot() );
   if ( td != NULL )
   {
     return td;
@@ -110,7 +119,7 @@ TDGeomFacet* TDGeomFacet::get_geom_facet( CubitFacetEdge *edge_ptr )
 }
 TDGeomFacet* TDGeomFacet::get_geom_facet( CubitFacet *facet_ptr )
 {
-  TDGeomFacet *td = (TDGeomFacet*) facet_ptr->get_TD(&TDGeomFacet::is_geom_facet);
+  TDGeomFacet *td = (TDGeomFacet*) facet_ptr->get_TD( &TDGeomFacet::is_geom_facet, TDGeomFacet::td_slot() );
   if ( td != NULL )
   {
     return td;
@@ -121,7 +130,7 @@ TDGeomFacet* TDGeomFacet::get_geom_facet( CubitFacet *facet_ptr )
 
 int TDGeomFacet::get_block_id( FacetEntity *facet_ptr )
 {
-  TDGeomFacet *td = (TDGeomFacet*) facet_ptr->get_TD(&TDGeomFacet::is_geom_facet);
+  TDGeomFacet *td = (TDGeomFacet*) facet_ptr->get_TD( &TDGeomFacet::is_geom_facet, TDGeomFacet::td_slot() );
   if ( td != NULL )
   {
     return td->get_block_id();
@@ -131,7 +140,7 @@ int TDGeomFacet::get_block_id( FacetEntity *facet_ptr )
 
 int TDGeomFacet::get_block_id( CubitFacet *facet_ptr )
 {
-  TDGeomFacet *td = (TDGeomFacet*) facet_ptr->get_TD(&TDGeomFacet::is_geom_facet);
+  TDGeomFacet *td = (TDGeomFacet*) facet_ptr->get_TD( &TDGeomFacet::is_geom_facet, TDGeomFacet::td_slot() );
   if ( td != NULL )
   {
     return td->get_block_id();
@@ -141,7 +150,7 @@ int TDGeomFacet::get_block_id( CubitFacet *facet_ptr )
 
 int TDGeomFacet::get_block_id( CubitFacetEdge *edge_ptr )
 {
-  TDGeomFacet *td = (TDGeomFacet*) edge_ptr->get_TD(&TDGeomFacet::is_geom_facet);
+  TDGeomFacet *td = (TDGeomFacet*) edge_ptr->get_TD( &TDGeomFacet::is_geom_facet, TDGeomFacet::td_slot() );
   if ( td != NULL )
   {
     return td->get_block_id();
@@ -185,7 +194,7 @@ void TDGeomFacet::add_cholla_surf( ChollaSurface *f_s_m )
 }
 int TDGeomFacet::get_hit_flag( FacetEntity *facet_ptr )
 {
-  TDGeomFacet *td = (TDGeomFacet*) facet_ptr->get_TD(&TDGeomFacet::is_geom_facet);
+  TDGeomFacet *td = (TDGeomFacet*) facet_ptr->get_TD( &TDGeomFacet::is_geom_facet, TDGeomFacet::td_slot() );
   if ( td != NULL )
   {
     return td->get_hit_flag();
@@ -194,7 +203,7 @@ int TDGeomFacet::get_hit_flag( FacetEntity *facet_ptr )
 }
 void TDGeomFacet::set_hit_flag( FacetEntity *facet_ptr, int new_val )
 {
-  TDGeomFacet *td = (TDGeomFacet*) facet_ptr->get_TD(&TDGeomFacet::is_geom_facet);
+  TDGeomFacet *td = (TDGeomFacet*) facet_ptr->get_TD( &TDGeomFacet::is_geom_facet, TDGeomFacet::td_slot() );
   if ( td != NULL )
   {
     td->set_hit_flag(new_val);
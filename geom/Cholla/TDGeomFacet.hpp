@@ -65,6 +65,10 @@ public:
   ~TDGeomFacet();
 
   static int is_geom_facet(const ToolData* td);
+
+  static int td_slot();
+  int user_slot() const { return td_slot(); }
+    //- the slot ToolDataUser keeps for this type
   
   int get_block_id()
     {return blockId;}
@@ -27,7 +27,7 @@
 #include "GeometryQueryEngine.hpp"
 #include "GeomSeg.hpp"
 #include "GeomPoint.hpp"
-#include "RTree.hpp"
+#include "PackedRTree.hpp"
 #include "AbstractTree.hpp"
 #include "IntersectionTool.hpp"
 #include "CpuTimer.hpp"
@@ -322,7 +322,7 @@ CubitStatus GeomMeasureTool::measure_face_loops( RefFace *face,
   {
     seg_list = boundary_seg_loops.get_and_step();
     creation_timer.cpu_secs();
-    curr_tree = new RTree<GeomSeg*>(GEOMETRY_RESABS);
+    curr_tree = new PackedRTree<GeomSeg*>(GEOMETRY_RESABS);
     creation_time += creation_timer.cpu_secs();
     for ( jj = seg_list->size(); jj > 0; jj-- )
     {
@@ -357,6 +357,7 @@ CubitStatus GeomMeasureTool::measure_face_loops( RefFace *face,
         }
       }
     }
+    curr_tree->balance();
     atree_list.append(curr_tree);
   }
   min_angle *= angle_convert;
@@ -3814,7 +3815,7 @@ void GeomMeasureTool::find_close_loops(RefFace *face,
   for (ii = 0; ii < boundary_seg_loops.size(); ii++ )
   {
     seg_list = boundary_seg_loops.get_and_step();
-    curr_tree = new RTree<GeomSeg*>(GEOMETRY_RESABS);
+    curr_tree = new PackedRTree<GeomSeg*>(GEOMETRY_RESABS);
     for ( jj = seg_list->size(); jj > 0; jj-- )
     {
         //build the r-tree.
@@ -3823,6 +3824,7 @@ void GeomMeasureTool::find_close_loops(RefFace *face,
       curr_tree->add(curr_seg);
         //calculate the interior angles.
     }
+    curr_tree->balance();
     atree_list.append(curr_tree);
   }
     //determine the minimum distance between the loops.
@@ -4916,9 +4918,10 @@ CubitStatus GeomMeasureTool::find_near_coincident_vertices(
   }
 
   //put all the vertices in a tree 
-  AbstractTree <RefVertex*> *a_tree = new RTree<RefVertex*>( high_tol ); 
+  AbstractTree <RefVertex*> *a_tree = new PackedRTree<RefVertex*>( high_tol ); 
   for (i=ref_verts.size(); i--;)
     a_tree->add(ref_verts.get_and_step());
+  a_tree->balance();
 
   std::multimap<double, dist_vert_struct> distance_vertex_map; 
 
@@ -5001,9 +5004,10 @@ CubitStatus GeomMeasureTool::find_near_coincident_vertices_unique(
   }
 
   //put all the vertices in a tree 
-  AbstractTree <RefVertex*> *a_tree = new RTree<RefVertex*>( high_tol ); 
+  AbstractTree <RefVertex*> *a_tree = new PackedRTree<RefVertex*>( high_tol ); 
   for (i=ref_verts.size(); i--;)
     a_tree->add(ref_verts.get_and_step());
+  a_tree->balance();
 
   //for each vertex
   for (i=ref_verts.size(); i--;)
@@ -5263,7 +5267,7 @@ CubitStatus GeomMeasureTool::find_near_coincident_vertex_curve_pairs(
   DLIList<RefVertex*> verts;
   DLIList<RefEdge*> curves;
 
-  RTree<RefEdge*> a_tree(high_tol);
+  PackedRTree<RefEdge*> a_tree(high_tol);
 
   int i,j;
   for( i=ref_vols.size(); i--; )
@@ -5403,7 +5407,7 @@ CubitStatus GeomMeasureTool::find_near_coincident_vertex_surface_pairs(
   DLIList<RefVertex*> verts;
   DLIList<RefFace*> faces;
 
-  AbstractTree<RefFace*> *a_tree = new RTree<RefFace*>( high_tol );
+  AbstractTree<RefFace*> *a_tree = new PackedRTree<RefFace*>( high_tol );
 
   int i,j;
   for( i=ref_vols.size(); i--; )
@@ -5420,6 +5424,7 @@ CubitStatus GeomMeasureTool::find_near_coincident_vertex_surface_pairs(
       a_tree->add( tmp_face );
     }
   }
+  a_tree->balance();
 
   ProgressTool *progress_ptr = NULL;
   int total_verts = verts.size();
@@ -331,6 +331,16 @@ public:
     //- hits to return (default = 0 = unlimited), and the ray radius to use for
     //- intersecting the entities (default = 0.0 = use modeller default).
 
+  virtual CubitBoolean prepare_concurrent_fire_ray(
+                         DLIList<TopologyBridge*> & /*at_entity_list*/ )
+    { return CUBIT_FALSE; }
+    //- Build anything fire_ray caches for the specified entities and return
+    //- CUBIT_TRUE if fire_ray may then be called on them from several
+    //- threads at once.  Called from a single thread before any rays are
+    //- scheduled; fire_ray must then only read those caches.  Used by
+    //- GeometryQueryTool::fire_rays; by default batched rays are fired
+    //- from the calling thread only.
+
   virtual CubitStatus get_isoparametric_points(Surface* ref_face_ptr,
                                                int &nu, int &nv,
                                                GMem *&gMem) const = 0;
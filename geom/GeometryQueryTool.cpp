@@ -82,6 +82,9 @@
 
 #include "GfxPreview.hpp" //DJQ
 #include "GfxDebug.hpp" //DJQ
+#include "CubitConcurrentApi.h"
+
+#include <algorithm>
 
 double GeometryQueryTool::geometryToleranceFactor = DEFAULT_GEOM_FACTOR;
 GeometryQueryTool* GeometryQueryTool::instance_ = 0;
@@ -766,6 +769,71 @@ CubitStatus GeometryQueryTool::fire_ray( CubitVector &origin,
   return CUBIT_SUCCESS;
 }
 
+//-------------------------------------------------------------------------
+// Purpose       : Find the visible TopologyEntity for a TopologyBridge hit
+//                 by a ray at the given location.  Hit entities may be
+//                 hidden under virtual entities.
+//
+// Special Notes :
+//
+// Creator       : Steve Storm
+//
+// Creation Date : 5/19/2007
+//-------------------------------------------------------------------------
+static TopologyEntity* visible_hit_entity( TopologyBridge *bridge_ptr,
+                                           CubitVector *loc_ptr )
+{
+  TopologyBridge *visible_tb = NULL;
+  TBOwner* o2 = bridge_ptr->owner();
+
+  bool broke_early = false;
+  BridgeManager* bridge_manager2;
+  while (!(bridge_manager2 = dynamic_cast<BridgeManager*>(o2)))
+  {
+    if (TopologyBridge* bridge2 = dynamic_cast<TopologyBridge*>(o2))
+    {
+      GeometryQueryEngine* gqe2 = bridge2->get_geometry_query_engine();
+
+      //Let the VQE handle the work
+      visible_tb = gqe2->get_visible_entity_at_point(bridge_ptr, loc_ptr);
+      if (visible_tb)
+        o2 = visible_tb->owner();
+      else
+        o2 = bridge2->owner();
+    }
+
+    else if(TBOwnerSet* set = dynamic_cast<TBOwnerSet*>(o2))
+    {
+      DLIList<TopologyBridge*> list2;
+      set->get_owners(list2);
+      list2.reset();
+
+      // This had better be the Virtual QE.
+      GeometryQueryEngine* gqe2 = list2.get()->get_geometry_query_engine();
+
+      //Let the VQE handle the work
+      visible_tb = gqe2->get_visible_entity_at_point(bridge_ptr, loc_ptr);
+      if (visible_tb)
+        o2 = visible_tb->owner();
+      else
+      {
+        broke_early = true;
+        break;
+      }
+    }
+    else
+    {
+      broke_early = true;
+      break;
+    }
+  }
+
+  if (!broke_early)
+    visible_tb = bridge_manager2->topology_bridge();
+
+  return visible_tb ? visible_tb->topology_entity() : 0;
+}
+
 //-------------------------------------------------------------------------
 // Purpose       : Fire a ray at a list of entities and return the
 //                 parameters along the ray (distance from origin of ray)
@@ -857,63 +925,7 @@ CubitStatus GeometryQueryTool::fire_ray( CubitVector &origin,
 	  for( i=0; i<tb_hit_list_ptr->size(); i++ )
 	  {
 		  bridge_ptr = tb_hit_list_ptr->get_and_step();
-
-		  TopologyBridge *visible_tb = NULL;
-		  TBOwner* o2 = bridge_ptr->owner();
-
-		  bool broke_early = false;
-		  BridgeManager* bridge_manager2;
-		  while (!(bridge_manager2 = dynamic_cast<BridgeManager*>(o2)))
-		  {
-			  if (TopologyBridge* bridge2 = dynamic_cast<TopologyBridge*>(o2))
-			  {
-				  GeometryQueryEngine* gqe2 = bridge2->get_geometry_query_engine();
-
-				  //Let the VQE handle the work
-				  visible_tb = gqe2->get_visible_entity_at_point(bridge_ptr, cv_list[i]);
-				  if (visible_tb)
-					  o2 = visible_tb->owner();
-				  else
-					  o2 = bridge2->owner();
-			  }
-
-			  else if(TBOwnerSet* set = dynamic_cast<TBOwnerSet*>(o2))
-			  {
-				  DLIList<TopologyBridge*> list2;
-				  set->get_owners(list2);
-				  list2.reset();
-
-				  // This had better be the Virtual QE.
-				  GeometryQueryEngine* gqe2 = list2.get()->get_geometry_query_engine();
-
-				  //Let the VQE handle the work
-				  visible_tb = gqe2->get_visible_entity_at_point(bridge_ptr, cv_list[i]);
-				  if (visible_tb)
-					  o2 = visible_tb->owner();
-				  else
-				  {
-					  broke_early = true;
-					  break;
-				  }
-			  }
-			  else
-			  {
-				  broke_early = true;
-				  break;
-			  }
-		  }
-
-		  if (!broke_early)
-			  visible_tb = bridge_manager2->topology_bridge();
-
-
-		  if( visible_tb )
-		  {
-			  topo_ptr = visible_tb->topology_entity();
-			  hit_entity_list_ptr->append( topo_ptr );
-		  }
-		  else
-			  hit_entity_list_ptr->append( 0 );
+		  hit_entity_list_ptr->append( visible_hit_entity( bridge_ptr, cv_list[i] ) );
 	  }
 
 
@@ -944,6 +956,211 @@ CubitStatus GeometryQueryTool::fire_ray( CubitVector &origin,
 	return CUBIT_SUCCESS;
 }
 
+//-------------------------------------------------------------------------
+// Purpose       : Holds the per-ray results of a fire_rays batch and
+//                 fires a contiguous range of rays at the entities of one
+//                 geometry engine.  Each range writes only the results of
+//                 its own rays, so ranges can run concurrently.
+//
+// Special Notes :
+//
+//-------------------------------------------------------------------------
+class FireRaysBatch
+{
+public:
+  FireRaysBatch( const std::vector<CubitVector> &origins,
+                 const std::vector<CubitVector> &directions,
+                 int max_hits, double ray_radius, bool want_hits )
+    : rayOrigins(origins), rayDirections(directions),
+      maxHits(max_hits), rayRadius(ray_radius), wantHits(want_hits),
+      rayParams(origins.size()), rayHits(origins.size()),
+      rayFailed(origins.size(), 0),
+      engine(NULL), atList(NULL)
+  {}
+
+  void set_targets( GeometryQueryEngine *gqe, DLIList<TopologyBridge*> *tb_list )
+  {
+    engine = gqe;
+    atList = tb_list;
+  }
+
+  void fire_range( std::pair<int,int> range )
+  {
+      // engines step through the target list, so each range needs its own
+    DLIList<TopologyBridge*> tb_list( *atList );
+    DLIList<double> params;
+    DLIList<TopologyBridge*> hits;
+    for( int r = range.first; r < range.second; r++ )
+    {
+      CubitVector origin( rayOrigins[r] ), direction( rayDirections[r] );
+      params.clean_out();
+      hits.clean_out();
+      if( engine->fire_ray( origin, direction, tb_list, params, maxHits,
+                            rayRadius, wantHits ? &hits : 0 ) == CUBIT_FAILURE )
+      {
+        rayFailed[r] = 1;
+        continue;
+      }
+
+      params.reset();
+      hits.reset();
+      for( int i = 0; i < params.size(); i++ )
+      {
+        rayParams[r].push_back( params.get_and_step() );
+        if( wantHits )
+          rayHits[r].push_back( i < hits.size() ? hits.get_and_step() : 0 );
+      }
+    }
+  }
+
+  const std::vector<CubitVector> &rayOrigins;
+  const std::vector<CubitVector> &rayDirections;
+  int maxHits;
+  double rayRadius;
+  bool wantHits;
+
+  std::vector<std::vector<double> > rayParams;
+  std::vector<std::vector<TopologyBridge*> > rayHits;
+  std::vector<char> rayFailed;
+
+  GeometryQueryEngine *engine;
+  DLIList<TopologyBridge*> *atList;
+};
+
+static bool hit_less( const std::pair<double, RefEntity*> &a,
+                      const std::pair<double, RefEntity*> &b )
+{
+  return a.first < b.first;
+}
+
+//-------------------------------------------------------------------------
+// Purpose       : Fire a batch of rays at a list of entities.
+//
+// Special Notes : The entities are grouped by geometry engine once for the
+//                 whole batch.  Rays are split into ranges run on the
+//                 CubitConcurrent pool for engines that allow concurrent
+//                 fire_ray calls; the result does not depend on how the
+//                 rays were split.
+//
+//-------------------------------------------------------------------------
+CubitStatus GeometryQueryTool::fire_rays( const std::vector<CubitVector> &origins,
+                                          const std::vector<CubitVector> &directions,
+                                          DLIList<RefEntity*> &at_entity_list,
+                                          std::vector<int> &offsets,
+                                          std::vector<double> &ray_params,
+                                          int max_hits,
+                                          double ray_radius,
+                                          std::vector<RefEntity*> *hit_entity_list_ptr )
+{
+  offsets.clear();
+  ray_params.clear();
+  if( hit_entity_list_ptr )
+    hit_entity_list_ptr->clear();
+
+  if( origins.size() != directions.size() )
+  {
+    PRINT_ERROR( "Number of ray origins and directions differ.\n" );
+    return CUBIT_FAILURE;
+  }
+
+  int i, j;
+  const int num_rays = (int)origins.size();
+
+  // Group the bridges by engine, keeping the order of first appearance
+  std::vector<GeometryQueryEngine*> engines;
+  std::vector<DLIList<TopologyBridge*> > engine_tbs;
+  at_entity_list.reset();
+  for( i=at_entity_list.size(); i--; )
+  {
+    TopologyEntity *topo_ptr = CAST_TO( at_entity_list.get_and_step(), TopologyEntity );
+    if( !topo_ptr )
+    {
+      PRINT_ERROR( "Couldnt get topo_ptr\n" );
+      continue;
+    }
+
+    GeometryQueryEngine *gqe = topo_ptr->get_geometry_query_engine();
+    if( !gqe )
+    {
+      PRINT_ERROR( "Unable to find geometry engine associated with an entity!\n" );
+      return CUBIT_FAILURE;
+    }
+
+    DLIList<TopologyBridge*> bridge_list;
+    topo_ptr->bridge_manager()->get_bridge_list( bridge_list );
+    bridge_list.reset();
+
+    for( j=0; j<(int)engines.size() && engines[j]!=gqe; j++ );
+    if( j == (int)engines.size() )
+    {
+      engines.push_back( gqe );
+      engine_tbs.push_back( DLIList<TopologyBridge*>() );
+    }
+    engine_tbs[j].append( bridge_list.get() );
+  }
+
+  FireRaysBatch batch( origins, directions, max_hits, ray_radius,
+                       hit_entity_list_ptr != NULL );
+
+  // An engine that cannot get its ray caches ready for concurrent
+  // queries has its rays fired one at a time
+  bool concurrent = CubitConcurrent::instance() &&
+                    CubitConcurrent::num_ranges( num_rays ) > 1;
+  for( j=0; j<(int)engines.size(); j++ )
+  {
+    batch.set_targets( engines[j], &engine_tbs[j] );
+    if( concurrent && engines[j]->prepare_concurrent_fire_ray( engine_tbs[j] ) )
+      CubitConcurrent::parallel_for_ranges( num_rays, batch, &FireRaysBatch::fire_range );
+    else
+      batch.fire_range( std::make_pair( 0, num_rays ) );
+
+    for( i=0; i<num_rays; i++ )
+      if( batch.rayFailed[i] )
+        return CUBIT_FAILURE;
+  }
+
+  // Map hits to visible entities, sort each ray's hits by distance and
+  // pack the result
+  offsets.reserve( num_rays + 1 );
+  offsets.push_back( 0 );
+  std::vector<std::pair<double, RefEntity*> > hits;
+  for( i=0; i<num_rays; i++ )
+  {
+    std::vector<double> &params = batch.rayParams[i];
+    hits.clear();
+    for( j=0; j<(int)params.size(); j++ )
+    {
+      RefEntity *ref_entity_ptr = 0;
+      if( hit_entity_list_ptr && batch.rayHits[i][j] )
+      {
+        CubitVector loc;
+        origins[i].next_point( directions[i], params[j], loc );
+        TopologyEntity *topo_ptr = visible_hit_entity( batch.rayHits[i][j], &loc );
+        ref_entity_ptr = CAST_TO( topo_ptr, RefEntity );
+      }
+      hits.push_back( std::make_pair( params[j], ref_entity_ptr ) );
+    }
+
+    // As in fire_ray, only the first hit at a given distance is kept
+    std::stable_sort( hits.begin(), hits.end(), hit_less );
+    int count = 0;
+    for( j=0; j<(int)hits.size(); j++ )
+    {
+      if( j && hits[j].first == hits[j-1].first )
+        continue;
+      if( max_hits > 0 && count == max_hits )
+        break;
+      ray_params.push_back( hits[j].first );
+      if( hit_entity_list_ptr )
+        hit_entity_list_ptr->push_back( hits[j].second );
+      count++;
+    }
+    offsets.push_back( (int)ray_params.size() );
+  }
+
+  return CUBIT_SUCCESS;
+}
+
 //-------------------------------------------------------------------------
 // Purpose       : Reads in geometry and creates the necessary Reference
 //                 entities associated with the input geometry. Has ability
@@ -20,6 +20,7 @@
 #include <typeinfo>
 #include <list>
 #include <set>
+#include <vector>
 #if !defined(WIN32)
 using std::type_info;
 #endif
@@ -508,6 +509,42 @@ public :
                         int max_hits = 0,
                         double ray_radius = 0.0,
                         DLIList<TopologyEntity*> *hit_entity_list_ptr = 0 );
+
+  /*!
+   * Fire a batch of rays at entities, passing back distances of hits and entities hit
+    * \arg origins
+    * origin of each ray
+    * \arg directions
+    * direction of each ray (same length as origins)
+    * \arg at_entity_list
+    * entities to fire rays at
+    * \arg offsets
+    * returned array of num_rays+1 offsets; the hits of ray i are
+    * ray_params[offsets[i]] up to ray_params[offsets[i+1]]
+    * \arg ray_params
+    * returned array of parameters (distances) along each ray at which entities were hit
+    * \arg max_hits
+    * maximum number of hits to return per ray, 0 = unlimited (default)
+    * \arg ray_radius
+    * radius of ray to use for intersecting entities, 0 = use engine default
+    * \arg hit_entity_list (pointer)
+    * entities hit by the rays (same length as ray_params), default NULL
+    * \return - error flag
+    *
+    *  Equivalent to calling fire_ray for each ray, but the entities are
+    *  grouped by geometry engine once for the batch and the rays are
+    *  fired concurrently when the engine allows it.  The hits of each ray
+    *  are sorted by distance.  Returned arrays are replaced, not appended to.
+    */
+  //! \brief Fire a batch of rays at entities, passing back distances of hits and entities hit
+  CubitStatus fire_rays( const std::vector<CubitVector> &origins,
+                         const std::vector<CubitVector> &directions,
+                         DLIList<RefEntity*> &at_entity_list,
+                         std::vector<int> &offsets,
+                         std::vector<double> &ray_params,
+                         int max_hits = 0,
+                         double ray_radius = 0.0,
+                         std::vector<RefEntity*> *hit_entity_list_ptr = 0 );
   
   //! \brief Debugging function.
   static void geom_debug( DLIList<TopologyEntity*> );
@@ -62,13 +62,17 @@
 #include "ProgressTool.hpp"
 #include "AppUtil.hpp"
 #include "CastTo.hpp"
-#include "RTree.hpp"
+#include "PackedRTree.hpp"
 #include "AbstractTree.hpp"
 #include "SettingHandler.hpp"
+#include "CubitConcurrentApi.h"
+
+#include <vector>
 
 MergeTool* MergeTool::instance_ = NULL;
 CubitBoolean MergeTool::groupResults = CUBIT_FALSE;
 CubitBoolean MergeTool::destroyDeadGeometry = CUBIT_TRUE;
+CubitBoolean MergeTool::concurrentCompare = CUBIT_FALSE;
 
 // Constructor
 MergeTool* MergeTool::instance()
@@ -80,6 +84,9 @@ MergeTool* MergeTool::instance()
 
 void MergeTool::initialize_settings( )
 {
+  SettingHandler::instance()->add_setting("Merge Concurrent Compare",
+                                          MergeTool::set_concurrent_compare,
+                                          MergeTool::get_concurrent_compare);
 }
 
 MergeTool::MergeTool()
@@ -702,7 +709,7 @@ CubitStatus MergeTool::merge_reffaces( DLIList<RefFace*>& refface_list,
     // since it is invalid. So...we need to remove it from the
     // tree, but still keep track of where we are in the list.
   double geom_factor = GeometryQueryTool::get_geometry_factor();
-  RTree<RefFace*> a_tree(GEOMETRY_RESABS*geom_factor);
+  PackedRTree<RefFace*> a_tree(GEOMETRY_RESABS*geom_factor);
 //  AbstractTree <RefFace*> *a_tree = new RTree<RefFace*> (GEOMETRY_RESABS*geom_factor);
   CpuTimer timer;
   int merge_count = 0;
@@ -723,6 +730,7 @@ CubitStatus MergeTool::merge_reffaces( DLIList<RefFace*>& refface_list,
       a_tree.add(curr_face);
     }
   }
+  a_tree.balance();
   PRINT_DEBUG_3( "Time to build r_tree %f secs, with %d entries\n",
                  time_to_build.cpu_secs(), refface_array.size() );
 
@@ -1035,6 +1043,129 @@ CubitStatus MergeTool::find_mergeable_refentities( DLIList<RefEntity*> &entities
   return CUBIT_SUCCESS;
 }
 
+//-------------------------------------------------------------------------
+// Purpose       : Read-only comparison of each surface against the
+//                 candidates found for it in an R-tree, for
+//                 find_mergeable_reffaces.
+//
+// Special Notes : the R-tree is packed before the batch runs and the
+//                 surfaces are neither merged nor deactivated until the
+//                 serial loop after it, so the ranges of surfaces can be
+//                 compared on the CubitConcurrent pool.  Each surface's
+//                 candidates are stored in its own slot.  The topology
+//                 queries rely on ModelQueryEngine keeping its traversal
+//                 state per thread.
+//
+//                 Comparisons are done without notifying the RefEntities,
+//                 so no compare data is created.  A comparison that fails
+//                 after matching some of the loops would have notified
+//                 the curves and vertices of those loops, which later
+//                 curve and vertex merging depends on, so only failures
+//                 found before the loops are compared are kept; the
+//                 serial loop compares the rest again.
+//
+//-------------------------------------------------------------------------
+class FaceCompareBatch
+{
+public:
+  FaceCompareBatch( DRefFaceArray &faces, PackedRTree<RefFace*> &tree,
+                    double geom_factor )
+    : refFaces(faces), aTree(tree), geomFactor(geom_factor),
+      results(faces.size()), evaluated(faces.size(), 0)
+  {
+    testBbox = GeometryQueryTool::instance()->get_merge_test_bbox();
+    testInternal = GeometryQueryTool::instance()->get_merge_test_internal();
+  }
+
+  void compare_range( std::pair<int,int> range )
+  {
+    DLIList<RefFace*> faces_in_range;
+    DLIList<RefVolume*> tmp_vols;
+    for( int i = range.first; i < range.second; i++ )
+    {
+      if( AppUtil::instance()->interrupt() )
+        return;
+
+      RefFace *refface_ptr = refFaces[i];
+      if( refface_ptr->deactivated() == CUBIT_TRUE )
+        continue;
+
+      faces_in_range.clean_out();
+      aTree.find( refface_ptr->bounding_box(), faces_in_range );
+
+      tmp_vols.clean_out();
+      refface_ptr->ref_volumes( tmp_vols );
+      RefVolume* tmp_vol = tmp_vols.get();
+
+      for( int j = faces_in_range.size(); j--; )
+      {
+        RefFace *compare_refface_ptr = faces_in_range.get_and_step();
+        if( compare_refface_ptr == refface_ptr ||
+            compare_refface_ptr->deactivated() == CUBIT_TRUE )
+          continue;
+
+        tmp_vols.clean_out();
+        compare_refface_ptr->ref_volumes( tmp_vols );
+        if( tmp_vol == tmp_vols.get() )
+          continue;
+
+        if( differ_before_loops( refface_ptr, compare_refface_ptr ) )
+          results[i].push_back( std::make_pair( compare_refface_ptr, CUBIT_FALSE ) );
+        else if( refface_ptr->about_spatially_equal( compare_refface_ptr, geomFactor,
+                                                     CUBIT_FALSE, testBbox,
+                                                     testInternal ) )
+          results[i].push_back( std::make_pair( compare_refface_ptr, CUBIT_TRUE ) );
+      }
+      evaluated[i] = 1;
+    }
+  }
+
+  bool lookup( int i, RefFace *compare_refface_ptr, CubitBoolean &status ) const
+  {
+    if( !evaluated[i] )
+      return false;
+    for( size_t j = 0; j < results[i].size(); j++ )
+    {
+      if( results[i][j].first == compare_refface_ptr )
+      {
+        status = results[i][j].second;
+        return true;
+      }
+    }
+    return false;
+  }
+    //- Gets the result of comparing surface i with compare_refface_ptr,
+    //- if it was computed and needs no notifying comparison.
+
+private:
+  bool differ_before_loops( RefFace *face_1, RefFace *face_2 ) const
+  {
+    if( !face_1->bounding_box().overlap( geomFactor * GEOMETRY_RESABS,
+                                         face_2->bounding_box() ) )
+      return true;
+    DLIList<RefEdge*> edges_1, edges_2;
+    face_1->ref_edges( edges_1 );
+    face_2->ref_edges( edges_2 );
+    if( edges_1.size() != edges_2.size() )
+      return true;
+    DLIList<Loop*> loops_1, loops_2;
+    face_1->loops( loops_1 );
+    face_2->loops( loops_2 );
+    return loops_1.size() != loops_2.size();
+  }
+    //- The tests RefFace::about_spatially_equal makes before comparing
+    //- any loops, and so before it can notify any RefEntity.
+
+  DRefFaceArray &refFaces;
+  PackedRTree<RefFace*> &aTree;
+  double geomFactor;
+  CubitBoolean testBbox;
+  int testInternal;
+
+  std::vector<std::vector<std::pair<RefFace*, CubitBoolean> > > results;
+  std::vector<char> evaluated;
+};
+
 CubitStatus MergeTool::find_mergeable_reffaces( DLIList<RefEntity*> &entities,
                                                 DLIList< DLIList<RefFace*>*> &lists_of_mergeable_ref_faces,
                                                 bool clean_up_compare_data )
@@ -1052,7 +1183,7 @@ CubitStatus MergeTool::find_mergeable_reffaces( DLIList<RefEntity*> &entities,
   }
 
   double geom_factor = GeometryQueryTool::get_geometry_factor();
-  RTree<RefFace*> a_tree(GEOMETRY_RESABS*geom_factor);
+  PackedRTree<RefFace*> a_tree(GEOMETRY_RESABS*geom_factor);
 //  AbstractTree <RefFace*> *a_tree = new RTree<RefFace*> (GEOMETRY_RESABS*geom_factor);
   
   DRefFaceArray refface_array( refface_list.size() );
@@ -1070,6 +1201,7 @@ CubitStatus MergeTool::find_mergeable_reffaces( DLIList<RefEntity*> &entities,
       a_tree.add(curr_face);
     }
   }
+  a_tree.balance();
   PRINT_DEBUG_3( "Time to build r_tree %f secs, with %d entries\n",
                  time_to_build.cpu_secs(), refface_array.size() );
 
@@ -1090,6 +1222,16 @@ CubitStatus MergeTool::find_mergeable_reffaces( DLIList<RefEntity*> &entities,
                        info, CUBIT_TRUE, CUBIT_TRUE );
     }
   }
+
+    // Compare every surface with the candidates from the tree up front,
+    // in parallel.  The loop below still walks the surfaces in order and
+    // makes the same decisions, looking the comparisons up instead of
+    // doing them.
+  FaceCompareBatch compare_batch( refface_array, a_tree, geom_factor );
+  if( concurrentCompare && CubitConcurrent::instance() &&
+      CubitConcurrent::num_ranges( array_size, 4 ) > 1 )
+    CubitConcurrent::parallel_for_ranges( array_size, compare_batch,
+                                          &FaceCompareBatch::compare_range, 4 );
   
     // Now find overlapping RefFaces and merge them.
     // Make sure that the operation is not performed on
@@ -1146,12 +1288,27 @@ CubitStatus MergeTool::find_mergeable_reffaces( DLIList<RefEntity*> &entities,
         continue;
       
       geom_factor = GeometryQueryTool::get_geometry_factor();
-      CubitBoolean status =
+      CubitBoolean status = CUBIT_TRUE;
+      CubitBoolean test_bbox = GeometryQueryTool::instance()->get_merge_test_bbox();
+      int test_internal = GeometryQueryTool::instance()->get_merge_test_internal();
+      if( compare_batch.lookup( i, compare_refface_ptr, status ) )
+      {
+        if( status == CUBIT_FALSE )
+          continue;
+
+          // The surfaces already passed the box and interior tests; only
+          // the loop comparison is repeated, to notify the RefEntities.
+        test_bbox = CUBIT_FALSE;
+        test_internal = 0;
+      }
+
+        // Compare again for a match to notify the RefEntities.
+      status =
         refface_ptr->about_spatially_equal( compare_refface_ptr,
                                             geom_factor,
                                             CUBIT_TRUE,
-                                            GeometryQueryTool::instance()->get_merge_test_bbox(),
-                                            GeometryQueryTool::instance()->get_merge_test_internal() );
+                                            test_bbox,
+                                            test_internal );
       if( status == CUBIT_FALSE )
         continue;
       
@@ -1633,10 +1790,11 @@ CubitStatus MergeTool::find_only_mergeable_curves( DLIList<Curve*> &all_curves,
     geom_factor = input_tol/GEOMETRY_RESABS;
 
   //build up a tree for speed purposes
-  RTree<Curve*> a_tree(GEOMETRY_RESABS*geom_factor);
+  PackedRTree<Curve*> a_tree(GEOMETRY_RESABS*geom_factor);
   //AbstractTree <Curve*> *a_tree = new RTree<Curve*> (GEOMETRY_RESABS*geom_factor);
   for( i=all_curves.size(); i--; )
     a_tree.add( all_curves.get_and_step() );
+  a_tree.balance();
 
   std::map< Curve*, DLIList<Curve*>*> curve_to_list_map;
   std::map< Curve*, DLIList<Curve*>*>::iterator list_iter; 
@@ -1936,7 +2094,7 @@ CubitStatus MergeTool::merge_refedges( DLIList<RefEdge*>& refedge_list,
   CpuTimer timer;
 
   double geom_factor = GeometryQueryTool::get_geometry_factor();
-  RTree<RefEdge*> a_tree(GEOMETRY_RESABS*geom_factor);
+  PackedRTree<RefEdge*> a_tree(GEOMETRY_RESABS*geom_factor);
   //AbstractTree <RefEdge*> *a_tree = new RTree<RefEdge*> (GEOMETRY_RESABS*geom_factor);
 
   DRefEdgeArray refedge_array( refedge_list.size() );
@@ -1955,6 +2113,7 @@ CubitStatus MergeTool::merge_refedges( DLIList<RefEdge*>& refedge_list,
       a_tree.add(curr_edge);
     }
   }
+  a_tree.balance();
 
     //initialize the marked flag for fast nulification...
   int array_size = refedge_array.size();
@@ -2474,7 +2633,7 @@ CubitStatus MergeTool::merge_refvertices( DLIList<RefVertex*>& refvertex_list,
   
   double geom_factor = GeometryQueryTool::get_geometry_factor();
   double tol = GEOMETRY_RESABS*geom_factor;
-  RTree<RefVertex*> a_tree(GEOMETRY_RESABS*geom_factor);
+  PackedRTree<RefVertex*> a_tree(GEOMETRY_RESABS*geom_factor);
 //  AbstractTree <RefVertex*> *a_tree = new RTree<RefVertex*> ( tol );
   DRefVertexArray refvertex_array( refvertex_list.size() );
   refvertex_list.reset();
@@ -4093,7 +4252,7 @@ void MergeTool::test_r_tree(DLIList <RefFace*> &refface_list)
   timer.cpu_secs();
   double geom_factor = GeometryQueryTool::get_geometry_factor();
   double tol = GEOMETRY_RESABS*geom_factor;
-  RTree<RefFace*> a_tree(GEOMETRY_RESABS*geom_factor);
+  PackedRTree<RefFace*> a_tree(GEOMETRY_RESABS*geom_factor);
 //  AbstractTree <RefFace*> *a_tree = new RTree<RefFace*> (tol);
   
   DRefFaceArray refface_array( refface_list.size() );
@@ -271,6 +271,17 @@ class CUBIT_GEOM_EXPORT MergeTool
   static void destroy_dead_geometry( CubitBoolean yes_no )
     { destroyDeadGeometry = yes_no; }
 
+  //@{
+  //! Get/Sets flag for comparing candidate surfaces on the CubitConcurrent
+  //! pool when finding mergeable surfaces ("Merge Concurrent Compare"
+  //! setting).  Only enable this if the geometry engines involved allow
+  //! concurrent read-only queries.
+  static void set_concurrent_compare( CubitBoolean value )
+    { concurrentCompare = value; }
+  static CubitBoolean get_concurrent_compare()
+    { return concurrentCompare; }
+  //@}
+
   //! This function is to be used only right
   //! after merging is called.  It is a way to
   //! access the groups that are created during the
@@ -439,6 +450,9 @@ class CUBIT_GEOM_EXPORT MergeTool
                                          bool faces_reversed );
    
    static CubitBoolean destroyDeadGeometry;
+
+   static CubitBoolean concurrentCompare;
+    //- Compare candidate surfaces concurrently in find_mergeable_reffaces.
    
    static MergeTool* instance_;
      // Static pointer to unique instance of this class
@@ -66,8 +66,7 @@
 //-------------------------------------------------------------------------
 
 ModelEntity::ModelEntity() : 
-    deactivatedStatus_(CUBIT_FALSE),
-    encountered_(CUBIT_FALSE)
+    deactivatedStatus_(CUBIT_FALSE)
 {
 }
 
@@ -100,10 +100,6 @@ protected:
    
    cBit deactivatedStatus_ : 1;
      //- The deactivated flag
-   
-   cBit encountered_ : 1;
-    // Indicates if it has already been found in 
-    // in a DAG query.  
 
 
 
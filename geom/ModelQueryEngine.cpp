@@ -24,6 +24,8 @@
 // ********** BEGIN STANDARD INCLUDES      **********
 
 #include <stdio.h>
+#include <stdint.h>
+#include <vector>
 
 // ********** END STANDARD INCLUDES        **********
 
@@ -60,6 +62,93 @@
 
 ModelQueryEngine* ModelQueryEngine::instance_ = NULL;
 
+//-------------------------------------------------------------------------
+// Purpose       : State of the queries running on one thread.
+//
+// Special Notes : The encountered nodes are kept in an open addressing
+//                 hash set whose slots are stamped with a generation
+//                 number.  A slot is in use only if its stamp matches the
+//                 current generation, so the set is cleared at the end of
+//                 a query by bumping the generation.
+//
+//-------------------------------------------------------------------------
+struct ModelQueryState
+{
+  struct Slot
+  {
+    ModelEntity* node;
+    unsigned int generation;
+  };
+
+  int callStackDepth;
+  unsigned int generation;
+  int count;
+  int hashBits;
+  std::vector<Slot> slots;
+
+  DLIList<ModelEntity*> intermediateNodeSets[2];
+
+  ModelQueryState()
+    : callStackDepth(0), generation(1), count(0), hashBits(0)
+  {
+    resize( 6 );
+  }
+
+  size_t index( ModelEntity* node ) const
+  {
+    uint64_t key = (uint64_t)(uintptr_t)node;
+    return (size_t)((key * 0x9E3779B97F4A7C15ULL) >> (64 - hashBits));
+  }
+
+  void resize( int bits )
+  {
+    std::vector<Slot> old_slots;
+    old_slots.swap( slots );
+    Slot empty = { NULL, 0 };
+    slots.assign( (size_t)1 << bits, empty );
+    hashBits = bits;
+    count = 0;
+    for( size_t i = 0; i < old_slots.size(); i++ )
+      if( old_slots[i].generation == generation )
+        insert( old_slots[i].node );
+  }
+
+  bool insert( ModelEntity* node )
+  {
+    if( 2 * (count + 1) > (int)slots.size() )
+      resize( hashBits + 1 );
+
+    size_t mask = slots.size() - 1;
+    for( size_t i = index( node ); ; i = (i + 1) & mask )
+    {
+      Slot& slot = slots[i];
+      if( slot.generation != generation )
+      {
+        slot.node = node;
+        slot.generation = generation;
+        count++;
+        return false;
+      }
+      if( slot.node == node )
+        return true;
+    }
+  }
+
+  void clear()
+  {
+    count = 0;
+    if( ++generation == 0 )
+    {
+        // wrapped around, so old stamps could look current
+      for( size_t i = 0; i < slots.size(); i++ )
+        slots[i].generation = 0;
+      generation = 1;
+    }
+  }
+};
+
+static thread_local ModelQueryState queryState;
+
 // ********** END STATIC DECLARATIONS      **********
 
 // ********** BEGIN PUBLIC FUNCTIONS       **********
@@ -112,7 +201,7 @@ ModelQueryEngine::~ModelQueryEngine()
 //
 // Creation Date : 06/08/96
 //-------------------------------------------------------------------------
-ModelQueryEngine::ModelQueryEngine() : queryCallStackDepth(0)
+ModelQueryEngine::ModelQueryEngine()
 {
 }
 
@@ -242,6 +331,7 @@ CubitStatus ModelQueryEngine::query_append_children (
   assert(current_type.is_valid() && target_type.is_valid());
   assert(current_type > target_type);
   
+  DLIList<ModelEntity*>* intermediateNodeSets = queryState.intermediateNodeSets;
   intermediateNodeSets[0].clean_out();
   intermediateNodeSets[0].append(&source_object);
   int current_index = 0;
@@ -288,6 +378,7 @@ CubitStatus ModelQueryEngine::query_append_parents(
   assert(current_type.is_valid() && target_type.is_valid());
   assert(current_type < target_type);
   
+  DLIList<ModelEntity*>* intermediateNodeSets = queryState.intermediateNodeSets;
   intermediateNodeSets[0].clean_out();
   intermediateNodeSets[0].append(&source_object);
   int current_index = 0;
@@ -324,26 +415,20 @@ CubitStatus ModelQueryEngine::query_append_parents(
 //-------------------------------------------------------------------------
 bool ModelQueryEngine::encountered( ModelEntity* node_ptr )
 {
-  if (node_ptr->encountered_)
-    return true;
-  
-  encounteredSet.append(node_ptr);
-  node_ptr->encountered_ = true;
-  return false;
+  return queryState.insert( node_ptr );
 }
 
 void ModelQueryEngine::inc_query_call_stack()
 {
-  queryCallStackDepth++;
+  queryState.callStackDepth++;
 }
 
 void ModelQueryEngine::dec_query_call_stack()
 {
-  assert(queryCallStackDepth > 0);
-  queryCallStackDepth--;
-  if (queryCallStackDepth == 0)
-    while (encounteredSet.size())
-      encounteredSet.pop()->encountered_ = CUBIT_FALSE;
+  assert(queryState.callStackDepth > 0);
+  queryState.callStackDepth--;
+  if (queryState.callStackDepth == 0)
+    queryState.clear();
 }
 
 // ********** BEGIN PRIVATE FUNCTIONS      **********
@@ -24,6 +24,11 @@
 //                 (ERD) of the different ModelEntity classes is maintained
 //                 by a class called ModelERD.
 //
+//                 Queries may run concurrently on different threads.  The
+//                 state of a query (the nodes already encountered and the
+//                 intermediate node sets) is kept per thread, so queries
+//                 never write to the ModelEntities they traverse.
+//
 // Creator       : Xuechen Liu 
 //
 // Creation Date : 06/08/96
@@ -155,15 +160,16 @@ class CUBIT_GEOM_EXPORT ModelQueryEngine
 
 
       bool encountered( ModelEntity* );
-        //- Mark node as encountered if it was not already encountered.
+        //- Mark node as encountered if it was not already encountered
+        //- in the current query on this thread.
         //- Return the previous value of the encountered flag.
   
       class BeginQuery {
         public:
           inline BeginQuery()
-            { ModelQueryEngine::instance()->inc_query_call_stack(); }
+            { ModelQueryEngine::inc_query_call_stack(); }
           inline ~BeginQuery()
-            { ModelQueryEngine::instance()->dec_query_call_stack(); }
+            { ModelQueryEngine::dec_query_call_stack(); }
           inline void* operator new(size_t /*size*/)
             { assert(0); return (void*)0; }
       };
@@ -181,15 +187,10 @@ class CUBIT_GEOM_EXPORT ModelQueryEngine
       
       friend class ModelQueryEngine::BeginQuery;
 
-      void inc_query_call_stack();
-      void dec_query_call_stack();
-      
-      int queryCallStackDepth;
-      
-      DLIList<ModelEntity*> encounteredSet; 
-     // A set of marked ModelEntities.
-    
-      DLIList<ModelEntity*> intermediateNodeSets[2];
+      static void inc_query_call_stack();
+      static void dec_query_call_stack();
+        //- Track the nesting of queries on this thread.  The encountered
+        //- marks are cleared when the outermost query returns.
 
    private:
 
@@ -36,6 +36,7 @@
 #include "OCCLump.hpp"
 #include "OCCModifyEngine.hpp"
 #include "OCCAttribSet.hpp"
+#include "OCCRayTree.hpp"
 
 #include <TopExp.hxx>
 #include <TopTools_IndexedMapOfShape.hxx>
@@ -66,6 +67,7 @@
 OCCBody::OCCBody(TopoDS_Compound *theShape, 
                  OCCSurface* surface, OCCShell* shell, Lump* lump)
 {
+  myRayTree = NULL;
   myTopoDSShape = theShape;
   if (surface != NULL)
     mySheetSurfaces.append(surface);
@@ -137,6 +139,8 @@ CubitBoolean OCCBody::is_sheet_body()
 
 void OCCBody::set_TopoDS_Shape( TopoDS_Compound& theshape)
 {
+  clear_ray_tree();
+
   if(!theshape.IsNull())
     assert(theshape.ShapeType() == TopAbs_COMPOUND);
 
@@ -168,6 +172,7 @@ OCCBody::OCCBody(DLIList<Lump*>& my_lumps,
                  DLIList<OCCShell*>& shells,
                  DLIList<OCCSurface*>& surfaces)
 {
+  myRayTree = NULL;
   myLumps = my_lumps;
   mySheetSurfaces = surfaces;
   myShells = shells;
@@ -213,6 +218,7 @@ TopoDS_Compound* OCCBody::make_Compound(DLIList<Lump*>& my_lumps,
 
 OCCBody::~OCCBody() 
 {
+  clear_ray_tree();
   if (myTopoDSShape)
   {
     myTopoDSShape->Nullify();
@@ -221,6 +227,29 @@ OCCBody::~OCCBody()
   }
 }
 
+OCCRayTree* OCCBody::ray_tree()
+{
+  if (myRayTree)
+    return myRayTree;
+
+  myRayTree = new OCCRayTree(this);
+  if (myRayTree->build() != CUBIT_SUCCESS)
+  {
+    clear_ray_tree();
+    return NULL;
+  }
+  return myRayTree;
+}
+
+void OCCBody::clear_ray_tree()
+{
+  if (myRayTree)
+  {
+    delete myRayTree;
+    myRayTree = NULL;
+  }
+}
+
 GeometryQueryEngine* OCCBody::get_geometry_query_engine() const
 {
   return OCCQueryEngine::instance();
@@ -474,6 +503,9 @@ CubitStatus OCCBody::update_OCC_entity( BRepBuilderAPI_ModifyShape *aBRepTrsf,
 {
   assert(aBRepTrsf != NULL || op != NULL);
 
+  OCCQueryEngine::instance()->shape_changed();
+  clear_ray_tree();
+
   TopoDS_Compound compsolid;
   TopoDS_Shape shape;
   shape = aBRepTrsf->Shape();
@@ -43,6 +43,7 @@ class BRepBuilderAPI_MakeShape;
 class LocOpe_SplitShape;
 class TopoDS_Shape;
 class TopoDS_Compound;
+class OCCRayTree;
 // ********** END FORWARD DECLARATIONS     **********
 
 class OCCBody : public BodySM
@@ -196,6 +197,14 @@ public:
                                         DLIList<OCCSurface*>& surfaces);
 
   CubitStatus transform(BRepBuilderAPI_Transform& aBRepTrsf); 
+
+  OCCRayTree* ray_tree();
+    //- Ray-fire tree over this body's faces, built on first use and
+    //- kept until one of those faces or the body's shape is replaced.
+    //- NULL if the body has no faces to triangulate.
+
+  void clear_ray_tree();
+    //- Discard the ray-fire tree.
 protected: 
 private:
 
@@ -210,6 +219,8 @@ private:
   DLIList<OCCSurface*> mySheetSurfaces;
 
   DLIList<OCCShell*>  myShells; 
+
+  OCCRayTree* myRayTree;
 };
 
 
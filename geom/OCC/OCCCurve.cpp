@@ -182,6 +182,7 @@ void OCCCurve::set_TopoDS_Edge(TopoDS_Edge edge)
     }
   }
  
+  propertyCache.clear();
   if(myTopoDSEdge)
     myTopoDSEdge->Nullify();
   *myTopoDSEdge = edge;
@@ -277,12 +278,18 @@ GeometryQueryEngine* OCCCurve::get_geometry_query_engine() const
 //-------------------------------------------------------------------------
 CubitBox OCCCurve::bounding_box() const 
 {
+  CubitBox box;
+  if (propertyCache.get_box(box))
+    return box;
+
   BRepAdaptor_Curve acurve(*myTopoDSEdge);
   Bnd_Box aBox;
   BndLib_Add3dCurve::Add(acurve, Precision::Approximation(), aBox);
   double min[3], max[3];
   aBox.Get( min[0], min[1], min[2], max[0], max[1], max[2]);
-  return CubitBox(min, max);
+  box.reset(min, max);
+  propertyCache.set_box(box);
+  return box;
 }
 
 
@@ -297,9 +304,15 @@ CubitBox OCCCurve::bounding_box() const
 //-------------------------------------------------------------------------
 double OCCCurve::measure()
 {
+  double length;
+  if (propertyCache.get_measure(length))
+    return length;
+
   GProp_GProps myProps;
   BRepGProp::LinearProperties(*myTopoDSEdge, myProps);
-  return myProps.Mass();
+  length = myProps.Mass();
+  propertyCache.set_measure(length);
+  return length;
 }
 
 //-------------------------------------------------------------------------
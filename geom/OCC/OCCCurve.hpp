@@ -20,6 +20,7 @@
 // ********** BEGIN CUBIT INCLUDES         **********
 #include "CubitDefines.h"
 #include "Curve.hpp"
+#include "OCCPropertyCache.hpp"
 #include "TopoDS_Edge.hxx"
 // ********** END CUBIT INCLUDES           **********
 
@@ -361,6 +362,8 @@ private:
   void adjust_periodic_parameter(double& param);
   
   TopoDS_Edge *myTopoDSEdge;
+  mutable OCCPropertyCache propertyCache;
+    //- Bounding box and length of myTopoDSEdge.
   DLIList<OCCLoop*> myLoopList;
   bool periodic;
   CubitBoolean myMarked ;
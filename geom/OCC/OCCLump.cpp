@@ -92,6 +92,7 @@ void OCCLump::set_TopoDS_Solid(TopoDS_Solid solid)
   if(myTopoDSSolid && solid.IsEqual(*myTopoDSSolid) )
     return;
 
+  propertyCache.clear();
   if(myTopoDSSolid)
     myTopoDSSolid->Nullify() ;
 
@@ -112,11 +113,17 @@ CubitStatus OCCLump::mass_properties( CubitVector& centroid,
   if (mySheetSurface || myShell)
     return CUBIT_FAILURE;
 
+  if (propertyCache.get_centroid(centroid) &&
+      propertyCache.get_measure(volume))
+    return CUBIT_SUCCESS;
+
   GProp_GProps myProps;
   BRepGProp::VolumeProperties(*myTopoDSSolid, myProps);
   volume = myProps.Mass();
   gp_Pnt pt = myProps.CentreOfMass();
   centroid.set(pt.X(), pt.Y(), pt.Z());
+  propertyCache.set_measure(volume);
+  propertyCache.set_centroid(centroid);
 
   return CUBIT_SUCCESS;
 }
@@ -241,7 +248,12 @@ CubitBox OCCLump::bounding_box() const
   else if(myShell)
     shape = *(myShell->get_TopoDS_Shell());
   else
+  {
+    CubitBox cBox;
+    if (propertyCache.get_box(cBox))
+      return cBox;
     shape =*myTopoDSSolid;
+  }
 
   //calculate the bounding box
   BRepBndLib::Add(shape, box);
@@ -252,6 +264,8 @@ CubitBox OCCLump::bounding_box() const
 
   //update boundingbox.
   CubitBox cBox(min, max);
+  if(!mySheetSurface && !myShell)
+    propertyCache.set_box(cBox);
   return cBox;
 }
 
@@ -283,9 +297,15 @@ double OCCLump::measure()
   else if(myShell)
     return myShell->measure();
 
+  double volume;
+  if (propertyCache.get_measure(volume))
+    return volume;
+
   GProp_GProps myProps;
   BRepGProp::VolumeProperties(*myTopoDSSolid, myProps);
-  return myProps.Mass();
+  volume = myProps.Mass();
+  propertyCache.set_measure(volume);
+  return volume;
 }
 
 void OCCLump::get_parents_virt(DLIList<TopologyBridge*> &bodies) 
@@ -19,6 +19,7 @@
 // ********** BEGIN CUBIT INCLUDES         **********
 #include "CubitDefines.h"
 #include "Lump.hpp"
+#include "OCCPropertyCache.hpp"
 #include <stdio.h>
 #include "TopoDS_Solid.hxx"
 // ********** END CUBIT INCLUDES           **********
@@ -160,6 +161,9 @@ private:
   BodySM *myBodyPtr;
 
   TopoDS_Solid *myTopoDSSolid;
+  mutable OCCPropertyCache propertyCache;
+    //- Bounding box, volume and centroid of myTopoDSSolid; sheet and
+    //- shell lumps use their surface's or shell's values instead.
 
   OCCSurface *mySheetSurface;
   OCCShell * myShell;
@@ -0,0 +1,129 @@
+//-------------------------------------------------------------------------
+// Filename      : OCCPropertyCache.cpp
+//
+// Purpose       : Lazily filled cache of the derived geometric properties
+//                 of an OCC entity.
+//
+// Special Notes : A value is published by setting its valid bit with
+//                 release ordering after the value is written; a lookup
+//                 that sees the bit with acquire ordering may read the
+//                 value without locking.  Stores to the same cache are
+//                 serialized by a small pool of striped locks.
+//
+//-------------------------------------------------------------------------
+
+#include "OCCPropertyCache.hpp"
+#include "OCCQueryEngine.hpp"
+
+#include <mutex>
+#include <stdint.h>
+
+static std::atomic<unsigned long> cacheHits(0);
+static std::atomic<unsigned long> cacheMisses(0);
+
+static const int NUM_STORE_LOCKS = 64;
+static std::mutex storeLocks[NUM_STORE_LOCKS];
+
+static std::mutex& store_lock( const void* cache )
+{
+  return storeLocks[((uintptr_t)cache >> 4) % NUM_STORE_LOCKS];
+}
+
+static unsigned long current_epoch()
+{
+  return OCCQueryEngine::instance()->shape_epoch() << 8;
+}
+
+OCCPropertyCache::OCCPropertyCache()
+  : myState(0), myMeasure(0.0)
+{
+}
+
+bool OCCPropertyCache::lookup( unsigned long bit ) const
+{
+  unsigned long state = myState.load( std::memory_order_acquire );
+  if( (state & bit) && (state & ~0xFFUL) == current_epoch() )
+  {
+    cacheHits.fetch_add( 1, std::memory_order_relaxed );
+    return true;
+  }
+  cacheMisses.fetch_add( 1, std::memory_order_relaxed );
+  return false;
+}
+
+void OCCPropertyCache::begin_store()
+{
+  store_lock( this ).lock();
+}
+
+void OCCPropertyCache::end_store( unsigned long bit )
+{
+  unsigned long state = myState.load( std::memory_order_relaxed );
+  unsigned long epoch = current_epoch();
+  if( (state & ~0xFFUL) != epoch )
+    state = epoch;
+  myState.store( state | bit, std::memory_order_release );
+  store_lock( this ).unlock();
+}
+
+bool OCCPropertyCache::get_box( CubitBox& box ) const
+{
+  if( !lookup( BOX ) )
+    return false;
+  box.reset( boxMin, boxMax );
+  return true;
+}
+
+void OCCPropertyCache::set_box( const CubitBox& box )
+{
+  begin_store();
+  box.minimum().get_xyz( boxMin );
+  box.maximum().get_xyz( boxMax );
+  end_store( BOX );
+}
+
+bool OCCPropertyCache::get_measure( double& measure ) const
+{
+  if( !lookup( MEASURE ) )
+    return false;
+  measure = myMeasure;
+  return true;
+}
+
+void OCCPropertyCache::set_measure( double measure )
+{
+  begin_store();
+  myMeasure = measure;
+  end_store( MEASURE );
+}
+
+bool OCCPropertyCache::get_centroid( CubitVector& centroid ) const
+{
+  if( !lookup( CENTROID ) )
+    return false;
+  centroid.set( myCentroid );
+  return true;
+}
+
+void OCCPropertyCache::set_centroid( const CubitVector& centroid )
+{
+  begin_store();
+  centroid.get_xyz( myCentroid );
+  end_store( CENTROID );
+}
+
+unsigned long OCCPropertyCache::hit_count()
+{
+  return cacheHits.load();
+}
+
+unsigned long OCCPropertyCache::miss_count()
+{
+  return cacheMisses.load();
+}
+
+void OCCPropertyCache::reset_counters()
+{
+  cacheHits.store( 0 );
+  cacheMisses.store( 0 );
+}
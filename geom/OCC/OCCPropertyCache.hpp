@@ -0,0 +1,68 @@
+//-------------------------------------------------------------------------
+// Filename      : OCCPropertyCache.hpp
+//
+// Purpose       : Lazily filled cache of the derived geometric properties
+//                 (bounding box, measure, centroid) of an OCC entity.
+//
+// Special Notes : Each value is stamped with the OCCQueryEngine shape
+//                 epoch when it is stored, so any update of the OCC shapes
+//                 (update_OCC_map or a transform) invalidates every cache
+//                 at once.  Owners also clear() their cache when their own
+//                 shape is replaced.
+//
+//                 Lookups may run concurrently with each other and with
+//                 fills; invalidation must not overlap either, which holds
+//                 since it only happens while the model is being modified.
+//
+//-------------------------------------------------------------------------
+
+#ifndef OCC_PROPERTY_CACHE_HPP
+#define OCC_PROPERTY_CACHE_HPP
+
+#include "CubitBox.hpp"
+#include "CubitVector.hpp"
+#include <atomic>
+
+class OCCPropertyCache
+{
+public:
+  OCCPropertyCache();
+
+  void clear() { myState.store( 0, std::memory_order_relaxed ); }
+    //- Discard every cached value.
+
+  bool get_box( CubitBox& box ) const;
+  void set_box( const CubitBox& box );
+    //- Bounding box.  get_ returns false (a miss) if not cached.
+
+  bool get_measure( double& measure ) const;
+  void set_measure( double measure );
+    //- Length, area or volume, depending on the owner.
+
+  bool get_centroid( CubitVector& centroid ) const;
+  void set_centroid( const CubitVector& centroid );
+    //- Center of mass.
+
+  static unsigned long hit_count();
+  static unsigned long miss_count();
+  static void reset_counters();
+    //- Lookups answered from / not found in any cache since the last reset.
+
+private:
+
+  enum { BOX = 1, MEASURE = 2, CENTROID = 4 };
+
+  bool lookup( unsigned long bit ) const;
+  void begin_store();
+  void end_store( unsigned long bit );
+
+  // (shape epoch << 8) | valid bits
+  std::atomic<unsigned long> myState;
+
+  double boxMin[3], boxMax[3];
+  double myMeasure;
+  double myCentroid[3];
+};
+
+#endif
+
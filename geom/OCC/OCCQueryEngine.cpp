@@ -94,6 +94,7 @@
 #include "OCCLump.hpp"
 #include "OCCBody.hpp"
 #include "OCCAttribSet.hpp"
+#include "OCCRayTree.hpp"
 #include "GMem.hpp"
 #include "GeometryQueryTool.hpp"
 #include "CubitObserver.hpp"
@@ -179,6 +180,7 @@ OCCQueryEngine::OCCQueryEngine()
   MyDF = new TDocStd_Document(xString);
   mainLabel = MyDF->Main();
   EXPORT_ATTRIB = CUBIT_TRUE;
+  shapeEpoch = 0;
 }
 
 //================================================================================
@@ -3455,20 +3457,41 @@ CubitStatus OCCQueryEngine::fire_ray(  CubitVector &origin,
 
   //- fire a ray at the specified body, returning the entities hit and
   //- the parameters along the ray; return CUBIT_FAILURE if error
-  // - line body intersection. 
+  // - bodies are intersected through their ray tree: a BVH over the
+  //   face triangulations selects the faces near the ray and only those
+  //   are intersected exactly.  Other entities fall back to a line
+  //   body intersection.
+  if (ray_radius != 0.0)
+  {
+    PRINT_ERROR("Firing a ray with a nonzero radius is not supported for OCC bodies.\n");
+    return CUBIT_FAILURE;
+  }
   gp_Pnt p(origin.x(), origin.y(), origin.z());
   gp_Dir dir(direction.x(), direction.y(), direction.z());
   gp_Lin L(p, dir);
-  TopoDS_Edge edge = BRepBuilderAPI_MakeEdge(L); 
+  TopoDS_Edge edge;
   
+  at_entity_list.reset();
   for(int i = 0; i < at_entity_list.size(); i++)
   {
     TopologyBridge* tb = at_entity_list.get_and_step();
-    TopoDS_Shape *shape;
     OCCBody *occBody = CAST_TO(tb, OCCBody);
     if (occBody )
     {
+      OCCRayTree* tree = occBody->ray_tree();
+      if (tree)
+      {
+        tree->fire_ray(origin, direction, ray_params, max_hits,
+                       hit_entity_list_ptr);
+        continue;
+      }
+
+      TopoDS_Shape *shape;
       occBody->get_TopoDS_Shape(shape);
+      if (!shape || shape->IsNull())
+        continue;
+      if (edge.IsNull())
+        edge = BRepBuilderAPI_MakeEdge(L);
     
       BRepExtrema_DistShapeShape distShapeShape(edge, *shape);
       //distShapeShape.Perform();
@@ -3481,19 +3504,40 @@ CubitStatus OCCQueryEngine::fire_ray(  CubitVector &origin,
       if (distShapeShape.Value() < get_sme_resabs_tolerance())
       {
         int numPnt = distShapeShape.NbSolution();
-        for (int i = 1; i <= numPnt; i++)
+        for (int j = 1; j <= numPnt; j++)
         {
 	  double para;
-	  distShapeShape.ParOnEdgeS1(i , para);
+	  distShapeShape.ParOnEdgeS1(j , para);
 	  ray_params.append(para);
+          if (hit_entity_list_ptr)
+            hit_entity_list_ptr->append(tb);
         }
-        hit_entity_list_ptr->append(tb);
       } 
     }
   }
   return status;
 }
 
+//-------------------------------------------------------------------------
+// Purpose       : build the ray trees used by fire_ray so that rays can be
+//                 fired at the bodies from several threads.
+//
+// Special Notes : other entities use the serial line-shape intersection.
+//
+//-------------------------------------------------------------------------
+CubitBoolean OCCQueryEngine::prepare_concurrent_fire_ray(
+                                DLIList<TopologyBridge*> &at_entity_list )
+{
+  at_entity_list.reset();
+  for(int i = 0; i < at_entity_list.size(); i++)
+  {
+    OCCBody *occBody = CAST_TO(at_entity_list.get_and_step(), OCCBody);
+    if (!occBody || !occBody->ray_tree())
+      return CUBIT_FALSE;
+  }
+  return CUBIT_TRUE;
+}
+
 double OCCQueryEngine::get_sme_resabs_tolerance() const
 {
   return Precision::Confusion(); 
@@ -3698,6 +3742,7 @@ CubitStatus OCCQueryEngine::update_entity_shape(GeometryEntity* entity_ptr,
 					BRepBuilderAPI_ModifyShape* aBRepTrsf,
                                         BRepAlgoAPI_BooleanOperation *op)
 {
+  shape_changed();
   if (OCCBody *body_ptr = CAST_TO( entity_ptr, OCCBody))
     {
       body_ptr->update_OCC_entity(aBRepTrsf, op);
@@ -3943,6 +3988,8 @@ int OCCQueryEngine::update_OCC_map(TopoDS_Shape& old_shape,
       old_shape.IsEqual(new_shape))
     return -1;
 
+  shapeEpoch++;
+
   //update the attribute label tree
   int current_id = OCCMap->Find(old_shape);
   std::map<int, TDF_Label>::iterator it_lab =
@@ -119,6 +119,15 @@ public:
 
   int update_OCC_map(TopoDS_Shape& old_shape, TopoDS_Shape& new_shape);
 
+  unsigned long shape_epoch() const { return shapeEpoch; }
+    //- Incremented whenever update_OCC_map replaces a shape or an entity
+    //- is transformed; cached derived data (OCCPropertyCache)
+    //- compares against it to detect that the shapes it was built from
+    //- have changed.
+
+  void shape_changed() { shapeEpoch++; }
+    //- Invalidate cached derived data after modifying shapes in place.
+
   virtual ~OCCQueryEngine();
   
   const char* modeler_type()
@@ -212,6 +221,11 @@ public:
     //- hits to return (default = 0 = unlimited), and the ray radius to use for
     //- intersecting the entities (default = 0.0 = use modeller default).
 
+  virtual CubitBoolean prepare_concurrent_fire_ray(
+                         DLIList<TopologyBridge*> &at_entity_list );
+    //- Build the ray trees of the bodies in at_entity_list.  Returns
+    //- CUBIT_TRUE if every entity is a body with a ray tree.
+
   virtual CubitStatus get_isoparametric_points(Surface* ,
                                                int&, int&,
                                                GMem*&) const;
@@ -463,6 +477,8 @@ private:
 
   static OCCQueryEngine* instance_;
     //- static pointer to unique instance of this class
+
+  unsigned long shapeEpoch;
 };
 
 // ********** BEGIN INLINE FUNCTIONS          **********
@@ -0,0 +1,206 @@
+//-------------------------------------------------------------------------
+// Filename      : OCCRayTree.cpp
+//
+// Purpose       : Ray-fire acceleration structure for an OCCBody.
+//
+// Special Notes :
+//
+//-------------------------------------------------------------------------
+
+#include "OCCRayTree.hpp"
+#include "OCCBody.hpp"
+#include "OCCSurface.hpp"
+#include "OCCQueryEngine.hpp"
+#include "GMem.hpp"
+#include "DLIList.hpp"
+#include "CubitBox.hpp"
+
+#include "BRep_Tool.hxx"
+#include "TopoDS_Face.hxx"
+#include "TopLoc_Location.hxx"
+#include "Poly_Triangulation.hxx"
+#include "Handle_Poly_Triangulation.hxx"
+#include "IntCurvesFace_Intersector.hxx"
+#include "gp_Lin.hxx"
+#include "gp_Pnt.hxx"
+#include "gp_Dir.hxx"
+#include "TopAbs_State.hxx"
+#include "Precision.hxx"
+
+#include <algorithm>
+#include <math.h>
+#include <utility>
+
+OCCRayTree::OCCRayTree( OCCBody* body )
+  : myBody(body), myTolerance(0.0)
+{
+}
+
+OCCRayTree::~OCCRayTree()
+{
+  clear();
+}
+
+void OCCRayTree::clear()
+{
+  for( size_t i = 0; i < myIntersectors.size(); i++ )
+    delete myIntersectors[i];
+  myIntersectors.clear();
+  myLocks.reset();
+  for( size_t i = 0; i < myFaces.size(); i++ )
+    if( myFaces[i]->ray_tree_body() == myBody )
+      myFaces[i]->set_ray_tree_body( NULL );
+  myFaces.clear();
+  triFace.clear();
+  myBVH.clear();
+}
+
+CubitStatus OCCRayTree::build()
+{
+  clear();
+
+  DLIList<OCCSurface*> surfaces;
+  myBody->get_all_surfaces( surfaces );
+  if( !surfaces.size() )
+    return CUBIT_FAILURE;
+
+    // mesh relative to the body size, unless the faces already
+    // carry a triangulation (e.g. from graphics)
+  CubitBox box = myBody->get_bounding_box();
+  double deflection = 1.0e-3 * box.diagonal().length();
+  if( deflection <= 0.0 )
+    deflection = 0.01;
+
+  std::vector<double> coords;
+  std::vector<int> conn;
+  double max_deflection = 0.0;
+
+  surfaces.reset();
+  for( int i = 0; i < surfaces.size(); i++ )
+  {
+    OCCSurface* surface = surfaces.get_and_step();
+    TopoDS_Face* face = surface->get_TopoDS_Face();
+    GMem g_mem;
+    if( !face || OCCQueryEngine::instance()->get_graphics( face, &g_mem, 15,
+                                              deflection ) != CUBIT_SUCCESS )
+      continue;
+
+    TopLoc_Location L;
+    Handle_Poly_Triangulation facets = BRep_Tool::Triangulation( *face, L );
+    if( !facets.IsNull() && facets->Deflection() > max_deflection )
+      max_deflection = facets->Deflection();
+
+    int face_index = (int)myFaces.size();
+    myFaces.push_back( surface );
+    surface->set_ray_tree_body( myBody );
+
+    int offset = (int)coords.size() / 3;
+    GPoint* pts = g_mem.point_list();
+    for( int j = 0; j < g_mem.pointListCount; j++ )
+    {
+      coords.push_back( pts[j].x );
+      coords.push_back( pts[j].y );
+      coords.push_back( pts[j].z );
+    }
+
+    int* flist = g_mem.facet_list();
+    for( int j = 0; j + 3 < g_mem.fListCount; j += flist[j] + 1 )
+    {
+      if( flist[j] != 3 )
+        continue;
+      conn.push_back( offset + flist[j+1] );
+      conn.push_back( offset + flist[j+2] );
+      conn.push_back( offset + flist[j+3] );
+      triFace.push_back( face_index );
+    }
+  }
+
+  if( triFace.empty() )
+    return CUBIT_FAILURE;
+
+  myIntersectors.resize( myFaces.size(), (IntCurvesFace_Intersector*)NULL );
+  myLocks.reset( new std::mutex[myFaces.size()] );
+  myTolerance = max_deflection + OCCQueryEngine::instance()->get_sme_resabs_tolerance();
+
+  myBVH.build( &coords[0], (int)coords.size()/3, &conn[0], (int)triFace.size() );
+  return CUBIT_SUCCESS;
+}
+
+int OCCRayTree::fire_ray( const CubitVector& origin,
+                          const CubitVector& direction,
+                          DLIList<double>& ray_params,
+                          int max_hits,
+                          DLIList<TopologyBridge*>* hit_entity_list )
+{
+  if( myBVH.empty() || direction.length_squared() < CUBIT_RESABS*CUBIT_RESABS )
+    return 0;
+
+    // candidate faces from the facets near the line, on both sides of
+    // the origin
+  std::vector<TriangleBVH::RayHit> tri_hits;
+  myBVH.fire_ray( origin, direction, tri_hits, myTolerance );
+  myBVH.fire_ray( origin, -direction, tri_hits, myTolerance );
+  if( tri_hits.empty() )
+    return 0;
+
+  std::vector<int> candidates;
+  candidates.reserve( tri_hits.size() );
+  for( size_t i = 0; i < tri_hits.size(); i++ )
+    candidates.push_back( triFace[tri_hits[i].triangle] );
+  std::sort( candidates.begin(), candidates.end() );
+  candidates.erase( std::unique( candidates.begin(), candidates.end() ),
+                    candidates.end() );
+
+    // refine against the exact faces
+  gp_Lin line( gp_Pnt( origin.x(), origin.y(), origin.z() ),
+               gp_Dir( direction.x(), direction.y(), direction.z() ) );
+  double resabs = OCCQueryEngine::instance()->get_sme_resabs_tolerance();
+
+  std::vector<double> hits;
+  for( size_t i = 0; i < candidates.size(); i++ )
+  {
+    int f = candidates[i];
+    std::lock_guard<std::mutex> lock( myLocks[f] );
+    if( !myIntersectors[f] )
+      myIntersectors[f] = new IntCurvesFace_Intersector( *myFaces[f]->get_TopoDS_Face(),
+                                                          resabs );
+    IntCurvesFace_Intersector* intersector = myIntersectors[f];
+    intersector->Perform( line, -Precision::Infinite(), Precision::Infinite() );
+    if( !intersector->IsDone() )
+      continue;
+    for( int j = 1; j <= intersector->NbPnt(); j++ )
+    {
+      TopAbs_State state = intersector->State( j );
+      if( state != TopAbs_IN && state != TopAbs_ON )
+        continue;
+      hits.push_back( intersector->WParameter( j ) );
+    }
+  }
+
+    // the body is the entity hit, so a point on an edge or vertex shared
+    // by several faces is one hit
+  std::sort( hits.begin(), hits.end() );
+  size_t num_hits = 0;
+  for( size_t i = 0; i < hits.size(); i++ )
+    if( !num_hits || hits[i] - hits[num_hits-1] > resabs )
+      hits[num_hits++] = hits[i];
+
+    // keep the max_hits hits closest to the origin
+  size_t first = 0;
+  if( max_hits > 0 )
+    while( num_hits - first > (size_t)max_hits )
+    {
+      if( fabs( hits[first] ) > fabs( hits[num_hits-1] ) )
+        first++;
+      else
+        num_hits--;
+    }
+
+  for( size_t i = first; i < num_hits; i++ )
+  {
+    ray_params.append( hits[i] );
+    if( hit_entity_list )
+      hit_entity_list->append( myBody );
+  }
+  return (int)(num_hits - first);
+}
@@ -0,0 +1,74 @@
+//-------------------------------------------------------------------------
+// Filename      : OCCRayTree.hpp
+//
+// Purpose       : Ray-fire acceleration structure for an OCCBody.
+//
+//                 A TriangleBVH is built once over the triangulation of
+//                 every face of the body.  A ray is fired at the BVH
+//                 with a tolerance covering the triangulation deflection
+//                 to collect candidate faces, and only those faces are
+//                 intersected exactly with IntCurvesFace_Intersector.
+//
+// Special Notes : Each face the tree was built from records the body as
+//                 the owner of its ray tree.  Replacing the shape of one
+//                 of those faces, or deleting it, discards the body's
+//                 tree, which is rebuilt on next use; other bodies' trees
+//                 are unaffected.
+//
+//                 Once built, fire_ray may be called from several threads
+//                 at once; each face's exact intersector is locked while
+//                 in use.
+//
+//-------------------------------------------------------------------------
+
+#ifndef OCC_RAY_TREE_HPP
+#define OCC_RAY_TREE_HPP
+
+#include "CubitDefines.h"
+#include "CubitVector.hpp"
+#include "TriangleBVH.hpp"
+#include <vector>
+#include <memory>
+#include <mutex>
+
+class OCCBody;
+class OCCSurface;
+class TopologyBridge;
+class IntCurvesFace_Intersector;
+template <class X> class DLIList;
+
+class OCCRayTree
+{
+public:
+  OCCRayTree( OCCBody* body );
+  ~OCCRayTree();
+
+  CubitStatus build();
+    //- (Re)build the tree from the body's current face triangulations.
+
+  int fire_ray( const CubitVector& origin,
+                const CubitVector& direction,
+                DLIList<double>& ray_params,
+                int max_hits,
+                DLIList<TopologyBridge*>* hit_entity_list );
+    //- Append exact hits of the line through origin, in both directions:
+    //- the signed distance along the normalized direction, and the body
+    //- as the entity hit, sorted by distance.  With max_hits > 0 only the
+    //- hits closest to the origin are kept.  Returns the number of hits
+    //- appended.
+
+private:
+
+  void clear();
+
+  OCCBody* myBody;
+  TriangleBVH myBVH;
+  std::vector<int> triFace;                     // triangle -> face index
+  std::vector<OCCSurface*> myFaces;
+  std::vector<IntCurvesFace_Intersector*> myIntersectors;  // built lazily
+  std::unique_ptr<std::mutex[]> myLocks;        // one per face
+  double myTolerance;
+};
+
+#endif
+
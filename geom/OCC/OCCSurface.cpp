@@ -100,6 +100,7 @@ OCCSurface::OCCSurface(TopoDS_Face *theFace)
   myShell = NULL;
   myLump = NULL;
   myBody = NULL;
+  myRayTreeBody = NULL;
   if(myTopoDSFace && !myTopoDSFace->IsNull())
     assert(myTopoDSFace->ShapeType() == TopAbs_FACE);
 }
@@ -107,6 +108,8 @@ OCCSurface::OCCSurface(TopoDS_Face *theFace)
 
 OCCSurface::~OCCSurface() 
 {
+  if(myRayTreeBody)
+    myRayTreeBody->clear_ray_tree();
   if(myTopoDSFace)
   {
     myTopoDSFace->Nullify();
@@ -120,6 +123,9 @@ void OCCSurface::set_TopoDS_Face(TopoDS_Face& face)
   if(myTopoDSFace && face.IsEqual(*myTopoDSFace))
     return;
 
+  propertyCache.clear();
+  if(myRayTreeBody)
+    myRayTreeBody->clear_ray_tree();
   if(myTopoDSFace)
     myTopoDSFace->Nullify();
   *myTopoDSFace = face ;
@@ -254,13 +260,19 @@ GeometryType OCCSurface::geometry_type()
 //-------------------------------------------------------------------------
 CubitBox OCCSurface::bounding_box() const 
 {
+  CubitBox box;
+  if (propertyCache.get_box(box))
+    return box;
+
   TopoDS_Face face = *myTopoDSFace;
   BRepAdaptor_Surface asurface(face);
   Bnd_Box aBox;
   BndLib_AddSurface::Add(asurface, Precision::Approximation(), aBox);
   double min[3], max[3];
   aBox.Get( min[0], min[1], min[2], max[0], max[1], max[2]);
-  return CubitBox(min, max);
+  box.reset(min, max);
+  propertyCache.set_box(box);
+  return box;
 }
 
 
@@ -744,9 +756,15 @@ CubitBoolean OCCSurface::get_param_range_V( double& lower_bound,
 //-------------------------------------------------------------------------
 double OCCSurface::measure() 
 {
+  double area;
+  if (propertyCache.get_measure(area))
+    return area;
+
   GProp_GProps myProps;
   BRepGProp::SurfaceProperties(*myTopoDSFace, myProps);
-  return myProps.Mass();
+  area = myProps.Mass();
+  propertyCache.set_measure(area);
+  return area;
 }
 
 //-------------------------------------------------------------------------
@@ -755,10 +773,16 @@ double OCCSurface::measure()
 //-------------------------------------------------------------------------
 CubitVector OCCSurface::center_point()
 {
+  CubitVector v;
+  if (propertyCache.get_centroid(v))
+    return v;
+
   GProp_GProps myProps;
   BRepGProp::SurfaceProperties(*myTopoDSFace, myProps);
   gp_Pnt pt = myProps.CentreOfMass();
-  CubitVector v(pt.X(),pt.Y(), pt.Z());
+  v.set(pt.X(),pt.Y(), pt.Z());
+  propertyCache.set_centroid(v);
+  propertyCache.set_measure(myProps.Mass());
   return v; 
 }
 
@@ -30,6 +30,7 @@
 
 #include "CubitDefines.h"
 #include "Surface.hpp"
+#include "OCCPropertyCache.hpp"
 
 // ********** END CUBIT INCLUDES          **********
 
@@ -345,6 +346,13 @@ public :
 
   OCCBody* my_body() {return myBody;}
 
+  void set_ray_tree_body(OCCBody* body)
+  { myRayTreeBody = body;}
+
+  OCCBody* ray_tree_body() {return myRayTreeBody;}
+    //- The body whose ray tree was built from this face.  That tree is
+    //- discarded when this face's shape is replaced or the face deleted.
+
   CubitStatus get_bodies(DLIList<OCCBody*> &bodies);
 
   virtual CubitBoolean is_parametric();
@@ -523,12 +531,17 @@ private:
 
   TopoDS_Face *myTopoDSFace;
 
+  mutable OCCPropertyCache propertyCache;
+    //- Bounding box, area and center of mass of myTopoDSFace.
+
   //Following 3 members are only for sheeted body.
   OCCShell* myShell;
   OCCLump* myLump;
   OCCBody* myBody;
   DLIList<OCCPoint*> myHardPoints;
 
+  OCCBody* myRayTreeBody;
+
 };
 
 
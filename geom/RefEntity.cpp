@@ -60,6 +60,15 @@
 // ********** END CUBIT INCLUDES           **********
 
 // ********** BEGIN STATIC DECLARATIONS    **********
+
+// looked up for every entity compared by the MergeTool
+// registered the first time it is needed, which is before any is added
+int TDCompare::td_slot()
+{
+  static int slot = ToolDataUser::register_TD_type( &TDCompare::is_compare );
+  return slot;
+}
+
 // ********** END STATIC DECLARATIONS      **********
 
 // ********** BEGIN PUBLIC FUNCTIONS       **********
@@ -868,7 +877,7 @@ void RefEntity::comparison_found(RefEntity* partner)
 
 void RefEntity::add_compare_data(RefEntity* partner) 
 {
-  TDCompare* compareDataPtr = (TDCompare*)(this->get_TD(&TDCompare::is_compare));
+  TDCompare* compareDataPtr = (TDCompare*)(this->get_TD( &TDCompare::is_compare, TDCompare::td_slot() ));
   if (compareDataPtr == NULL)
   {
     compareDataPtr = new TDCompare() ;
@@ -877,7 +886,7 @@ void RefEntity::add_compare_data(RefEntity* partner)
   compareDataPtr->set_compare_partner(partner) ;
   
   
-  compareDataPtr = (TDCompare*)(partner->get_TD(&TDCompare::is_compare));
+  compareDataPtr = (TDCompare*)(partner->get_TD( &TDCompare::is_compare, TDCompare::td_slot() ));
   if (compareDataPtr == NULL)
   {
     compareDataPtr = new TDCompare() ;
@@ -898,7 +907,7 @@ void RefEntity::add_compare_data(RefEntity* partner)
 
 void RefEntity::remove_compare_data()
 {
-  ToolData* tdPtr = this->get_TD(&TDCompare::is_compare) ;
+  ToolData* tdPtr = this->get_TD( &TDCompare::is_compare, TDCompare::td_slot() ) ;
   TDCompare* tdComparePtr = CAST_TO(tdPtr, TDCompare) ;
   
   if (tdComparePtr == NULL)
@@ -925,7 +934,7 @@ void RefEntity::remove_compare_data()
 
 RefEntity* RefEntity::get_compare_partner()
 {
-  ToolData* tdPtr = get_TD(&TDCompare::is_compare) ;
+  ToolData* tdPtr = get_TD( &TDCompare::is_compare, TDCompare::td_slot() ) ;
   TDCompare* tdComparePtr = CAST_TO(tdPtr, TDCompare) ;
   return tdComparePtr ? tdComparePtr->get_compare_partner() : 0;
 }
@@ -1130,6 +1139,9 @@ void RefEntity::set_id(int i, CubitBoolean emit_event )
 
   if( emit_event )
     AppUtil::instance()->send_event(this, IdSetEvent( old_id, entityId ) );
+  else
+      // the factory still has to re-index the entity under its new id
+    RefEntityFactory::instance()->notify_observer(this, IdSetEvent( old_id, entityId ) );
 
   int old_max = RefEntityFactory::instance()->maximum_id(this);
   
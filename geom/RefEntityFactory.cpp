@@ -8,6 +8,8 @@
 #include "GeometryQueryTool.hpp"
 #include "DLIList.hpp"
 #include "AppUtil.hpp"
+#include "RefEntityIdTable.hpp"
+#include "IdSetEvent.hpp"
 
 static int sort_by_ascending_ids(CubitEntity*& a, CubitEntity*& b)
 {
@@ -17,54 +19,6 @@ static int sort_by_ascending_ids(CubitEntity*& a, CubitEntity*& b)
     return 1;
 } 
 
-static int sort_by_ascending_ids(RefVertex*& a, RefVertex*& b)
-{
-  if( a->id() < b->id() ) 
-    return -1;
-  else
-    return 1;
-} 
-
-static int sort_by_ascending_ids(RefVolume*& a, RefVolume*& b)
-{
-  if( a->id() < b->id() )
-    return -1;
-  else
-    return 1;
-} 
-
-static int sort_by_ascending_ids(RefEdge*& a, RefEdge*& b)
-{
-  if( a->id() < b->id() )
-    return -1;
-  else
-    return 1;
-} 
-
-static int sort_by_ascending_ids(RefFace*& a, RefFace*& b)
-{
-  if( a->id() < b->id() )
-    return -1;
-  else
-    return 1;
-} 
-
-static int sort_by_ascending_ids(Body*& a, Body*& b)
-{
-  if( a->id() < b->id() )
-    return -1;
-  else
-    return 1;
-} 
-
-static int sort_by_ascending_ids(RefGroup*& a, RefGroup*& b)
-{
-  if( a->id() < b->id() )
-    return -1;
-  else
-    return 1;
-} 
-
 RefEntityFactory *RefEntityFactory::instance_ = NULL;
 
 RefEntityFactory *RefEntityFactory::instance()
@@ -84,12 +38,12 @@ RefEntityFactory::RefEntityFactory(RefEntityFactory *factory)
 
 
   if (factory == NULL) {
-    refVertexList = new DLIList<RefVertex*>();
-    refEdgeList = new DLIList<RefEdge*>();
-    refFaceList = new DLIList<RefFace*>();
-    refGroupList = new DLIList<RefGroup*>();
-    refVolumeList = new DLIList<RefVolume*>();
-    bodyList = new DLIList<Body*>();
+    refVertexList = new RefEntityIdTable();
+    refEdgeList = new RefEntityIdTable();
+    refFaceList = new RefEntityIdTable();
+    refGroupList = new RefEntityIdTable();
+    refVolumeList = new RefEntityIdTable();
+    bodyList = new RefEntityIdTable();
     register_observer(this);
   }
   else {
@@ -101,12 +55,6 @@ RefEntityFactory::RefEntityFactory(RefEntityFactory *factory)
     bodyList = NULL;
   }
 
-  refVertexListIsSorted = true;
-  refEdgeListIsSorted = true;
-  refFaceListIsSorted = true;
-  refVolumeListIsSorted = true;
-  bodyListIsSorted = true;
-  refGroupListIsSorted = true;
   ManageListSorting = true;
   
   reset_ids();
@@ -187,22 +135,22 @@ CubitStatus RefEntityFactory::ref_entity_list( char const* keyword,
                                                const CubitBoolean print_errors )
 {
    if ( !strcmp( keyword, "body" ) || !strcmp( keyword, "Body" )) {
-     CAST_LIST_TO_PARENT((*bodyList), entity_list) ;
+     bodyList->entities(entity_list);
    }
    else if ( !strcmp( keyword, "curve" ) || !strcmp( keyword, "Curve" ) ) {
-     CAST_LIST_TO_PARENT((*refEdgeList), entity_list) ;
+     refEdgeList->entities(entity_list);
    }
    else if ( !strcmp( keyword, "volume" ) || !strcmp( keyword, "Volume" ) ) {
-     CAST_LIST_TO_PARENT((*refVolumeList), entity_list) ; 
+     refVolumeList->entities(entity_list); 
    }
    else if ( !strcmp( keyword, "vertex" ) || !strcmp( keyword, "Vertex" ) ) {
-     CAST_LIST_TO_PARENT((*refVertexList), entity_list) ;
+     refVertexList->entities(entity_list);
    }
    else if ( !strcmp( keyword, "surface" ) || !strcmp( keyword, "Surface" ) ) {
-     CAST_LIST_TO_PARENT((*refFaceList), entity_list) ; 
+     refFaceList->entities(entity_list); 
    }
    else if ( !strcmp( keyword, "group" ) || !strcmp( keyword, "Group" ) ) {
-     CAST_LIST_TO_PARENT((*refGroupList), entity_list) ;
+     refGroupList->entities(entity_list);
    }
    else 
    {
@@ -248,82 +196,46 @@ void RefEntityFactory::add(RefEntity* ref_entity)
 
 void RefEntityFactory::add(RefGroup* refGPtr)
 {
-   assert(!refGroupList->is_in_list(refGPtr));
-   if(refGroupList->size() > 0)
-   {
-    refGroupList->last();
-    if(ManageListSorting && refGPtr->id() < refGroupList->get()->id())
-      refGroupListIsSorted = false;
-   }
-   refGroupList->append(refGPtr);
+   assert(!refGroupList->contains(refGPtr));
+   refGroupList->add(refGPtr, ManageListSorting);
    if (refGPtr->id() > maxRefGroupId) maxRefGroupId = refGPtr->id();
 }
 
 void RefEntityFactory::add(Body* bodyPtr)
 {
-   assert(!bodyList->is_in_list(bodyPtr));
-   if(bodyList->size() > 0)
-   {
-    bodyList->last();
-    if(ManageListSorting && bodyPtr->id() < bodyList->get()->id())
-      bodyListIsSorted = false;
-   }
-   bodyList->append(bodyPtr);
+   assert(!bodyList->contains(bodyPtr));
+   bodyList->add(bodyPtr, ManageListSorting);
    if (bodyPtr->id() > maxBodyId) maxBodyId = bodyPtr->id();
 }
 
 void RefEntityFactory::add(RefVolume* refVPtr)
 {
-   assert(!refVolumeList->is_in_list(refVPtr));
-   if(refVolumeList->size() > 0)
-   {
-    refVolumeList->last();
-    if(ManageListSorting && refVPtr->id() < refVolumeList->get()->id())
-      refVolumeListIsSorted = false;
-   }
-   refVolumeList->append(refVPtr);
+   assert(!refVolumeList->contains(refVPtr));
+   refVolumeList->add(refVPtr, ManageListSorting);
    if (refVPtr->id() > maxRefVolumeId)
        maxRefVolumeId = refVPtr->id();
 }
 
 void RefEntityFactory::add(RefFace* refFPtr)
 {
-   assert(!refFaceList->is_in_list(refFPtr));
-   if(refFaceList->size() > 0)
-   {
-    refFaceList->last();
-    if(ManageListSorting && refFPtr->id() < refFaceList->get()->id())
-      refFaceListIsSorted = false;
-   }
-   refFaceList->append(refFPtr);
+   assert(!refFaceList->contains(refFPtr));
+   refFaceList->add(refFPtr, ManageListSorting);
    if (refFPtr->entityId > maxRefFaceId)
        maxRefFaceId = refFPtr->entityId;
 }
 
 void RefEntityFactory::add(RefEdge* refEPtr)
 {
-   assert(!refEdgeList->is_in_list(refEPtr));
-   if(refEdgeList->size() > 0)
-   {
-    refEdgeList->last();
-    if(ManageListSorting && refEPtr->id() < refEdgeList->get()->id())
-      refEdgeListIsSorted = false;
-   }
-   refEdgeList->append(refEPtr);
+   assert(!refEdgeList->contains(refEPtr));
+   refEdgeList->add(refEPtr, ManageListSorting);
    if (refEPtr->id() > maxRefEdgeId)
        maxRefEdgeId = refEPtr->id();
 }
 
 void RefEntityFactory::add(RefVertex* refVPtr)
 {
-   assert(!refVertexList->is_in_list(refVPtr));
-   if(refVertexList->size() > 0)
-   {
-    refVertexList->last();
-    if(ManageListSorting && refVPtr->id() < refVertexList->get()->id())
-      refVertexListIsSorted = false;
-   }
-   refVertexList->append(refVPtr);
+   assert(!refVertexList->contains(refVPtr));
+   refVertexList->add(refVPtr, ManageListSorting);
    if (refVPtr->id() > maxRefVertexId)
        maxRefVertexId = refVPtr->id();
 }
@@ -366,9 +278,8 @@ void RefEntityFactory::remove (RefVertex *ref_vertex_ptr)
   
    if (ref_vertex_ptr != NULL)
    {
-      if (refVertexList->move_to ( ref_vertex_ptr )) 
-          refVertexList->remove ();
-      else assert(0);
+      if (!refVertexList->remove( ref_vertex_ptr ))
+          assert(0);
    }
 }
 
@@ -378,9 +289,8 @@ void RefEntityFactory::remove (RefEdge *ref_edge_ptr)
 
    if (ref_edge_ptr != NULL)
    {
-      if (refEdgeList->move_to ( ref_edge_ptr ))
-          refEdgeList->remove ();
-      else assert(0);
+      if (!refEdgeList->remove( ref_edge_ptr ))
+          assert(0);
    }
 }
 
@@ -390,9 +300,8 @@ void RefEntityFactory::remove (RefFace *ref_face_ptr)
 
    if (ref_face_ptr != NULL)
    {
-      if (refFaceList->move_to ( ref_face_ptr ))
-          refFaceList->remove ();
-      else assert(0);
+      if (!refFaceList->remove( ref_face_ptr ))
+          assert(0);
    }
 }
 
@@ -402,9 +311,8 @@ void RefEntityFactory::remove (RefVolume *ref_volume_ptr)
 
   if (ref_volume_ptr != NULL)
    {
-      if (refVolumeList->move_to ( ref_volume_ptr ))
-          refVolumeList->remove ();
-      else assert(0);
+      if (!refVolumeList->remove( ref_volume_ptr ))
+          assert(0);
    }
 }
 
@@ -414,9 +322,8 @@ void RefEntityFactory::remove (RefGroup *ref_group_ptr)
 
   if (ref_group_ptr != NULL)
   {
-    if (refGroupList->move_to ( ref_group_ptr ))
-      refGroupList->remove ();
-    else assert(0);
+    if (!refGroupList->remove( ref_group_ptr ))
+      assert(0);
   }
 }
 
@@ -426,40 +333,39 @@ void RefEntityFactory::remove (Body *body_ptr)
 
   if (body_ptr != NULL)
   {
-    if (bodyList->move_to ( body_ptr ))
-      bodyList->remove ();
-    else assert(0);
+    if (!bodyList->remove( body_ptr ))
+      assert(0);
   }
 }
 
 void RefEntityFactory::bodies(DLIList<Body*> &bodies) 
 {
-  bodies = *bodyList;
+  bodyList->entities(bodies);
 }
 
 void RefEntityFactory::ref_volumes(DLIList<RefVolume*> &ref_volumes)
 {
-  ref_volumes = *refVolumeList;
+  refVolumeList->entities(ref_volumes);
 }
 
 void RefEntityFactory::ref_groups(DLIList<RefGroup*> &ref_groups)
 {
-  ref_groups = *refGroupList;
+  refGroupList->entities(ref_groups);
 }
 
 void RefEntityFactory::ref_faces(DLIList<RefFace*> &ref_faces)
 {
-  ref_faces = *refFaceList;
+  refFaceList->entities(ref_faces);
 }
 
 void RefEntityFactory::ref_edges(DLIList<RefEdge*> &ref_edges)
 {
-  ref_edges = *refEdgeList;
+  refEdgeList->entities(ref_edges);
 }
 
 void RefEntityFactory::ref_vertices(DLIList<RefVertex*> &ref_vertices)
 {
-  ref_vertices = *refVertexList;
+  refVertexList->entities(ref_vertices);
 }
 
 #ifdef PROE
@@ -537,290 +443,32 @@ RefEntity* RefEntityFactory::get_ref_entity (const type_info& type, int id)
 
 Body* RefEntityFactory::get_body (int id)
 {
-   if (!bodyList->size())
-       return NULL;
-   
-   // Make sure the list is sorted for the binary search.
-   if(ManageListSorting && !bodyListIsSorted)
-   {
-     bodyList->sort(sort_by_ascending_ids);
-     bodyListIsSorted = true;
-   }
-
-   // Do a binary search on the sorted list.  We are making the assumption
-   // here that there are no NULL entries in the list.
-   bool found = false;
-   int left_index = 0;
-   int right_index = bodyList->size()-1;
-   int mid_index = (left_index + right_index)/2;
-   int mid_id = ((*bodyList)[mid_index])->id();
-
-   while(!found && (right_index-left_index) > 1)
-   {
-     if(mid_id == id)
-       found = true;
-     else
-     {
-       if(mid_id > id)
-         right_index = mid_index;
-       else
-         left_index = mid_index;
-       mid_index = (left_index + right_index)/2;
-       mid_id = ((*bodyList)[mid_index])->id();
-     }
-   }
-
-   if(!found)
-   {
-     if(((*bodyList)[left_index])->id() == id)
-       return ((*bodyList)[left_index]);
-     else if(((*bodyList)[right_index])->id() == id)
-       return ((*bodyList)[right_index]);
-   }
-   else
-     return ((*bodyList)[mid_index]);
-   
-   return NULL ;
+   return static_cast<Body*>(bodyList->find(id));
 }
 
-RefGroup* RefEntityFactory::get_ref_group   (int id)
+RefGroup* RefEntityFactory::get_ref_group (int id)
 {
-   if (!refGroupList->size())
-       return NULL;
-   
-   // Make sure the list is sorted for the binary search.
-   if(ManageListSorting && !refGroupListIsSorted)
-   {
-     refGroupList->sort(sort_by_ascending_ids);
-     refGroupListIsSorted = true;
-   }
-
-   // Do a binary search on the sorted list.  We are making the assumption
-   // here that there are no NULL entries in the list.
-   bool found = false;
-   int left_index = 0;
-   int right_index = refGroupList->size()-1;
-   int mid_index = (left_index + right_index)/2;
-   int mid_id = ((*refGroupList)[mid_index])->id();
-
-   while(!found && (right_index-left_index) > 1)
-   {
-     if(mid_id == id)
-       found = true;
-     else
-     {
-       if(mid_id > id)
-         right_index = mid_index;
-       else
-         left_index = mid_index;
-       mid_index = (left_index + right_index)/2;
-       mid_id = ((*refGroupList)[mid_index])->id();
-     }
-   }
-
-   if(!found)
-   {
-     if(((*refGroupList)[left_index])->id() == id)
-       return ((*refGroupList)[left_index]);
-     else if(((*refGroupList)[right_index])->id() == id)
-       return ((*refGroupList)[right_index]);
-   }
-   else
-     return ((*refGroupList)[mid_index]);
-
-   return NULL ;
+   return static_cast<RefGroup*>(refGroupList->find(id));
 }
 
-RefVolume* RefEntityFactory::get_ref_volume (int id) 
+RefVolume* RefEntityFactory::get_ref_volume (int id)
 {
-   if (!refVolumeList->size())
-       return NULL;
-   
-   // Make sure the list is sorted for the binary search.
-   if(ManageListSorting && !refVolumeListIsSorted)
-   {
-     refVolumeList->sort(sort_by_ascending_ids);
-     refVolumeListIsSorted = true;
-   }
-
-   // Do a binary search on the sorted list.  We are making the assumption
-   // here that there are no NULL entries in the list.
-   bool found = false;
-   int left_index = 0;
-   int right_index = refVolumeList->size()-1;
-   int mid_index = (left_index + right_index)/2;
-   int mid_id = ((*refVolumeList)[mid_index])->id();
-
-   while(!found && (right_index-left_index) > 1)
-   {
-     if(mid_id == id)
-       found = true;
-     else
-     {
-       if(mid_id > id)
-         right_index = mid_index;
-       else
-         left_index = mid_index;
-       mid_index = (left_index + right_index)/2;
-       mid_id = ((*refVolumeList)[mid_index])->id();
-     }
-   }
-
-   if(!found)
-   {
-     if(((*refVolumeList)[left_index])->id() == id)
-       return ((*refVolumeList)[left_index]);
-     else if(((*refVolumeList)[right_index])->id() == id)
-       return ((*refVolumeList)[right_index]);
-   }
-   else
-     return ((*refVolumeList)[mid_index]);
-
-   return NULL ;
+   return static_cast<RefVolume*>(refVolumeList->find(id));
 }
 
-RefFace* RefEntityFactory::get_ref_face (int id) 
+RefFace* RefEntityFactory::get_ref_face (int id)
 {
-   if (!refFaceList->size())
-       return NULL;
-   
-   // Make sure the list is sorted for the binary search.
-   if(ManageListSorting && !refFaceListIsSorted)
-   {
-     refFaceList->sort(sort_by_ascending_ids);
-     refFaceListIsSorted = true;
-   }
-
-   // Do a binary search on the sorted list.  We are making the assumption
-   // here that there are no NULL entries in the list.
-   bool found = false;
-   int left_index = 0;
-   int right_index = refFaceList->size()-1;
-   int mid_index = (left_index + right_index)/2;
-   int mid_id = ((*refFaceList)[mid_index])->id();
-
-   while(!found && (right_index-left_index) > 1)
-   {
-     if(mid_id == id)
-       found = true;
-     else
-     {
-       if(mid_id > id)
-         right_index = mid_index;
-       else
-         left_index = mid_index;
-       mid_index = (left_index + right_index)/2;
-       mid_id = ((*refFaceList)[mid_index])->id();
-     }
-   }
-
-   if(!found)
-   {
-     if(((*refFaceList)[left_index])->id() == id)
-       return ((*refFaceList)[left_index]);
-     else if(((*refFaceList)[right_index])->id() == id)
-       return ((*refFaceList)[right_index]);
-   }
-   else
-     return ((*refFaceList)[mid_index]);
-
-   return NULL ;
+   return static_cast<RefFace*>(refFaceList->find(id));
 }
 
-RefEdge* RefEntityFactory::get_ref_edge (int id) 
+RefEdge* RefEntityFactory::get_ref_edge (int id)
 {
-   if (!refEdgeList->size())
-       return NULL;
-   
-   // Make sure the list is sorted for the binary search.
-   if(ManageListSorting && !refEdgeListIsSorted)
-   {
-     refEdgeList->sort(sort_by_ascending_ids);
-     refEdgeListIsSorted = true;
-   }
-
-   // Do a binary search on the sorted list.  We are making the assumption
-   // here that there are no NULL entries in the list.
-   bool found = false;
-   int left_index = 0;
-   int right_index = refEdgeList->size()-1;
-   int mid_index = (left_index + right_index)/2;
-   int mid_id = ((*refEdgeList)[mid_index])->id();
-
-   while(!found && (right_index-left_index) > 1)
-   {
-     if(mid_id == id)
-       found = true;
-     else
-     {
-       if(mid_id > id)
-         right_index = mid_index;
-       else
-         left_index = mid_index;
-       mid_index = (left_index + right_index)/2;
-       mid_id = ((*refEdgeList)[mid_index])->id();
-     }
-   }
-
-   if(!found)
-   {
-     if(((*refEdgeList)[left_index])->id() == id)
-       return ((*refEdgeList)[left_index]);
-     else if(((*refEdgeList)[right_index])->id() == id)
-       return ((*refEdgeList)[right_index]);
-   }
-   else
-     return ((*refEdgeList)[mid_index]);
-
-   return NULL ;
+   return static_cast<RefEdge*>(refEdgeList->find(id));
 }
 
-RefVertex* RefEntityFactory::get_ref_vertex (int id) 
+RefVertex* RefEntityFactory::get_ref_vertex (int id)
 {
-   if (!refVertexList->size())
-       return NULL;
-   
-   // Make sure the list is sorted for the binary search.
-   if(ManageListSorting && !refVertexListIsSorted)
-   {
-     refVertexList->sort(sort_by_ascending_ids);
-     refVertexListIsSorted = true;
-   }
-
-   // Do a binary search on the sorted list.  We are making the assumption
-   // here that there are no NULL entries in the list.
-   bool found = false;
-   int left_index = 0;
-   int right_index = refVertexList->size()-1;
-   int mid_index = (left_index + right_index)/2;
-   int mid_id = ((*refVertexList)[mid_index])->id();
-
-   while(!found && (right_index-left_index) > 1)
-   {
-     if(mid_id == id)
-       found = true;
-     else
-     {
-       if(mid_id > id)
-         right_index = mid_index;
-       else
-         left_index = mid_index;
-       mid_index = (left_index + right_index)/2;
-       mid_id = ((*refVertexList)[mid_index])->id();
-     }
-   }
-
-   if(!found)
-   {
-     if(((*refVertexList)[left_index])->id() == id)
-       return ((*refVertexList)[left_index]);
-     else if(((*refVertexList)[right_index])->id() == id)
-       return ((*refVertexList)[right_index]);
-   }
-   else
-     return ((*refVertexList)[mid_index]);
-
-   return NULL ;
+   return static_cast<RefVertex*>(refVertexList->find(id));
 }
 
 //* Methods: next*Id
@@ -870,93 +518,81 @@ int RefEntityFactory::next_ref_part_id ()
 
 Body *RefEntityFactory::get_first_body()
 {
-	bodyList->reset(); 
-	return bodyList->size() ? bodyList->get() : 0;
+	return static_cast<Body*>(bodyList->first());
 }
 
 RefVolume *RefEntityFactory::get_first_ref_volume()
 {
-	refVolumeList->reset(); 
-	return refVolumeList->size() ? refVolumeList->get() : 0;
+	return static_cast<RefVolume*>(refVolumeList->first());
 }
 
 RefGroup *RefEntityFactory::get_first_ref_group()
 {
-	refGroupList->reset(); 
-	return refGroupList->size() ? refGroupList->get() : 0;
+	return static_cast<RefGroup*>(refGroupList->first());
 }
 
 RefFace *RefEntityFactory::get_first_ref_face()
 {
-	refFaceList->reset(); 
-	return refFaceList->size() ? refFaceList->get() : 0;
+	return static_cast<RefFace*>(refFaceList->first());
 }
 
 RefEdge *RefEntityFactory::get_first_ref_edge()
 {
-	refEdgeList->reset(); 
-	return refEdgeList->size() ? refEdgeList->get() : 0;
+	return static_cast<RefEdge*>(refEdgeList->first());
 }
 
 RefVertex *RefEntityFactory::get_first_ref_vertex()
 {
-	refVertexList->reset(); 
-	return refVertexList->size() ? refVertexList->get() : 0;
+	return static_cast<RefVertex*>(refVertexList->first());
 }
 
         
 Body *RefEntityFactory::get_next_body()
-{return bodyList->size() ? bodyList->step_and_get() : 0;}
+{return static_cast<Body*>(bodyList->next());}
 
 RefVolume *RefEntityFactory::get_next_ref_volume()
-{return refVolumeList->size() ? refVolumeList->step_and_get() : 0;}
+{return static_cast<RefVolume*>(refVolumeList->next());}
 
 RefGroup *RefEntityFactory::get_next_ref_group()
-{return refGroupList->size() ? refGroupList->step_and_get() : 0;}
+{return static_cast<RefGroup*>(refGroupList->next());}
 
 RefFace *RefEntityFactory::get_next_ref_face()
-{return refFaceList->size() ? refFaceList->step_and_get() : 0;}
+{return static_cast<RefFace*>(refFaceList->next());}
 
 RefEdge *RefEntityFactory::get_next_ref_edge()
-{return refEdgeList->size() ? refEdgeList->step_and_get() : 0;}
+{return static_cast<RefEdge*>(refEdgeList->next());}
 
 RefVertex *RefEntityFactory::get_next_ref_vertex()
-{return refVertexList->size() ? refVertexList->step_and_get() : 0;}
+{return static_cast<RefVertex*>(refVertexList->next());}
 
 Body *RefEntityFactory::get_last_body()
 {
-	bodyList->last(); 
-	return bodyList->size() ? bodyList->get() : 0;
+	return static_cast<Body*>(bodyList->last());
 }
 
 RefVolume *RefEntityFactory::get_last_ref_volume()
 {
-	refVolumeList->last(); 
-	return refVolumeList->size() ? refVolumeList->get() : 0;
+	return static_cast<RefVolume*>(refVolumeList->last());
 }
 
 RefGroup *RefEntityFactory::get_last_ref_group()
 {
-	refGroupList->last(); 
-	return refGroupList->size() ? refGroupList->get() : 0;
+	return static_cast<RefGroup*>(refGroupList->last());
 }
 
 RefFace *RefEntityFactory::get_last_ref_face()
 {
-	refFaceList->last(); 
-	return refFaceList->size() ? refFaceList->get() : 0;
+	return static_cast<RefFace*>(refFaceList->last());
 }
 
 RefEdge *RefEntityFactory::get_last_ref_edge()
 {
-	refEdgeList->last(); 
-	return refEdgeList->size() ? refEdgeList->get() : 0;
+	return static_cast<RefEdge*>(refEdgeList->last());
 }
 
 RefVertex *RefEntityFactory::get_last_ref_vertex()
 {
-	refVertexList->last(); 
-	return refVertexList->size() ? refVertexList->get() : 0;
+	return static_cast<RefVertex*>(refVertexList->last());
 }
 
 void RefEntityFactory::incorporate_id (RefEntity *ref_ent)
@@ -1189,18 +825,22 @@ CubitStatus RefEntityFactory::notify_observer(CubitObservable *observable,
     remove(entity);
   else if (event == ID_SET) 
   {
-    if(CAST_TO(entity, RefEdge) && ManageListSorting)
-      refEdgeListIsSorted = false;
-    else if(CAST_TO(entity, RefFace) && ManageListSorting)
-      refFaceListIsSorted = false;
-    else if(CAST_TO(entity, RefVertex) && ManageListSorting)
-      refVertexListIsSorted = false;
-    else if(CAST_TO(entity, RefVolume) && ManageListSorting)
-      refVolumeListIsSorted = false;
-    else if(CAST_TO(entity, RefGroup) && ManageListSorting)
-      refGroupListIsSorted = false;
-    else if(CAST_TO(entity, Body) && ManageListSorting)
-      bodyListIsSorted = false;
+    const IdSetEvent &id_event = static_cast<const IdSetEvent&>(observer_event);
+    RefEntityIdTable *table = NULL;
+    if(CAST_TO(entity, RefEdge))
+      table = refEdgeList;
+    else if(CAST_TO(entity, RefFace))
+      table = refFaceList;
+    else if(CAST_TO(entity, RefVertex))
+      table = refVertexList;
+    else if(CAST_TO(entity, RefVolume))
+      table = refVolumeList;
+    else if(CAST_TO(entity, RefGroup))
+      table = refGroupList;
+    else if(CAST_TO(entity, Body))
+      table = bodyList;
+    if (table)
+      table->id_changed(entity, id_event.get_old_id(), ManageListSorting);
   }
 
   return CUBIT_SUCCESS;
@@ -42,6 +42,7 @@ class RefGroup;
 class RefVolume;
 template <class X> class DLIList;
 class CubitEntity;
+class RefEntityIdTable;
 
 class CUBIT_GEOM_EXPORT RefEntityFactory : public CubitObserver
 {
@@ -212,19 +213,13 @@ protected:
 
 private:
 
-  bool refVertexListIsSorted;
-  bool refEdgeListIsSorted;
-  bool refFaceListIsSorted;
-  bool refVolumeListIsSorted;
-  bool bodyListIsSorted;
-  bool refGroupListIsSorted;
-
-  DLIList<RefVertex*> *refVertexList;
-  DLIList<RefEdge*> *refEdgeList;
-  DLIList<RefFace*> *refFaceList;
-  DLIList<RefGroup*> *refGroupList;
-  DLIList<RefVolume*> *refVolumeList;
-  DLIList<Body*> *bodyList;
+  RefEntityIdTable *refVertexList;
+  RefEntityIdTable *refEdgeList;
+  RefEntityIdTable *refFaceList;
+  RefEntityIdTable *refGroupList;
+  RefEntityIdTable *refVolumeList;
+  RefEntityIdTable *bodyList;
+    //- the entities of each type, in ascending id order, hashed by id
 #ifdef PROE
   DLIList<RefAssembly*> *refAssemblyList;
   DLIList<RefPart*> *refPartList;
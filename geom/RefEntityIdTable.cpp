@@ -0,0 +1,168 @@
+//-------------------------------------------------------------------------
+// Filename      : RefEntityIdTable.cpp
+//
+// Purpose       : The set of RefEntities of one type kept by
+//                 RefEntityFactory, with lookup by id.
+//
+// Special Notes :
+//
+//-------------------------------------------------------------------------
+
+#include "RefEntityIdTable.hpp"
+#include "RefEntity.hpp"
+
+#include <algorithm>
+
+static bool ascending_id( RefEntity* a, RefEntity* b )
+{
+  return a->id() < b->id();
+}
+
+RefEntityIdTable::RefEntityIdTable()
+  : numHoles(0), isSorted(true), cursor(0)
+{
+}
+
+RefEntityIdTable::SlotMap::iterator
+RefEntityIdTable::find_slot( int id, RefEntity* entity )
+{
+  std::pair<SlotMap::iterator, SlotMap::iterator> range =
+    slotById.equal_range( id );
+  for( SlotMap::iterator it = range.first; it != range.second; ++it )
+    if( slotEntities[it->second] == entity )
+      return it;
+  return slotById.end();
+}
+
+void RefEntityIdTable::add( RefEntity* entity, bool keep_sorted )
+{
+  if( keep_sorted && isSorted )
+  {
+      // compare against the last entity still in the table
+    for( int i = (int)slotEntities.size(); i--; )
+    {
+      if( slotEntities[i] )
+      {
+        if( entity->id() < slotEntities[i]->id() )
+          isSorted = false;
+        break;
+      }
+    }
+  }
+
+  slotById.insert( std::make_pair( entity->id(), (int)slotEntities.size() ) );
+  slotEntities.push_back( entity );
+}
+
+bool RefEntityIdTable::remove( RefEntity* entity )
+{
+  SlotMap::iterator it = find_slot( entity->id(), entity );
+  if( it == slotById.end() )
+    return false;
+
+  slotEntities[it->second] = NULL;
+  slotById.erase( it );
+  numHoles++;
+
+    // keep the array no more than about half empty
+  if( numHoles > 16 && numHoles > size() )
+  {
+    bool was_sorted = isSorted;
+    isSorted = true;
+    compact();
+    isSorted = was_sorted;
+  }
+  return true;
+}
+
+void RefEntityIdTable::id_changed( RefEntity* entity, int old_id,
+                                   bool keep_sorted )
+{
+  SlotMap::iterator it = find_slot( old_id, entity );
+  if( it == slotById.end() )
+    return;
+
+  int slot = it->second;
+  slotById.erase( it );
+  slotById.insert( std::make_pair( entity->id(), slot ) );
+  if( keep_sorted )
+    isSorted = false;
+}
+
+RefEntity* RefEntityIdTable::find( int id ) const
+{
+  SlotMap::const_iterator it = slotById.find( id );
+  return it == slotById.end() ? NULL : slotEntities[it->second];
+}
+
+bool RefEntityIdTable::contains( RefEntity* entity ) const
+{
+  std::pair<SlotMap::const_iterator, SlotMap::const_iterator> range =
+    slotById.equal_range( entity->id() );
+  for( SlotMap::const_iterator it = range.first; it != range.second; ++it )
+    if( slotEntities[it->second] == entity )
+      return true;
+  return false;
+}
+
+void RefEntityIdTable::compact()
+{
+    // keep next() going from the same place: the cursor moves to the
+    // entity before it if that entity was removed
+  int num_slots = (int)slotEntities.size();
+  int new_cursor = 0;
+  for( int i = 0; i < cursor && i < num_slots; i++ )
+    if( slotEntities[i] )
+      new_cursor++;
+  if( cursor >= num_slots || !slotEntities[cursor] )
+    new_cursor--;
+  cursor = new_cursor;
+
+  slotEntities.erase( std::remove( slotEntities.begin(), slotEntities.end(),
+                                   (RefEntity*)NULL ),
+                      slotEntities.end() );
+  numHoles = 0;
+  if( !isSorted )
+  {
+    std::stable_sort( slotEntities.begin(), slotEntities.end(), ascending_id );
+    isSorted = true;
+    cursor = 0;
+  }
+
+  slotById.clear();
+  for( int i = 0; i < (int)slotEntities.size(); i++ )
+    slotById.insert( std::make_pair( slotEntities[i]->id(), i ) );
+}
+
+const std::vector<RefEntity*>& RefEntityIdTable::entities()
+{
+  if( numHoles || !isSorted )
+    compact();
+  return slotEntities;
+}
+
+RefEntity* RefEntityIdTable::first()
+{
+  entities();
+  cursor = 0;
+  return slotEntities.empty() ? NULL : slotEntities[0];
+}
+
+RefEntity* RefEntityIdTable::next()
+{
+  if( !size() )
+    return NULL;
+
+  int num_slots = (int)slotEntities.size();
+  do
+    cursor = (cursor + 1) % num_slots;
+  while( !slotEntities[cursor] );
+  return slotEntities[cursor];
+}
+
+RefEntity* RefEntityIdTable::last()
+{
+  entities();
+  cursor = (int)slotEntities.size() - 1;
+  return slotEntities.empty() ? NULL : slotEntities[cursor];
+}
@@ -0,0 +1,89 @@
+//-------------------------------------------------------------------------
+// Filename      : RefEntityIdTable.hpp
+//
+// Purpose       : The set of RefEntities of one type kept by
+//                 RefEntityFactory, with lookup by id.
+//
+// Special Notes : Entities are kept in an array in ascending id order,
+//                 with a hash index from id to array slot.  Removal leaves
+//                 an empty slot, so add, remove and lookup by id are O(1);
+//                 the empty slots are squeezed out, and the array re-sorted
+//                 if an id changed or an entity was added out of order,
+//                 the next time the entities are listed in order.
+//
+//-------------------------------------------------------------------------
+
+#ifndef REFENTITYIDTABLE_HPP
+#define REFENTITYIDTABLE_HPP
+
+#include "CubitGeomConfigure.h"
+
+#include <vector>
+#include <unordered_map>
+
+class RefEntity;
+template <class X> class DLIList;
+
+class CUBIT_GEOM_EXPORT RefEntityIdTable
+{
+public:
+
+  RefEntityIdTable();
+
+  void add( RefEntity* entity, bool keep_sorted = true );
+    //- Add entity, under its current id.  If keep_sorted is false the
+    //- entity is listed after the others regardless of its id.
+
+  bool remove( RefEntity* entity );
+    //- Remove entity.  Returns false if it was not in the table.
+
+  void id_changed( RefEntity* entity, int old_id, bool keep_sorted = true );
+    //- Move entity from old_id to its current id.
+
+  RefEntity* find( int id ) const;
+    //- The entity with the given id, or NULL.
+
+  bool contains( RefEntity* entity ) const;
+
+  int size() const
+    { return (int)slotEntities.size() - numHoles; }
+
+  const std::vector<RefEntity*>& entities();
+    //- All entities, in ascending id order.
+
+  template <class X> void entities( DLIList<X*>& list )
+    {
+      const std::vector<RefEntity*>& all = entities();
+      list.clean_out();
+      list.reserve( (int)all.size() );
+      for( int i = 0; i < (int)all.size(); i++ )
+        list.append( static_cast<X*>(all[i]) );
+    }
+    //- All entities, in ascending id order, replacing the contents of
+    //- list.
+
+  RefEntity* first();
+  RefEntity* next();
+  RefEntity* last();
+    //- Step through the entities in ascending id order.  next() wraps
+    //- around from the last entity to the first.
+
+private:
+
+  typedef std::unordered_multimap<int, int> SlotMap;
+
+  SlotMap::iterator find_slot( int id, RefEntity* entity );
+    //- The index entry of entity under id, or end().
+
+  void compact();
+    //- Removes the empty slots, sorts by id if needed and rebuilds the
+    //- index.
+
+  std::vector<RefEntity*> slotEntities;  // NULL for removed entities
+  SlotMap slotById;
+  int numHoles;
+  bool isSorted;
+  int cursor;
+};
+
+#endif
@@ -28,7 +28,7 @@
 #include "SurfaceOverlapFacet.hpp"
 #include "CurveOverlapFacet.hpp"
 #include "TDSurfaceOverlap.hpp"
-#include "RTree.hpp"
+#include "PackedRTree.hpp"
 #include "AbstractTree.hpp"
 
 #include "GMem.hpp"
@@ -145,13 +145,14 @@ SurfaceOverlapTool::find_candidate_surfaces_for_imprinting( DLIList<BodySM*> &bo
     tolerance = overlap_tol;
 
   // Populate the Surface AbstractTree
-  AbstractTree<Surface*> *a_tree = new RTree<Surface*>( tolerance );
+  AbstractTree<Surface*> *a_tree = new PackedRTree<Surface*>( tolerance );
   surface_list.reset();
   for( i=surface_list.size(); i--; )
   {
     Surface *surface = surface_list.get_and_step();
     a_tree->add( surface );
   }
+  a_tree->balance();
 
   std::map<Surface*, DLIList<SurfaceOverlapFacet*>* > surface_facet_map;
   std::map<Surface*, double > surface_to_area_map;
@@ -445,7 +446,7 @@ SurfaceOverlapTool::find_overlapping_surfaces( DLIList<RefFace*> &ref_face_list,
   RefFace *ref_face_ptr1, *ref_face_ptr2;
 
   // Populate the RefFace AbstractTree
-  AbstractTree<RefFace*> *a_tree = new RTree<RefFace*>( gapMax );
+  AbstractTree<RefFace*> *a_tree = new PackedRTree<RefFace*>( gapMax );
   int i;
   ref_face_list.reset();
   for( i=ref_face_list.size(); i--; )
@@ -453,6 +454,7 @@ SurfaceOverlapTool::find_overlapping_surfaces( DLIList<RefFace*> &ref_face_list,
     RefFace *ref_face_ptr = ref_face_list.get_and_step();
     a_tree->add( ref_face_ptr );
   }
+  a_tree->balance();
 
   // Main loop for finding overlapping surfaces
   ref_face_list.reset();
@@ -871,10 +873,11 @@ CubitBoolean SurfaceOverlapTool::check_size_and_swap_surfs(
     if( iter2 == a_tree_map->end() ) 
     {
       //a_tree = new RTree<SurfaceOverlapFacet*>( gapMax );
-      a_tree2 = new RTree<SurfaceOverlapFacet*>( tolerance+facet_tol );
+      a_tree2 = new PackedRTree<SurfaceOverlapFacet*>( tolerance+facet_tol );
 
       for( i=facet_list2->size(); i--; )
         a_tree2->add( facet_list2->get_and_step() ); 
+      a_tree2->balance();
       
       a_tree_map->insert( std::map<Surface*, AbstractTree<SurfaceOverlapFacet*>*>::value_type( tmp_surf2, a_tree2 ));
     }
@@ -1828,13 +1831,14 @@ CubitStatus SurfaceOverlapTool::find_overlapping_curves( DLIList<Curve*> &curve_
     tolerance = overlap_tol;
 
   // Populate the Surface AbstractTree
-  AbstractTree<Curve*> *a_tree = new RTree<Curve*>( tolerance );
+  AbstractTree<Curve*> *a_tree = new PackedRTree<Curve*>( tolerance );
   curve_list.reset();
   for( i=curve_list.size(); i--; )
   {
     Curve *curve = curve_list.get_and_step();
     a_tree->add( curve );
   }
+  a_tree->balance();
 
   std::map<Curve*, DLIList<CurveOverlapFacet*>* > facet_map;
   std::map<Curve*, DLIList<Curve*>* >::iterator list_iter; 
@@ -2011,7 +2015,7 @@ CubitStatus SurfaceOverlapTool::find_overlapping_curves( DLIList<RefFace*> &face
       tolerance = maxgap;
 
   // Populate the Surface AbstractTree
-  AbstractTree<RefFace*> *a_tree = new RTree<RefFace*>( tolerance );
+  AbstractTree<RefFace*> *a_tree = new PackedRTree<RefFace*>( tolerance );
   faces.reset();
   int i;
   for( i=faces.size(); i--; )
@@ -2019,6 +2023,7 @@ CubitStatus SurfaceOverlapTool::find_overlapping_curves( DLIList<RefFace*> &face
     RefFace* face = faces.get_and_step();
     a_tree->add( face );
   }
+  a_tree->balance();
 
   faces.reset();
   for( i=faces.size(); i--; )
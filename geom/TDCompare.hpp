@@ -65,6 +65,10 @@ class TDCompare : public ToolData
 
       static int is_compare(const ToolData* td) 
 	  {return (dynamic_cast<TDCompare*>(const_cast<ToolData*>(td)) != NULL);}
+
+      static int td_slot();
+      int user_slot() const { return td_slot(); }
+      //- the slot ToolDataUser keeps for this type
   
       void set_compare_partner(RefEntity* partner) ;
       RefEntity* get_compare_partner() const ; 
@@ -78,6 +78,14 @@ int TDUniqueId::is_unique_id(const ToolData* td)
   return (CAST_TO(const_cast<ToolData*>(td), TDUniqueId) != NULL);
 }
 
+// looked up for every entity when attributes are written or read
+// registered the first time it is needed, which is before any is added
+int TDUniqueId::td_slot()
+{
+  static int slot = ToolDataUser::register_TD_type( &TDUniqueId::is_unique_id );
+  return slot;
+}
+
 TDUniqueId::~TDUniqueId()
 {
     // remove this from the list
@@ -108,7 +116,7 @@ int TDUniqueId::get_unique_id(ToolDataUser *owner,
                               const CubitBoolean create_new)
 {
   assert(owner != 0);
-  TDUniqueId *uid = (TDUniqueId *) owner->get_TD(&TDUniqueId::is_unique_id);
+  TDUniqueId *uid = (TDUniqueId *) owner->get_TD( &TDUniqueId::is_unique_id, TDUniqueId::td_slot() );
   if (!uid && create_new == CUBIT_TRUE) {
     uid = new TDUniqueId(owner);
   }
@@ -72,6 +72,10 @@ public:
   static void clear_copy_map();
 
   static int is_unique_id(const ToolData* td);
+
+  static int td_slot();
+  int user_slot() const { return td_slot(); }
+    //- the slot ToolDataUser keeps for this type
   
   static int get_unique_id(ToolDataUser *owner,
                            const CubitBoolean create_new = CUBIT_TRUE);
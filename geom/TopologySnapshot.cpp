@@ -0,0 +1,341 @@
+//-------------------------------------------------------------------------
+// Filename      : TopologySnapshot.cpp
+//
+// Purpose       : Read-only, flattened copy of the Body-Volume-Face-Edge-
+//                 Vertex adjacency of a set of bodies.
+//
+// Special Notes :
+//
+//-------------------------------------------------------------------------
+
+#include "TopologySnapshot.hpp"
+#include "GeometryQueryTool.hpp"
+#include "Body.hpp"
+#include "RefVolume.hpp"
+#include "RefFace.hpp"
+#include "RefEdge.hpp"
+#include "RefVertex.hpp"
+#include "CoFace.hpp"
+#include "CoEdge.hpp"
+#include "CubitEvent.hpp"
+
+#include <algorithm>
+#include <utility>
+
+TopologySnapshot::TopologySnapshot()
+  : isStale(true)
+{
+  register_observer( this );
+}
+
+TopologySnapshot::~TopologySnapshot()
+{
+  unregister_observer( this );
+}
+
+void TopologySnapshot::clear()
+{
+  for( int i = 0; i < NUM_LEVELS; i++ )
+  {
+    levelEntities[i].clear();
+    downOffsets[i].clear();
+    downIndices[i].clear();
+    downSenses[i].clear();
+    upOffsets[i].clear();
+    upIndices[i].clear();
+  }
+  entityKeys.clear();
+  isStale = true;
+}
+
+CubitStatus TopologySnapshot::build()
+{
+  DLIList<Body*> body_list;
+  GeometryQueryTool::instance()->bodies( body_list );
+  return build( body_list );
+}
+
+void TopologySnapshot::add_children( int level, RefEntity* parent,
+                                     std::vector<RefEntity*>& raw_children,
+                                     std::vector<CubitSense>& raw_senses )
+{
+  int i;
+  switch( level )
+  {
+    case BODY:
+    {
+      DLIList<RefVolume*> volumes;
+      static_cast<Body*>(parent)->ref_volumes( volumes );
+      for( i = 0; i < volumes.size(); i++ )
+      {
+        raw_children.push_back( volumes.get_and_step() );
+        raw_senses.push_back( CUBIT_FORWARD );
+      }
+      break;
+    }
+    case VOLUME:
+    {
+      DLIList<CoFace*> co_faces;
+      static_cast<RefVolume*>(parent)->co_faces( co_faces );
+      for( i = 0; i < co_faces.size(); i++ )
+      {
+        CoFace* co_face = co_faces.get_and_step();
+        raw_children.push_back( co_face->get_ref_face_ptr() );
+        raw_senses.push_back( co_face->get_sense() );
+      }
+      break;
+    }
+    case FACE:
+    {
+      DLIList<CoEdge*> co_edges;
+      static_cast<RefFace*>(parent)->co_edges( co_edges );
+      for( i = 0; i < co_edges.size(); i++ )
+      {
+        CoEdge* co_edge = co_edges.get_and_step();
+        raw_children.push_back( co_edge->get_ref_edge_ptr() );
+        raw_senses.push_back( co_edge->get_sense() );
+      }
+      break;
+    }
+    case EDGE:
+    {
+      RefEdge* edge = static_cast<RefEdge*>(parent);
+      RefVertex* start = edge->start_vertex();
+      RefVertex* end = edge->end_vertex();
+      if( start )
+      {
+        raw_children.push_back( start );
+        raw_senses.push_back( CUBIT_FORWARD );
+      }
+      if( end )
+      {
+        raw_children.push_back( end );
+        raw_senses.push_back( CUBIT_REVERSED );
+      }
+      break;
+    }
+  }
+}
+
+//-------------------------------------------------------------------------
+// Purpose       : Flatten the topology of the given bodies.
+//
+// Special Notes : Works down one level at a time.  The children of all
+//                 entities of a level are gathered with duplicates, given
+//                 indices in order of first appearance, and then packed
+//                 per parent with the duplicates removed.  The upward
+//                 arrays are the transpose of the downward ones.
+//
+//-------------------------------------------------------------------------
+CubitStatus TopologySnapshot::build( DLIList<Body*>& body_list )
+{
+  clear();
+
+  int i, j, level;
+  std::vector<RefEntity*>& bodies = levelEntities[BODY];
+  std::vector<RefEntity*> sorted_bodies;
+  body_list.reset();
+  for( i = body_list.size(); i--; )
+    sorted_bodies.push_back( body_list.get_and_step() );
+  std::sort( sorted_bodies.begin(), sorted_bodies.end() );
+  sorted_bodies.erase( std::unique( sorted_bodies.begin(), sorted_bodies.end() ),
+                       sorted_bodies.end() );
+  std::vector<char> used( sorted_bodies.size(), 0 );
+  body_list.reset();
+  for( i = body_list.size(); i--; )
+  {
+    RefEntity* body = body_list.get_and_step();
+    size_t pos = std::lower_bound( sorted_bodies.begin(), sorted_bodies.end(), body )
+                 - sorted_bodies.begin();
+    if( !used[pos] )
+    {
+      used[pos] = 1;
+      bodies.push_back( body );
+    }
+  }
+
+  std::vector<RefEntity*> raw_children;
+  std::vector<CubitSense> raw_senses;
+  std::vector<int> raw_offsets, raw_index;
+  std::vector<std::pair<RefEntity*, int> > order;
+  std::vector<std::pair<int, int> > first_use;
+  std::vector<int> group_start;
+  std::vector<int> seen_parent, seen_position;
+
+  for( level = BODY; level > VERTEX; level-- )
+  {
+    const std::vector<RefEntity*>& parents = levelEntities[level];
+    std::vector<RefEntity*>& children = levelEntities[level-1];
+    int num_parents = (int)parents.size();
+
+    raw_children.clear();
+    raw_senses.clear();
+    raw_offsets.assign( 1, 0 );
+    for( i = 0; i < num_parents; i++ )
+    {
+      add_children( level, parents[i], raw_children, raw_senses );
+      raw_offsets.push_back( (int)raw_children.size() );
+    }
+
+      // index the distinct children in order of first appearance
+    int num_raw = (int)raw_children.size();
+    order.resize( num_raw );
+    for( i = 0; i < num_raw; i++ )
+      order[i] = std::make_pair( raw_children[i], i );
+    std::sort( order.begin(), order.end() );
+
+    group_start.clear();
+    for( i = 0; i < num_raw; i = j )
+    {
+      for( j = i + 1; j < num_raw && order[j].first == order[i].first; j++ );
+      group_start.push_back( i );
+    }
+    int num_groups = (int)group_start.size();
+    group_start.push_back( num_raw );
+
+    first_use.resize( num_groups );
+    for( i = 0; i < num_groups; i++ )
+      first_use[i] = std::make_pair( order[group_start[i]].second, i );
+    std::sort( first_use.begin(), first_use.end() );
+
+    raw_index.resize( num_raw );
+    for( i = 0; i < num_groups; i++ )
+    {
+      int group = first_use[i].second;
+      for( j = group_start[group]; j < group_start[group+1]; j++ )
+        raw_index[order[j].second] = (int)children.size();
+      children.push_back( order[group_start[group]].first );
+    }
+
+      // pack per parent, merging repeated children
+    std::vector<int>& offsets = downOffsets[level];
+    std::vector<int>& indices = downIndices[level];
+    std::vector<CubitSense>& senses = downSenses[level];
+    offsets.assign( 1, 0 );
+    indices.reserve( num_raw );
+    senses.reserve( num_raw );
+    seen_parent.assign( children.size(), -1 );
+    seen_position.resize( children.size() );
+    for( i = 0; i < num_parents; i++ )
+    {
+      for( j = raw_offsets[i]; j < raw_offsets[i+1]; j++ )
+      {
+        int child = raw_index[j];
+        if( seen_parent[child] == i )
+        {
+          CubitSense& sense = senses[seen_position[child]];
+          if( sense != raw_senses[j] )
+            sense = CUBIT_UNKNOWN;
+          continue;
+        }
+        seen_parent[child] = i;
+        seen_position[child] = (int)indices.size();
+        indices.push_back( child );
+        senses.push_back( raw_senses[j] );
+      }
+      offsets.push_back( (int)indices.size() );
+    }
+  }
+  downOffsets[VERTEX].assign( levelEntities[VERTEX].size() + 1, 0 );
+
+    // upward adjacency
+  for( level = VERTEX; level < BODY; level++ )
+  {
+    const std::vector<int>& offsets = downOffsets[level+1];
+    const std::vector<int>& indices = downIndices[level+1];
+    std::vector<int>& up_offsets = upOffsets[level];
+    std::vector<int>& up_indices = upIndices[level];
+    int num_children = (int)levelEntities[level].size();
+    int num_parents = (int)levelEntities[level+1].size();
+
+    up_offsets.assign( num_children + 1, 0 );
+    for( i = 0; i < (int)indices.size(); i++ )
+      up_offsets[indices[i] + 1]++;
+    for( i = 0; i < num_children; i++ )
+      up_offsets[i+1] += up_offsets[i];
+
+    std::vector<int> fill( up_offsets.begin(), up_offsets.end() - 1 );
+    up_indices.resize( indices.size() );
+    for( i = 0; i < num_parents; i++ )
+      for( j = offsets[i]; j < offsets[i+1]; j++ )
+        up_indices[fill[indices[j]]++] = i;
+  }
+  upOffsets[BODY].assign( levelEntities[BODY].size() + 1, 0 );
+
+    // lookup by entity
+  for( level = VERTEX; level < NUM_LEVELS; level++ )
+  {
+    for( i = 0; i < (int)levelEntities[level].size(); i++ )
+    {
+      Key key;
+      key.entity = levelEntities[level][i];
+      key.level = level;
+      key.index = i;
+      entityKeys.push_back( key );
+    }
+  }
+  std::sort( entityKeys.begin(), entityKeys.end() );
+
+  isStale = false;
+  return CUBIT_SUCCESS;
+}
+
+int TopologySnapshot::index( RefEntity* entity, Level& level ) const
+{
+  Key key;
+  key.entity = entity;
+  std::vector<Key>::const_iterator it =
+    std::lower_bound( entityKeys.begin(), entityKeys.end(), key );
+  if( it == entityKeys.end() || it->entity != entity )
+    return -1;
+  level = (Level)it->level;
+  return it->index;
+}
+
+Body* TopologySnapshot::body( int index ) const
+{
+  return static_cast<Body*>( levelEntities[BODY][index] );
+}
+
+RefVolume* TopologySnapshot::ref_volume( int index ) const
+{
+  return static_cast<RefVolume*>( levelEntities[VOLUME][index] );
+}
+
+RefFace* TopologySnapshot::ref_face( int index ) const
+{
+  return static_cast<RefFace*>( levelEntities[FACE][index] );
+}
+
+RefEdge* TopologySnapshot::ref_edge( int index ) const
+{
+  return static_cast<RefEdge*>( levelEntities[EDGE][index] );
+}
+
+RefVertex* TopologySnapshot::ref_vertex( int index ) const
+{
+  return static_cast<RefVertex*>( levelEntities[VERTEX][index] );
+}
+
+CubitStatus TopologySnapshot::notify_observer( CubitObservable* /*observable*/,
+                                               const CubitEvent& observer_event )
+{
+  switch( observer_event.get_event_type() )
+  {
+    case MODEL_ENTITY_CONSTRUCTED:
+    case MODEL_ENTITY_MODIFIED:
+    case MODEL_ENTITY_DESTRUCTED:
+    case GEOMETRY_TOPOLOGY_MODIFIED:
+    case TOPOLOGY_MODIFIED:
+    case NEW_ENTITY_UNMERGED:
+    case FREE_REF_ENTITY_GENERATED:
+    case TOP_LEVEL_ENTITY_DESTRUCTED:
+    case ENTITIES_MERGED:
+    case MODEL_RESET:
+      isStale = true;
+      break;
+    default:
+      break;
+  }
+  return CUBIT_SUCCESS;
+}
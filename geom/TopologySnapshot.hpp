@@ -0,0 +1,153 @@
+//-------------------------------------------------------------------------
+// Filename      : TopologySnapshot.hpp
+//
+// Purpose       : Read-only, flattened copy of the Body-Volume-Face-Edge-
+//                 Vertex adjacency of a set of bodies, for passes that
+//                 query adjacency many times on a model that does not
+//                 change during the pass.
+//
+// Special Notes : Entities of each level are given dense indices, in the
+//                 order they are first reached from the bodies.  Downward
+//                 and upward adjacency is stored in compressed sparse row
+//                 arrays, so a query returns a range of indices into the
+//                 snapshot without allocating.
+//
+//                 The snapshot is only changed by build() and clear(), so
+//                 queries may run concurrently.  It watches the model
+//                 events and reports is_stale() once the topology may have
+//                 changed; it is not rebuilt automatically.
+//
+//-------------------------------------------------------------------------
+
+#ifndef TOPOLOGY_SNAPSHOT_HPP
+#define TOPOLOGY_SNAPSHOT_HPP
+
+#include "CubitDefines.h"
+#include "CubitObserver.hpp"
+#include "DLIList.hpp"
+#include "CubitGeomConfigure.h"
+
+#include <vector>
+
+class RefEntity;
+class Body;
+class RefVolume;
+class RefFace;
+class RefEdge;
+class RefVertex;
+
+class CUBIT_GEOM_EXPORT TopologySnapshot : public CubitObserver
+{
+public:
+
+  enum Level { VERTEX = 0, EDGE = 1, FACE = 2, VOLUME = 3, BODY = 4,
+               NUM_LEVELS = 5 };
+    //- Levels of the snapshot, lowest to highest.
+
+  class IndexRange
+  {
+  public:
+    IndexRange( const int* first, const int* last )
+      : beginPtr(first), endPtr(last) {}
+    const int* begin() const { return beginPtr; }
+    const int* end() const { return endPtr; }
+    int size() const { return (int)(endPtr - beginPtr); }
+    int operator[]( int i ) const { return beginPtr[i]; }
+  private:
+    const int* beginPtr;
+    const int* endPtr;
+  };
+    //- A range of entity indices at one level of the snapshot.
+
+  TopologySnapshot();
+  virtual ~TopologySnapshot();
+
+  CubitStatus build();
+  CubitStatus build( DLIList<Body*>& body_list );
+    //- Flatten the topology of the given bodies, or of all bodies in the
+    //- model.  Free curves and vertices are not included.
+
+  void clear();
+    //- Release the snapshot.
+
+  bool is_stale() const
+    { return isStale; }
+    //- True if the snapshot was never built, or if the model topology
+    //- may have changed since it was built.
+
+  int num_entities( Level level ) const
+    { return (int)levelEntities[level].size(); }
+
+  RefEntity* entity( Level level, int index ) const
+    { return levelEntities[level][index]; }
+  Body* body( int index ) const;
+  RefVolume* ref_volume( int index ) const;
+  RefFace* ref_face( int index ) const;
+  RefEdge* ref_edge( int index ) const;
+  RefVertex* ref_vertex( int index ) const;
+    //- The entity with the given index.
+
+  int index( RefEntity* entity, Level& level ) const;
+    //- The index and level of entity, or -1 if it is not in the snapshot.
+
+  IndexRange children( Level level, int index ) const
+    { return range( downOffsets[level], downIndices[level], index ); }
+    //- Indices, at level-1, of the entities directly below an entity.
+    //- Each child appears once.  Edge children are the start vertex
+    //- followed by the end vertex; a missing vertex is left out.
+
+  const CubitSense* child_senses( Level level, int index ) const
+    { return downSenses[level].empty() ? 0 :
+             &downSenses[level][0] + downOffsets[level][index]; }
+    //- Senses of the children, in the same order: CoFace senses for a
+    //- volume, CoEdge senses for a face and FORWARD/REVERSED for the
+    //- start/end vertex of an edge.  CUBIT_UNKNOWN if a child is used
+    //- with both senses (or a closed edge's single vertex).  Always
+    //- FORWARD for the volumes of a body.
+
+  IndexRange parents( Level level, int index ) const
+    { return range( upOffsets[level], upIndices[level], index ); }
+    //- Indices, at level+1, of the entities directly above an entity.
+
+  virtual CubitStatus notify_observer( CubitObservable* observable,
+                                       const CubitEvent& observer_event );
+    //- Mark the snapshot stale on model topology events.
+
+private:
+
+  static IndexRange range( const std::vector<int>& offsets,
+                           const std::vector<int>& indices, int index )
+    {
+      const int* base = indices.empty() ? 0 : &indices[0];
+      return IndexRange( base + offsets[index], base + offsets[index+1] );
+    }
+
+  void add_children( int level, RefEntity* parent,
+                     std::vector<RefEntity*>& raw_children,
+                     std::vector<CubitSense>& raw_senses );
+    //- Appends the children of parent, one level down, with senses.
+
+  struct Key
+  {
+    RefEntity* entity;
+    int level;
+    int index;
+    bool operator<( const Key& other ) const
+      { return entity < other.entity; }
+  };
+
+  bool isStale;
+
+  std::vector<RefEntity*> levelEntities[NUM_LEVELS];
+
+  // indexed by the level of the parent (down) or of the child (up)
+  std::vector<int> downOffsets[NUM_LEVELS];
+  std::vector<int> downIndices[NUM_LEVELS];
+  std::vector<CubitSense> downSenses[NUM_LEVELS];
+  std::vector<int> upOffsets[NUM_LEVELS];
+  std::vector<int> upIndices[NUM_LEVELS];
+
+  std::vector<Key> entityKeys;  // sorted by entity, for index()
+};
+
+#endif
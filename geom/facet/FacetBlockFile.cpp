@@ -0,0 +1,435 @@
+//-------------------------------------------------------------------------
+// Filename      : FacetBlockFile.cpp
+//
+// Purpose       : Writes and reads a section of a file made of typed,
+//                 contiguous arrays ("blocks").
+//
+// Special Notes :
+//
+//-------------------------------------------------------------------------
+
+#include "FacetBlockFile.hpp"
+#include "CubitFileIOWrapper.hpp"
+#include "CubitMessage.hpp"
+
+#include <string.h>
+
+typedef NCubitFile::UnsignedInt32 UnsignedInt32;
+
+namespace
+{
+  const UnsignedInt32 BLOCK_FORMAT_VERSION = 1;
+  const unsigned int BLOCK_PACKED = 0x1;   // shuffled and LZ4 packed
+  const int HEADER_WORDS = 6;
+  const int ENTRY_WORDS = 10;
+
+  inline size_t align8( size_t n )
+  {
+    return (n + 7) & ~(size_t)7;
+  }
+
+  inline void put_size( UnsignedInt32 *words, size_t n )
+  {
+    words[0] = (UnsignedInt32)(n & 0xFFFFFFFF);
+    words[1] = (UnsignedInt32)((unsigned long long)n >> 32);
+  }
+
+  inline size_t get_size( const UnsignedInt32 *words )
+  {
+    return (size_t)(words[0] | ((unsigned long long)words[1] << 32));
+  }
+
+  inline UnsignedInt32 read32( const unsigned char *p )
+  {
+    UnsignedInt32 v;
+    memcpy( &v, p, 4 );
+    return v;
+  }
+
+  // Regroup the bytes of each element so that the first bytes of all
+  // elements come first, then the second bytes and so on.  Exponents and
+  // high order bytes of nearby values then lie together, which packs far
+  // better than the interleaved values.
+  void shuffle_bytes( const char *src, size_t count, int elem_size, char *dst )
+  {
+    for (int bb = 0; bb < elem_size; bb++)
+      for (size_t ii = 0; ii < count; ii++)
+        dst[bb*count + ii] = src[ii*elem_size + bb];
+  }
+
+  void unshuffle_bytes( const char *src, size_t count, int elem_size, char *dst )
+  {
+    for (int bb = 0; bb < elem_size; bb++)
+      for (size_t ii = 0; ii < count; ii++)
+        dst[ii*elem_size + bb] = src[bb*count + ii];
+  }
+
+  void put_length( std::vector<char> &dst, size_t len )
+  {
+    for (; len >= 255; len -= 255)
+      dst.push_back( (char)255 );
+    dst.push_back( (char)len );
+  }
+
+  // Pack in the LZ4 block format: sequences of a token, literals and a
+  // two byte offset back to a match of at least four bytes.  The last
+  // five bytes are always literals.
+  void lz_pack( const unsigned char *src, size_t n, std::vector<char> &dst )
+  {
+    const int HASH_BITS = 14;
+    std::vector<size_t> table( 1 << HASH_BITS, (size_t)-1 );
+    size_t anchor = 0, ip = 0;
+
+    dst.clear();
+    dst.reserve( n + n/255 + 16 );
+    while (n >= 13 && ip < n - 12)
+    {
+      UnsignedInt32 seq = read32( src + ip );
+      UnsignedInt32 hh = (seq * 2654435761u) >> (32 - HASH_BITS);
+      size_t ref = table[hh];
+      table[hh] = ip;
+      if (ref == (size_t)-1 || ip - ref > 65535 || read32( src + ref ) != seq)
+      {
+        ip++;
+        continue;
+      }
+
+      size_t len = 4;
+      size_t max_len = n - 5 - ip;
+      while (len < max_len && src[ref+len] == src[ip+len])
+        len++;
+
+      size_t lit = ip - anchor;
+      size_t extra = len - 4;
+      dst.push_back( (char)(((lit < 15 ? lit : 15) << 4) |
+                            (extra < 15 ? extra : 15)) );
+      if (lit >= 15)
+        put_length( dst, lit - 15 );
+      dst.insert( dst.end(), src + anchor, src + ip );
+      size_t offset = ip - ref;
+      dst.push_back( (char)(offset & 0xFF) );
+      dst.push_back( (char)(offset >> 8) );
+      if (extra >= 15)
+        put_length( dst, extra - 15 );
+
+      ip += len;
+      anchor = ip;
+    }
+
+    size_t lit = n - anchor;
+    dst.push_back( (char)((lit < 15 ? lit : 15) << 4) );
+    if (lit >= 15)
+      put_length( dst, lit - 15 );
+    dst.insert( dst.end(), src + anchor, src + n );
+  }
+
+  bool lz_unpack( const unsigned char *src, size_t n,
+                  unsigned char *dst, size_t dst_size )
+  {
+    size_t ip = 0, op = 0;
+    while (ip < n)
+    {
+      unsigned int token = src[ip++];
+      size_t lit = token >> 4;
+      if (lit == 15)
+      {
+        unsigned int bb;
+        do
+        {
+          if (ip >= n)
+            return false;
+          bb = src[ip++];
+          lit += bb;
+        } while (bb == 255);
+      }
+      if (lit > n - ip || lit > dst_size - op)
+        return false;
+      memcpy( dst + op, src + ip, lit );
+      ip += lit;
+      op += lit;
+      if (ip == n)
+        break;
+
+      if (n - ip < 2)
+        return false;
+      size_t offset = src[ip] | (src[ip+1] << 8);
+      ip += 2;
+      if (offset == 0 || offset > op)
+        return false;
+
+      size_t len = token & 15;
+      if (len == 15)
+      {
+        unsigned int bb;
+        do
+        {
+          if (ip >= n)
+            return false;
+          bb = src[ip++];
+          len += bb;
+        } while (bb == 255);
+      }
+      len += 4;
+      if (len > dst_size - op)
+        return false;
+        // the match may overlap the bytes being written
+      for (size_t ii = 0; ii < len; ii++, op++)
+        dst[op] = dst[op - offset];
+    }
+    return op == dst_size;
+  }
+
+  void swap_bytes( char *data, size_t count, int elem_size )
+  {
+    for (size_t ii = 0; ii < count; ii++)
+    {
+      char *elem = data + ii*elem_size;
+      for (int bb = 0; bb < elem_size/2; bb++)
+      {
+        char tmp = elem[bb];
+        elem[bb] = elem[elem_size-1-bb];
+        elem[elem_size-1-bb] = tmp;
+      }
+    }
+  }
+}
+
+FacetBlockWriter::FacetBlockWriter()
+{
+}
+
+FacetBlockWriter::~FacetBlockWriter()
+{
+}
+
+void FacetBlockWriter::add_block( int type, const void *data, size_t count,
+                                  int elem_size, bool compress )
+{
+  blockList.push_back( Block() );
+  Block &block = blockList.back();
+  block.type = type;
+  block.elemSize = elem_size;
+  block.flags = 0;
+  block.rawBytes = count * elem_size;
+  block.data = (const char*)data;
+
+  if (compress && block.rawBytes >= 64)
+  {
+    std::vector<char> shuffled( block.rawBytes );
+    shuffle_bytes( block.data, count, elem_size, &shuffled[0] );
+    lz_pack( (const unsigned char*)&shuffled[0], block.rawBytes, block.packed );
+    if (block.packed.size() < block.rawBytes - block.rawBytes/8)
+      block.flags |= BLOCK_PACKED;
+    else
+      std::vector<char>().swap( block.packed );
+  }
+}
+
+size_t FacetBlockWriter::stored_bytes() const
+{
+  size_t size = sizeof(UnsignedInt32) * (HEADER_WORDS + ENTRY_WORDS * blockList.size());
+  for (size_t ii = 0; ii < blockList.size(); ii++)
+  {
+    const Block &block = blockList[ii];
+    size = align8( size );
+    size += (block.flags & BLOCK_PACKED) ? block.packed.size() : block.rawBytes;
+  }
+  return align8( size );
+}
+
+CubitStatus FacetBlockWriter::write( FILE *fp )
+{
+  static const char zeros[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+  long pos = ftell( fp );
+  if (pos < 0)
+    return CUBIT_FAILURE;
+  size_t pad = align8( pos ) - pos;
+  if (pad && fwrite( zeros, 1, pad, fp ) != pad)
+    return CUBIT_FAILURE;
+
+  std::vector<UnsignedInt32> header( HEADER_WORDS + ENTRY_WORDS * blockList.size(), 0 );
+  memcpy( &header[0], "FBLK", 4 );
+  header[1] = BLOCK_FORMAT_VERSION;
+  header[2] = (UnsignedInt32)blockList.size();
+  put_size( &header[4], stored_bytes() );
+
+  size_t offset = header.size() * sizeof(UnsignedInt32);
+  size_t ii;
+  for (ii = 0; ii < blockList.size(); ii++)
+  {
+    const Block &block = blockList[ii];
+    size_t stored = (block.flags & BLOCK_PACKED) ? block.packed.size() : block.rawBytes;
+    UnsignedInt32 *entry = &header[HEADER_WORDS + ENTRY_WORDS * ii];
+    offset = align8( offset );
+    entry[0] = block.type;
+    entry[1] = block.flags;
+    entry[2] = block.elemSize;
+    put_size( entry + 4, offset );
+    put_size( entry + 6, stored );
+    put_size( entry + 8, block.rawBytes );
+    offset += stored;
+  }
+
+  if (fwrite( &header[0], sizeof(UnsignedInt32), header.size(), fp ) != header.size())
+    return CUBIT_FAILURE;
+
+  offset = header.size() * sizeof(UnsignedInt32);
+  for (ii = 0; ii < blockList.size(); ii++)
+  {
+    const Block &block = blockList[ii];
+    pad = align8( offset ) - offset;
+    if (pad && fwrite( zeros, 1, pad, fp ) != pad)
+      return CUBIT_FAILURE;
+    offset += pad;
+
+    const char *data = block.data;
+    size_t stored = block.rawBytes;
+    if (block.flags & BLOCK_PACKED)
+    {
+      data = &block.packed[0];
+      stored = block.packed.size();
+    }
+    if (stored && fwrite( data, 1, stored, fp ) != stored)
+      return CUBIT_FAILURE;
+    offset += stored;
+  }
+
+  pad = align8( offset ) - offset;
+  if (pad && fwrite( zeros, 1, pad, fp ) != pad)
+    return CUBIT_FAILURE;
+  return CUBIT_SUCCESS;
+}
+
+FacetBlockReader::FacetBlockReader()
+  : sectionData(NULL), sectionSize(0), swapBytes(false)
+{
+}
+
+FacetBlockReader::~FacetBlockReader()
+{
+  for (size_t ii = 0; ii < expandedBlocks.size(); ii++)
+    delete expandedBlocks[ii];
+}
+
+CubitStatus FacetBlockReader::section_size( FILE *fp, unsigned int endian,
+                                            long &start, size_t &size )
+{
+  long pos = ftell( fp );
+  if (pos < 0)
+    return CUBIT_FAILURE;
+  start = (long)align8( pos );
+
+  UnsignedInt32 header[HEADER_WORDS];
+  if (fseek( fp, start, SEEK_SET ) ||
+      fread( header, sizeof(UnsignedInt32), HEADER_WORDS, fp ) != HEADER_WORDS ||
+      memcmp( header, "FBLK", 4 ))
+    return CUBIT_FAILURE;
+  if (endian)
+    swap_bytes( (char*)(header + 1), HEADER_WORDS - 1, sizeof(UnsignedInt32) );
+  size = get_size( header + 4 );
+
+  if (fseek( fp, start, SEEK_SET ))
+    return CUBIT_FAILURE;
+  return CUBIT_SUCCESS;
+}
+
+CubitStatus FacetBlockReader::open( const char *section, size_t size,
+                                    unsigned int endian )
+{
+  sectionData = section;
+  sectionSize = 0;
+  swapBytes = (endian != 0);
+  entryList.clear();
+
+  size_t header_bytes = HEADER_WORDS * sizeof(UnsignedInt32);
+  if (!section || size < header_bytes || memcmp( section, "FBLK", 4 ))
+    return CUBIT_FAILURE;
+
+  UnsignedInt32 header[HEADER_WORDS];
+  memcpy( header, section, header_bytes );
+  if (swapBytes)
+    swap_bytes( (char*)(header + 1), HEADER_WORDS - 1, sizeof(UnsignedInt32) );
+  if (header[1] > BLOCK_FORMAT_VERSION)
+  {
+    PRINT_ERROR("Facet data was written by a newer version of this program.\n");
+    return CUBIT_FAILURE;
+  }
+
+  // the section must hold its own header and table, and lie within size
+  size_t num_blocks = header[2];
+  size_t section_size = get_size( header + 4 );
+  if (section_size < header_bytes || section_size > size ||
+      num_blocks > (section_size - header_bytes) / (ENTRY_WORDS * sizeof(UnsignedInt32)) ||
+      num_blocks > (size - header_bytes) / (ENTRY_WORDS * sizeof(UnsignedInt32)))
+    return CUBIT_FAILURE;
+
+  std::vector<UnsignedInt32> table( ENTRY_WORDS * num_blocks + 1 );
+  memcpy( &table[0], section + header_bytes,
+          ENTRY_WORDS * num_blocks * sizeof(UnsignedInt32) );
+  if (swapBytes)
+    swap_bytes( (char*)&table[0], table.size(), sizeof(UnsignedInt32) );
+
+  for (size_t ii = 0; ii < num_blocks; ii++)
+  {
+    const UnsignedInt32 *words = &table[ENTRY_WORDS * ii];
+    Entry entry;
+    entry.type = words[0];
+    entry.flags = words[1];
+    entry.elemSize = words[2];
+    entry.offset = get_size( words + 4 );
+    entry.storedBytes = get_size( words + 6 );
+    entry.rawBytes = get_size( words + 8 );
+    if (entry.elemSize <= 0 || entry.offset > section_size ||
+        entry.storedBytes > section_size - entry.offset ||
+        entry.rawBytes % entry.elemSize)
+      return CUBIT_FAILURE;
+    entryList.push_back( entry );
+  }
+
+  sectionSize = section_size;
+  return CUBIT_SUCCESS;
+}
+
+const void *FacetBlockReader::block( int type, size_t &count, int elem_size )
+{
+  count = 0;
+  const Entry *entry = NULL;
+  for (size_t ii = 0; ii < entryList.size() && !entry; ii++)
+    if (entryList[ii].type == type)
+      entry = &entryList[ii];
+  if (!entry || entry->elemSize != elem_size)
+    return NULL;
+
+  size_t num_elems = entry->rawBytes / elem_size;
+  const char *stored = sectionData + entry->offset;
+  bool packed = (entry->flags & BLOCK_PACKED) != 0;
+  if (!packed && entry->storedBytes != entry->rawBytes)
+    return NULL;
+  if (!packed && (!swapBytes || elem_size == 1))
+  {
+    count = num_elems;
+    return stored;
+  }
+
+  std::vector<char> *expanded = new std::vector<char>( entry->rawBytes + 1 );
+  if (packed)
+  {
+    std::vector<char> shuffled( entry->rawBytes + 1 );
+    if (!lz_unpack( (const unsigned char*)stored, entry->storedBytes,
+                    (unsigned char*)&shuffled[0], entry->rawBytes ))
+    {
+      delete expanded;
+      return NULL;
+    }
+    unshuffle_bytes( &shuffled[0], num_elems, elem_size, &(*expanded)[0] );
+  }
+  else
+    memcpy( &(*expanded)[0], stored, entry->rawBytes );
+
+  if (swapBytes)
+    swap_bytes( &(*expanded)[0], num_elems, elem_size );
+
+  expandedBlocks.push_back( expanded );
+  count = num_elems;
+  return &(*expanded)[0];
+}
@@ -0,0 +1,117 @@
+//-------------------------------------------------------------------------
+// Filename      : FacetBlockFile.hpp
+//
+// Purpose       : Writes and reads a section of a file made of typed,
+//                 contiguous arrays ("blocks"), as used for the facet
+//                 data of version 2 mesh-based geometry files.
+//
+// Special Notes : The section is placed at an 8 byte aligned offset in
+//                 the file and starts with a table giving the type,
+//                 element size, offset and length of each block, so a
+//                 reader that has the section in memory (mapped or read
+//                 in one piece) can use the arrays where they lie.
+//
+//                 A block may be compressed: its bytes are regrouped by
+//                 their position within each element and then packed in
+//                 the LZ4 block format.  Blocks are stored in the byte
+//                 order of the machine that wrote them and swapped by
+//                 the reader if needed.
+//
+//                 Layout, all integers in the writer's byte order:
+//                   "FBLK", version, number of blocks, 0, section size (8)
+//                   per block: type, flags, element size, 0,
+//                              offset (8), stored bytes (8), raw bytes (8)
+//                   block data, each block at an 8 byte aligned offset
+//                 Offsets are from the start of the section.
+//
+//-------------------------------------------------------------------------
+
+#ifndef FACETBLOCKFILE_HPP
+#define FACETBLOCKFILE_HPP
+
+#include "CubitDefines.h"
+#include <stdio.h>
+#include <vector>
+
+class FacetBlockWriter
+{
+public:
+
+  FacetBlockWriter();
+  ~FacetBlockWriter();
+
+  void add_block( int type, const void *data, size_t count, int elem_size,
+                  bool compress = false );
+    //- Add a block of count elements of elem_size bytes.  The data is
+    //- not copied unless it is compressed, so it must stay valid until
+    //- write is called.  A compressed block is stored uncompressed if
+    //- compressing does not make it noticeably smaller.
+
+  CubitStatus write( FILE *fp );
+    //- Write the section at the next 8 byte aligned position in fp.
+
+  size_t stored_bytes() const;
+    //- The size of the section as written.
+
+private:
+
+  struct Block
+  {
+    int type;
+    int elemSize;
+    unsigned int flags;
+    size_t rawBytes;
+    const char *data;
+    std::vector<char> packed;
+  };
+
+  std::vector<Block> blockList;
+};
+
+class FacetBlockReader
+{
+public:
+
+  FacetBlockReader();
+  ~FacetBlockReader();
+
+  static CubitStatus section_size( FILE *fp, unsigned int endian,
+                                   long &start, size_t &size );
+    //- Find the section at the next 8 byte aligned position in fp and
+    //- read its size from the header.  Leaves fp at start.
+
+  CubitStatus open( const char *section, size_t size, unsigned int endian );
+    //- Use the section at the given address.  size may be larger than the
+    //- section.  endian is non-zero if the file was written with the other
+    //- byte order, as returned by CIOWrapper::get_endian.  The memory must
+    //- stay valid while blocks are used.
+
+  size_t size() const
+    { return sectionSize; }
+    //- The size of the section.
+
+  const void *block( int type, size_t &count, int elem_size );
+    //- The elements of the given block, or NULL with count 0 if there is
+    //- no such block or it is damaged.  Compressed or byte swapped blocks
+    //- are expanded into memory owned by the reader.
+
+private:
+
+  struct Entry
+  {
+    int type;
+    unsigned int flags;
+    int elemSize;
+    size_t offset;
+    size_t storedBytes;
+    size_t rawBytes;
+  };
+
+  const char *sectionData;
+  size_t sectionSize;
+  bool swapBytes;
+  std::vector<Entry> entryList;
+  std::vector< std::vector<char>* > expandedBlocks;
+};
+
+#endif
@@ -22,6 +22,9 @@
 #include "DLIList.hpp"
 #include "CubitFacet.hpp"
 #include "CubitPoint.hpp"
+#include "CubitFacetEdge.hpp"
+#include "FacetContainmentTool.hpp"
+#include "FacetEvalTool.hpp"
 #include "CubitVector.hpp"
 #include "CubitString.hpp"
 #include "ShellSM.hpp"
@@ -58,11 +61,14 @@ FacetLump::FacetLump(DLIList<ShellSM*> &shells,
 {
   myBodyPtr = body_ptr;
   myShells += shells;
+  containTool = NULL;
 }
 
 
 FacetLump::~FacetLump()
-{}
+{
+  delete containTool;
+}
 
 //-------------------------------------------------------------------------
 // Purpose       : The purpose of this function is to append a
@@ -451,6 +457,64 @@ CubitPointContainment FacetLump::point_containment( const CubitVector &point )
   
 }
 
+void FacetLump::point_containment( const double *xyz, size_t num_points,
+                                   CubitPointContainment *results )
+{
+  // the surfaces of each shell, and whether they still match the tool
+  DLIList<FacetShell*> shells;
+  std::vector<DLIList<FacetSurface*> > shell_surfaces( myShells.size() );
+  std::vector<unsigned long> key;
+  int i, j;
+  myShells.reset();
+  for(i=0; i<myShells.size(); i++)
+  {
+    FacetShell *facet_shell = CAST_TO(myShells.get_and_step(), FacetShell);
+    shells.append( facet_shell );
+    facet_shell->get_surfaces( shell_surfaces[i] );
+    for (j=shell_surfaces[i].size(); j--;)
+    {
+      FacetSurface *facet_surf = shell_surfaces[i].get_and_step();
+      FacetEvalTool *eval_tool = facet_surf->get_eval_tool();
+      key.push_back( eval_tool ? eval_tool->change_stamp() : 0 );
+      key.push_back( facet_surf->get_shell_sense( facet_shell ) );
+      key.push_back( facet_surf->interp_order() );
+    }
+  }
+
+  if (!containTool || key != containKey)
+  {
+    delete containTool;
+    containTool = new FacetContainmentTool;
+    containKey.swap( key );
+    shells.reset();
+    for(i=0; i<shells.size(); i++)
+    {
+      FacetShell *facet_shell = shells.get_and_step();
+      for (j=shell_surfaces[i].size(); j--;)
+      {
+        FacetSurface *facet_surf = shell_surfaces[i].get_and_step();
+        DLIList<CubitFacet*> facets;
+        DLIList<CubitPoint*> points;
+        facet_surf->get_my_facets( facets, points );
+
+        // an interpolated surface can be up to about a facet edge length
+        // from each facet; closer points are checked against the surface
+        containTool->add_facets( facets, facet_surf->get_shell_sense( facet_shell ),
+                                 facet_surf->interp_order() != 0 ? 1.0 : 0.0 );
+      }
+    }
+    containTool->build();
+  }
+
+  containTool->point_containment( xyz, num_points, results );
+  for (size_t ii=0; ii<num_points; ii++)
+  {
+    if (results[ii] == CUBIT_PNT_UNKNOWN)
+      results[ii] = point_containment( CubitVector( xyz[3*ii], xyz[3*ii+1],
+                                                    xyz[3*ii+2] ) );
+  }
+}
+
 //Determine whether this lump is really a sheet (that is, sheet-body).
 CubitBoolean FacetLump::is_sheet( )
 {
@@ -14,6 +14,7 @@
 #define FACET_LUMP_HPP
 
 // ********** BEGIN STANDARD INCLUDES      **********
+#include <vector>
 // ********** END STANDARD INCLUDES        **********
 
 // ********** BEGIN CUBIT INCLUDES         **********
@@ -34,6 +35,7 @@ class FacetLoop;
 class FacetCoEdge;
 class FacetCurve;
 class FacetPoint;
+class FacetContainmentTool;
 
 // ********** END FORWARD DECLARATIONS     **********
 
@@ -153,6 +155,14 @@ public:
 
   CubitPointContainment point_containment( const CubitVector &point );
 
+  void point_containment( const double *xyz, size_t num_points,
+                          CubitPointContainment *results );
+    //- Classify num_points x,y,z triples.  The facets of all shells are
+    //- put in one FacetContainmentTool, kept until the surfaces or their
+    //- facets change, so this is much faster than classifying the points
+    //- one at a time.  Points within a facet edge length of the facets of
+    //- interpolated (curved) surfaces are classified one at a time.
+
     //is this lump a sheet
   CubitBoolean is_sheet( );
 
@@ -164,6 +174,11 @@ private:
 
   FacetAttribSet attribSet;
     //List of FacetAttrib*'s instead of CubitSimpleAttribs 
+
+  FacetContainmentTool *containTool;
+  std::vector<unsigned long> containKey;
+    //- the tool used by point_containment, and the change stamp, shell
+    //- sense and interpolation order of each surface it was built from
 } ;
 
 
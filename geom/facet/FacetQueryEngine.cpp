@@ -67,9 +67,15 @@
 #include "KDDTree.hpp"
 #include "RTree.hpp"
 #include "FacetDataUtil.hpp"
+#include "CompactFacetMesh.hpp"
+#include "FacetBlockFile.hpp"
 #include "GridSearchTree.hpp"
+#include "CubitFileUtil.hpp"
+#include "CubitConcurrentApi.h"
 #include <stdio.h>
 #include <errno.h>
+#include <string.h>
+#include <algorithm>
 #include "GeometryModifyTool.hpp"
 #include "BodySM.hpp"
 
@@ -77,12 +83,41 @@ using namespace NCubitFile;
 
 FacetQueryEngine* FacetQueryEngine::instance_ = NULL;
 int FacetQueryEngine::hashPointSize = 0;
-DLIList<CubitPoint*> *FacetQueryEngine::hashPointArray = NULL;
+bool FacetQueryEngine::hashPointDense = true;
+std::vector<CubitPoint*> FacetQueryEngine::hashPointArray;
+std::vector<CubitPoint*> FacetQueryEngine::hashPointList;
+CubitBoolean FacetQueryEngine::compressFacetBlocks = CUBIT_FALSE;
+int FacetQueryEngine::mbgFileVersion = 1;
 
 const int FacetQueryEngine::FQE_MAJOR_VERSION = 10;
 const int FacetQueryEngine::FQE_MINOR_VERSION = 0;
 const int FacetQueryEngine::FQE_SUBMINOR_VERSION = 0;
 
+// Newest version of the mesh-based geometry files read and written.
+// Version 1 files write the facet data with CIOWrapper; version 2 files
+// hold it in a FacetBlockWriter section, with these block types.
+static const UnsignedInt32 MBG_FILE_VERSION = 2;
+enum MBGFacetBlock
+{
+  MBG_POINT_COORDS = 1,
+  MBG_POINT_UVS,
+  MBG_NORMAL_POINTS,
+  MBG_NORMALS,
+  MBG_EDGE_POINTS,
+  MBG_EDGE_CONTROL_POINTS,
+  MBG_FACET_EDGES,
+  MBG_FACET_FLAGS,
+  MBG_FACET_CONTROL_POINTS,
+  MBG_C_ZERO_INTS,
+  MBG_C_ZERO_DOUBLES,
+  MBG_SURFACE_TOOL_INTS,
+  MBG_SURFACE_TOOL_DOUBLES,
+  MBG_SURFACE_TOOL_IDS,
+  MBG_CURVE_TOOL_INTS,
+  MBG_CURVE_TOOL_DOUBLES,
+  MBG_CURVE_TOOL_IDS
+};
+
 //================================================================================
 // Description:
 // Author     :
@@ -951,14 +986,21 @@ CubitStatus FacetQueryEngine::export_solid_model( DLIList<TopologyBridge*>& ref_
   file_writer.Write( &endian_value, 1 );
 
   // write out version #
-  UnsignedInt32 version = 1;
+  UnsignedInt32 version = mbgFileVersion;
   file_writer.Write( &version, 1 );
 
 
   //save the facets (geometry info )
   CubitStatus status;
-  status = save_facets( file_ptr, facet_surfaces, facet_curves, facet_points );
-  if( status == CUBIT_FAILURE ) return CUBIT_FAILURE;
+  if( version >= 2 )
+    status = save_facet_blocks( file_ptr, facet_surfaces, facet_curves, facet_points );
+  else
+    status = save_facets( file_ptr, facet_surfaces, facet_curves, facet_points );
+  if( status == CUBIT_FAILURE )
+  {
+    fclose( file_ptr );
+    return CUBIT_FAILURE;
+  }
 
   //write out topology and attributes
   status = write_topology( file_ptr,
@@ -1911,7 +1953,12 @@ CubitStatus FacetQueryEngine::import_solid_model( const char* file_name ,
     return CUBIT_FAILURE;
   }
 
-  CubitStatus status = import_solid_model(file_ptr, imported_entities );
+  // the facet data of version 2 files is used straight from the mapped
+  // file, if it can be mapped
+  CubitMappedFile mapped_file;
+  mapped_file.open( CubitString(file_name) );
+  CubitStatus status = import_solid_model(file_ptr, mapped_file.data(),
+                                          mapped_file.size(), imported_entities );
   
   fclose(file_ptr);
   return status;
@@ -1919,6 +1966,14 @@ CubitStatus FacetQueryEngine::import_solid_model( const char* file_name ,
 
 CubitStatus FacetQueryEngine::import_solid_model(FILE *file_ptr,
                                                  DLIList<TopologyBridge*> &imported_entities )
+{
+  return import_solid_model( file_ptr, NULL, 0, imported_entities );
+}
+
+CubitStatus FacetQueryEngine::import_solid_model(FILE *file_ptr,
+                                                 const char *mapped_file,
+                                                 size_t mapped_size,
+                                                 DLIList<TopologyBridge*> &imported_entities )
 
 {
   CubitPoint **points_array = NULL;
@@ -1952,10 +2007,46 @@ CubitStatus FacetQueryEngine::import_solid_model(FILE *file_ptr,
 
   //Read in points/edges/facets
   CubitStatus status;
-  status = restore_facets( file_ptr, file_reader.get_endian(),
-                           num_points, num_edges,
-                           num_facets, points_array, num_cfet,
-                           num_fet, cfet_array, fet_array );
+  if( version >= 2 )
+  {
+    if( version > MBG_FILE_VERSION )
+    {
+      PRINT_ERROR("MESH_BASED_GEOMETRY file version %u is newer than this program reads\n",
+                  (unsigned)version);
+      return CUBIT_FAILURE;
+    }
+
+    long start;
+    size_t size;
+    std::vector<char> buffer;
+    FacetBlockReader reader;
+    status = FacetBlockReader::section_size( file_ptr, file_reader.get_endian(),
+                                             start, size );
+    if( status == CUBIT_SUCCESS )
+    {
+      if( mapped_file && (size_t)start <= mapped_size )
+        status = reader.open( mapped_file + start, mapped_size - start,
+                              file_reader.get_endian() );
+      else
+      {
+        buffer.resize( size + 1 );
+        if( fread( &buffer[0], 1, size, file_ptr ) != size )
+          status = CUBIT_FAILURE;
+        else
+          status = reader.open( &buffer[0], size, file_reader.get_endian() );
+      }
+    }
+    if( status == CUBIT_SUCCESS )
+      status = restore_facet_blocks( reader, num_points, points_array,
+                                     num_cfet, num_fet, cfet_array, fet_array );
+    if( status == CUBIT_SUCCESS && fseek( file_ptr, start + (long)size, SEEK_SET ) )
+      status = CUBIT_FAILURE;
+  }
+  else
+    status = restore_facets( file_ptr, file_reader.get_endian(),
+                             num_points, num_edges,
+                             num_facets, points_array, num_cfet,
+                             num_fet, cfet_array, fet_array );
   if( status == CUBIT_FAILURE)
   {
     PRINT_ERROR("Problems restore facets\n");
@@ -2442,6 +2533,26 @@ FacetQueryEngine::delete_solid_model_entities( TBPoint* point ) const
   return CUBIT_SUCCESS;
 }
 
+//-------------------------------------------------------------------------
+// Purpose       : Fire a ray at the specified entities, returning the
+//                 parameters (distances) along the ray and optionally the
+//                 entities hit.
+//
+// Special Notes : Bodies and lumps report the FacetSurfaces hit.  Each
+//                 surface fires the ray at the facet tree of its eval tool,
+//                 after a test against its bounding box.  Hits on
+//                 different surfaces within ray_radius of each other are
+//                 one crossing of a shared curve or point and reported
+//                 once.  The hits on each entity in at_entity_list are
+//                 sorted by distance and limited to max_hits.
+//
+//-------------------------------------------------------------------------
+static bool ray_hit_less( const std::pair<double,TopologyBridge*> &a,
+                          const std::pair<double,TopologyBridge*> &b )
+{
+  return a.first < b.first;
+}
+
 CubitStatus FacetQueryEngine::fire_ray( CubitVector &origin,
                                         CubitVector &direction,
                                         DLIList<TopologyBridge*> &at_entity_list,
@@ -2450,153 +2561,99 @@ CubitStatus FacetQueryEngine::fire_ray( CubitVector &origin,
                                         double ray_radius,
                                         DLIList<TopologyBridge*> *hit_entity_list) const
 {
-  
-  TopologyBridge *bridge_ptr;
-  int i, j;
-  bool hit = false;
+  if( ray_radius == 0.0 )
+    ray_radius = GEOMETRY_RESABS;
 
-  DLIList<double> tmp_ray_params;
-  DLIList<FacetSurface*> at_surface_list;
-  DLIList<FacetCurve*> at_curve_list;
-  DLIList<FacetPoint*> at_point_list;
+  CubitVector unit_dir = direction;
+  if( unit_dir.length() < CUBIT_RESABS )
+    return CUBIT_FAILURE;
+  unit_dir.normalize();
+
+  std::vector<double> distances;
+  std::vector<std::pair<double,TopologyBridge*> > hits;
+  int i, j;
 
-  if( ray_radius == 0.0 )
-	  ray_radius = get_sme_resabs_tolerance();
-  
   at_entity_list.reset();
   for (i=0; i<at_entity_list.size(); i++)
   {
-	  hit = false;
-	  bridge_ptr = at_entity_list.get_and_step();
-
-	  //determine which type of geometry we have. body, lump, face, curve?
-	  if (CAST_TO(bridge_ptr, FacetBody))
-	  {
-		  FacetBody* f_body = CAST_TO(bridge_ptr, FacetBody);
-		  DLIList<Surface*> surface_list;
-		  f_body->surfaces(surface_list);
-	  }
-	  else if (CAST_TO(bridge_ptr, FacetLump))
-	  {
-		  FacetLump* f_lump = CAST_TO(bridge_ptr, FacetLump);
-		  PRINT_INFO("Found FacetLump.\n");
-		  DLIList<FacetSurface*> f_surface_list;
-		  f_lump->get_surfaces(f_surface_list);
-		  at_surface_list.merge_unique(f_surface_list);
-	  }
-	  else if (CAST_TO(bridge_ptr, Surface))
-	  {
-		  FacetSurface* f_surface = CAST_TO(bridge_ptr, FacetSurface);
-		  
-		  DLIList<CubitFacet*> facet_list;
-		  DLIList<CubitPoint*> point_list;
-		  f_surface->get_my_facets(facet_list, point_list);
-
-		  //PRINT_INFO("There are %d facets.\n", facet_list.size());
-
-		  //RTree<CubitFacet*> rtree(ray_radius);
-		  //for (j=0; j<facet_list.size(); j++)
-			//  rtree.add(facet_list.get_and_step();
-		  
-		  //DLIList<CubitFacet*> facet_list1;
-		  //CubitBox range_box();
-		  //make range box for the ray
-		  //rtree.find(range_box, facet_list1);
-
-		  CubitVector* intersection_pt = new CubitVector();		
-	      double distance;
-
-		  for (j=0; j<facet_list.size(); j++)
-		  {
-			  if (hit)
-				  break;
-
-			  CubitFacet* facet = facet_list.get_and_step();
-
-			  // Find intersection of ray with triangle
-			  int rv = FacetEvalTool::intersect_ray(origin, direction, facet, intersection_pt, distance);
-
-			  switch (rv)
-			  {
-			  case -1:
-				  //PRINT_INFO("Facet is degenerate (segment or point).\n");
-				  break;
-			  case 0:
-				  //PRINT_INFO("Ray does not intersect the facet.\n");
-				  break;
-			  case 1:
-				  {
-					  hit = true;
-					  if (hit_entity_list)
-						  hit_entity_list->append(bridge_ptr);
-					  ray_params.append(distance);
-					  //PRINT_INFO("Ray intersects facet at %f, %f, %f.\n", intersection_pt->x(), intersection_pt->y(), intersection_pt->z());
-					
-					  continue;
-				  }
-			  case 2:
-				  //PRINT_INFO("Ray is in same plane as the facet.\n");
-				  break;
-			  }
-		  }
-          if (intersection_pt)
-              delete intersection_pt;
-	  
-	  }
-	  else if (CAST_TO(bridge_ptr, Curve))
-	  {
-		  FacetCurve* f_curve = CAST_TO(bridge_ptr, FacetCurve);
-		  DLIList<CubitFacetEdge*> facet_edge_list;
-		  f_curve->get_facets(facet_edge_list);
-
-		  //PRINT_INFO("There are %d facetedges.\n", facet_edge_list.size());
-          CubitVector* intersection_pt = new CubitVector();		
-          double distance;
-
-          for (j=0; j<facet_edge_list.size(); j++)
-		  {
-			  if (hit)
-				  break;
-
-			  CubitFacetEdge* facet_edge = facet_edge_list.get_and_step();
-
-			  int rv = FacetEvalTool::intersect_ray(origin, direction, facet_edge, intersection_pt, distance);
-
-			  switch (rv)
-			  {
-			  case -1:
-				  //PRINT_INFO("Facet is degenerate (segment or point).\n");
-				  break;
-			  case 0:
-				  //PRINT_INFO("Ray does not intersect the facet edge.\n");
-				  break;
-			  case 1:
-				  {
-					  hit = true;
-					  if (hit_entity_list)
-						  hit_entity_list->append(bridge_ptr);
-					  ray_params.append(distance);
-					  //PRINT_INFO("Ray intersects facet at %f, %f, %f.\n", intersection_pt->x(), intersection_pt->y(), intersection_pt->z());
-					
-					  continue;
-				  }
-			  case 2:
-				  //PRINT_INFO("Ray is parallel to the facet.\n");
-				  break;
-			  }
-
-		  }
-          if (intersection_pt)
-              delete intersection_pt;
-	  }
-	  else if (CAST_TO(bridge_ptr, FacetPoint))
-	  {
-		  FacetPoint* f_point = CAST_TO(bridge_ptr, FacetPoint);
-		  at_point_list.append_unique(f_point);
-	  }
-	  else
-		  ;//PRINT_INFO("Cast error in FacetQueryEngine::fire_ray.\n");
+    TopologyBridge *bridge_ptr = at_entity_list.get_and_step();
+    DLIList<FacetSurface*> surface_list;
+    hits.clear();
+
+    //determine which type of geometry we have. body, lump, face, curve?
+    if (FacetBody *f_body = CAST_TO(bridge_ptr, FacetBody))
+      f_body->get_surfaces(surface_list);
+    else if (FacetLump *f_lump = CAST_TO(bridge_ptr, FacetLump))
+      f_lump->get_surfaces(surface_list);
+    else if (FacetSurface *f_surface = CAST_TO(bridge_ptr, FacetSurface))
+      surface_list.append(f_surface);
+    else if (FacetCurve *f_curve = CAST_TO(bridge_ptr, FacetCurve))
+    {
+      DLIList<CubitFacetEdge*> facet_edge_list;
+      f_curve->get_facets(facet_edge_list);
+
+      CubitVector intersection_pt;
+      double distance;
+      distances.clear();
+      for (j=0; j<facet_edge_list.size(); j++)
+      {
+        CubitFacetEdge* facet_edge = facet_edge_list.get_and_step();
+        if (FacetEvalTool::intersect_ray(origin, direction, facet_edge,
+                                         &intersection_pt, distance) == 1 &&
+            distance >= -ray_radius)
+          distances.push_back(CUBIT_MAX(distance, 0.0));
+      }
+
+      // a ray through a facet point hits both of its edges
+      std::sort(distances.begin(), distances.end());
+      for (j=0; j<(int)distances.size(); j++)
+        if (j == 0 || distances[j] - distances[j-1] > ray_radius)
+          hits.push_back(std::make_pair(distances[j], bridge_ptr));
+    }
+    else if (FacetPoint *f_point = CAST_TO(bridge_ptr, FacetPoint))
+    {
+      CubitVector to_point = f_point->coordinates() - origin;
+      double distance = to_point % unit_dir;
+      if (distance >= -ray_radius &&
+          (to_point - distance * unit_dir).length() <= ray_radius)
+        hits.push_back(std::make_pair(CUBIT_MAX(distance, 0.0), bridge_ptr));
+    }
+
+    surface_list.reset();
+    for (j=0; j<surface_list.size(); j++)
+    {
+      FacetSurface *f_surface = surface_list.get_and_step();
+      const FacetEvalTool *eval_tool = f_surface->get_eval_tool();
+      if (!eval_tool)
+        continue;
+      distances.clear();
+      eval_tool->fire_ray(origin, unit_dir, ray_radius, max_hits, distances);
+      for (size_t k=0; k<distances.size(); k++)
+        hits.push_back(std::make_pair(distances[k], (TopologyBridge*)f_surface));
+    }
+
+    std::stable_sort(hits.begin(), hits.end(), ray_hit_less);
 
+    // a ray through a curve or point shared by surfaces of a body or
+    // lump hits each of them there; report the crossing once, on the
+    // first surface
+    if (surface_list.size() > 1)
+    {
+      size_t kept = 0;
+      for (size_t k=0; k<hits.size(); k++)
+        if (kept == 0 || hits[k].first - hits[kept-1].first > ray_radius)
+          hits[kept++] = hits[k];
+      hits.resize(kept);
+    }
+
+    if (max_hits > 0 && (int)hits.size() > max_hits)
+      hits.resize(max_hits);
+    for (j=0; j<(int)hits.size(); j++)
+    {
+      ray_params.append(hits[j].first);
+      if (hit_entity_list)
+        hit_entity_list->append(hits[j].second);
+    }
   }
 
   return CUBIT_SUCCESS;
@@ -2604,6 +2661,59 @@ CubitStatus FacetQueryEngine::fire_ray( CubitVector &origin,
   //- fire a ray at the specified entities, returning the parameters
   //- (distances) along the ray and optionally the entities hit
 
+CubitStatus FacetQueryEngine::point_containment( TopologyBridge *body_or_lump,
+                                   const std::vector<CubitVector> &points,
+                                   std::vector<CubitPointContainment> &results ) const
+{
+  DLIList<FacetLump*> lump_list;
+  FacetBody *f_body = CAST_TO(body_or_lump, FacetBody);
+  FacetLump *f_lump = CAST_TO(body_or_lump, FacetLump);
+  if (f_body)
+  {
+    DLIList<FacetLump*> lumps;
+    f_body->get_lumps(lumps);
+    lump_list += lumps;
+  }
+  else if (f_lump)
+    lump_list.append(f_lump);
+  else
+  {
+    PRINT_ERROR("FacetQueryEngine::point_containment needs a facet body or volume.\n");
+    return CUBIT_FAILURE;
+  }
+
+  size_t num_points = points.size();
+  results.assign(num_points, CUBIT_PNT_OUTSIDE);
+  if (num_points == 0)
+    return CUBIT_SUCCESS;
+
+  std::vector<double> xyz(3*num_points);
+  size_t ii;
+  for (ii=0; ii<num_points; ii++)
+  {
+    xyz[3*ii]   = points[ii].x();
+    xyz[3*ii+1] = points[ii].y();
+    xyz[3*ii+2] = points[ii].z();
+  }
+
+    // inside any lump is inside the body; otherwise on the boundary of
+    // any lump is on the boundary
+  std::vector<CubitPointContainment> lump_results(num_points);
+  for (int jj=0; jj<lump_list.size(); jj++)
+  {
+    lump_list.get_and_step()->point_containment(&xyz[0], num_points,
+                                                &lump_results[0]);
+    for (ii=0; ii<num_points; ii++)
+    {
+      if (lump_results[ii] == CUBIT_PNT_INSIDE ||
+          (lump_results[ii] == CUBIT_PNT_BOUNDARY &&
+           results[ii] != CUBIT_PNT_INSIDE))
+        results[ii] = lump_results[ii];
+    }
+  }
+
+  return CUBIT_SUCCESS;
+}
 
 double FacetQueryEngine::get_sme_resabs_tolerance() const
 {
@@ -2819,7 +2929,7 @@ CubitStatus FacetQueryEngine::ensure_is_ascii_stl_file(FILE * fp, CubitBoolean &
 //===========================================================================
 CubitStatus FacetQueryEngine::read_facets_stl_tolerance(
                                               DLIList<CubitFacet *> &tfacet_list,
-                                              DLIList<CubitPoint *> & /*point_list*/,
+                                              DLIList<CubitPoint *> &point_list,
                                               const char * file_name,
                                               int &npoints,
                                               int &ntri,
@@ -2945,44 +3055,10 @@ CubitStatus FacetQueryEngine::read_facets_stl_tolerance(
   else
   {
     fclose(fp);
-    // file is closed so that it can be opened as binary
-    fp = fopen(file_name, "rb");
-    if (fp == NULL)
-    {
-      PRINT_ERROR("Could not open file %s for reading\n", file_name);
-      return CUBIT_FAILURE;
-    }
-
-    char dummy;
-        // iterates through the facets of the file
-    float cur[12];		// an array to hold 48 bytes representing 1AVS facet
-
-    fseek(fp, 80, SEEK_SET);
-    fread(&ntri, 4, 1, fp);
-
-    PRINT_INFO ("Reading facets...\n");
-    for (ii=0; ii<ntri; ii++) {
-      // read in 1 facet
-      if (!fread(cur, 4, 12, fp))
-      {
-        PRINT_INFO ("Abnormal file termination %s \n", file_name); break;
-      }
-    	fread(&dummy, 1, 1, fp);
-       fread(&dummy, 1, 1, fp);
-
-        //make point
-      current_point = (CubitPoint *) new CubitPointData(cur[3],cur[4],cur[5]);
-      current_point->set_id(points_in_file++);
-      file_points.append(current_point);
-      current_point = (CubitPoint *) new CubitPointData(cur[6],cur[7],cur[8]);
-      current_point->set_id(points_in_file++);
-      file_points.append(current_point);
-      current_point = (CubitPoint *) new CubitPointData(cur[9],cur[10],cur[11]);
-      current_point->set_id(points_in_file++);
-      file_points.append(current_point);
-    }
+    seek_address = 0;
+    return read_facets_stl_binary(tfacet_list, point_list, file_name,
+                                  npoints, ntri, tolerance);
   }
-  fclose(fp);
   
 // at this point all points from the file are in file_points
 end_read_file_points:
@@ -3235,121 +3311,109 @@ CubitStatus FacetQueryEngine::read_facets_stl(
   else
   {
     fclose(fp);
-    // file is closed so that it can be opened as binary
-    fp = fopen(file_name, "rb");
-    if (fp == NULL)
-    {
-      PRINT_ERROR("Could not open file %s for reading\n", file_name);
-      return CUBIT_FAILURE;
-    }
+    seek_address = 0;
+    return read_facets_stl_binary(tfacet_list, point_list, file_name,
+                                  npoints, ntri, 0.0);
+  }
+}
 
+namespace
+{
+  //-----------------------------------------------------------------
+  // Copies the vertices of a range of 50-byte binary STL records
+  // into a CompactFacetMesh that has been sized for them.
+  //-----------------------------------------------------------------
+  class StlRecordParser
+  {
+  public:
+    StlRecordParser( const char *records, double *coords )
+      : stlRecords(records), pointCoords(coords) {}
 
-    CubitFacet *facet_ptr = NULL;
-    CubitPoint *point0,
-              *point1,
-                *point2;
-
-    char dummy;
-    int		   ii=0;    // iterates through the facets of the file
-    float cur[12];		// an array to hold 48 bytes representing 1 facet
-    npoints=0;          // only tri facets in stl files
-
-    fseek(fp, 80, SEEK_SET);
-    fread(&ntri, 4, 1, fp);
-    int distinct_ntri=ntri;
-
-    PRINT_INFO ("Reading facets...\n");
-    for (ii=0; ii<ntri; ii++) {
-      // read in 1 facet
-      if (!fread(cur, 4, 12, fp))
+    void parse( std::pair<int,int> range )
+    {
+      float cur[9];
+      for( int ii = range.first; ii < range.second; ii++ )
       {
-        PRINT_INFO ("Abnormal file termination %s \n", file_name); break;
+          // skip the normal, the first 12 bytes of each record
+        memcpy( cur, stlRecords + 50*(size_t)ii + 12, sizeof(cur) );
+        double *xyz = pointCoords + 9*(size_t)ii;
+        for( int jj = 0; jj < 9; jj++ )
+          xyz[jj] = cur[jj];
       }
-    		fread(&dummy, 1, 1, fp);
-        fread(&dummy, 1, 1, fp);
+    }
 
-        //make point
-        point0 = (CubitPoint *) new CubitPointData( cur[3], cur[4], cur[5] );
+  private:
+    const char *stlRecords;
+    double *pointCoords;
+  };
+}
 
-        pos=mm.find(point0);
-        if (pos==mm.end())
-        {
-          mm.insert ( vMap::value_type(point0, npoints));
-          point0->set_id( npoints ++ );
-          //point_list is output of function
-          point_list.append(point0);
-        }
-        else
-        {
-          delete point0;
-          point0=((*pos).first);
-        }
+//===========================================================================
+//Function Name: read_facets_stl_binary
+//Member Type:  PRIVATE
+//Description:  read facets from a binary stl file.  The file is mapped
+// into memory and the records copied in parallel chunks.  If tolerance
+// is positive, vertices within tolerance are combined the same way
+// GridSearchTree does it; otherwise vertices with equal coordinates are
+// merged by hashing.
+//===========================================================================
+CubitStatus FacetQueryEngine::read_facets_stl_binary(
+                                              DLIList<CubitFacet *> &tfacet_list,
+                                              DLIList<CubitPoint *> &point_list,
+                                              const char * file_name,
+                                              int &npoints,
+                                              int &ntri,
+                                              double tolerance )
+{
+  npoints = 0;
+  ntri = 0;
 
-        //make point
-        point1 = (CubitPoint *) new CubitPointData( cur[6], cur[7], cur[8] );
+  CubitMappedFile file;
+  if (!file.open(CubitString(file_name)) || file.size() < 84)
+  {
+    PRINT_ERROR("Could not open file %s for reading\n", file_name);
+    return CUBIT_FAILURE;
+  }
 
-        pos=mm.find(point1);
-        if (pos==mm.end())
-        {
-          mm.insert ( vMap::value_type(point1, npoints));
-          point1->set_id( npoints ++ );
-          //point_list is output of function
-          point_list.append(point1);
-        }
-        else
-        {
-          delete point1;
-          point1=((*pos).first);
-        }
+  int num_tri;
+  memcpy(&num_tri, file.data() + 80, 4);
+  size_t max_tri = (file.size() - 84) / 50;
+  if (num_tri < 0 || (size_t)num_tri > max_tri)
+  {
+    PRINT_INFO ("Abnormal file termination %s \n", file_name);
+    num_tri = num_tri < 0 ? 0 : (int)max_tri;
+  }
 
-        //make point
-        point2 = (CubitPoint *) new CubitPointData( cur[9], cur[10], cur[11] );
+  PRINT_INFO ("Reading facets...\n");
+  CompactFacetMesh mesh;
+  mesh.resize( 3*num_tri, num_tri );
+  if (!num_tri)
+    return CUBIT_SUCCESS;
 
-        pos=mm.find(point2);
-        if (pos==mm.end())
-        {
-          mm.insert ( vMap::value_type(point2, npoints));
-          point2->set_id( npoints ++ );
-          //point_list is output of function
-          point_list.append(point2);
-        }
-        else
-        {
-          delete point2;
-          point2=((*pos).first);
-        }
+  int *conn = mesh.connectivity();
+  for (int ii = 0; ii < 3*num_tri; ii++)
+    conn[ii] = ii;
 
-        // this is to avoid a facet with all points on same line, which crashes CUBIT
-        // because of assertion
-        if (point0 && point1 && point2 && point0!=point1 && point1!=point2 && point2 !=point0)
-        {
-          facet_ptr = new CubitFacetData( point0, point1, point2 );
-          append_to_facet_list=CUBIT_TRUE;
-        }
-        else
-        {
-          append_to_facet_list=CUBIT_FALSE;
-        }
+  // a record is only a copy, so a task gets at least a few thousand
+  StlRecordParser parser( file.data() + 84, mesh.coords() );
+  CubitConcurrent::parallel_for_ranges( num_tri, parser, &StlRecordParser::parse, 4096 );
+  file.close();
 
-        if (!facet_ptr)
-        {
-          fclose(fp);
-          return CUBIT_FAILURE;
-        }
+  // welding every vertex read, in order, gives the same points as
+  // GridSearchTree; merging exact duplicates first could change which
+  // point a vertex near several kept points goes to
+  if (tolerance > 0.0)
+    mesh.weld_points( tolerance );
+  else
+    mesh.merge_coincident_points();
 
-        if (append_to_facet_list)
-        {
-          tfacet_list.append( facet_ptr );
-        }
-        else
-        {
-          distinct_ntri--;
-        }
-    }
-    ntri=distinct_ntri;
-    fclose(fp);
-    return CUBIT_SUCCESS;
-  }
+  // this is to avoid a facet with all points on same line, which crashes CUBIT
+  // because of assertion
+  mesh.remove_degenerate_triangles();
+
+  npoints = mesh.num_points();
+  ntri = mesh.num_triangles();
+  return mesh.convert_to_facets( point_list, tfacet_list );
 }
 
 
@@ -3452,6 +3516,9 @@ CubitStatus FacetQueryEngine::import_facets(
 
       // make cubit facet entities from the points and connectivity
 
+      qfacet_list.reserve( nquad );
+      tfacet_list.reserve( ntri );
+      point_list.reserve( npoints );
       if (nquad  > 0)
         rv = make_facets(conn, nfacets, qfacet_list);
       if (ntri > 0)
@@ -4272,40 +4339,81 @@ CubitStatus FacetQueryEngine::export_facets(DLIList<CubitFacet*> &facet_list,
 //=============================================================================
 CubitStatus FacetQueryEngine::init_hash_points( int num_points )
 {
-  /* === find the next highest prime number */
+  if (num_points < 0)
+    return CUBIT_FAILURE;
 
-  hashPointSize = num_points / 10;
-  int i;
-  if (hashPointSize < 13) hashPointSize = 13;
-  else
-  {
-    i=2;
-    while (i<hashPointSize*0.5 + 1) {
-      if (hashPointSize % i == 0) {
-        i=2;
-        hashPointSize++;
-      }
-      else {
-        i++;
-      }
-    }
-  }
-  hashPointArray = new DLIList<CubitPoint*>[hashPointSize];
+  // ids are usually 0 or 1 to num_points, so start with a table indexed
+  // directly by id and switch to hashing only if an id doesn't fit
+  hashPointDense = true;
+  hashPointSize = num_points + 2;
+  hashPointArray.assign( hashPointSize, (CubitPoint*)NULL );
+  hashPointList.clear();
+  hashPointList.reserve( num_points );
 
   return CUBIT_SUCCESS;
 }
 
+//=============================================================================
+//Function:  rehash_points (PRIVATE)
+//Description: rebuild the hash array as an open-addressing table of
+//             table_size slots from the points added so far
+//=============================================================================
+void FacetQueryEngine::rehash_points( int table_size )
+{
+  hashPointDense = false;
+  hashPointSize = table_size;
+  hashPointArray.assign( hashPointSize, (CubitPoint*)NULL );
+
+  for (size_t ii=0; ii<hashPointList.size(); ii++)
+  {
+    CubitPoint *point_ptr = hashPointList[ii];
+    int key = get_hash_key( point_ptr->id() );
+    while (hashPointArray[key] && hashPointArray[key]->id() != point_ptr->id())
+      key = (key + 1) & (hashPointSize - 1);
+    if (!hashPointArray[key])
+      hashPointArray[key] = point_ptr;
+  }
+}
+
 //=============================================================================
 //Function:  add_hash_point (PRIVATE)
-//Description: hash the point into the hash table
+//Description: hash the point into the hash table.  If a point with the same
+//             id was already added, that point stays in the table.
 //Author: sjowen
 //Date: 4/3/02
 //=============================================================================
 CubitStatus FacetQueryEngine::add_hash_point( CubitPoint *point_ptr )
 {
   int id = point_ptr->id();
+  hashPointList.push_back( point_ptr );
+
+  if (hashPointDense)
+  {
+    if (id >= 0 && id < hashPointSize)
+    {
+      if (!hashPointArray[id])
+        hashPointArray[id] = point_ptr;
+      return CUBIT_SUCCESS;
+    }
+    int table_size = 16;
+    while (table_size < 2 * (int)hashPointList.capacity())
+      table_size *= 2;
+    rehash_points( table_size );
+    return CUBIT_SUCCESS;
+  }
+
+  // keep the table at most half full
+  if (2 * (int)hashPointList.size() > hashPointSize)
+  {
+    rehash_points( 2 * hashPointSize );
+    return CUBIT_SUCCESS;
+  }
+
   int key = get_hash_key( id );
-  hashPointArray[key].append( point_ptr );
+  while (hashPointArray[key] && hashPointArray[key]->id() != id)
+    key = (key + 1) & (hashPointSize - 1);
+  if (!hashPointArray[key])
+    hashPointArray[key] = point_ptr;
   return CUBIT_SUCCESS;
 }
 
@@ -4317,17 +4425,19 @@ CubitStatus FacetQueryEngine::add_hash_point( CubitPoint *point_ptr )
 //=============================================================================
 CubitPoint *FacetQueryEngine::get_hash_point( int id )
 {
+  if (hashPointDense)
+  {
+    if (id < 0 || id >= hashPointSize)
+      return (CubitPoint*)NULL;
+    return hashPointArray[id];
+  }
+
   int key = get_hash_key( id );
-  int ii;
-  int found = 0;
-  CubitPoint *point_ptr;
-  for (ii=0; ii<hashPointArray[key].size() && !found; ii++)
+  while (hashPointArray[key])
   {
-    point_ptr = hashPointArray[key].get_and_step();
-    if (point_ptr->id() == id)
-    {
-      return point_ptr;
-    }
+    if (hashPointArray[key]->id() == id)
+      return hashPointArray[key];
+    key = (key + 1) & (hashPointSize - 1);
   }
   return (CubitPoint*)NULL;
 }
@@ -4340,44 +4450,39 @@ CubitPoint *FacetQueryEngine::get_hash_point( int id )
 //=============================================================================
 void FacetQueryEngine::delete_hash_points( )
 {
-  if (hashPointArray)
-   delete [] hashPointArray;
-  hashPointArray = NULL;
+  std::vector<CubitPoint*>().swap( hashPointArray );
+  std::vector<CubitPoint*>().swap( hashPointList );
   hashPointSize = 0;
+  hashPointDense = true;
 }
 
 //=============================================================================
 //Function:  get_hash_key (PRIVATE)
-//Description:
+//Description: first slot to try for an id in the open-addressing table
 //Author: sjowen
 //Date: 4/3/02
 //=============================================================================
 int FacetQueryEngine::get_hash_key( int id )
 {
-  int key = id % hashPointSize;
-  return key;
+  unsigned int key = (unsigned int)id * 2654435761u;
+  key ^= key >> 16;
+  return (int)(key & (unsigned int)(hashPointSize - 1));
 }
 
 //===========================================================================
 //Function Name: get_all_hash_points
 //Member Type:  PUBLIC
-//Description:  makes a single list from all points in the hash table
+//Description:  makes a single list from all points in the hash table, in
+//              the order they were added
 //===========================================================================
 CubitStatus FacetQueryEngine::get_all_hash_points(
   DLIList<CubitPoint *> &point_list ) // return point list
 {
   CubitStatus rv = CUBIT_SUCCESS;
 
-  int ii, jj;
-  CubitPoint *point_ptr;
-  for(jj=0; jj<hashPointSize; jj++)
-  {
-    for (ii=0; ii<hashPointArray[jj].size(); ii++)
-    {
-      point_ptr = hashPointArray[jj].get_and_step();
-      point_list.append(point_ptr);
-    }
-  }
+  point_list.reserve( point_list.size() + (int)hashPointList.size() );
+  for (size_t ii=0; ii<hashPointList.size(); ii++)
+    point_list.append( hashPointList[ii] );
 
   return rv;
 }
@@ -4579,6 +4684,391 @@ CubitStatus FacetQueryEngine::restore_eval_tools(
   return CUBIT_SUCCESS;
 }
 
+//===========================================================================
+//Function Name: set_mbg_file_version
+//Member Type:  PUBLIC
+//Description:  set the version of the mesh-based geometry files written
+//===========================================================================
+CubitStatus FacetQueryEngine::set_mbg_file_version( int version )
+{
+  if( version < 1 || version > (int)MBG_FILE_VERSION )
+  {
+    PRINT_ERROR("Cannot write MESH_BASED_GEOMETRY file version %d\n", version);
+    return CUBIT_FAILURE;
+  }
+  mbgFileVersion = version;
+  return CUBIT_SUCCESS;
+}
+
+
+//===========================================================================
+//Function Name: save_facet_blocks
+//Member Type:  PUBLIC
+//Description:  save the facets and eval tools of the entities to fp as
+//              one FacetBlockWriter section.  Each array of the CUB file
+//              facet data becomes a block, so restoring needs no parsing.
+//===========================================================================
+CubitStatus FacetQueryEngine::save_facet_blocks(
+  FILE *fp,
+  DLIList<FacetSurface*> &facet_surfaces,
+  DLIList<FacetCurve*> &facet_curves,
+  DLIList<FacetPoint*> &facet_points )
+{
+  DLIList<CubitFacet *> facet_list;
+  DLIList<CubitFacetEdge *> edge_list;
+  DLIList<CubitPoint *> point_list;
+
+  // get a unique list of all facets, edges and points.  This sets
+  // their ids to their index in the lists.
+  CubitStatus rv = gather_facets(facet_surfaces, facet_curves, facet_points,
+                                 facet_list, edge_list, point_list );
+  if (rv != CUBIT_SUCCESS)
+    return rv;
+
+  int ii, jj;
+  bool compress = compressFacetBlocks ? true : false;
+
+  // points, their normals and the extra data at surface boundaries
+  int npoints = point_list.size();
+  std::vector<double> coords( 3*npoints ), uvs( 3*npoints );
+  std::vector<int> normal_points;
+  std::vector<double> normals;
+  int c_zero_int_size = 0, c_zero_double_size = 0;
+  CubitPoint *cp_ptr;
+  TDFacetBoundaryPoint *td_fbp;
+  point_list.reset();
+  for (ii=0; ii<npoints; ii++)
+  {
+    cp_ptr = point_list.get_and_step();
+    CubitVector coord = cp_ptr->coordinates();
+    coords[3*ii]   = coord.x();
+    coords[3*ii+1] = coord.y();
+    coords[3*ii+2] = coord.z();
+    uvs[3*ii]   = cp_ptr->u();
+    uvs[3*ii+1] = cp_ptr->v();
+    uvs[3*ii+2] = cp_ptr->size();
+    CubitVector *normal = cp_ptr->normal_ptr();
+    if (normal)
+    {
+      normal_points.push_back( ii );
+      normals.push_back( normal->x() );
+      normals.push_back( normal->y() );
+      normals.push_back( normal->z() );
+    }
+    if ((td_fbp = TDFacetBoundaryPoint::get_facet_boundary_point( cp_ptr )) != NULL)
+      td_fbp->get_boundary_point_data_size( c_zero_int_size, c_zero_double_size );
+  }
+
+  std::vector<int> c_zero_ints( c_zero_int_size );
+  std::vector<double> c_zero_doubles( c_zero_double_size );
+  if (c_zero_int_size > 0)
+  {
+    int iidx = 0, didx = 0;
+    point_list.reset();
+    for (ii=0; ii<npoints; ii++)
+    {
+      td_fbp = TDFacetBoundaryPoint::get_facet_boundary_point( point_list.get_and_step() );
+      if (td_fbp != NULL)
+        td_fbp->get_boundary_point_data( &c_zero_ints[0],
+                                         c_zero_doubles.empty() ? NULL : &c_zero_doubles[0],
+                                         iidx, didx );
+    }
+  }
+
+  // edges.  Control points are kept only if every edge has them.
+  int nedges = edge_list.size();
+  std::vector<int> edge_points( 2*nedges );
+  std::vector<double> edge_ctrl( 3*NUM_EDGE_CPTS*nedges );
+  CubitFacetEdge *edge_ptr;
+  CubitVector *ctrl_pts;
+  edge_list.reset();
+  for (ii=0; ii<nedges; ii++)
+  {
+    edge_ptr = edge_list.get_and_step();
+    edge_points[2*ii]   = edge_ptr->point(0)->id();
+    edge_points[2*ii+1] = edge_ptr->point(1)->id();
+    if (edge_ctrl.empty())
+      continue;
+    if ((ctrl_pts = edge_ptr->control_points()) == NULL)
+    {
+      edge_ctrl.clear();
+      continue;
+    }
+    for (jj=0; jj<NUM_EDGE_CPTS; jj++)
+      ctrl_pts[jj].get_xyz( &edge_ctrl[(ii*NUM_EDGE_CPTS+jj)*3] );
+  }
+
+  // facets, their is_flat and is_backwards flags and control points
+  int nfacets = facet_list.size();
+  std::vector<int> facet_edges( 3*nfacets ), facet_flags( 2*nfacets );
+  std::vector<double> facet_ctrl( 3*NUM_TRI_CPTS*nfacets );
+  CubitFacet *facet_ptr;
+  facet_list.reset();
+  for (ii=0; ii<nfacets; ii++)
+  {
+    facet_ptr = facet_list.get_and_step();
+    for (jj=0; jj<3; jj++)
+      facet_edges[3*ii+jj] = facet_ptr->edge(jj)->id();
+    facet_flags[2*ii]   = facet_ptr->is_flat();
+    facet_flags[2*ii+1] = facet_ptr->is_backwards();
+    if (facet_ctrl.empty())
+      continue;
+    if ((ctrl_pts = facet_ptr->control_points()) == NULL)
+    {
+      facet_ctrl.clear();
+      continue;
+    }
+    for (jj=0; jj<NUM_TRI_CPTS; jj++)
+      ctrl_pts[jj].get_xyz( &facet_ctrl[(ii*NUM_TRI_CPTS+jj)*3] );
+  }
+
+  // eval tools, numbered in the order they are written
+  std::vector<int> fet_ints, fet_ids, cfet_ints, cfet_ids;
+  std::vector<double> fet_doubles, cfet_doubles;
+  int ft_id = 0;
+  facet_surfaces.reset();
+  for (ii=facet_surfaces.size(); ii--; )
+  {
+    FacetEvalTool *feval_tool = facet_surfaces.get_and_step()->get_eval_tool();
+    if (feval_tool)
+    {
+      feval_tool->set_output_id( ft_id++ );
+      feval_tool->save( fet_ints, fet_doubles, fet_ids );
+    }
+  }
+  facet_curves.reset();
+  for (ii=facet_curves.size(); ii--; )
+  {
+    CurveFacetEvalTool *ceval_tool = facet_curves.get_and_step()->get_eval_tool();
+    if (ceval_tool)
+      ceval_tool->save( cfet_ints, cfet_doubles, cfet_ids );
+  }
+
+  FacetBlockWriter writer;
+#define ADD_FACET_BLOCK( type, array ) \
+  if (!array.empty()) \
+    writer.add_block( type, &array[0], array.size(), sizeof(array[0]), compress )
+  ADD_FACET_BLOCK( MBG_POINT_COORDS, coords );
+  ADD_FACET_BLOCK( MBG_POINT_UVS, uvs );
+  ADD_FACET_BLOCK( MBG_NORMAL_POINTS, normal_points );
+  ADD_FACET_BLOCK( MBG_NORMALS, normals );
+  ADD_FACET_BLOCK( MBG_EDGE_POINTS, edge_points );
+  ADD_FACET_BLOCK( MBG_EDGE_CONTROL_POINTS, edge_ctrl );
+  ADD_FACET_BLOCK( MBG_FACET_EDGES, facet_edges );
+  ADD_FACET_BLOCK( MBG_FACET_FLAGS, facet_flags );
+  ADD_FACET_BLOCK( MBG_FACET_CONTROL_POINTS, facet_ctrl );
+  ADD_FACET_BLOCK( MBG_C_ZERO_INTS, c_zero_ints );
+  ADD_FACET_BLOCK( MBG_C_ZERO_DOUBLES, c_zero_doubles );
+  ADD_FACET_BLOCK( MBG_SURFACE_TOOL_INTS, fet_ints );
+  ADD_FACET_BLOCK( MBG_SURFACE_TOOL_DOUBLES, fet_doubles );
+  ADD_FACET_BLOCK( MBG_SURFACE_TOOL_IDS, fet_ids );
+  ADD_FACET_BLOCK( MBG_CURVE_TOOL_INTS, cfet_ints );
+  ADD_FACET_BLOCK( MBG_CURVE_TOOL_DOUBLES, cfet_doubles );
+  ADD_FACET_BLOCK( MBG_CURVE_TOOL_IDS, cfet_ids );
+#undef ADD_FACET_BLOCK
+
+  return writer.write( fp );
+}
+
+//===========================================================================
+//Function Name: check_c_zero_data
+//Description:  true if the boundary point data written by
+//              TDFacetBoundaryPoint::get_boundary_point_data is complete
+//              and its point and facet ids are in range
+//===========================================================================
+static bool check_c_zero_data( const int *int_data, size_t int_size,
+                               size_t double_size,
+                               int num_points, int num_facets )
+{
+  size_t iidx = 0, didx = 0;
+  while (iidx < int_size)
+  {
+    if (iidx + 2 > int_size)
+      return false;
+    int id = int_data[iidx++];
+    if (id < 0 || id >= num_points)
+      return false;
+    int num_bpd = int_data[iidx++];
+    if (num_bpd < 0)
+      return false;
+    for (int ii=0; ii<num_bpd; ii++)
+    {
+      if (iidx >= int_size)
+        return false;
+      int numfacs = int_data[iidx++];
+      if (numfacs < 0 || iidx + numfacs + 1 > int_size)
+        return false;
+      for (int jj=0; jj<numfacs; jj++)
+      {
+        id = int_data[iidx++];
+        if (id < 0 || id >= num_facets)
+          return false;
+      }
+      iidx++;  // surface id
+      didx += 6;
+    }
+  }
+  return didx == double_size;
+}
+
+//===========================================================================
+//Function Name: restore_facet_blocks
+//Member Type:  PUBLIC
+//Description:  create the facets and eval tools from a section written
+//              by save_facet_blocks
+//===========================================================================
+CubitStatus FacetQueryEngine::restore_facet_blocks(
+  FacetBlockReader &reader,
+  int &num_points,
+  CubitPoint **&points,
+  int &num_cfet,
+  int &num_fet,
+  CurveFacetEvalTool **&cfet_array,
+  FacetEvalTool **&fet_array )
+{
+  size_t ncoords, nuvs, nnormal_points, nnormals, nedge_points, nedge_ctrl,
+         nfacet_edges, nfacet_flags, nfacet_ctrl, nc_zero_ints,
+         nc_zero_doubles, nfet_ints, nfet_doubles, nfet_ids,
+         ncfet_ints, ncfet_doubles, ncfet_ids;
+  const double *coords = (const double*)reader.block( MBG_POINT_COORDS, ncoords, 8 );
+  const double *uvs = (const double*)reader.block( MBG_POINT_UVS, nuvs, 8 );
+  const int *normal_points = (const int*)reader.block( MBG_NORMAL_POINTS, nnormal_points, 4 );
+  const double *normals = (const double*)reader.block( MBG_NORMALS, nnormals, 8 );
+  const int *edge_points = (const int*)reader.block( MBG_EDGE_POINTS, nedge_points, 4 );
+  const double *edge_ctrl = (const double*)reader.block( MBG_EDGE_CONTROL_POINTS, nedge_ctrl, 8 );
+  const int *facet_edges = (const int*)reader.block( MBG_FACET_EDGES, nfacet_edges, 4 );
+  const int *facet_flags = (const int*)reader.block( MBG_FACET_FLAGS, nfacet_flags, 4 );
+  const double *facet_ctrl = (const double*)reader.block( MBG_FACET_CONTROL_POINTS, nfacet_ctrl, 8 );
+  const int *c_zero_ints = (const int*)reader.block( MBG_C_ZERO_INTS, nc_zero_ints, 4 );
+  const double *c_zero_doubles = (const double*)reader.block( MBG_C_ZERO_DOUBLES, nc_zero_doubles, 8 );
+  const int *fet_ints = (const int*)reader.block( MBG_SURFACE_TOOL_INTS, nfet_ints, 4 );
+  const double *fet_doubles = (const double*)reader.block( MBG_SURFACE_TOOL_DOUBLES, nfet_doubles, 8 );
+  const int *fet_ids = (const int*)reader.block( MBG_SURFACE_TOOL_IDS, nfet_ids, 4 );
+  const int *cfet_ints = (const int*)reader.block( MBG_CURVE_TOOL_INTS, ncfet_ints, 4 );
+  const double *cfet_doubles = (const double*)reader.block( MBG_CURVE_TOOL_DOUBLES, ncfet_doubles, 8 );
+  const int *cfet_ids = (const int*)reader.block( MBG_CURVE_TOOL_IDS, ncfet_ids, 4 );
+
+  num_points = (int)(ncoords / 3);
+  int num_edges = (int)(nedge_points / 2);
+  int num_facets = (int)(nfacet_edges / 3);
+  num_fet = (int)(nfet_ints / 6);
+  num_cfet = (int)(ncfet_ints / 6);
+
+  // check the sizes and ids before creating anything
+  size_t ii, jj;
+  bool good = ncoords % 3 == 0 && nuvs == ncoords &&
+              nnormals == 3*nnormal_points &&
+              nedge_points % 2 == 0 &&
+              (nedge_ctrl == 0 || nedge_ctrl == 3*NUM_EDGE_CPTS*nedge_points/2) &&
+              nfacet_edges % 3 == 0 && nfacet_flags == 2*(size_t)num_facets &&
+              (nfacet_ctrl == 0 || nfacet_ctrl == 3*NUM_TRI_CPTS*(size_t)num_facets) &&
+              nfet_ints % 6 == 0 && nfet_doubles == 2*(size_t)num_fet &&
+              ncfet_ints % 6 == 0 && ncfet_doubles == (size_t)num_cfet;
+  for (ii=0; good && ii<nnormal_points; ii++)
+    good = normal_points[ii] >= 0 && normal_points[ii] < num_points;
+  for (ii=0; good && ii<nedge_points; ii++)
+    good = edge_points[ii] >= 0 && edge_points[ii] < num_points;
+  for (ii=0; good && ii<nfacet_edges; ii++)
+    good = facet_edges[ii] >= 0 && facet_edges[ii] < num_edges;
+  size_t count = 0;
+  for (ii=0; good && ii<nfet_ints; ii+=6)
+    for (jj=3; jj<6; jj++)
+    {
+      good = good && fet_ints[ii+jj] >= 0;
+      count += fet_ints[ii+jj];
+    }
+  good = good && count == nfet_ids;
+  count = 0;
+  for (ii=0; good && ii<ncfet_ints; ii+=6)
+    for (jj=4; jj<6; jj++)
+    {
+      good = good && cfet_ints[ii+jj] >= 0;
+      count += cfet_ints[ii+jj];
+    }
+  good = good && count == ncfet_ids;
+  good = good && check_c_zero_data( c_zero_ints, nc_zero_ints, nc_zero_doubles,
+                                    num_points, num_facets );
+  if (!good)
+  {
+    PRINT_ERROR("Facet data in mesh-based geometry file is damaged\n");
+    num_points = num_fet = num_cfet = 0;
+    return CUBIT_FAILURE;
+  }
+
+  // create the points, edges and facets
+  points = new CubitPoint * [num_points];
+  for (ii=0; ii<(size_t)num_points; ii++)
+  {
+    points[ii] = (CubitPoint *) new CubitPointData( coords[3*ii],
+                                                    coords[3*ii+1],
+                                                    coords[3*ii+2] );
+    points[ii]->set_uvs( uvs[3*ii], uvs[3*ii+1], uvs[3*ii+2] );
+  }
+  CubitVector normal;
+  for (ii=0; ii<nnormal_points; ii++)
+  {
+    normal.set( &normals[3*ii] );
+    points[ normal_points[ii] ]->normal( normal );
+  }
+
+  CubitFacetEdge **edges = new CubitFacetEdge * [num_edges];
+  for (ii=0; ii<(size_t)num_edges; ii++)
+  {
+    edges[ii] = (CubitFacetEdge *) new CubitFacetEdgeData( points[edge_points[2*ii]],
+                                                           points[edge_points[2*ii+1]] );
+    if (nedge_ctrl)
+      edges[ii]->set_control_points( &edge_ctrl[ii*NUM_EDGE_CPTS*3] );
+  }
+
+  CubitFacet **facets = new CubitFacet * [num_facets];
+  for (ii=0; ii<(size_t)num_facets; ii++)
+  {
+    facets[ii] = (CubitFacet *) new CubitFacetData( edges[facet_edges[3*ii]],
+                                                    edges[facet_edges[3*ii+1]],
+                                                    edges[facet_edges[3*ii+2]] );
+    facets[ii]->is_flat( facet_flags[2*ii] );
+    facets[ii]->is_backwards( facet_flags[2*ii+1] );
+    if (nfacet_ctrl)
+      facets[ii]->set_control_points( &facet_ctrl[ii*NUM_TRI_CPTS*3] );
+  }
+
+  // the extra info at the surface boundaries
+  int iidx = 0, didx = 0;
+  while (iidx < (int)nc_zero_ints)
+    TDFacetBoundaryPoint::new_facet_boundary_point( points, facets, iidx, didx,
+      const_cast<int*>(c_zero_ints), const_cast<double*>(c_zero_doubles) );
+
+  // the eval tools
+  CubitStatus rv = CUBIT_SUCCESS;
+  fet_array = new FacetEvalTool * [num_fet];
+  for (ii=0, count=0; ii<(size_t)num_fet; ii++)
+  {
+    fet_array[ii] = new FacetEvalTool();
+    if (fet_array[ii]->restore( &fet_ints[6*ii], &fet_doubles[2*ii],
+                                fet_ids + count, num_facets, num_edges,
+                                num_points, facets, edges, points ) != CUBIT_SUCCESS)
+      rv = CUBIT_FAILURE;
+    count += fet_ints[6*ii+3] + fet_ints[6*ii+4] + fet_ints[6*ii+5];
+  }
+
+  cfet_array = new CurveFacetEvalTool * [num_cfet];
+  for (ii=0, count=0; ii<(size_t)num_cfet; ii++)
+  {
+    cfet_array[ii] = new CurveFacetEvalTool();
+    if (cfet_array[ii]->restore( &cfet_ints[6*ii], &cfet_doubles[ii],
+                                 cfet_ids + count, num_edges, num_points,
+                                 edges, points, num_fet, fet_array ) != CUBIT_SUCCESS)
+      rv = CUBIT_FAILURE;
+    count += cfet_ints[6*ii+4] + cfet_ints[6*ii+5];
+  }
+
+  if (rv != CUBIT_SUCCESS)
+    PRINT_ERROR("Error restoring mesh-based geometry\n");
+
+  delete [] facets;
+  delete [] edges;
+  return rv;
+}
 
 //===========================================================================
 //Function Name: dump_facets
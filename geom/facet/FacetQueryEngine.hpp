@@ -21,6 +21,7 @@
 // ********** BEGIN STANDARD INCLUDES         **********
 
 #include <typeinfo>
+#include <vector>
 #if !defined(WIN32)
 using std::type_info;
 #endif
@@ -75,6 +76,7 @@ class CubitPoint;
 class FacetEntity;
 class CurveFacetEvalTool;
 class FacetEvalTool;
+class FacetBlockReader;
 
 // ********** END FORWARD DECLARATIONS        **********
 
@@ -293,6 +295,12 @@ public:
 private:
   CubitStatus import_solid_model(FILE *file_ptr,
                                  DLIList<TopologyBridge*> &imported_entities );
+  CubitStatus import_solid_model(FILE *file_ptr,
+                                 const char *mapped_file,
+                                 size_t mapped_size,
+                                 DLIList<TopologyBridge*> &imported_entities );
+    //- mapped_file, if not NULL, is the whole file in memory and is used
+    //- instead of reading the facet data of version 2 files from file_ptr
 
 public:
   virtual void delete_solid_model_entities(DLIList<BodySM*>& body_list) const;
@@ -321,6 +329,12 @@ public:
     //-       To resolve to visible entities, use "get_visible_ents_for_hits"
     //-       in GeometryQueryTool.
 
+  CubitStatus point_containment( TopologyBridge *body_or_lump,
+                                 const std::vector<CubitVector> &points,
+                                 std::vector<CubitPointContainment> &results ) const;
+    //- Classify many points against a FacetBody or FacetLump at once.
+    //- A point inside any lump of a body is inside the body.
+
   virtual double get_sme_resabs_tolerance() const; // Gets solid modeler's resolution absolute tolerance
   virtual double set_sme_resabs_tolerance( double new_resabs );
 
@@ -356,6 +370,17 @@ public:
                                               int &ntri,
                                               long& seek_address);
   //- read facets from an stl file
+
+  CubitStatus read_facets_stl_binary(
+                                     DLIList<CubitFacet *> &tfacet_list,
+                                     DLIList<CubitPoint *> &point_list,
+                                     const char * file_name,
+                                     int &npoints,
+                                     int &ntri,
+                                     double tolerance);
+  //- read facets from a binary stl file, merging vertices with equal
+  //- coordinates and, if tolerance is positive, vertices within tolerance
+  //- distance of each other
   
   CubitStatus import_facets( const char *file_name, 
                              CubitBoolean use_feature_angle, 
@@ -436,6 +461,36 @@ public:
                                   FacetEvalTool **&feval_tools );
     //- restore facets from CUB file
 
+  CubitStatus save_facet_blocks( FILE *fp,
+                                 DLIList<FacetSurface*> &facet_surfaces,
+                                 DLIList<FacetCurve*> &facet_curves,
+                                 DLIList<FacetPoint*> &facet_points );
+  CubitStatus restore_facet_blocks( FacetBlockReader &reader,
+                                    int &num_points,
+                                    CubitPoint **&points_array,
+                                    int &num_cfet,
+                                    int &num_fet,
+                                    CurveFacetEvalTool **&cfet_array,
+                                    FacetEvalTool **&fet_array );
+    //- save and restore the facets and eval tools as the arrays of a
+    //- FacetBlockWriter section, as in version 2 mesh-based geometry files
+
+  static void set_compress_facet_blocks( CubitBoolean compress )
+    { compressFacetBlocks = compress; }
+  static CubitBoolean get_compress_facet_blocks()
+    { return compressFacetBlocks; }
+    //- compress the facet data of mesh-based geometry files when saving
+    //- them.  Smaller files, but slower to save and restore.
+
+  static CubitStatus set_mbg_file_version( int version );
+  static int get_mbg_file_version()
+    { return mbgFileVersion; }
+    //- the version of mesh-based geometry files written by
+    //- export_solid_model.  1, the default, writes the CIOWrapper format
+    //- that every release reads; 2 holds the facet data in a
+    //- FacetBlockWriter section, which releases before version 2 cannot
+    //- read.  Compression only applies to version 2.
+
 CubitStatus create_super_facet_bounding_box(
                                 DLIList<BodySM*>& body_list,
                                 CubitBox& super_box );
@@ -519,15 +574,25 @@ private:
   static FacetQueryEngine* instance_;
     //- static pointer to unique instance of this class
 
+  static CubitBoolean compressFacetBlocks;
+  static int mbgFileVersion;
+
   static CubitStatus init_hash_points( int num_points );
   static CubitStatus add_hash_point( CubitPoint *point_ptr );
   static CubitPoint *get_hash_point( int id );
   static void delete_hash_points( );
   static int get_hash_key( int id );
   static CubitStatus get_all_hash_points(DLIList<CubitPoint *> &point_list);
+  static void rehash_points( int table_size );
   static int hashPointSize;
-  static DLIList<CubitPoint *> *hashPointArray;
-    //- hash table functions used for reading the facet file
+  static bool hashPointDense;
+  static std::vector<CubitPoint *> hashPointArray;
+  static std::vector<CubitPoint *> hashPointList;
+    //- hash table functions used for reading the facet file.  While the
+    //- ids are between 0 and hashPointSize the table is indexed directly
+    //- by id; otherwise it is an open-addressing table of hashPointSize
+    //- (a power of two) slots.  hashPointList holds the points in the
+    //- order they were added.
 
   static const int FQE_MAJOR_VERSION;
   static const int FQE_MINOR_VERSION;
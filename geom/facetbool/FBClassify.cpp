@@ -28,7 +28,9 @@
 #include "FBClassify.hpp"
 #include "IntegerHash.hpp"
 #include "GfxDebug.hpp"
+#include "FBPredicates.hpp"
 #include <stack>
+#include <algorithm>
 //make this the same CUBIT_RESABS???
 //const double EPSILON_CLASSIFY = 1.e-12;
 const double EPSILON_CLASSIFY = 1.e-10;
@@ -375,25 +377,42 @@ int FBClassify::classify(int itri, int which)
   b = polyref->tris[itri]->b;
   c = polyref->tris[itri]->c;
 
-  unsigned int i, num_perturb;
+  unsigned int num_perturb;
+  int i, closest_i;
   double obj_tri_a, obj_tri_b, obj_tri_c, obj_tri_d, dotprod;
-  double distance_to_other_sqr, closest_distance_to_plane, t;
-  double closest_distance_to_other_sqr;
-  double xint, yint, zint, distance_to_plane, closest_dotproduct;
+  double closest_distance_to_plane, t, closest_t, entry, in_plane_entry;
+  double distance_to_plane, closest_dotproduct;
   bool perturb, done, foundone;
-  double other_xbar, other_ybar, other_zbar;
-  int other_tri_0, other_tri_1, other_tri_2;
+  double raystart[3], rayend[3], raydir[3];
 
   perturb = false;
   num_perturb = 0;
   done = false;
+  raydir[0] = a; raydir[1] = b; raydir[2] = c;
   
   while ( (done == false) && (num_perturb < 20) ) {
     closest_dotproduct = -CUBIT_DBL_MAX + 1.;
     closest_distance_to_plane = CUBIT_DBL_MAX;
-    closest_distance_to_other_sqr = CUBIT_DBL_MAX;
+    closest_t = CUBIT_DBL_MAX;
+    closest_i = -1;
+    in_plane_entry = -1.;
     foundone = false;
-    for ( i = 0; i < polyobj->tris.size(); i++ ) {
+
+      //  Only the triangles whose boxes the ray passes through can be
+      //  hit.  Walk them in the order the ray enters their boxes, and stop
+      //  once the next box is entered beyond the nearest hit so far.  A
+      //  hit just behind the start is entered at 0, so boxes entered at 0
+      //  are always looked at.  Equal hits go to the lowest triangle, so
+      //  the result does not depend on the shape of the tree.
+    raystart[0] = xbary; raystart[1] = ybary; raystart[2] = zbary;
+    rayend[0] = xbary + a; rayend[1] = ybary + b; rayend[2] = zbary + c;
+    raywalk.queue.clear();
+    if ( polyobj->kdtree && (polyobj->tris.size() > 0) )
+      polyobj->kdtree->ray_kdtree_first(raystart,raydir,raywalk);
+    while ( (raywalk.queue.empty() == false) &&
+            ((i = polyobj->kdtree->ray_kdtree_next(raywalk,
+                                                   CUBIT_MAX(closest_t,0.),
+                                                   entry)) >= 0) ) {
       obj_tri_a = polyobj->tris[i]->a;
       obj_tri_b = polyobj->tris[i]->b;
       obj_tri_c = polyobj->tris[i]->c;
@@ -403,108 +422,51 @@ int FBClassify::classify(int itri, int which)
         //calculate the distance to the other triangles plane
       distance_to_plane = (obj_tri_a*xbary + obj_tri_b*ybary +
                            obj_tri_c*zbary + obj_tri_d);
-       
-      
-      if ( fabs(dotprod) < EPSILON_CLASSIFY ) {
-          //  Is the point in the plane?
-        if ( fabs(distance_to_plane) < EPSILON_CLASSIFY ) {
-            //  Perturb the ray and recast.
-          perturb = true;
-          num_perturb += 1;
-          break;
-        }
+
+        //  The line of the ray passes through the triangle, or over its
+        //  boundary, when the three edges all turn the same way about it;
+        //  a zero means it meets that edge.  The signs are exact, so only
+        //  a ray lying in the plane of the triangle, which makes all three
+        //  zero, has to be perturbed, and only if the triangle may be
+        //  reached before the nearest hit.
+      const double *p0 = polyobj->verts[polyobj->tris[i]->v0]->coord;
+      const double *p1 = polyobj->verts[polyobj->tris[i]->v1]->coord;
+      const double *p2 = polyobj->verts[polyobj->tris[i]->v2]->coord;
+      double o0, o1, o2;
+
+      o0 = FBPredicates::orient3d(raystart,rayend,p0,p1);
+      o1 = FBPredicates::orient3d(raystart,rayend,p1,p2);
+      o2 = FBPredicates::orient3d(raystart,rayend,p2,p0);
+      if ( (o0 == 0.0) && (o1 == 0.0) && (o2 == 0.0) ) {
+        if ( (in_plane_entry < 0.) || (entry < in_plane_entry) )
+          in_plane_entry = entry;
         continue;
       }
+      if ( ( (o0 < 0.0) || (o1 < 0.0) || (o2 < 0.0) ) &&
+           ( (o0 > 0.0) || (o1 > 0.0) || (o2 > 0.0) ) ) continue;
+      if ( dotprod == 0.0 ) continue;
       
       t =-(distance_to_plane)/dotprod;
       if ( t < -EPSILON_CLASSIFY ) continue;
-      xint = xbary + a*t;
-      yint = ybary + b*t;
-      zint = zbary + c*t;
 
-        //  Check whether the intersection point lies in or on
-        //  the object triangle's
-        //  bounding box.
-      if ( (polyobj->tris[i]->boundingbox.xmin - EPSILON > xint) || 
-           (polyobj->tris[i]->boundingbox.xmax + EPSILON < xint) ||
-           (polyobj->tris[i]->boundingbox.ymin - EPSILON > yint) || 
-           (polyobj->tris[i]->boundingbox.ymax + EPSILON < yint) ||
-           (polyobj->tris[i]->boundingbox.zmin - EPSILON > zint) || 
-           (polyobj->tris[i]->boundingbox.zmax + EPSILON < zint) ) 
-        continue;
-      
-        //  Is the point (xint, yint, zint) inside or on the triangle?
-        //  Get a principal projection to make this a 2D problem.
-      double xp1, yp1, xp2, yp2, xp3, yp3, ptx, pty;
-      int retval;
-
-      if ( (fabs(obj_tri_b) >= fabs(obj_tri_a)) && 
-           (fabs(obj_tri_b) >= fabs(obj_tri_c)) ) {
-        xp1 = polyobj->verts[polyobj->tris[i]->v0]->coord[0];
-        yp1 = polyobj->verts[polyobj->tris[i]->v0]->coord[2];
-        xp2 = polyobj->verts[polyobj->tris[i]->v1]->coord[0];
-        yp2 = polyobj->verts[polyobj->tris[i]->v1]->coord[2];
-        xp3 = polyobj->verts[polyobj->tris[i]->v2]->coord[0];
-        yp3 = polyobj->verts[polyobj->tris[i]->v2]->coord[2];
-        ptx = xint;
-        pty = zint;        
-      } else if ( fabs(obj_tri_a) >= fabs(obj_tri_c) ) {
-        xp1 = polyobj->verts[polyobj->tris[i]->v0]->coord[1];
-        yp1 = polyobj->verts[polyobj->tris[i]->v0]->coord[2];
-        xp2 = polyobj->verts[polyobj->tris[i]->v1]->coord[1];
-        yp2 = polyobj->verts[polyobj->tris[i]->v1]->coord[2];
-        xp3 = polyobj->verts[polyobj->tris[i]->v2]->coord[1];
-        yp3 = polyobj->verts[polyobj->tris[i]->v2]->coord[2];
-        ptx = yint;
-        pty = zint;   
-      } else {
-        xp1 = polyobj->verts[polyobj->tris[i]->v0]->coord[0];
-        yp1 = polyobj->verts[polyobj->tris[i]->v0]->coord[1];
-        xp2 = polyobj->verts[polyobj->tris[i]->v1]->coord[0];
-        yp2 = polyobj->verts[polyobj->tris[i]->v1]->coord[1];
-        xp3 = polyobj->verts[polyobj->tris[i]->v2]->coord[0];
-        yp3 = polyobj->verts[polyobj->tris[i]->v2]->coord[1];
-        ptx = xint;
-        pty = yint;  
-      }
-      retval = pt_in_tri_2d(ptx,pty,xp1,yp1,xp2,yp2,xp3,yp3);
-      if ( (retval == FB_ORIENTATION_INSIDE) ||
-           (retval == FB_ORIENTATION_ON) ) {
-          //calculate the distance to the other triangle's centroid
-        other_tri_0 = polyobj->tris[i]->v0;
-        other_tri_1 = polyobj->tris[i]->v1;
-        other_tri_2 = polyobj->tris[i]->v2;
-        other_xbar = ( polyobj->verts[other_tri_0]->coord[0] + 
-                       polyobj->verts[other_tri_1]->coord[0] + 
-                       polyobj->verts[other_tri_2]->coord[0] )/3.;
-        other_ybar = ( polyobj->verts[other_tri_0]->coord[1] + 
-                       polyobj->verts[other_tri_1]->coord[1] + 
-                       polyobj->verts[other_tri_2]->coord[1] )/3.;
-        other_zbar = ( polyobj->verts[other_tri_0]->coord[2] + 
-                       polyobj->verts[other_tri_1]->coord[2] + 
-                       polyobj->verts[other_tri_2]->coord[2] )/3.;
-        
-          //calculate the distance (squared) to the other triangle's centroid
-        distance_to_other_sqr = ( (xbary-other_xbar)*(xbary-other_xbar) +
-                                  (ybary-other_ybar)*(ybary-other_ybar) +
-                                  (zbary-other_zbar)*(zbary-other_zbar) );
-          //if this is the closest other triangle so far...
-        if(closest_distance_to_other_sqr > distance_to_other_sqr){
-            //then we found one, and update the closest distance, dot prod,
-            // and distance to other plane.
-          foundone = true;
-          closest_distance_to_other_sqr = distance_to_other_sqr;
-          closest_dotproduct = dotprod;
-          if(mydebug){
-            polyobj->debug_draw_fb_triangle(polyobj->tris[i]);
-            GfxDebug::mouse_xforms();
-          }
-          closest_distance_to_plane = distance_to_plane;
-            //  This is the closest triangle.
-          if ( fabs(closest_distance_to_plane) < EPSILON_CLASSIFY ) 
-            break;   
+        //if this is the nearest hit along the ray so far...
+      if ( (t < closest_t) || ((t == closest_t) && (i < closest_i)) ) {
+          //then we found one, and update the nearest distance, dot prod,
+          // and distance to other plane.
+        foundone = true;
+        closest_t = t;
+        closest_i = i;
+        closest_dotproduct = dotprod;
+        if(mydebug){
+          polyobj->debug_draw_fb_triangle(polyobj->tris[i]);
+          GfxDebug::mouse_xforms();
         }
-      }       
+        closest_distance_to_plane = distance_to_plane;
+      }
+    }
+    if ( (in_plane_entry >= 0.) && (in_plane_entry <= CUBIT_MAX(closest_t,0.)) ) {
+      perturb = true;
+      num_perturb += 1;
     }
     if ( perturb == false ) done = true;
     else {
@@ -546,55 +508,6 @@ void FBClassify::perturb_the_ray(double &xbary, double &ybary, double &zbary)
   zbary += 1.e-4*(double(rand())/(RAND_MAX+1.0)-0.5);
 }
 
-int FBClassify::pt_in_tri_2d(double xpt, double ypt,
-                              double x0, double y0,
-		              double x1, double y1,
-		              double x2, double y2)
-{
-//  From Schneider & Eberly, "Geometric Tools for COmputer Graphics",
-//  Chap. 13.3.1.  If triangle is needle-thin, CUBIT_FAILURE might be
-//  returned, in wich case is_point_in is undefined.
-
-double c0, c1, c2;
-double e0x, e1x, e2x, e0y, e1y, e2y;
-double n0x, n1x, n2x, n0y, n1y, n2y;
-double denom0, denom1, denom2;
-int result;
-
-  e0x = x1 - x0; e0y = y1 - y0;  
-  e1x = x2 - x1; e1y = y2 - y1;  
-  e2x = x0 - x2; e2y = y0 - y2;  
-  n0x = e0y; n0y = -e0x;
-  n1x = e1y; n1y = -e1x;
-  n2x = e2y; n2y = -e2x;
-  denom0 = n1x*e0x + n1y*e0y;
-  if ( fabs(denom0) < EPSILON_CLASSIFY ) {
-    PRINT_ERROR("Failure in pt_in_tri_2d; needle-thin triangle encountered.\n");
-    return FB_ORIENTATION_UNDEFINED;
-  }
-  denom1 = n2x*e1x + n2y*e1y;
-  if ( fabs(denom1) < EPSILON_CLASSIFY ) {
-    PRINT_ERROR("Failure in pt_in_tri_2d; needle-thin triangle encountered.\n");
-    return FB_ORIENTATION_UNDEFINED;
-  }
-  denom2 = n0x*e2x + n0y*e2y;
-  if ( fabs(denom2) < EPSILON_CLASSIFY ) {
-    PRINT_ERROR("Failure in pt_in_tri_2d; needle-thin triangle encountered.\n");
-    return FB_ORIENTATION_UNDEFINED;
-  }
-  
-  c0 = -( n1x*(xpt-x1) + n1y*(ypt-y1) )/denom0;
-  c1 = -( n2x*(xpt-x2) + n2y*(ypt-y2) )/denom1;
-  c2 = -( n0x*(xpt-x0) + n0y*(ypt-y0) )/denom2;
-
-  if ( (c0 > 0.0) && (c1 > 0.0) && (c2 > 0.0) ) result = FB_ORIENTATION_INSIDE;
-  else if ( (c0 < 0.0) || (c1 < 0.0) || (c2 < 0.0) ) result = FB_ORIENTATION_OUTSIDE;
-  else result = FB_ORIENTATION_ON;
-
-  return result;
-
-}
-
 void FBClassify::get_group(std::vector<int> **this_group,
                            std::vector<int> **this_group_characterization)
 {
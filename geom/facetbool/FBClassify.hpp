@@ -52,11 +52,8 @@ private:
   std::vector<int> group, group_characterization;
   void fill_group(int itri, int ngroup);
   void perturb_the_ray(double &xbary, double &ybary, double &zbary);
-  int pt_in_tri_2d(double xpt, double ypt,
-                           double x0, double y0,
-		           double x1, double y1,
-		           double x2, double y2);
   int *e0, *e1, *e2;
+  KDTreeRay raywalk;  //  the walk along a ray through the other object
   int number_of_groups;
   int classify(int itri, int which);
   int classify_against_plane(int itri, int which);
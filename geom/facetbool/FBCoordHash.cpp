@@ -0,0 +1,148 @@
+/*
+ *
+ *
+ * Copyright (C) 2004 Sandia Corporation.  Under the terms of Contract DE-AC04-94AL85000
+ * with Sandia Corporation, the U.S. Government retains certain rights in this software.
+ *
+ * This file is part of facetbool--contact via cubit@sandia.gov
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ *
+ */
+
+#include <math.h>
+#include <string.h>
+#include "FBCoordHash.hpp"
+
+//  The cells are much larger than the tolerance, so that a tolerance box
+//  seldom touches more than one cell.
+const double FB_CELLS_PER_TOL = 1000.;
+
+FBCoordHash::FBCoordHash(int expected_size, double tol)
+{
+  tolerance = tol;
+  cellsize = FB_CELLS_PER_TOL*tol;
+  numstored = 0;
+  mask = 0;
+  grow(2*expected_size);
+}
+
+FBCoordHash::~FBCoordHash()
+{
+
+}
+
+void FBCoordHash::reserve(int expected_size)
+{
+  if ( (int)slots.size() < 2*expected_size ) 
+    grow(2*expected_size);
+}
+
+unsigned int FBCoordHash::cell_hash(double cx, double cy, double cz) const
+{
+unsigned int words[6], hashvalue;
+int i;
+
+  //  The cell numbers are integral doubles; add zero to make -0 into 0 
+  //  and hash their bits.
+  cx += 0.0; cy += 0.0; cz += 0.0;
+  memcpy(&words[0],&cx,sizeof(double));
+  memcpy(&words[2],&cy,sizeof(double));
+  memcpy(&words[4],&cz,sizeof(double));
+  hashvalue = 2166136261u;
+  for ( i = 0; i < 6; i++ ) {
+    hashvalue ^= words[i];
+    hashvalue *= 16777619u;
+    hashvalue ^= hashvalue >> 15;
+  }
+  return hashvalue & mask;
+}
+
+int FBCoordHash::find(double x, double y, double z) const
+{
+double cxmin, cxmax, cymin, cymax, czmin, czmax, cx, cy, cz;
+unsigned int islot;
+int ifoundit;
+
+  cxmin = floor((x - tolerance)/cellsize); cxmax = floor((x + tolerance)/cellsize);
+  cymin = floor((y - tolerance)/cellsize); cymax = floor((y + tolerance)/cellsize);
+  czmin = floor((z - tolerance)/cellsize); czmax = floor((z + tolerance)/cellsize);
+
+  ifoundit = -1;
+  for ( cx = cxmin; cx <= cxmax; cx += 1.0 ) {
+    for ( cy = cymin; cy <= cymax; cy += 1.0 ) {
+      for ( cz = czmin; cz <= czmax; cz += 1.0 ) {
+        islot = cell_hash(cx,cy,cz);
+        while ( slots[islot].index != -1 ) {
+          const Slot& slot = slots[islot];
+          if ( ( fabs(slot.coord[0]-x) < tolerance ) &&
+               ( fabs(slot.coord[1]-y) < tolerance ) &&
+               ( fabs(slot.coord[2]-z) < tolerance ) &&
+               ( (ifoundit == -1) || (slot.index < ifoundit) ) )
+            ifoundit = slot.index;
+          islot = (islot + 1) & mask;
+        }
+      }
+    }
+  }
+
+  return ifoundit;
+}
+
+void FBCoordHash::insert(double x, double y, double z, int index)
+{
+Slot slot;
+
+  if ( 2*(numstored + 1) > (int)slots.size() ) 
+    grow(2*(numstored + 1));
+  slot.coord[0] = x; slot.coord[1] = y; slot.coord[2] = z;
+  slot.index = index;
+  put(slot);
+  numstored++;
+}
+
+void FBCoordHash::put(const Slot& slot)
+{
+unsigned int islot;
+
+  islot = cell_hash(floor(slot.coord[0]/cellsize),
+                    floor(slot.coord[1]/cellsize),
+                    floor(slot.coord[2]/cellsize));
+  while ( slots[islot].index != -1 ) 
+    islot = (islot + 1) & mask;
+  slots[islot] = slot;
+}
+
+void FBCoordHash::grow(int min_slots)
+{
+std::vector<Slot> oldslots;
+unsigned int i, numslots;
+Slot empty;
+
+  numslots = 64;
+  while ( (int)numslots < min_slots ) numslots *= 2;
+  if ( numslots <= slots.size() ) return;
+
+  empty.coord[0] = empty.coord[1] = empty.coord[2] = 0.0;
+  empty.index = -1;
+  oldslots.swap(slots);
+  slots.assign(numslots,empty);
+  mask = numslots - 1;
+  for ( i = 0; i < oldslots.size(); i++ ) {
+    if ( oldslots[i].index != -1 ) put(oldslots[i]);
+  }
+}
@@ -0,0 +1,69 @@
+/*
+ *
+ *
+ * Copyright (C) 2004 Sandia Corporation.  Under the terms of Contract DE-AC04-94AL85000
+ * with Sandia Corporation, the U.S. Government retains certain rights in this software.
+ *
+ * This file is part of facetbool--contact via cubit@sandia.gov
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ *
+ */
+
+#ifndef _FBCOORDHASH
+#define _FBCOORDHASH
+#include <vector>
+
+//  A set of indexed coordinates that can be searched for a coordinate 
+//  within a tolerance.  Space is divided into cubic cells and each 
+//  coordinate is stored, with its index, in the open-addressed (linearly 
+//  probed) slot array under its cell.  A search looks in the one to eight
+//  cells that the tolerance box around the coordinate touches.
+class FBCoordHash
+{
+
+public:
+
+  FBCoordHash(int expected_size = 0, double tol = 1.e-7);
+  ~FBCoordHash();
+
+  //  Make room for expected_size coordinates without regrowing.
+  void reserve(int expected_size);
+
+  //  The lowest index of the coordinates that are closer than the 
+  //  tolerance to (x,y,z) in each direction, or -1 if there are none.
+  int find(double x, double y, double z) const;
+
+  //  Add a coordinate; no check is made for one already within tolerance.
+  void insert(double x, double y, double z, int index);
+
+private:
+  struct Slot {
+    double coord[3];
+    int index;  //  -1 for an empty slot
+  };
+  std::vector<Slot> slots;
+  unsigned int mask;  //  number of slots - 1; the number is a power of 2
+  int numstored;
+  double tolerance, cellsize;
+
+  unsigned int cell_hash(double cx, double cy, double cz) const;
+  void put(const Slot& slot);
+  void grow(int min_slots);
+};
+
+#endif
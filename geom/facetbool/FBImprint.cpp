@@ -25,6 +25,7 @@
  */
 
 #include <vector>
+#include <algorithm>
 #include <math.h>
 #include "FBImprint.hpp"
 #include "FBPolyhedron.hpp"
@@ -110,13 +111,11 @@ CubitStatus FBImprint::edges_tri_intersect(const std::vector<FB_Coord*>& FB_impr
 {
   CubitStatus status;
   unsigned int i, j;
-  int numboxesfound, *boxlist;
+  std::vector<int> boxlist;
   FSBoundingBox* edgebox;
   double edge_dir[3], edge_0[3], edge_1[3], edge_length = 0.0;
   bool big_angle;
 
-  boxlist = new int[poly->tris.size()];
-
   status = CUBIT_SUCCESS;
   new_edge_created = false;
   for ( i = 0; i < FB_imprint_edge_bboxes.size(); i++ ) {
@@ -127,8 +126,9 @@ CubitStatus FBImprint::edges_tri_intersect(const std::vector<FB_Coord*>& FB_impr
           (edgebox->ymin > poly->polyymax) ||
           (edgebox->zmax < poly->polyzmin) || 
           (edgebox->zmin > poly->polyzmax) ) continue;
-     poly->kdtree->box_kdtree_intersect(*edgebox,&numboxesfound,boxlist);
-     if ( numboxesfound > 0 ) {  //  Get a unit vector along the edge.
+     poly->kdtree->box_kdtree_intersect(*edgebox,boxlist);
+     std::sort(boxlist.begin(),boxlist.end());
+     if ( boxlist.size() > 0 ) {  //  Get a unit vector along the edge.
        edge_0[0] = FB_imprint_edge_coords[FB_imprint_edges[i]->v0]->coord[0];
        edge_1[0] = FB_imprint_edge_coords[FB_imprint_edges[i]->v1]->coord[0];
        edge_dir[0] = edge_1[0] - edge_0[0];
@@ -145,7 +145,7 @@ CubitStatus FBImprint::edges_tri_intersect(const std::vector<FB_Coord*>& FB_impr
        edge_dir[2] /= edge_length;             
      }
 
-     for ( j = 0; j < (unsigned int)numboxesfound; j++ ) { 
+     for ( j = 0; j < boxlist.size(); j++ ) { 
         FB_Triangle *tri = poly->tris[boxlist[j]];     
         if ( (edgebox->xmax < tri->boundingbox.xmin) || 
              (edgebox->xmin > tri->boundingbox.xmax) ||
@@ -25,12 +25,15 @@
  */
 
 #include <vector>
+#include <algorithm>
 #include "FBIntersect.hpp"
 #include "FBPolyhedron.hpp"
 #include "FBRetriangulate.hpp"
+#include "FBPredicates.hpp"
 #include "CubitMessage.hpp"
 #include "GfxDebug.hpp"
 #include "GeometryDefines.h"
+#include "CubitConcurrentApi.h"
 
 FBIntersect::FBIntersect()
 {
@@ -344,14 +347,61 @@ bool boxes_intersect;
 CubitStatus FBIntersect::pair_intersect()
 {
 CubitStatus status;
-unsigned int i, j, k;
-int numboxesfound, *boxlist;
-double dtemp;
+unsigned int i, k;
+
+//  The triangle pairs are intersected in ranges of poly1 triangles, 
+//  in parallel when the concurrency pool is available.  Each range only 
+//  reads the two polyhedra and records its intersection segments; the 
+//  segments are then added to the polyhedra serially in triangle order, 
+//  so that vertex and edge numbering do not depend on the scheduling.
+  size_t num_tris = poly1->tris.size();
+  rangeSegments.clear();
+  rangeSegments.resize( CubitConcurrent::num_ranges(num_tris) );
+  CubitConcurrent::parallel_for_ranges( num_tris, *this, 
+                                        &FBIntersect::pair_intersect_range );
 
-  boxlist = new int[poly2->tris.size()];
-  
   status = CUBIT_SUCCESS;
-  for ( i = 0; i < poly1->tris.size(); i++ ) {
+  for ( k = 0; k < rangeSegments.size(); k++ ) {
+    std::vector<FB_IntersectSegment> &segments = rangeSegments[k];
+    for ( i = 0; i < segments.size(); i++ ) {
+      FB_IntersectSegment &seg = segments[i];
+      if ( seg.type == FB_SEGMENT_SMALL_AREA ) {
+        PRINT_WARNING("small-area triangle\n");
+        continue;
+      }
+
+      int mydebug = 0;
+      if ( mydebug )
+      {
+         // Draw the 2 facets which are intersecting.
+         GfxDebug::clear();
+         poly1->debug_draw_boundary_edges(CUBIT_YELLOW);
+         poly2->debug_draw_boundary_edges(CUBIT_PINK);
+         poly1->debug_draw_fb_triangle(poly1->tris[seg.tri1]);
+         poly2->debug_draw_fb_triangle(poly2->tris[seg.tri2]);
+         GfxDebug::mouse_xforms();
+      }
+
+      status = add_intersection_edges(seg);
+      if ( status != CUBIT_SUCCESS ) break;
+    }
+    if ( status != CUBIT_SUCCESS ) break;
+  }
+  rangeSegments.clear();
+
+  return status;
+}
+
+void FBIntersect::pair_intersect_range(size_t index, std::pair<size_t,size_t> tris)
+{
+unsigned int i, j, k;
+double xc1[9], plane1[4], xc2[9], plane2[4];
+double txc[9], tplane[4];
+double linecoeff[3];
+std::vector<FB_IntersectSegment> &segments = rangeSegments[index];
+std::vector<int> boxlist;
+
+  for ( i = tris.first; i < tris.second; i++ ) {
      FB_Triangle *tri1 = poly1->tris[i];
      if ( (tri1->boundingbox.xmax < poly2->polyxmin) || 
           (tri1->boundingbox.xmin > poly2->polyxmax) ||
@@ -359,9 +409,11 @@ double dtemp;
           (tri1->boundingbox.ymin > poly2->polyymax) ||
           (tri1->boundingbox.zmax < poly2->polyzmin) || 
           (tri1->boundingbox.zmin > poly2->polyzmax) ) continue;
-     poly2->kdtree->box_kdtree_intersect(tri1->boundingbox,&numboxesfound,boxlist);
+     poly2->kdtree->box_kdtree_intersect(tri1->boundingbox,boxlist);
+     std::sort(boxlist.begin(),boxlist.end());
+     get_triangle_geometry(poly1,tri1,xc1,plane1);
 
-     for ( j = 0; j < (unsigned int)numboxesfound; j++ ) { 
+     for ( j = 0; j < boxlist.size(); j++ ) { 
         FB_Triangle *tri2 = poly2->tris[boxlist[j]];     
         if ( (tri1->boundingbox.xmax < tri2->boundingbox.xmin) || 
              (tri1->boundingbox.xmin > tri2->boundingbox.xmax) ||
@@ -369,23 +421,12 @@ double dtemp;
              (tri1->boundingbox.ymin > tri2->boundingbox.ymax) ||
              (tri1->boundingbox.zmax < tri2->boundingbox.zmin ) || 
              (tri1->boundingbox.zmin > tri2->boundingbox.zmax) ) continue;
-
-     int mydebug = 0;
-     if ( mydebug )
-     {
-         // Draw the 2 facets which are intersecting.
-         GfxDebug::clear();
-         poly1->debug_draw_boundary_edges(CUBIT_YELLOW);
-         poly2->debug_draw_boundary_edges(CUBIT_PINK);
-         poly1->debug_draw_fb_triangle(tri1);
-         poly2->debug_draw_fb_triangle(tri2);
-         GfxDebug::mouse_xforms();
-     }
+        get_triangle_geometry(poly2,tri2,xc2,plane2);
 
 //  Find the line of intersection of the two triangle planes. 
-        linecoeff[0] = tri1->c*tri2->b - tri1->b*tri2->c;
-        linecoeff[1] = tri1->a*tri2->c - tri1->c*tri2->a;
-        linecoeff[2] = tri1->b*tri2->a - tri1->a*tri2->b;
+        linecoeff[0] = plane1[2]*plane2[1] - plane1[1]*plane2[2];
+        linecoeff[1] = plane1[0]*plane2[2] - plane1[2]*plane2[0];
+        linecoeff[2] = plane1[1]*plane2[0] - plane1[0]*plane2[1];
 
         if ( (fabs(linecoeff[0]) < EPSILON) && 
              (fabs(linecoeff[1]) < EPSILON) &&  
@@ -396,330 +437,154 @@ double dtemp;
             // calculate the distance between the triangles.  Just because they are coplanar
             // does not mean we have to intersect.  If the distance between them is larger than
             // GEOMETRY_RESABS, then just continue on.
-            double dist = poly1->verts[tri1->v2]->coord[0]*tri2->a +
-                          poly1->verts[tri1->v2]->coord[1]*tri2->b +
-                          poly1->verts[tri1->v2]->coord[2]*tri2->c + tri2->d;
+            double dist = xc1[6]*plane2[0] + xc1[7]*plane2[1] + 
+                          xc1[8]*plane2[2] + plane2[3];
             if ( dist > GEOMETRY_RESABS )
             {
                 continue;
             }
 
             //  coplanar triangles; tilt each vertex of the triangle up successively
-            //  and then do the usual tri-tri intersection.
-            double ta, tb, tc, td;
-            double tx1[3],ty1[3],tz1[3];
-
-            //  triangle 1
-            ta = tri1->a; tb = tri1->b; tc = tri1->c; td = tri1->d;
-            for ( k = 0; k < 3; k++ ) {
-              tx1[k] = poly1->verts[tri1->v0]->coord[k];
-              ty1[k] = poly1->verts[tri1->v1]->coord[k];
-              tz1[k] = poly1->verts[tri1->v2]->coord[k];
-            } 
-
-            poly1->verts[tri1->v2]->coord[0] += ta;
-            poly1->verts[tri1->v2]->coord[1] += tb;
-            poly1->verts[tri1->v2]->coord[2] += tc;
-            //  Compute new normal and linecoeff
-            newplanecoefficients(poly1, tri1);
-            linecoeff[0] = tri1->c*tri2->b - tri1->b*tri2->c;
-            linecoeff[1] = tri1->a*tri2->c - tri1->c*tri2->a;
-            linecoeff[2] = tri1->b*tri2->a - tri1->a*tri2->b;
-            dtemp = sqrt(linecoeff[0]*linecoeff[0] +
-                         linecoeff[1]*linecoeff[1] +
-                         linecoeff[2]*linecoeff[2]);
-            linecoeff[0] /= dtemp;
-            linecoeff[1] /= dtemp;
-            linecoeff[2] /= dtemp;
-
-            status = tri_tri_intersect(tri1,tri2);
-            if ( status != CUBIT_SUCCESS )
-            {
-                return status;
+            //  and then do the usual tri-tri intersection.  The tilt is applied to
+            //  copies of the coordinates, so the polyhedra are left untouched.
+            int vert;
+            for ( vert = 2; vert >= 0; vert-- ) {
+              for ( k = 0; k < 9; k++ ) txc[k] = xc1[k];
+              txc[3*vert] += plane1[0];
+              txc[3*vert+1] += plane1[1];
+              txc[3*vert+2] += plane1[2];
+              if ( newplanecoefficients(txc,tplane) == false )
+                segments.push_back(FB_IntersectSegment(i,boxlist[j],FB_SEGMENT_SMALL_AREA));
+              tri_tri_intersect(txc,tplane,xc2,plane2,i,boxlist[j],segments);
             }
-
-            //  Restore values.
-            poly1->verts[tri1->v2]->coord[0] = tz1[0];
-            poly1->verts[tri1->v2]->coord[1] = tz1[1];
-            poly1->verts[tri1->v2]->coord[2] = tz1[2];
-            tri1->a = ta; tri1->b = tb; tri1->c = tc; tri1->d = td;
-
-            poly1->verts[tri1->v1]->coord[0] += ta;
-            poly1->verts[tri1->v1]->coord[1] += tb;
-            poly1->verts[tri1->v1]->coord[2] += tc;
-            //  Compute new normal and linecoeff
-            newplanecoefficients(poly1, tri1);
-            linecoeff[0] = tri1->c*tri2->b - tri1->b*tri2->c;
-            linecoeff[1] = tri1->a*tri2->c - tri1->c*tri2->a;
-            linecoeff[2] = tri1->b*tri2->a - tri1->a*tri2->b;
-            dtemp = sqrt(linecoeff[0]*linecoeff[0] +
-                         linecoeff[1]*linecoeff[1] +
-                         linecoeff[2]*linecoeff[2]);
-            linecoeff[0] /= dtemp;
-            linecoeff[1] /= dtemp;
-            linecoeff[2] /= dtemp;
-
-            status = tri_tri_intersect(tri1,tri2);
-            if ( status != CUBIT_SUCCESS )
-            {
-                return status;
+            for ( vert = 2; vert >= 0; vert-- ) {
+              for ( k = 0; k < 9; k++ ) txc[k] = xc2[k];
+              txc[3*vert] += plane2[0];
+              txc[3*vert+1] += plane2[1];
+              txc[3*vert+2] += plane2[2];
+              if ( newplanecoefficients(txc,tplane) == false )
+                segments.push_back(FB_IntersectSegment(i,boxlist[j],FB_SEGMENT_SMALL_AREA));
+              tri_tri_intersect(xc1,plane1,txc,tplane,i,boxlist[j],segments);
             }
-
-            //  Restore values.
-            poly1->verts[tri1->v1]->coord[0] = ty1[0];
-            poly1->verts[tri1->v1]->coord[1] = ty1[1];
-            poly1->verts[tri1->v1]->coord[2] = ty1[2];
-            tri1->a = ta; tri1->b = tb; tri1->c = tc; tri1->d = td;
-
-            poly1->verts[tri1->v0]->coord[0] += ta;
-            poly1->verts[tri1->v0]->coord[1] += tb;
-            poly1->verts[tri1->v0]->coord[2] += tc;
-            //  Compute new normal and linecoeff
-            newplanecoefficients(poly1, tri1);
-            linecoeff[0] = tri1->c*tri2->b - tri1->b*tri2->c;
-            linecoeff[1] = tri1->a*tri2->c - tri1->c*tri2->a;
-            linecoeff[2] = tri1->b*tri2->a - tri1->a*tri2->b;
-            dtemp = sqrt(linecoeff[0]*linecoeff[0] +
-                         linecoeff[1]*linecoeff[1] +
-                         linecoeff[2]*linecoeff[2]);
-            linecoeff[0] /= dtemp;
-            linecoeff[1] /= dtemp;
-            linecoeff[2] /= dtemp;
-
-            status = tri_tri_intersect(tri1,tri2);
-            if ( status != CUBIT_SUCCESS )
-            {
-                return status;
-            }
-
-            //  Restore values.
-            poly1->verts[tri1->v0]->coord[0] = tx1[0];
-            poly1->verts[tri1->v0]->coord[1] = tx1[1];
-            poly1->verts[tri1->v0]->coord[2] = tx1[2];
-            tri1->a = ta; tri1->b = tb; tri1->c = tc; tri1->d = td;
-
-            //  triangle 2
-            ta = tri2->a; tb = tri2->b; tc = tri2->c; td = tri2->d;
-            for ( k = 0; k < 3; k++ ) {
-              tx1[k] = poly2->verts[tri2->v0]->coord[k];
-              ty1[k] = poly2->verts[tri2->v1]->coord[k];
-              tz1[k] = poly2->verts[tri2->v2]->coord[k];
-            } 
-
-            poly2->verts[tri2->v2]->coord[0] += ta;
-            poly2->verts[tri2->v2]->coord[1] += tb;
-            poly2->verts[tri2->v2]->coord[2] += tc;
-            //  Compute new normal and linecoeff
-            newplanecoefficients(poly2, tri2);
-            linecoeff[0] = tri1->c*tri2->b - tri1->b*tri2->c;
-            linecoeff[1] = tri1->a*tri2->c - tri1->c*tri2->a;
-            linecoeff[2] = tri1->b*tri2->a - tri1->a*tri2->b;
-            dtemp = sqrt(linecoeff[0]*linecoeff[0] +
-                         linecoeff[1]*linecoeff[1] +
-                         linecoeff[2]*linecoeff[2]);
-            linecoeff[0] /= dtemp;
-            linecoeff[1] /= dtemp;
-            linecoeff[2] /= dtemp;
-
-            status = tri_tri_intersect(tri1,tri2);
-            if ( status != CUBIT_SUCCESS )
-            {
-                return status;
-            }
-
-            //  Restore values.
-            poly2->verts[tri2->v2]->coord[0] = tz1[0];
-            poly2->verts[tri2->v2]->coord[1] = tz1[1];
-            poly2->verts[tri2->v2]->coord[2] = tz1[2];
-            tri2->a = ta; tri2->b = tb; tri2->c = tc; tri2->d = td;
-
-            poly2->verts[tri2->v1]->coord[0] += ta;
-            poly2->verts[tri2->v1]->coord[1] += tb;
-            poly2->verts[tri2->v1]->coord[2] += tc;
-            //  Compute new normal and linecoeff
-            newplanecoefficients(poly2, tri2);
-            linecoeff[0] = tri1->c*tri2->b - tri1->b*tri2->c;
-            linecoeff[1] = tri1->a*tri2->c - tri1->c*tri2->a;
-            linecoeff[2] = tri1->b*tri2->a - tri1->a*tri2->b;
-            dtemp = sqrt(linecoeff[0]*linecoeff[0] +
-                         linecoeff[1]*linecoeff[1] +
-                         linecoeff[2]*linecoeff[2]);
-            linecoeff[0] /= dtemp;
-            linecoeff[1] /= dtemp;
-            linecoeff[2] /= dtemp;
-
-            status = tri_tri_intersect(tri1,tri2);
-            if ( status != CUBIT_SUCCESS )
-            {
-                return status;
-            }
-
-            //  Restore values.
-            poly2->verts[tri2->v1]->coord[0] = ty1[0];
-            poly2->verts[tri2->v1]->coord[1] = ty1[1];
-            poly2->verts[tri2->v1]->coord[2] = ty1[2];
-            tri2->a = ta; tri2->b = tb; tri2->c = tc; tri2->d = td;
-
-            poly2->verts[tri2->v0]->coord[0] += ta;
-            poly2->verts[tri2->v0]->coord[1] += tb;
-            poly2->verts[tri2->v0]->coord[2] += tc;
-            //  Compute new normal and linecoeff
-            newplanecoefficients(poly2, tri2);
-            linecoeff[0] = tri1->c*tri2->b - tri1->b*tri2->c;
-            linecoeff[1] = tri1->a*tri2->c - tri1->c*tri2->a;
-            linecoeff[2] = tri1->b*tri2->a - tri1->a*tri2->b;
-            dtemp = sqrt(linecoeff[0]*linecoeff[0] +
-                         linecoeff[1]*linecoeff[1] +
-                         linecoeff[2]*linecoeff[2]);
-            linecoeff[0] /= dtemp;
-            linecoeff[1] /= dtemp;
-            linecoeff[2] /= dtemp;
-
-            status = tri_tri_intersect(tri1,tri2);
-            if ( status != CUBIT_SUCCESS )
-            {
-                return status;
-            }
-
-            //  Restore values.
-            poly2->verts[tri2->v0]->coord[0] = tx1[0];
-            poly2->verts[tri2->v0]->coord[1] = tx1[1];
-            poly2->verts[tri2->v0]->coord[2] = tx1[2];
-            tri2->a = ta; tri2->b = tb; tri2->c = tc; tri2->d = td;
             
             continue;
         }
 
         if ( do_imprint == true ) {
         //  Don't intersect nearly-coplanar triangles.
-          if ( fabs(tri1->a*tri2->a + tri1->b*tri2->b +tri1->c*tri2->c) > 0.8 ) continue;
-       }
-        double dtemp;
-        dtemp = sqrt(linecoeff[0]*linecoeff[0] +
-                     linecoeff[1]*linecoeff[1] +
-                     linecoeff[2]*linecoeff[2]);
-        linecoeff[0] /= dtemp;
-        linecoeff[1] /= dtemp;
-        linecoeff[2] /= dtemp;
-
-        status = tri_tri_intersect(tri1,tri2);
-        if ( status != CUBIT_SUCCESS )
-        {
-            return status;
+          if ( fabs(plane1[0]*plane2[0] + plane1[1]*plane2[1] + plane1[2]*plane2[2]) > 0.8 ) continue;
         }
 
+        tri_tri_intersect(xc1,plane1,xc2,plane2,i,boxlist[j],segments);
+
      } // end of loop over poly2
 
   } // end of loop over poly1
-
-    //delete entire array.
-  delete [] boxlist;
-  
-  return status;
 }
 
-CubitStatus FBIntersect::tri_tri_intersect(FB_Triangle *tri1,
-              FB_Triangle *tri2)
+void FBIntersect::get_triangle_geometry(FBPolyhedron *poly, FB_Triangle *tri,
+                                        double *xc, double *plane)
 {
-int ret1, ret2, i;
-double xc10[3], xc11[3],xc12[3]; // coords for poly1 triangle
-double xc20[3], xc21[3],xc22[3]; // coords for poly2 triangle
-double d10, d11, d12, d20, d21, d22; // distance of vertex from plane of other triangle
-double tt[4];
-int edge_vert_type[4];
-CubitStatus status;
-
-  int mydebug = 0;
-  status = CUBIT_SUCCESS;
+int i;
 
-  tt[0] = tt[1] = tt[2] = tt[3] = CUBIT_DBL_MAX;
-//  Is tri1 entirely on one side of tri2?
   for ( i = 0; i < 3; i++ ) {
-     xc10[i] = poly1->verts[tri1->v0]->coord[i];
-     xc11[i] = poly1->verts[tri1->v1]->coord[i];
-     xc12[i] = poly1->verts[tri1->v2]->coord[i];
-   }
+    xc[i] = poly->verts[tri->v0]->coord[i];
+    xc[3+i] = poly->verts[tri->v1]->coord[i];
+    xc[6+i] = poly->verts[tri->v2]->coord[i];
+  }
+  plane[0] = tri->a; plane[1] = tri->b; plane[2] = tri->c; plane[3] = tri->d;
+}
 
-   //  distance of each tri1 vert to plane of tri2
-   d10 = xc10[0]*tri2->a + xc10[1]*tri2->b + xc10[2]*tri2->c + tri2->d;
-   d11 = xc11[0]*tri2->a + xc11[1]*tri2->b + xc11[2]*tri2->c + tri2->d;
-   d12 = xc12[0]*tri2->a + xc12[1]*tri2->b + xc12[2]*tri2->c + tri2->d;
-   if ( ( (d10 < -EPSILON2) && (d11 < -EPSILON2) && (d12 < -EPSILON2) ) ||
-        ( (d10 > EPSILON2) && (d11 > EPSILON2) && (d12 > EPSILON2) ) ) 
-      return CUBIT_SUCCESS;
-//  Is tri2 entirely on one side of tri1?
-  for ( i = 0; i < 3; i++ ) {
-     xc20[i] = poly2->verts[tri2->v0]->coord[i];
-     xc21[i] = poly2->verts[tri2->v1]->coord[i];
-     xc22[i] = poly2->verts[tri2->v2]->coord[i];
-   }
+void FBIntersect::tri_tri_intersect(double *xc1, double *plane1,
+                                    double *xc2, double *plane2,
+                                    int itri1, int itri2,
+                                    std::vector<FB_IntersectSegment>& segments)
+{
+int ret1, ret2;
+double d10, d11, d12, d20, d21, d22; // distance of vertex from plane of other triangle
+double linecoeff[3], linept[3];
+double dtemp;
+FB_IntersectSegment seg(itri1,itri2,FB_SEGMENT_EDGE);
 
+//  Is tri1 entirely on one side of tri2?  The sides are decided with exact
+//  orientation signs; the distances, which are only as good as the plane
+//  coefficients, are kept for locating the crossings.
+   if ( same_side(xc2,&xc1[0],&xc1[3],&xc1[6]) )
+      return;
+//  Is tri2 entirely on one side of tri1?
+   if ( same_side(xc1,&xc2[0],&xc2[3],&xc2[6]) )
+     return;
+   //  distance of each tri1 vert to plane of tri2
+   d10 = xc1[0]*plane2[0] + xc1[1]*plane2[1] + xc1[2]*plane2[2] + plane2[3];
+   d11 = xc1[3]*plane2[0] + xc1[4]*plane2[1] + xc1[5]*plane2[2] + plane2[3];
+   d12 = xc1[6]*plane2[0] + xc1[7]*plane2[1] + xc1[8]*plane2[2] + plane2[3];
    //  distance of each tri2 vert to plane of tri1
-   d20 = xc20[0]*tri1->a + xc20[1]*tri1->b + xc20[2]*tri1->c + tri1->d;
-   d21 = xc21[0]*tri1->a + xc21[1]*tri1->b + xc21[2]*tri1->c + tri1->d;
-   d22 = xc22[0]*tri1->a + xc22[1]*tri1->b + xc22[2]*tri1->c + tri1->d;
-   if ( ( (d20 < -EPSILON2) && (d21 < -EPSILON2) && (d22 < -EPSILON2) ) ||
-        ( (d20 > EPSILON2) && (d21 > EPSILON2) && (d22 > EPSILON2) ) )
-     return CUBIT_SUCCESS;
+   d20 = xc2[0]*plane1[0] + xc2[1]*plane1[1] + xc2[2]*plane1[2] + plane1[3];
+   d21 = xc2[3]*plane1[0] + xc2[4]*plane1[1] + xc2[5]*plane1[2] + plane1[3];
+   d22 = xc2[6]*plane1[0] + xc2[7]*plane1[1] + xc2[8]*plane1[2] + plane1[3];
+//  Direction of the line of intersection.
+   linecoeff[0] = plane1[2]*plane2[1] - plane1[1]*plane2[2];
+   linecoeff[1] = plane1[0]*plane2[2] - plane1[2]*plane2[0];
+   linecoeff[2] = plane1[1]*plane2[0] - plane1[0]*plane2[1];
+   dtemp = sqrt(linecoeff[0]*linecoeff[0] +
+                linecoeff[1]*linecoeff[1] +
+                linecoeff[2]*linecoeff[2]);
+   linecoeff[0] /= dtemp;
+   linecoeff[1] /= dtemp;
+   linecoeff[2] /= dtemp;
 //  Get a point on the line of intersection to serve as a reference point.
    double ta, tb, ts1, ts2, tdot11;
-   ts1 = -tri1->d; ts2 = -tri2->d;
+   ts1 = -plane1[3]; ts2 = -plane2[3];
 
-   tdot11 = tri1->a*tri2->a + tri1->b*tri2->b + tri1->c*tri2->c;
+   tdot11 = plane1[0]*plane2[0] + plane1[1]*plane2[1] + plane1[2]*plane2[2];
    ta = (ts2*tdot11 - ts1)/(tdot11*tdot11 - 1);
    tb = (ts1*tdot11 - ts2)/(tdot11*tdot11 - 1);
-   linept[0] = ta*tri1->a + tb*tri2->a;
-   linept[1] = ta*tri1->b + tb*tri2->b;
-   linept[2] = ta*tri1->c + tb*tri2->c;
+   linept[0] = ta*plane1[0] + tb*plane2[0];
+   linept[1] = ta*plane1[1] + tb*plane2[1];
+   linept[2] = ta*plane1[2] + tb*plane2[2];
   
 //  There are several cases for the distances.  
 //  ret1 holds the number of intersections of the triangle with the
 //  intersection line. 
 //  Do tri1.
       ret1 = get_intersectionline_parameter_values(d10,d11,d12,
-                                            xc10,xc11,xc12,
-                   tt[0],tt[1],
-                   edge_vert_type[0],edge_vert_type[1]);
+                                            &xc1[0],&xc1[3],&xc1[6],
+                                            linept,linecoeff,
+                   seg.tt[0],seg.tt[1],
+                   seg.edge_vert_type[0],seg.edge_vert_type[1]);
 //  Do tri2.
       ret2 = get_intersectionline_parameter_values(d20,d21,d22,
-                                            xc20,xc21,xc22,
-                   tt[2],tt[3],
-                   edge_vert_type[2],edge_vert_type[3]);
+                                            &xc2[0],&xc2[3],&xc2[6],
+                                            linept,linecoeff,
+                   seg.tt[2],seg.tt[3],
+                   seg.edge_vert_type[2],seg.edge_vert_type[3]);
 //  If not two intersections for each triangle, no intersection edge exists.
     if ( (ret1 == 2) && (ret2 == 2) )
     {
-        status = add_intersection_edges(tri1,tri2,tt,edge_vert_type);
-        if ( status != CUBIT_SUCCESS )
-        {
-            return status;
-        }
-    }
-    if(mydebug){
-      double min_angle_1, max_angle_1;
-      double min_angle_2, max_angle_2;
-      poly1->min_max_angles_in_fb_triangle(tri1, min_angle_1, max_angle_1);
-      poly2->min_max_angles_in_fb_triangle(tri2, min_angle_2, max_angle_2);
-    
-    
-      if(min_angle_1 < 10 || min_angle_2 < 10){
-        PRINT_INFO(" Tri 1 min angle = %f\n",min_angle_1);
-        PRINT_INFO(" Tri 2 min angle = %f\n",min_angle_2);
-      }
+        if ( find_intersection_segment(seg,linept,linecoeff) == true )
+          segments.push_back(seg);
     }
-    
-    return status;
 }
 
-CubitStatus FBIntersect::add_intersection_edges(FB_Triangle *tri1,
-                   FB_Triangle *tri2,
-                   double *tt,
-                   int *edge_vert_type
-                   )
+bool FBIntersect::same_side(double *xc, double *pt0, double *pt1, double *pt2)
 {
-int v10, v11, v20, v21;
-bool ifoundit, exists;
-FB_Edge *edge;
-double x1pt, y1pt, z1pt, x2pt, y2pt, z2pt;
+double o0, o1, o2;
+
+  o0 = FBPredicates::orient3d(&xc[0],&xc[3],&xc[6],pt0);
+  o1 = FBPredicates::orient3d(&xc[0],&xc[3],&xc[6],pt1);
+  o2 = FBPredicates::orient3d(&xc[0],&xc[3],&xc[6],pt2);
+  return ( ( (o0 < 0.0) && (o1 < 0.0) && (o2 < 0.0) ) ||
+           ( (o0 > 0.0) && (o1 > 0.0) && (o2 > 0.0) ) );
+}
+
+bool FBIntersect::find_intersection_segment(FB_IntersectSegment& seg,
+                                            double *linept,
+                                            double *linecoeff)
+{
+bool ifoundit;
+double *tt = seg.tt;
+int *edge_vert_type = seg.edge_vert_type;
+double *pt1 = &seg.pt[0], *pt2 = &seg.pt[3];
 int edge1_vert0_type, edge1_vert1_type, edge2_vert0_type, edge2_vert1_type;
 
   ifoundit = false;
@@ -734,10 +599,10 @@ int edge1_vert0_type, edge1_vert1_type, edge2_vert0_type, edge2_vert1_type;
   if ( fabs(tt[1]-tt[3]) < EPSILON ) tt[3] = tt[1];
    
 // cases 0 and 9, no overlap 
-//  if ( (tt[1] < tt[2]) || (tt[3] < tt[0]) ) return CUBIT_SUCCESS;
-  if ( tt[1] < tt[2] ) { return CUBIT_SUCCESS; }
+//  if ( (tt[1] < tt[2]) || (tt[3] < tt[0]) ) return false;
+  if ( tt[1] < tt[2] ) { return false; }
   
-  if ( tt[3] < tt[0] ) { return CUBIT_SUCCESS; }
+  if ( tt[3] < tt[0] ) { return false; }
 
 //  These next four cases are by far the most common forms of overlap,
 //  so check for them first.
@@ -750,8 +615,8 @@ int edge1_vert0_type, edge1_vert1_type, edge2_vert0_type, edge2_vert1_type;
 //      2222        
   if ( (tt[2] > tt[0]) && (tt[3] < tt[1]) ) {
     ifoundit = true;    
-    get_point_from_parameter(tt[2],&x1pt,&y1pt,&z1pt);
-    get_point_from_parameter(tt[3],&x2pt,&y2pt,&z2pt);
+    get_point_from_parameter(tt[2],linept,linecoeff,pt1);
+    get_point_from_parameter(tt[3],linept,linecoeff,pt2);
     edge1_vert0_type = INTERIOR_VERT;
     edge1_vert1_type = INTERIOR_VERT;
     edge2_vert0_type = edge_vert_type[2];
@@ -762,8 +627,8 @@ int edge1_vert0_type, edge1_vert1_type, edge2_vert0_type, edge2_vert1_type;
 //        22222222     
   } else if ( (tt[2] < tt[1]) && (tt[2] > tt[0]) && (tt[3] > tt[1]) ) {
     ifoundit = true;
-    get_point_from_parameter(tt[2],&x1pt,&y1pt,&z1pt);
-    get_point_from_parameter(tt[1],&x2pt,&y2pt,&z2pt);
+    get_point_from_parameter(tt[2],linept,linecoeff,pt1);
+    get_point_from_parameter(tt[1],linept,linecoeff,pt2);
     edge1_vert0_type = INTERIOR_VERT;
     edge1_vert1_type = edge_vert_type[1];
     edge2_vert0_type = edge_vert_type[2];
@@ -774,8 +639,8 @@ int edge1_vert0_type, edge1_vert1_type, edge2_vert0_type, edge2_vert1_type;
 //    22222222      
   } else if ( (tt[0] < tt[3]) && (tt[0] > tt[2]) && (tt[1] > tt[3]) ) {
     ifoundit = true;  
-    get_point_from_parameter(tt[0],&x1pt,&y1pt,&z1pt);
-    get_point_from_parameter(tt[3],&x2pt,&y2pt,&z2pt);
+    get_point_from_parameter(tt[0],linept,linecoeff,pt1);
+    get_point_from_parameter(tt[3],linept,linecoeff,pt2);
     edge1_vert0_type = edge_vert_type[0];
     edge1_vert1_type = INTERIOR_VERT;
     edge2_vert0_type = INTERIOR_VERT;
@@ -786,8 +651,8 @@ int edge1_vert0_type, edge1_vert1_type, edge2_vert0_type, edge2_vert1_type;
 //    22222222      
   } else if ( (tt[0] > tt[2]) && (tt[1] < tt[3]) ) {
     ifoundit = true;  
-    get_point_from_parameter(tt[0],&x1pt,&y1pt,&z1pt);
-    get_point_from_parameter(tt[1],&x2pt,&y2pt,&z2pt);
+    get_point_from_parameter(tt[0],linept,linecoeff,pt1);
+    get_point_from_parameter(tt[1],linept,linecoeff,pt2);
     edge1_vert0_type = edge_vert_type[0];
     edge1_vert1_type = edge_vert_type[1];
     edge2_vert0_type = INTERIOR_VERT;
@@ -798,9 +663,8 @@ int edge1_vert0_type, edge1_vert1_type, edge2_vert0_type, edge2_vert1_type;
 //           22222222 
   } else if ( fabs(tt[1]-tt[2]) < EPSILON ) {
     ifoundit = true;
-//    return CUBIT_SUCCESS;
-    get_point_from_parameter(tt[1],&x1pt,&y1pt,&z1pt);
-    get_point_from_parameter(tt[1],&x2pt,&y2pt,&z2pt);  
+    get_point_from_parameter(tt[1],linept,linecoeff,pt1);
+    get_point_from_parameter(tt[1],linept,linecoeff,pt2);  
     edge1_vert0_type = edge_vert_type[1];
     edge1_vert1_type = edge_vert_type[1];
     edge2_vert0_type = edge_vert_type[2];
@@ -813,8 +677,8 @@ int edge1_vert0_type, edge1_vert1_type, edge2_vert0_type, edge2_vert1_type;
 //       22222    
     if ( tt[1] == tt[3] ) {
       ifoundit = true;
-      get_point_from_parameter(tt[2],&x1pt,&y1pt,&z1pt);
-      get_point_from_parameter(tt[3],&x2pt,&y2pt,&z2pt);  
+      get_point_from_parameter(tt[2],linept,linecoeff,pt1);
+      get_point_from_parameter(tt[3],linept,linecoeff,pt2);  
       edge1_vert0_type = INTERIOR_VERT;
       edge1_vert1_type = edge_vert_type[1];
       edge2_vert0_type = edge_vert_type[2];
@@ -829,8 +693,8 @@ int edge1_vert0_type, edge1_vert1_type, edge2_vert0_type, edge2_vert1_type;
 //    22222222  
     if ( tt[1] == tt[3] ) { 
       ifoundit = true;
-      get_point_from_parameter(tt[0],&x1pt,&y1pt,&z1pt);
-      get_point_from_parameter(tt[1],&x2pt,&y2pt,&z2pt);
+      get_point_from_parameter(tt[0],linept,linecoeff,pt1);
+      get_point_from_parameter(tt[1],linept,linecoeff,pt2);
       edge1_vert0_type = edge_vert_type[0];
       edge1_vert1_type = edge_vert_type[1];
       edge2_vert0_type = edge_vert_type[2];
@@ -841,8 +705,8 @@ int edge1_vert0_type, edge1_vert1_type, edge2_vert0_type, edge2_vert1_type;
 //    2222     
     } else if ( tt[1] > tt[3] ) { 
       ifoundit = true;
-      get_point_from_parameter(tt[2],&x1pt,&y1pt,&z1pt);
-      get_point_from_parameter(tt[3],&x2pt,&y2pt,&z2pt);
+      get_point_from_parameter(tt[2],linept,linecoeff,pt1);
+      get_point_from_parameter(tt[3],linept,linecoeff,pt2);
       edge1_vert0_type = edge_vert_type[0];
       edge1_vert1_type = INTERIOR_VERT;
       edge2_vert0_type = edge_vert_type[2];
@@ -853,8 +717,8 @@ int edge1_vert0_type, edge1_vert1_type, edge2_vert0_type, edge2_vert1_type;
 //    22222222      
     } else {
       ifoundit = true;
-      get_point_from_parameter(tt[0],&x1pt,&y1pt,&z1pt);
-      get_point_from_parameter(tt[1],&x2pt,&y2pt,&z2pt);
+      get_point_from_parameter(tt[0],linept,linecoeff,pt1);
+      get_point_from_parameter(tt[1],linept,linecoeff,pt2);
       edge1_vert0_type = edge_vert_type[0];
       edge1_vert1_type = edge_vert_type[1];
       edge2_vert0_type = edge_vert_type[2];
@@ -869,9 +733,8 @@ int edge1_vert0_type, edge1_vert1_type, edge2_vert0_type, edge2_vert1_type;
 //    22222222  
     if ( fabs(tt[0]-tt[3]) < EPSILON ) {
       ifoundit = true;
-//      return CUBIT_SUCCESS;
-      get_point_from_parameter(tt[0],&x1pt,&y1pt,&z1pt);
-      get_point_from_parameter(tt[0],&x2pt,&y2pt,&z2pt);  
+      get_point_from_parameter(tt[0],linept,linecoeff,pt1);
+      get_point_from_parameter(tt[0],linept,linecoeff,pt2);  
       edge1_vert0_type = edge_vert_type[0];
       edge1_vert1_type = edge_vert_type[0];
       edge2_vert0_type = edge_vert_type[3];
@@ -882,8 +745,8 @@ int edge1_vert0_type, edge1_vert1_type, edge2_vert0_type, edge2_vert1_type;
 //    22222222    
     } else if ( fabs(tt[1]-tt[3]) < EPSILON ) {
       ifoundit = true;
-      get_point_from_parameter(tt[0],&x1pt,&y1pt,&z1pt);
-      get_point_from_parameter(tt[1],&x2pt,&y2pt,&z2pt);       
+      get_point_from_parameter(tt[0],linept,linecoeff,pt1);
+      get_point_from_parameter(tt[1],linept,linecoeff,pt2);       
       edge1_vert0_type = edge_vert_type[0];
       edge1_vert1_type = edge_vert_type[1];
       edge2_vert0_type = INTERIOR_VERT;
@@ -892,11 +755,43 @@ int edge1_vert0_type, edge1_vert1_type, edge2_vert0_type, edge2_vert1_type;
     
   }
 
-  if ( ifoundit == false ) {
+//  An unaccounted for case is still recorded, so that it can be reported
+//  when the segments are added.
+  if ( ifoundit == false ) 
+    seg.type = FB_SEGMENT_UNACCOUNTED;
+  seg.edge1_vert0_type = edge1_vert0_type;
+  seg.edge1_vert1_type = edge1_vert1_type;
+  seg.edge2_vert0_type = edge2_vert0_type;
+  seg.edge2_vert1_type = edge2_vert1_type;
+
+  return true;
+}
+
+CubitStatus FBIntersect::add_intersection_edges(FB_IntersectSegment& seg)
+{
+int v10, v11, v20, v21;
+bool exists;
+FB_Edge *edge;
+FB_Triangle *tri1, *tri2;
+double *tt = seg.tt;
+int *edge_vert_type = seg.edge_vert_type;
+double x1pt, y1pt, z1pt, x2pt, y2pt, z2pt;
+int edge1_vert0_type, edge1_vert1_type, edge2_vert0_type, edge2_vert1_type;
+
+  if ( seg.type == FB_SEGMENT_UNACCOUNTED ) {
     PRINT_ERROR("unaccounted for case in add_intersection_edges: tt[] =  %le %le %le %le\n",
       tt[0],tt[1],tt[2],tt[3]);
     return CUBIT_FAILURE;
   } else {
+    tri1 = poly1->tris[seg.tri1];
+    tri2 = poly2->tris[seg.tri2];
+    x1pt = seg.pt[0]; y1pt = seg.pt[1]; z1pt = seg.pt[2];
+    x2pt = seg.pt[3]; y2pt = seg.pt[4]; z2pt = seg.pt[5];
+    edge1_vert0_type = seg.edge1_vert0_type;
+    edge1_vert1_type = seg.edge1_vert1_type;
+    edge2_vert0_type = seg.edge2_vert0_type;
+    edge2_vert1_type = seg.edge2_vert1_type;
+
     tri1->dudded = true;
     v10 = poly1->addavertex(x1pt,y1pt,z1pt);
     v11 = poly1->addavertex(x2pt,y2pt,z2pt);
@@ -1025,17 +920,18 @@ int edge1_vert0_type, edge1_vert1_type, edge2_vert0_type, edge2_vert1_type;
 }
 
 void FBIntersect::get_point_from_parameter(double parameter,
-                 double *x, double *y, double *z)
+                 double *linept, double *linecoeff, double *pt)
 {
-  *x = linept[0] + linecoeff[0]*parameter; 
-  *y = linept[1] + linecoeff[1]*parameter; 
-  *z = linept[2] + linecoeff[2]*parameter; 
+  pt[0] = linept[0] + linecoeff[0]*parameter; 
+  pt[1] = linept[1] + linecoeff[1]*parameter; 
+  pt[2] = linept[2] + linecoeff[2]*parameter; 
 
 }
 
 double FBIntersect::get_distance_parameter(double *xc0,
                  double *xc1,
-                 double d0, double d1)
+                 double d0, double d1,
+                 double *linept, double *linecoeff)
 {
 double v1dot, v2dot;
 
@@ -1053,7 +949,8 @@ double v1dot, v2dot;
 }
 
 
-double FBIntersect::get_distance_parameter_single(double *xc)
+double FBIntersect::get_distance_parameter_single(double *xc,
+                 double *linept, double *linecoeff)
 {
 double coeff;
 int coord;
@@ -1077,6 +974,8 @@ int FBIntersect::get_intersectionline_parameter_values(
                     double *pt0,
                     double *pt1,
                     double *pt2,
+                    double *linept,
+                    double *linecoeff,
                     double& t0,
                     double& t1,
                     int& vert_type_0,
@@ -1092,23 +991,23 @@ int ret = 0;
         ret = 0;
       } else {
       //  d0 = d1 = 0
-        t0 = get_distance_parameter_single(pt0);
-        t1 = get_distance_parameter_single(pt1);
+        t0 = get_distance_parameter_single(pt0,linept,linecoeff);
+        t1 = get_distance_parameter_single(pt1,linept,linecoeff);
    vert_type_0 = VERTEX_0;
    vert_type_1 = VERTEX_1;
         ret = 2;
       }
     } else if ( fabs(d2) < EPSILON ) {
     //  d0 = d2 = 0
-      t0 = get_distance_parameter_single(pt0);
-      t1 = get_distance_parameter_single(pt2);      
+      t0 = get_distance_parameter_single(pt0,linept,linecoeff);
+      t1 = get_distance_parameter_single(pt2,linept,linecoeff);      
       vert_type_0 = VERTEX_0;
       vert_type_1 = VERTEX_2;     
       ret = 2;
     } else if ( d1*d2 < 0.0 ) {
     //  d0 = 0 and edge 12 crosses
-      t0 = get_distance_parameter_single(pt0);
-      t1 = get_distance_parameter(pt1,pt2,d1,d2);
+      t0 = get_distance_parameter_single(pt0,linept,linecoeff);
+      t1 = get_distance_parameter(pt1,pt2,d1,d2,linept,linecoeff);
       vert_type_0 = VERTEX_0;
       vert_type_1 = EDGE_1;     
       ret = 2;
@@ -1119,15 +1018,15 @@ int ret = 0;
   } else if ( fabs(d1) < EPSILON ) {
     if ( fabs(d2) < EPSILON ) {
     //  d1 = d2 = 0
-      t0 = get_distance_parameter_single(pt1);
-      t1 = get_distance_parameter_single(pt2); 
+      t0 = get_distance_parameter_single(pt1,linept,linecoeff);
+      t1 = get_distance_parameter_single(pt2,linept,linecoeff); 
       vert_type_0 = VERTEX_1;
       vert_type_1 = VERTEX_2;     
       ret = 2;   
     } else if ( d0*d2 < 0.0 ) {
     //  d1 = 0 and edge 20 crosses
-      t0 = get_distance_parameter_single(pt1);    
-      t1 = get_distance_parameter(pt0,pt2,d0,d2);
+      t0 = get_distance_parameter_single(pt1,linept,linecoeff);    
+      t1 = get_distance_parameter(pt0,pt2,d0,d2,linept,linecoeff);
       vert_type_0 = VERTEX_1;
       vert_type_1 = EDGE_2;     
       ret = 2;
@@ -1138,8 +1037,8 @@ int ret = 0;
   } else if ( fabs(d2) < EPSILON ) {
     if ( d0*d1 < 0.0 ) {
     //  d2 = 0 and edge 01 crosses
-      t0 = get_distance_parameter_single(pt2);    
-      t1 = get_distance_parameter(pt0,pt1,d0,d1);
+      t0 = get_distance_parameter_single(pt2,linept,linecoeff);    
+      t1 = get_distance_parameter(pt0,pt1,d0,d1,linept,linecoeff);
       vert_type_0 = VERTEX_2;
       vert_type_1 = EDGE_0;     
       ret = 2;    
@@ -1150,23 +1049,23 @@ int ret = 0;
   } else if ( d0*d1 < 0.0 ) {
     if ( d0*d2 < 0.0 ) {
     //  edges 01 and 02 cross
-      t0 = get_distance_parameter(pt0,pt1,d0,d1);
-      t1 = get_distance_parameter(pt0,pt2,d0,d2);
+      t0 = get_distance_parameter(pt0,pt1,d0,d1,linept,linecoeff);
+      t1 = get_distance_parameter(pt0,pt2,d0,d2,linept,linecoeff);
       vert_type_0 = EDGE_0;
       vert_type_1 = EDGE_2;     
       ret = 2;
     } else {
     //  edges 01 and 12 cross
-      t0 = get_distance_parameter(pt0,pt1,d0,d1);
-      t1 = get_distance_parameter(pt1,pt2,d1,d2);
+      t0 = get_distance_parameter(pt0,pt1,d0,d1,linept,linecoeff);
+      t1 = get_distance_parameter(pt1,pt2,d1,d2,linept,linecoeff);
       vert_type_0 = EDGE_0;
       vert_type_1 = EDGE_1;     
       ret = 2;
     }
   } else {
   //  edges 02 and 12 cross
-      t0 = get_distance_parameter(pt0,pt2,d0,d2);
-      t1 = get_distance_parameter(pt1,pt2,d1,d2);
+      t0 = get_distance_parameter(pt0,pt2,d0,d2,linept,linecoeff);
+      t1 = get_distance_parameter(pt1,pt2,d1,d2,linept,linecoeff);
       vert_type_0 = EDGE_2;
       vert_type_1 = EDGE_1;     
       ret = 2;
@@ -1388,7 +1287,11 @@ CubitStatus FBIntersect::gather_by_boolean(std::vector<double>& out_coords,
     classify1->get_group(&group1, &groupcharacterization1);
     classify2->get_group(&group2, &groupcharacterization2);
 
-    IntegerHash *hashobj = new IntegerHash(NUMHASHBINS,20);
+    //  The output has at most as many vertices as the two objects, and
+    //  usually about half as many as it has triangles.
+    FBCoordHash coordhash(CUBIT_MIN(poly1->verts.size() + poly2->verts.size(),
+                                    (poly1->tris.size() + poly2->tris.size())/2),
+                          EPSILON);
 
     it = group1->begin();
     ig = groupcharacterization1->begin(); 
@@ -1402,13 +1305,13 @@ CubitStatus FBIntersect::gather_by_boolean(std::vector<double>& out_coords,
         if ( ( *(ig + *it) & booltest1 ) != 0 )
         {
             vtx = poly1->tris[i]->v0;
-            vertnum1 = get_vertex(poly1, vtx, hashobj, out_coords, verts_sofar);
+            vertnum1 = get_vertex(poly1, vtx, coordhash, out_coords, verts_sofar);
 
             vtx = poly1->tris[i]->v1;
-            vertnum2 = get_vertex(poly1, vtx, hashobj, out_coords, verts_sofar);
+            vertnum2 = get_vertex(poly1, vtx, coordhash, out_coords, verts_sofar);
 
             vtx = poly1->tris[i]->v2;
-            vertnum3 = get_vertex(poly1, vtx, hashobj, out_coords, verts_sofar);
+            vertnum3 = get_vertex(poly1, vtx, coordhash, out_coords, verts_sofar);
 
             if ( store_connectivity( out_connections,
                                      vertnum1,
@@ -1440,13 +1343,13 @@ CubitStatus FBIntersect::gather_by_boolean(std::vector<double>& out_coords,
         if ( ( *(ig + *it) & booltest2 ) != 0 )
         {
             vtx = poly2->tris[i]->v0;
-            vertnum1 = get_vertex(poly2, vtx, hashobj, out_coords, verts_sofar);
+            vertnum1 = get_vertex(poly2, vtx, coordhash, out_coords, verts_sofar);
 
             vtx = poly2->tris[i]->v1;
-            vertnum2 = get_vertex(poly2, vtx, hashobj, out_coords, verts_sofar);
+            vertnum2 = get_vertex(poly2, vtx, coordhash, out_coords, verts_sofar);
 
             vtx = poly2->tris[i]->v2;
-            vertnum3 = get_vertex(poly2, vtx, hashobj, out_coords, verts_sofar);
+            vertnum3 = get_vertex(poly2, vtx, coordhash, out_coords, verts_sofar);
 
             if ( op == CUBIT_FB_SUBTRACTION ) //  reverse the winding      
             {
@@ -1491,8 +1394,7 @@ CubitStatus FBIntersect::gather_by_boolean(std::vector<double>& out_coords,
 //  GfxDebug::mouse_xforms();
 //  GfxDebug::clear();
 //  poly2->debug_draw_boundary_edges(CUBIT_GREEN);
-    delete hashobj;   
- 
+
     status = CUBIT_SUCCESS;  
     return status;
 }
@@ -1519,34 +1421,20 @@ CubitStatus FBIntersect::store_connectivity
 }
 
 int FBIntersect::get_vertex(FBPolyhedron *poly, int vtx, 
-                            IntegerHash *hashobj,
+                            FBCoordHash& coordhash,
                             std::vector<double>& out_coords,
                             int &num_sofar)
 {
-double xx, yy, zz, xval, yval, zval;
-int i, hashvalue, *hasharrayptr, hasharraysize, hptr, ifoundit;
+double xx, yy, zz;
+int ifoundit;
 
   xx = poly->verts[vtx]->coord[0];
   yy = poly->verts[vtx]->coord[1];
   zz = poly->verts[vtx]->coord[2];
-  hashvalue = makeahashvaluefrom_coord(xx,yy,zz);
-  hasharrayptr = hashobj->getHashBin(hashvalue,&hasharraysize);
-  ifoundit = -1;
-  for ( i = 0; i < hasharraysize; i++ ) {
-    hptr = hasharrayptr[i];
-    xval = out_coords[3*hptr];
-    yval = out_coords[3*hptr+1];
-    zval = out_coords[3*hptr+2];
-    if ( ( fabs(xval-xx) < EPSILON ) && 
-    ( fabs(yval-yy) < EPSILON ) &&
-    ( fabs(zval-zz) < EPSILON ) ) {
-      ifoundit = hasharrayptr[i];
-      break;
-    }
-  }
+  ifoundit = coordhash.find(xx,yy,zz);
   if ( ifoundit == -1 ) {
     ifoundit = num_sofar;
-    hashobj->addtoHashList(hashvalue,num_sofar);
+    coordhash.insert(xx,yy,zz,num_sofar);
     out_coords.push_back(xx);
     out_coords.push_back(yy);
     out_coords.push_back(zz);    
@@ -1555,20 +1443,6 @@ int i, hashvalue, *hasharrayptr, hasharraysize, hptr, ifoundit;
     
   return ifoundit;
 }
-                                   
-int FBIntersect::makeahashvaluefrom_coord(double x, double y, double z)
-{
-double mantissasum;
-
-      if ( fabs(x) < 1.e-3 ) x = 0.0;
-      if ( fabs(y) < 1.e-3 ) y = 0.0;
-      if ( fabs(z) < 1.e-3 ) z = 0.0;
-      mantissasum = (int)(10000.0*fabs(x) + 0.5) + 
-                    (int)(10000.0*fabs(y) + 0.5) + 
-          (int)(10000.0*fabs(z) + 0.5);
-      
-      return (int)(mantissasum) % NUMHASHBINS;
-}
                                     
                                       
 void FBIntersect::set_body1_planar()
@@ -1586,38 +1460,35 @@ void FBIntersect::set_imprint()
   do_imprint = true;
 }
 
-void FBIntersect::newplanecoefficients(FBPolyhedron *poly, FB_Triangle *tri)
+bool FBIntersect::newplanecoefficients(double *xc, double *plane)
 {
-FB_Coord *mycoord;
 double x1, x2, x3, y1, y2, y3, z1, z2, z3, e1x, e1y, e1z, e2x, e2y, e2z;
 double a, b, c, d, dtemp;
-
-     mycoord = poly->verts[tri->v0];
-     x1 = mycoord->coord[0];
-     y1 = mycoord->coord[1];
-     z1 = mycoord->coord[2];
-     mycoord = poly->verts[tri->v1];
-     x2 = mycoord->coord[0];
-     y2 = mycoord->coord[1];
-     z2 = mycoord->coord[2];
-     mycoord = poly->verts[tri->v2];
-     x3 = mycoord->coord[0];
-     y3 = mycoord->coord[1];
-     z3 = mycoord->coord[2];
+bool big_enough;
+
+     x1 = xc[0];
+     y1 = xc[1];
+     z1 = xc[2];
+     x2 = xc[3];
+     y2 = xc[4];
+     z2 = xc[5];
+     x3 = xc[6];
+     y3 = xc[7];
+     z3 = xc[8];
      e1x = x1 - x2; e1y = y1 - y2; e1z = z1 - z2;
      e2x = x3 - x2; e2y = y3 - y2; e2z = z3 - z2;
      a = e1z*e2y - e2z*e1y;
      b = e1x*e2z - e2x*e1z;
      c = e1y*e2x - e2y*e1x;
      dtemp = sqrt(a*a + b*b + c*c);
-     if ( dtemp > EPSILON2 ) {
+     big_enough = dtemp > EPSILON2;
+     if ( big_enough ) {
        a /= dtemp;
        b /= dtemp;
        c /= dtemp;
-     } else {
-       PRINT_WARNING("small-area triangle\n");
      }
      d = -(a*x1 + b*y1 + c*z1);
-     tri->a = a; tri->b = b; tri->c = c; tri->d = d;
-          
+     plane[0] = a; plane[1] = b; plane[2] = c; plane[3] = d;
+
+     return big_enough;          
 }
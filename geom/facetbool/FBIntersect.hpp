@@ -32,10 +32,39 @@
 #include "FBStructs.hpp"
 #include "CubitDefines.h"
 #include "FBClassify.hpp"
+#include "FBCoordHash.hpp"
 
 class FBPolyhedron;
 class FBRetriangulate;
 
+//  The intersection of a pair of triangles, as found by the tri-tri 
+//  intersection and later added to the polyhedra.
+const int FB_SEGMENT_EDGE = 0;
+const int FB_SEGMENT_UNACCOUNTED = 1;
+const int FB_SEGMENT_SMALL_AREA = 2;
+
+class FB_IntersectSegment {
+
+public:
+  FB_IntersectSegment(int itri1, int itri2, int itype)
+  {
+    tri1 = itri1;
+    tri2 = itri2;
+    type = itype;
+    tt[0] = tt[1] = tt[2] = tt[3] = CUBIT_DBL_MAX;
+    edge_vert_type[0] = edge_vert_type[1] = UNKNOWN;
+    edge_vert_type[2] = edge_vert_type[3] = UNKNOWN;
+    edge1_vert0_type = edge1_vert1_type = UNKNOWN;
+    edge2_vert0_type = edge2_vert1_type = UNKNOWN;
+  }
+  int tri1, tri2;  //  indices into poly1->tris and poly2->tris
+  int type;
+  double tt[4];
+  int edge_vert_type[4];
+  double pt[6];  //  the two endpoints of the segment
+  int edge1_vert0_type, edge1_vert1_type, edge2_vert0_type, edge2_vert1_type;
+};
+
 class FBIntersect {
 
 public:
@@ -99,8 +128,6 @@ public:
   void set_imprint();
    
 private:
-  double linecoeff[3];
-  double linept[3];
   FBPolyhedron *poly1, *poly2; 
   bool do_edges_only;
   bool do_classify;
@@ -108,25 +135,33 @@ private:
   bool body1_is_plane, body2_is_plane;
   bool nothing_intersected;
   std::vector<int> *f_c_indices1, *f_c_indices2;
+  std::vector< std::vector<FB_IntersectSegment> > rangeSegments;
   FBClassify *classify1, *classify2;
   CubitStatus pair_intersect();
   int get_vertex(FBPolyhedron *poly, int vtx, 
-                 IntegerHash *hashobj,
+                 FBCoordHash& coordhash,
                  std::vector<double>& out_coords,
                  int &num_sofar);
-  int makeahashvaluefrom_coord(double x, double y, double z);
-  CubitStatus tri_tri_intersect(FB_Triangle *tri1,
-                                FB_Triangle *tri2);
-  CubitStatus add_intersection_edges(FB_Triangle *tri1,
-              FB_Triangle *tri2,
-              double *tt,
-              int *edge_vert_type);
+  void pair_intersect_range(size_t index, std::pair<size_t,size_t> tris);
+  void get_triangle_geometry(FBPolyhedron *poly, FB_Triangle *tri,
+                             double *xc, double *plane);
+  void tri_tri_intersect(double *xc1, double *plane1,
+                         double *xc2, double *plane2,
+                         int itri1, int itri2,
+                         std::vector<FB_IntersectSegment>& segments);
+  bool same_side(double *xc, double *pt0, double *pt1, double *pt2);
+  bool find_intersection_segment(FB_IntersectSegment& seg,
+                                 double *linept,
+                                 double *linecoeff);
+  CubitStatus add_intersection_edges(FB_IntersectSegment& seg);
   inline void get_point_from_parameter(double parameter,
-              double *x, double *y, double *z);
+              double *linept, double *linecoeff, double *pt);
   inline double get_distance_parameter(double *xc0,
               double *xc1,
-              double d0, double d1);
-  inline double get_distance_parameter_single(double *xc);
+              double d0, double d1,
+              double *linept, double *linecoeff);
+  inline double get_distance_parameter_single(double *xc,
+              double *linept, double *linecoeff);
   int get_intersectionline_parameter_values(
                     double d0, 
                     double d1, 
@@ -134,6 +169,8 @@ private:
                     double *pt0,
                     double *pt1,
                     double *pt2,
+                    double *linept,
+                    double *linecoeff,
                     double& t0,
                     double& t1,
                     int& vert_type_0,
@@ -151,7 +188,7 @@ private:
       return EDGE_2;
     else return INTERIOR_VERT;
   }  
-  void  newplanecoefficients(FBPolyhedron *poly, FB_Triangle *tri);
+  bool newplanecoefficients(double *xc, double *plane);
 
   CubitStatus store_connectivity( std::vector<int>& out_connections,
                                   int vertnum1,
@@ -38,15 +38,16 @@
 #include "CubitMessage.hpp"
 #include "CubitVector.hpp"
 #include "GfxDebug.hpp"
+#include "CubitConcurrentApi.h"
 const double BOX_CRACK = 1.e-4;
 
-FBPolyhedron::FBPolyhedron()
+FBPolyhedron::FBPolyhedron() : coordhash(0,EPSILON)
 {
 
   polyxmin = polyymin = polyzmin = CUBIT_DBL_MAX;
   polyxmax = polyymax = polyzmax = -polyxmin;
-  hashobj = new IntegerHash(NUMHASHBINS,20);
   original_numtris = 0;
+  kdtree = 0;
   
 }
 
@@ -54,7 +55,6 @@ FBPolyhedron::~FBPolyhedron()
 {
 unsigned int i;
 
-  delete hashobj; 
   delete kdtree;
   for ( i = 0; i < verts.size(); i++ ) {
     delete verts[i];
@@ -69,7 +69,7 @@ CubitStatus FBPolyhedron::makepoly(const std::vector<double>& coords,
                                    const std::vector<int>& connections,
                                    std::vector<int> *f_c_indices)
 {
-  int hashvalue, parent, cubitfacetindex;
+  int parent, cubitfacetindex;
   int cubitedge0index, cubitedge1index, cubitedge2index;
   unsigned int i;
   FB_Coord *mycoord; 
@@ -78,12 +78,15 @@ CubitStatus FBPolyhedron::makepoly(const std::vector<double>& coords,
   FSBOXVECTOR boxvector;
   std::vector<int>::iterator dpi;
   status = CUBIT_SUCCESS;
+
+   //  Leave room for the vertices that intersecting will add, which go
+   //  roughly with the number of triangles.
+   coordhash.reserve(coords.size()/3 + connections.size()/3);
   
    for ( i = 0; i < coords.size(); i += 3 ) {
 
       mycoord = new FB_Coord(coords[i],coords[i+1],coords[i+2]); 
-      hashvalue = makeahashvaluefrom_coord(coords[i],coords[i+1],coords[i+2]);
-      hashobj->addtoHashList(hashvalue,verts.size());
+      coordhash.insert(coords[i],coords[i+1],coords[i+2],verts.size());
       verts.push_back(mycoord);  
    }
    numpts = verts.size();
@@ -144,49 +147,17 @@ double xmin, ymin, zmin, xmax, ymax, zmax;
   return true;
 }
 
-int FBPolyhedron::makeahashvaluefrom_coord(double x, double y, double z)
-{
-double mantissasum;
-
-      if ( fabs(x) < 1.e-3 ) x = 0.0;
-      if ( fabs(y) < 1.e-3 ) y = 0.0;
-      if ( fabs(z) < 1.e-3 ) z = 0.0;
-      mantissasum = (int)(10000.0*fabs(x) + 0.5) + 
-                    (int)(10000.0*fabs(y) + 0.5) + 
-          (int)(10000.0*fabs(z) + 0.5);
-      
-      return (int)(mantissasum) % NUMHASHBINS;
-}
-
 int FBPolyhedron::addavertex(double x, double y, double z)
 {
-int hashvalue, i, ifoundit;
-int *hasharrayptr, hasharraysize;
-double xval, yval, zval;
-FB_Coord *mycoord, *newcoord;
+int ifoundit;
+FB_Coord *newcoord;
 
-  hashvalue = makeahashvaluefrom_coord(x,y,z);
-  
-  hasharrayptr = hashobj->getHashBin(hashvalue,&hasharraysize);
-  
-  ifoundit = -1;
-  for ( i = 0; i < hasharraysize; i++ ) {
-    mycoord = verts[hasharrayptr[i]];
-    xval = mycoord->coord[0];
-    yval = mycoord->coord[1];
-    zval = mycoord->coord[2];
-    if ( ( fabs(xval-x) < EPSILON ) && 
-    ( fabs(yval-y) < EPSILON ) &&
-    ( fabs(zval-z) < EPSILON ) ) {
-      ifoundit = hasharrayptr[i];
-      break;
-    }
-  }
+  ifoundit = coordhash.find(x,y,z);
   if ( ifoundit == -1 ) {
     newcoord = new FB_Coord(x,y,z);
     ifoundit = verts.size();    
     verts.push_back(newcoord);
-    hashobj->addtoHashList(hashvalue,ifoundit);
+    coordhash.insert(x,y,z,ifoundit);
   }
   verts[ifoundit]->is_on_boundary = true;
   return ifoundit;
@@ -357,39 +328,90 @@ unsigned int i;
 CubitStatus FBPolyhedron::retriangulate(std::vector<int>& newfacets, 
                                         std::vector<int>& newfacetsindex)
 {
-CubitStatus status;
+  return retriangulate(newfacets,&newfacetsindex);
+}
+
+CubitStatus FBPolyhedron::retriangulate(std::vector<int>& newfacets)
+{
+  return retriangulate(newfacets,0);
+}
+
+//  Retriangulates ranges of dudded triangles, keeping the triangles and
+//  facets each range makes until they are added to the polyhedron.  Each
+//  range reads only the vertices and its own triangles.
+class FB_RetriangulateBatch {
+
+public:
+  FB_RetriangulateBatch(std::vector<FB_Coord *>& my_verts,
+                        std::vector<FB_Triangle *>& my_tris, size_t num_ranges)
+    : verts(my_verts), tris(my_tris), results(num_ranges) {}
+
+  void retriangulate_range(size_t index, std::pair<size_t,size_t> range);
+
+  class RangeResult {
+  public:
+    RangeResult() { status = CUBIT_SUCCESS; found_one = false; }
+    std::vector<FB_Triangle *> newtris;
+    std::vector<int> newfacets;
+    std::vector<int> newfacetsindex;  //  offsets into this range's newfacets
+    CubitStatus status;  //  that of the last triangle retriangulated
+    bool found_one;
+  };
+
+  std::vector<FB_Coord *>& verts;
+  std::vector<FB_Triangle *>& tris;
+  std::vector<RangeResult> results;
+};
+
+void FB_RetriangulateBatch::retriangulate_range(size_t index, 
+                                                std::pair<size_t,size_t> range)
+{
 FBRetriangulate *retriangulater;
-unsigned int i;
+size_t i;
+RangeResult &result = results[index];
 
-  status = CUBIT_SUCCESS;
-  for ( i = 0; i < tris.size(); i++ ) {
+  for ( i = range.first; i < range.second; i++ ) {
     if ( tris[i]->dudded == true ) {
       tris[i]->parent = (int)i;
-      retriangulater = new FBRetriangulate(verts, tris, newfacets, newfacetsindex); 
-      status = retriangulater->retriangulate_this_tri(i);      
+      retriangulater = new FBRetriangulate(verts, tris, result.newtris, 
+                                           result.newfacets, 
+                                           result.newfacetsindex); 
+      result.status = retriangulater->retriangulate_this_tri(i);      
+      result.found_one = true;
       delete retriangulater;
     }
-  
   }
-  
-  return status;
+
 }
 
-CubitStatus FBPolyhedron::retriangulate(std::vector<int>& newfacets)
+CubitStatus FBPolyhedron::retriangulate(std::vector<int>& newfacets, 
+                                        std::vector<int> *newfacetsindex)
 {
 CubitStatus status;
-FBRetriangulate *retriangulater;
-unsigned int i;
+unsigned int i, k;
+size_t num_tris, offset;
+
+//  Each dudded triangle is retriangulated independently of the others, so
+//  ranges of them are done in parallel when the concurrency pool is 
+//  available.  The new triangles and facets are then added in range 
+//  order, the same order as retriangulating them one by one.
+  num_tris = tris.size();
+  FB_RetriangulateBatch batch(verts, tris, CubitConcurrent::num_ranges(num_tris));
+  CubitConcurrent::parallel_for_ranges( num_tris, batch, 
+                                        &FB_RetriangulateBatch::retriangulate_range );
 
   status = CUBIT_SUCCESS;
-  for ( i = 0; i < tris.size(); i++ ) {
-    if ( tris[i]->dudded == true ) {
-      tris[i]->parent = (int)i;
-      retriangulater = new FBRetriangulate(verts, tris, newfacets); 
-      status = retriangulater->retriangulate_this_tri(i);
-      delete retriangulater;
+  for ( k = 0; k < batch.results.size(); k++ ) {
+    FB_RetriangulateBatch::RangeResult &result = batch.results[k];
+    if ( result.found_one == true ) status = result.status;
+    offset = newfacets.size();
+    newfacets.insert(newfacets.end(),result.newfacets.begin(),
+                     result.newfacets.end());
+    if ( newfacetsindex ) {
+      for ( i = 0; i < result.newfacetsindex.size(); i++ )
+        newfacetsindex->push_back((int)offset + result.newfacetsindex[i]);
     }
-  
+    tris.insert(tris.end(),result.newtris.begin(),result.newtris.end());
   }
   
   return status;
@@ -519,6 +541,18 @@ int j;
     j++;
   }
   tris.resize(j);
+
+  //  The KdTree holds triangle sequence numbers, so remake it for the
+  //  compacted tris, including the ones added by retriangulation.
+  delete kdtree;
+  kdtree = 0;
+  if ( tris.size() > 0 ) {
+    FSBOXVECTOR boxvector;
+    for ( i = 0; i < tris.size(); i++ )
+      boxvector.push_back(&tris[i]->boundingbox);
+    kdtree = new KDTree();
+    kdtree->makeKDTree(tris.size(),boxvector);
+  }
 }
 
   //find the largest and smallest angles in this triangle
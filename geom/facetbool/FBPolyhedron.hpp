@@ -29,7 +29,7 @@
 #include <vector>
 #include <map>
 #include "FBStructs.hpp"
-#include "IntegerHash.hpp"
+#include "FBCoordHash.hpp"
 #include "CubitDefines.h"
 #include "KdTree.hpp"
 
@@ -58,8 +58,7 @@ private:
   std::multimap<unsigned int,unsigned int> edgmmap;
   std::vector<int> goodtris;
   double polyxmin, polyxmax, polyymin, polyymax, polyzmin, polyzmax;
-  IntegerHash *hashobj;
-  int makeahashvaluefrom_coord(double x, double y, double z);
+  FBCoordHash coordhash;
   int addavertex(double x, double y, double z);
   unsigned int numpts, numtris;
   void putnewpoints(std::vector<double>& newpoints);
@@ -67,6 +66,8 @@ private:
   bool edge_exists(int v0, int v1); 
   KDTree *kdtree;
   int original_numtris;
+  CubitStatus retriangulate(std::vector<int>& newfacets, 
+                            std::vector<int> *newfacetsindex);
 //  void putnewtriangles(std::vector<int>& newFacets);
   void add_new_triangle_data();
   void make_tri_plane_coeffs(FB_Triangle *tri);
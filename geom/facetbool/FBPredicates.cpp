@@ -0,0 +1,260 @@
+/*
+ *
+ *
+ * Copyright (C) 2004 Sandia Corporation.  Under the terms of Contract DE-AC04-94AL85000
+ * with Sandia Corporation, the U.S. Government retains certain rights in this software.
+ *
+ * This file is part of facetbool--contact via cubit@sandia.gov
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ *
+ */
+
+#include <math.h>
+#include "FBPredicates.hpp"
+
+//  Half the distance between 1.0 and the next larger double, and 2^27 + 1
+//  for splitting a double into two 26-bit halves.
+const double FB_PRED_EPSILON = 1.1102230246251565e-16;
+const double FB_PRED_SPLITTER = 134217729.0;
+//  Error bounds of the floating-point evaluations.
+const double FB_CCW_ERRBOUND = (3.0 + 16.0*FB_PRED_EPSILON)*FB_PRED_EPSILON;
+const double FB_O3D_ERRBOUND = (7.0 + 56.0*FB_PRED_EPSILON)*FB_PRED_EPSILON;
+
+//  x + y is exactly a + b, with x the rounded sum.
+static inline void fb_two_sum(double a, double b, double &x, double &y)
+{
+  x = a + b;
+  double bvirt = x - a;
+  double avirt = x - bvirt;
+  y = (a - avirt) + (b - bvirt);
+}
+
+//  As fb_two_sum, when |a| >= |b|.
+static inline void fb_fast_two_sum(double a, double b, double &x, double &y)
+{
+  x = a + b;
+  y = b - (x - a);
+}
+
+static inline void fb_split(double a, double &ahi, double &alo)
+{
+  double c = FB_PRED_SPLITTER*a;
+  ahi = c - (c - a);
+  alo = a - ahi;
+}
+
+//  x + y is exactly a*b, with x the rounded product.
+static inline void fb_two_product(double a, double b, double &x, double &y)
+{
+  double ahi, alo, bhi, blo;
+
+  x = a*b;
+  fb_split(a,ahi,alo);
+  fb_split(b,bhi,blo);
+  double err1 = x - ahi*bhi;
+  double err2 = err1 - alo*bhi;
+  double err3 = err2 - ahi*blo;
+  y = alo*blo - err3;
+}
+
+//  An expansion is an array of nonoverlapping doubles in order of increasing
+//  magnitude whose sum is the exact value; its last entry has the sign of
+//  the value.  h = e + f; h may not be e or f.  Returns the length of h.
+static int fb_expansion_sum(int elen, const double *e, int flen, 
+                            const double *f, double *h)
+{
+int eindex, findex, hindex, hlast;
+double q, qnew;
+
+  q = f[0];
+  for ( hindex = 0; hindex < elen; hindex++ ) {
+    fb_two_sum(q,e[hindex],qnew,h[hindex]);
+    q = qnew;
+  }
+  h[hindex] = q;
+  hlast = hindex;
+  for ( findex = 1; findex < flen; findex++ ) {
+    q = f[findex];
+    for ( hindex = findex; hindex <= hlast; hindex++ ) {
+      fb_two_sum(q,h[hindex],qnew,h[hindex]);
+      q = qnew;
+    }
+    h[++hlast] = q;
+  }
+  //  Drop the zero components.
+  hindex = -1;
+  for ( eindex = 0; eindex <= hlast; eindex++ ) {
+    if ( h[eindex] != 0.0 ) h[++hindex] = h[eindex];
+  }
+  if ( hindex == -1 ) {
+    h[0] = 0.0;
+    return 1;
+  }
+  return hindex + 1;
+}
+
+//  h = b*e; h may not be e.  Returns the length of h.
+static int fb_scale_expansion(int elen, const double *e, double b, double *h)
+{
+int eindex, hindex;
+double q, sum, hh, product1, product0;
+
+  fb_two_product(e[0],b,q,hh);
+  hindex = 0;
+  if ( hh != 0.0 ) h[hindex++] = hh;
+  for ( eindex = 1; eindex < elen; eindex++ ) {
+    fb_two_product(e[eindex],b,product1,product0);
+    fb_two_sum(q,product0,sum,hh);
+    if ( hh != 0.0 ) h[hindex++] = hh;
+    fb_fast_two_sum(product1,sum,q,hh);
+    if ( hh != 0.0 ) h[hindex++] = hh;
+  }
+  if ( (q != 0.0) || (hindex == 0) ) h[hindex++] = q;
+  return hindex;
+}
+
+//  h = px*qy - qx*py exactly, in at most four components.
+static int fb_two_by_two(double px, double py, double qx, double qy, double *h)
+{
+double e[2], f[2];
+
+  fb_two_product(px,qy,e[1],e[0]);
+  fb_two_product(qx,py,f[1],f[0]);
+  f[0] = -f[0]; f[1] = -f[1];
+  return fb_expansion_sum(2,e,2,f,h);
+}
+
+static void fb_negate(int elen, double *e)
+{
+  for ( int i = 0; i < elen; i++ ) e[i] = -e[i];
+}
+
+double FBPredicates::orient2d(const double *pa, const double *pb, 
+                              const double *pc)
+{
+double detleft, detright, det, detsum;
+
+  detleft = (pa[0] - pc[0])*(pb[1] - pc[1]);
+  detright = (pa[1] - pc[1])*(pb[0] - pc[0]);
+  det = detleft - detright;
+
+  if ( detleft > 0.0 ) {
+    if ( detright <= 0.0 ) return det;
+    detsum = detleft + detright;
+  } else if ( detleft < 0.0 ) {
+    if ( detright >= 0.0 ) return det;
+    detsum = -detleft - detright;
+  } else {
+    return det;
+  }
+
+  if ( fabs(det) > FB_CCW_ERRBOUND*detsum ) return det;
+  return orient2d_exact(pa,pb,pc);
+}
+
+double FBPredicates::orient3d(const double *pa, const double *pb, 
+                              const double *pc, const double *pd)
+{
+double adx, bdx, cdx, ady, bdy, cdy, adz, bdz, cdz;
+double bdxcdy, cdxbdy, cdxady, adxcdy, adxbdy, bdxady;
+double det, permanent;
+
+  adx = pa[0] - pd[0];
+  bdx = pb[0] - pd[0];
+  cdx = pc[0] - pd[0];
+  ady = pa[1] - pd[1];
+  bdy = pb[1] - pd[1];
+  cdy = pc[1] - pd[1];
+  adz = pa[2] - pd[2];
+  bdz = pb[2] - pd[2];
+  cdz = pc[2] - pd[2];
+
+  bdxcdy = bdx*cdy;
+  cdxbdy = cdx*bdy;
+  cdxady = cdx*ady;
+  adxcdy = adx*cdy;
+  adxbdy = adx*bdy;
+  bdxady = bdx*ady;
+
+  det = adz*(bdxcdy - cdxbdy) + bdz*(cdxady - adxcdy) + cdz*(adxbdy - bdxady);
+  permanent = (fabs(bdxcdy) + fabs(cdxbdy))*fabs(adz) +
+              (fabs(cdxady) + fabs(adxcdy))*fabs(bdz) +
+              (fabs(adxbdy) + fabs(bdxady))*fabs(cdz);
+
+  if ( fabs(det) > FB_O3D_ERRBOUND*permanent ) return det;
+  return orient3d_exact(pa,pb,pc,pd);
+}
+
+//  The differences of the coordinates are not exact, so the exact forms
+//  expand the determinants in terms of products of the coordinates.
+double FBPredicates::orient2d_exact(const double *pa, const double *pb,
+                                    const double *pc)
+{
+double ab[4], bc[4], ca[4], abbc[8], det[12];
+int ablen, bclen, calen, abbclen, detlen;
+
+  ablen = fb_two_by_two(pa[0],pa[1],pb[0],pb[1],ab);
+  bclen = fb_two_by_two(pb[0],pb[1],pc[0],pc[1],bc);
+  calen = fb_two_by_two(pc[0],pc[1],pa[0],pa[1],ca);
+  abbclen = fb_expansion_sum(ablen,ab,bclen,bc,abbc);
+  detlen = fb_expansion_sum(abbclen,abbc,calen,ca,det);
+
+  return det[detlen-1];
+}
+
+double FBPredicates::orient3d_exact(const double *pa, const double *pb,
+                                    const double *pc, const double *pd)
+{
+double ab[4], bc[4], cd[4], da[4], ac[4], bd[4];
+double temp8[8], abc[12], bcd[12], cda[12], dab[12];
+double adet[24], bdet[24], cdet[24], ddet[24];
+double abdet[48], cddet[48], det[96];
+int ablen, bclen, cdlen, dalen, aclen, bdlen;
+int templen, abclen, bcdlen, cdalen, dablen;
+int alen, blen, clen, dlen, ablen2, cdlen2, detlen;
+
+  ablen = fb_two_by_two(pa[0],pa[1],pb[0],pb[1],ab);
+  bclen = fb_two_by_two(pb[0],pb[1],pc[0],pc[1],bc);
+  cdlen = fb_two_by_two(pc[0],pc[1],pd[0],pd[1],cd);
+  dalen = fb_two_by_two(pd[0],pd[1],pa[0],pa[1],da);
+  aclen = fb_two_by_two(pa[0],pa[1],pc[0],pc[1],ac);
+  bdlen = fb_two_by_two(pb[0],pb[1],pd[0],pd[1],bd);
+
+  //  The 3x3 minors of the x and y columns.
+  templen = fb_expansion_sum(cdlen,cd,dalen,da,temp8);
+  cdalen = fb_expansion_sum(templen,temp8,aclen,ac,cda);
+  templen = fb_expansion_sum(dalen,da,ablen,ab,temp8);
+  dablen = fb_expansion_sum(templen,temp8,bdlen,bd,dab);
+  fb_negate(bdlen,bd);
+  fb_negate(aclen,ac);
+  templen = fb_expansion_sum(ablen,ab,bclen,bc,temp8);
+  abclen = fb_expansion_sum(templen,temp8,aclen,ac,abc);
+  templen = fb_expansion_sum(bclen,bc,cdlen,cd,temp8);
+  bcdlen = fb_expansion_sum(templen,temp8,bdlen,bd,bcd);
+
+  alen = fb_scale_expansion(bcdlen,bcd,pa[2],adet);
+  blen = fb_scale_expansion(cdalen,cda,-pb[2],bdet);
+  clen = fb_scale_expansion(dablen,dab,pc[2],cdet);
+  dlen = fb_scale_expansion(abclen,abc,-pd[2],ddet);
+
+  ablen2 = fb_expansion_sum(alen,adet,blen,bdet,abdet);
+  cdlen2 = fb_expansion_sum(clen,cdet,dlen,ddet,cddet);
+  detlen = fb_expansion_sum(ablen2,abdet,cdlen2,cddet,det);
+
+  return det[detlen-1];
+}
@@ -0,0 +1,69 @@
+/*
+ *
+ *
+ * Copyright (C) 2004 Sandia Corporation.  Under the terms of Contract DE-AC04-94AL85000
+ * with Sandia Corporation, the U.S. Government retains certain rights in this software.
+ *
+ * This file is part of facetbool--contact via cubit@sandia.gov
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ *
+ */
+
+#ifndef _FBPREDICATES
+#define _FBPREDICATES
+
+//===========================================================================
+//  Orientation predicates whose signs are exact.  Each one is first 
+//  evaluated in floating point and the result is returned if it is larger
+//  than the rounding error bound of the evaluation.  Only when it is not
+//  is the determinant evaluated again with exact (expansion) arithmetic,
+//  so the cost is that of the floating-point formula except very near zero.
+//  After J. R. Shewchuk, "Adaptive Precision Floating-Point Arithmetic and
+//  Fast Robust Geometric Predicates", 1997.
+//===========================================================================
+class FBPredicates {
+
+public:
+
+//===========================================================================
+//  Arguments:
+//  pa, pb, pc (INPUT) the x and y coordinates of three points
+//  Return Value:  positive if pa, pb, pc are in counterclockwise order,
+//  negative if clockwise, and zero if they are collinear
+//===========================================================================
+static double orient2d(const double *pa, const double *pb, const double *pc);
+
+//===========================================================================
+//  Arguments:
+//  pa, pb, pc, pd (INPUT) the x, y and z coordinates of four points
+//  Return Value:  positive if pd lies below the plane through pa, pb, pc,
+//  where below means pa, pb, pc appear counterclockwise seen from above;
+//  negative if pd lies above the plane, and zero if the points are coplanar
+//===========================================================================
+static double orient3d(const double *pa, const double *pb, const double *pc,
+                       const double *pd);
+
+private:
+
+static double orient2d_exact(const double *pa, const double *pb, 
+                             const double *pc);
+static double orient3d_exact(const double *pa, const double *pb, 
+                             const double *pc, const double *pd);
+};
+
+#endif
@@ -32,6 +32,7 @@
 #include <algorithm>
 #include "FBRetriangulate.hpp"
 #include "FBTiler.hpp"
+#include "FBPredicates.hpp"
 #include "CubitMessage.hpp"
 
 #ifdef KEEP_BOYD10_KEEP
@@ -48,11 +49,13 @@ bool edgecf_less(const FB_Edge* efirst, const FB_Edge* esecond)
     
 FBRetriangulate::FBRetriangulate(std::vector<FB_Coord *>& my_verts,
                                  std::vector<FB_Triangle *>& my_tris,
+                                 std::vector<FB_Triangle *>& my_newtris,
                                  std::vector<int>& my_newfacets,
                                  std::vector<int>& my_newfacetsindex)
+  : verts(my_verts)
 {
-  verts = my_verts;
   tris = &my_tris;
+  newtris = &my_newtris;
   newfacets = &my_newfacets;
   newfacetsindex = &my_newfacetsindex;
   p_dir=0;
@@ -61,10 +64,12 @@ FBRetriangulate::FBRetriangulate(std::vector<FB_Coord *>& my_verts,
     
 FBRetriangulate::FBRetriangulate(std::vector<FB_Coord *>& my_verts,
                                  std::vector<FB_Triangle *>& my_tris,
+                                 std::vector<FB_Triangle *>& my_newtris,
                                  std::vector<int>& my_newfacets)
+  : verts(my_verts)
 {
-  verts = my_verts;
   tris = &my_tris;
+  newtris = &my_newtris;
   newfacets = &my_newfacets;
   newfacetsindex = 0;
   p_dir=0;
@@ -211,7 +216,7 @@ CubitStatus FBRetriangulate::retriangulate_this_tri(int sequence)
       new_tri = new FB_Triangle(*itp,*(itp+1),*(itp+2),
                                 sequence,my_tri->cubitsurfaceindex,
                                 e0index, e1index, e2index);
-      tris->push_back(new_tri);                         
+      newtris->push_back(new_tri);                         
       itp += 3;   
     }
     if ( newfacetsindex ) newfacetsindex->push_back(nfsize);
@@ -595,32 +600,26 @@ void FBRetriangulate::add_edge_down(int v0, int seq)
   
 bool FBRetriangulate::test_for_crossing(int v0, int v1, int v2, int v3)
 {
-  double x0, y0, x1, y1, x2, y2, x3, y3, dxa, dya, dxb, dyb, p01x, p01y;
-  double product, dasq, dbsq, prodsq;
-  double s, t;
-
-  x0 = verts[v0]->coord[p_dir]; y0 = verts[v0]->coord[s_dir];
-  x1 = verts[v1]->coord[p_dir]; y1 = verts[v1]->coord[s_dir];
-  x2 = verts[v2]->coord[p_dir]; y2 = verts[v2]->coord[s_dir];
-  x3 = verts[v3]->coord[p_dir]; y3 = verts[v3]->coord[s_dir];
-  dxa = x1 - x0; dya = y1 - y0;
-  dxb = x3 - x2; dyb = y3 - y2;
-  
-  product = dxa*dyb - dya*dxb;
-  dasq = dxa*dxa + dya*dya;
-  dbsq = dxb*dxb + dyb*dyb;
-  prodsq = product*product;
-  
-  if ( prodsq > EPSILON2*dasq*dbsq ) {
-    p01x = x2 - x0;
-    p01y = y2 - y0;
-    s = (p01x*dyb - p01y*dxb)/product;
-    if ( (s < 0.0) || (s > 1.0) ) return false; 
-  
-    t = (p01x*dya - p01y*dxa)/product;
-    if ( (t < 0.0) || (t > 1.0) ) return false; 
-    
-  }
+  double p0[2], p1[2], p2[2], p3[2];
+  double o0, o1, o2, o3;
+
+  p0[0] = verts[v0]->coord[p_dir]; p0[1] = verts[v0]->coord[s_dir];
+  p1[0] = verts[v1]->coord[p_dir]; p1[1] = verts[v1]->coord[s_dir];
+  p2[0] = verts[v2]->coord[p_dir]; p2[1] = verts[v2]->coord[s_dir];
+  p3[0] = verts[v3]->coord[p_dir]; p3[1] = verts[v3]->coord[s_dir];
+
+  //  The segments v0-v1 and v2-v3 cross, or touch, if neither one has
+  //  both endpoints of the other strictly on one side of it.  The 
+  //  orientation signs are exact, so nearly parallel segments need no
+  //  special treatment.  Collinear segments are taken to cross.
+  o0 = FBPredicates::orient2d(p0,p1,p2);
+  o1 = FBPredicates::orient2d(p0,p1,p3);
+  if ( ( (o0 > 0.0) && (o1 > 0.0) ) || ( (o0 < 0.0) && (o1 < 0.0) ) )
+    return false;
+  o2 = FBPredicates::orient2d(p2,p3,p0);
+  o3 = FBPredicates::orient2d(p2,p3,p1);
+  if ( ( (o2 > 0.0) && (o3 > 0.0) ) || ( (o2 < 0.0) && (o3 < 0.0) ) )
+    return false;
   
   return true;
 }
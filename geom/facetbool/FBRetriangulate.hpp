@@ -37,19 +37,22 @@ class FBRetriangulate {
 public:
   FBRetriangulate(std::vector<FB_Coord *>& my_verts,
                   std::vector<FB_Triangle *>& my_tris,
+                  std::vector<FB_Triangle *>& my_newtris,
                   std::vector<int>& my_newfacets,
                   std::vector<int>& my_newfacetsindex);
 
   FBRetriangulate(std::vector<FB_Coord *>& my_verts,
                   std::vector<FB_Triangle *>& my_tris,
+                  std::vector<FB_Triangle *>& my_newtris,
                   std::vector<int>& my_newfacets);
 
   ~FBRetriangulate();
   CubitStatus retriangulate_this_tri(int sequence);
   
 private:
-  std::vector<FB_Coord *> verts;
+  std::vector<FB_Coord *>& verts;
   std::vector<FB_Triangle *> *tris;
+  std::vector<FB_Triangle *> *newtris;
   std::vector<int> *newfacets;
   std::vector<int> *newfacetsindex;  
   int p_dir, s_dir;
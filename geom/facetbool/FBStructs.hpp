@@ -34,12 +34,12 @@
 class FSBoundingBox {
 public:
   FSBoundingBox() { }
-  FSBoundingBox(float xmi, float ymi, float zmi, float xma, float yma, float zma)
+  FSBoundingBox(double xmi, double ymi, double zmi, double xma, double yma, double zma)
   {
     xmin = xmi; xmax = xma; ymin = ymi; ymax = yma; zmin = zmi; zmax = zma;
   }
   ~FSBoundingBox() { }
-  float  xmin, xmax, ymin, ymax, zmin, zmax;
+  double xmin, xmax, ymin, ymax, zmin, zmax;
 };
 
 typedef std::vector<FSBoundingBox* > FSBOXVECTOR;
@@ -33,9 +33,9 @@
 FBTiler::FBTiler(std::vector<FB_Coord *>& my_verts, int pd, int sd, int sequence,
                  double a, double b, double c,
                  std::vector<int> *tri_list)
+  : verts(my_verts)
 {
 
-  verts = my_verts;
   p_dir = pd;
   s_dir = sd;
   xnorm = a;
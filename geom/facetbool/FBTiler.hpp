@@ -60,7 +60,7 @@ private:
   int s_dir;
   int parent;
   double xnorm, ynorm, znorm;
-  std::vector<FB_Coord *> verts;
+  std::vector<FB_Coord *>& verts;
   std::vector<int> *my_tri_list;  
   int add_triangle(int v1, int v2, int v3);
 //  bool reflex_angle(int v0, int v1, int v2, int v1chain);
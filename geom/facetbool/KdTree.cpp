@@ -25,264 +25,459 @@
  */
 
 #include "KdTree.hpp"
-#include <stack>
 #include <vector>
+#include <algorithm>
+#include <functional>
 #include <math.h>
+#include <float.h>
+#include "CubitDefines.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define KD_USE_SSE
+#include <xmmintrin.h>
+#endif
 
 const int XCUT = 0;
 const int YCUT = 1;
 const int ZCUT = 2;
 
+//  Nodes with this many boxes or fewer are leaves.
+const int KD_LEAF_SIZE = 4;
+//  Number of bins for the surface area heuristic.
+const int KD_NUM_BINS = 16;
+//  The tree is kept shallow enough for the traversal's fixed stack.
+const int KD_MAX_DEPTH = 60;
+const int KD_STACK_SIZE = 64;
+
+//  Returns n boxes aligned to 32 bytes within a new buffer.
+static KDTreeBox *kd_aligned_boxes(int n, char *&buffer)
+{
+size_t address;
+
+  buffer = new char[n*sizeof(KDTreeBox) + 32];
+  address = ((size_t)buffer + 31) & ~(size_t)31;
+  return (KDTreeBox *)address;
+}
+
+//  Floats no larger and no smaller than x.
+static inline float kd_round_down(double x)
+{
+  float f = (float)x;
+  if ( f > x ) f = (float)(x - fabs(x)*FLT_EPSILON);
+  return f;
+}
+
+static inline float kd_round_up(double x)
+{
+  float f = (float)x;
+  if ( f < x ) f = (float)(x + fabs(x)*FLT_EPSILON);
+  return f;
+}
+
+//  An empty box, to be grown by the ones below.  While binning, count is
+//  the number of boxes in the bin.
+static inline void kd_empty_box(KDTreeBox& box)
+{
+  box.lo[0] = box.lo[1] = box.lo[2] = FLT_MAX;
+  box.hi[0] = box.hi[1] = box.hi[2] = -FLT_MAX;
+  box.ref = box.count = 0;
+}
+
+//  The box is rounded outward to floats, so that it holds every point of
+//  the unrounded one.
+static inline void kd_add_box(KDTreeBox& box, const FSBoundingBox *thisbox)
+{
+float lo[3], hi[3];
+int i;
+
+  lo[0] = kd_round_down(thisbox->xmin); hi[0] = kd_round_up(thisbox->xmax);
+  lo[1] = kd_round_down(thisbox->ymin); hi[1] = kd_round_up(thisbox->ymax);
+  lo[2] = kd_round_down(thisbox->zmin); hi[2] = kd_round_up(thisbox->zmax);
+  for ( i = 0; i < 3; i++ ) {
+    if ( lo[i] < box.lo[i] ) box.lo[i] = lo[i];
+    if ( hi[i] > box.hi[i] ) box.hi[i] = hi[i];
+  }
+}
+
+static inline void kd_merge_box(KDTreeBox& box, const KDTreeBox& other)
+{
+int i;
+
+  for ( i = 0; i < 3; i++ ) {
+    if ( other.lo[i] < box.lo[i] ) box.lo[i] = other.lo[i];
+    if ( other.hi[i] > box.hi[i] ) box.hi[i] = other.hi[i];
+  }
+  box.count += other.count;
+}
+
+static inline double kd_half_area(const KDTreeBox& box)
+{
+double dx, dy, dz;
+
+  dx = box.hi[0] - box.lo[0]; 
+  dy = box.hi[1] - box.lo[1]; 
+  dz = box.hi[2] - box.lo[2];
+  return dx*dy + dy*dz + dz*dx;
+}
+
+static inline float kd_center(const KDTreeBox& box, int dir)
+{
+  return 0.5f*(box.lo[dir] + box.hi[dir]);
+}
+
+static inline int kd_bin(const KDTreeBox& box, int dir, float cmin, float scale,
+                         int numbins)
+{
+  int bin = (int)((kd_center(box,dir) - cmin)*scale);
+  if ( bin >= numbins ) bin = numbins - 1;
+  else if ( bin < 0 ) bin = 0;
+  return bin;
+}
+
+//  The query box, padded and rounded outward to floats, so that every box 
+//  within the padding of the unrounded one is found.
+static void kd_query_box(const FSBoundingBox& bbox, double pad, float *lo, float *hi)
+{
+double dmin[3], dmax[3];
+int i;
+
+  dmin[0] = bbox.xmin - pad; dmax[0] = bbox.xmax + pad;
+  dmin[1] = bbox.ymin - pad; dmax[1] = bbox.ymax + pad;
+  dmin[2] = bbox.zmin - pad; dmax[2] = bbox.zmax + pad;
+  for ( i = 0; i < 3; i++ ) {
+    lo[i] = kd_round_down(dmin[i]);
+    hi[i] = kd_round_up(dmax[i]);
+  }
+}
+
+#ifdef KD_USE_SSE
+static inline bool kd_boxes_overlap(__m128 qlo, __m128 qhi, const KDTreeBox& box)
+{
+  __m128 blo = _mm_load_ps(box.lo);
+  __m128 bhi = _mm_load_ps(box.hi);
+  //  The fourth lanes hold the ints and are ignored.
+  int outside = _mm_movemask_ps(_mm_or_ps(_mm_cmplt_ps(qhi,blo),
+                                          _mm_cmpgt_ps(qlo,bhi)));
+  return (outside & 7) == 0;
+}
+#else
+static inline bool kd_boxes_overlap(const float *qlo, const float *qhi, 
+                                    const KDTreeBox& box)
+{
+  return !( (qhi[0] < box.lo[0]) || (qlo[0] > box.hi[0]) ||
+            (qhi[1] < box.lo[1]) || (qlo[1] > box.hi[1]) ||
+            (qhi[2] < box.lo[2]) || (qlo[2] > box.hi[2]) );
+}
+#endif
+
 KDTree::KDTree()
 {
   epsilonkd = 1.e-6;
+  numtris = numnodes = 0;
+  nodes = leafboxes = 0;
+  nodebuffer = leafbuffer = 0;
 }
 
 KDTree::~KDTree()
 {
-int i;
-FSBoundingBox* fsbb;
- for ( i = 0; i < 2*numtris-1; i++ ) {
-    fsbb = treebox[i];
-    delete fsbb;
-  }
-  delete [] treebox;
-  delete [] nextbranch; 
+  delete [] nodebuffer;
+  delete [] leafbuffer; 
 }
 
 int KDTree::makeKDTree(int npoly, const FSBOXVECTOR& boxlist)
 {
-double *xcenterdata, *ycenterdata, *zcenterdata, *whichcut[3], *cutarray; 
-int i, cuttingdir, min_tri_sequence_value, max_tri_sequence_value, 
-    median_value;
-double xcen, ycen, zcen;
-std::vector<TreeStack* > mytreestack;
-int icnt;
-TreeStack *thistreestack;
-FSBoundingBox *thisbox;
+int i, min_tri_sequence_value, max_tri_sequence_value, split_value, left;
+std::vector<TreeStack> mytreestack;
 
+  delete [] nodebuffer;
+  delete [] leafbuffer;
+  nodes = leafboxes = 0;
+  nodebuffer = leafbuffer = 0;
   numtris = npoly;
-  boxlistptr = boxlist;
-  isequence = new int[npoly];
-  xcenterdata = new double[npoly];
-  ycenterdata = new double[npoly];
-  zcenterdata = new double[npoly];
-  nextbranch = new int[2*npoly];
-  treebox = new FSBoundingBox*[2*npoly];
+  numnodes = 0;
+  if ( npoly <= 0 ) return 1;
+
+  nodes = kd_aligned_boxes(2*npoly,nodebuffer);
+  leafboxes = kd_aligned_boxes(npoly,leafbuffer);
   
-//  Get the arrays of bounding box center points for x, y, and z.  We will use 
-//  these arrays to find the median values along each direction.
+//  The leaf boxes are sorted in place as the tree is built, each keeping
+//  its triangle's sequence number, so they end up in tree order.
   for ( i = 0; i < npoly; i++ ) {
-    isequence[i] = i;
-    xcen = 0.5*(boxlist[i]->xmin + boxlist[i]->xmax);
-    ycen = 0.5*(boxlist[i]->ymin + boxlist[i]->ymax);
-    zcen = 0.5*(boxlist[i]->zmin + boxlist[i]->zmax);
-    xcenterdata[i] = xcen;
-    ycenterdata[i] = ycen;
-    zcenterdata[i] = zcen;  
+    kd_empty_box(leafboxes[i]);
+    kd_add_box(leafboxes[i],boxlist[i]);
+    leafboxes[i].ref = i;
+    leafboxes[i].count = 0;
   }
-  whichcut[0] = xcenterdata; whichcut[1] = ycenterdata; whichcut[2] = zcenterdata;
   
-  //  Get the bounding box of the root node -- the entire set of bounding boxes.
-  thisbox = getbox(0,npoly-1);
-  icnt = 0;
-  treebox[icnt] = thisbox;
-  nextbranch[icnt] = icnt;
-   
-  max_tri_sequence_value = npoly-1;
-  min_tri_sequence_value = 0;
- 
-  if ( max_tri_sequence_value == 0 ) return 1;  //  Just one triangle in the data set.
-
-  //  Get the cutting direction for the next branch.  
-  cuttingdir = getcuttingdirection(thisbox); 
-     
-  thistreestack = new TreeStack(min_tri_sequence_value,
-	                                   max_tri_sequence_value,
-					   cuttingdir,icnt);
-  icnt++;                                         
-  mytreestack.push_back(thistreestack);
+  //  The root node's box is that of the entire set of boxes.
+  getbox(0,npoly-1,nodes[0]);
+  numnodes = 1;
+  mytreestack.push_back(TreeStack(0,npoly-1,0,0));
     
   while ( mytreestack.size() > 0 ) {
-    TreeStack* thisone = mytreestack[mytreestack.size()-1];
+    TreeStack thisone = mytreestack[mytreestack.size()-1];
     mytreestack.pop_back();
-    cuttingdir = thisone->cuttingdir;
-    min_tri_sequence_value = thisone->min;
-    max_tri_sequence_value = thisone->max;
-
-
-    median_value = (min_tri_sequence_value + max_tri_sequence_value)/2;
-    cutarray = whichcut[cuttingdir];
-    
-    find_the_median(median_value-min_tri_sequence_value,0,
-                    max_tri_sequence_value-min_tri_sequence_value,
-                    cutarray,&isequence[min_tri_sequence_value]);
-    if ( min_tri_sequence_value == median_value ) {  //  This is a leaf.
-//      FSBoundingBox *thisbox = boxlist[isequence[median_value]];
-      thisbox = new FSBoundingBox(
-                             boxlist[isequence[median_value]]->xmin,
-			     boxlist[isequence[median_value]]->ymin, 
-                             boxlist[isequence[median_value]]->zmin,
-			     boxlist[isequence[median_value]]->xmax,
-			     boxlist[isequence[median_value]]->ymax,
-			     boxlist[isequence[median_value]]->zmax);
-
-
-      treebox[icnt] = thisbox;
-      nextbranch[icnt] = -isequence[median_value];
-      nextbranch[thisone->sequence] = icnt;
-      icnt++;
-    } else {
-      thisbox = getbox(min_tri_sequence_value,median_value);
-        nextbranch[thisone->sequence] = icnt;
-      treebox[icnt] = thisbox;
-//      nextbranch[icnt] = 11111;
-      cuttingdir = getcuttingdirection(thisbox);
-
-      thistreestack = new TreeStack(min_tri_sequence_value,
-	                                   median_value,cuttingdir,icnt);
-      icnt++;                                    
-      mytreestack.push_back(thistreestack);
-    } 
-    //  The delete that follows is because we need to delete items that
-    //  were created and placed on mytreestack.  This one comes from the pop()
-    
-    delete thisone;
-    
-    if ( median_value+1 == max_tri_sequence_value ) {  //  This is a leaf.
-//      FSBoundingBox *thisbox = boxlist[isequence[max_tri_sequence_value]];
-      thisbox = new FSBoundingBox(
-                             boxlist[isequence[max_tri_sequence_value]]->xmin,
-			     boxlist[isequence[max_tri_sequence_value]]->ymin, 
-                             boxlist[isequence[max_tri_sequence_value]]->zmin,
-			     boxlist[isequence[max_tri_sequence_value]]->xmax,
-			     boxlist[isequence[max_tri_sequence_value]]->ymax,
-			     boxlist[isequence[max_tri_sequence_value]]->zmax);
-
-
-      treebox[icnt] = thisbox;
-      nextbranch[icnt] = -isequence[max_tri_sequence_value];
-      icnt++;
-    } else {
-      thisbox = getbox(median_value+1,max_tri_sequence_value);
-      treebox[icnt] = thisbox;
-//      nextbranch[icnt] = 22222;
-      cuttingdir = getcuttingdirection(thisbox);
-      thistreestack = new TreeStack(median_value+1,
-	                                   max_tri_sequence_value,
-					   cuttingdir,icnt);
-      icnt++;                                     
-      mytreestack.push_back(thistreestack);    
-    }     
+    min_tri_sequence_value = thisone.min;
+    max_tri_sequence_value = thisone.max;
+    KDTreeBox& node = nodes[thisone.sequence];
+
+    if ( (max_tri_sequence_value - min_tri_sequence_value < KD_LEAF_SIZE) ||
+         (thisone.depth >= KD_MAX_DEPTH) ) {  //  This is a leaf.
+      node.ref = min_tri_sequence_value;
+      node.count = max_tri_sequence_value - min_tri_sequence_value + 1;
+      continue;
+    }
 
+    left = numnodes;
+    numnodes += 2;
+    split_value = getsplit(min_tri_sequence_value,max_tri_sequence_value,
+                           node,nodes[left],nodes[left+1]);
+    node.ref = left;
+    node.count = 0;
+    mytreestack.push_back(TreeStack(split_value,max_tri_sequence_value,
+                                    thisone.depth+1,left+1));
+    mytreestack.push_back(TreeStack(min_tri_sequence_value,split_value-1,
+                                    thisone.depth+1,left));
   } 
- 
-  delete [] isequence;
-  delete [] xcenterdata;
-  delete [] ycenterdata;
-  delete [] zcenterdata;
    
   return 1;
 }
 
-FSBoundingBox* KDTree::getbox(int min, int max)
+void KDTree::getbox(int min, int max, KDTreeBox& box)
 {
-FSBoundingBox *thisbox;
 int i;
-//  Makes a bounding box and sets its size to include all of the boxes in the
-//  sequence of bounding boxes from min to max of index isequence[].  Returns pointer
-//  to this box.
+//  Sets box to include all of the leaf boxes from min to max.
 
-  thisbox = new FSBoundingBox(1.e20,1.e20,1.e20,-1.e20,-1.e20,-1.e20);
-double xmin, ymin, zmin, xmax, ymax, zmax;
+  kd_empty_box(box);
+  for ( i = min; i <= max; i++ ) 
+    kd_merge_box(box,leafboxes[i]);
+  box.count = 0;
+}
+
+int KDTree::getsplit(int min, int max, const KDTreeBox& box,
+                     KDTreeBox& leftbox, KDTreeBox& rightbox)
+{
+int i, j, bin, numbins, dir, best_bin, left_count, numboxes;
+KDTreeBox bins[KD_NUM_BINS], lower[KD_NUM_BINS], upper;
+float cmin, scale;
+double cost, best_cost;
+
+//  Divides the leaf boxes min to max in two, the boxes of the first child 
+//  ahead of those of the second, and returns the sequence number of the 
+//  first box of the second child.  The centers are put into bins along the
+//  node's longest side, and the division between bins with the least 
+//  surface area heuristic cost, the sum of each child's area times its 
+//  number of boxes, is used.  The children's boxes are set too.  Small 
+//  nodes get fewer bins, there being no more divisions to try than boxes.
+
+  numboxes = max - min + 1;
+  numbins = CUBIT_MIN(numboxes,KD_NUM_BINS);
+  dir = getcuttingdirection(box);
+  //  The centers are within the node's box, so bin across it.
+  cmin = box.lo[dir];
+  scale = 0.0;
+  if ( box.hi[dir] > box.lo[dir] ) scale = numbins/(box.hi[dir] - cmin);
+  for ( bin = 0; bin < KD_NUM_BINS; bin++ ) kd_empty_box(bins[bin]);
   
   for ( i = min; i <= max; i++ ) {
-    xmin = boxlistptr[isequence[i]]->xmin;
-    ymin = boxlistptr[isequence[i]]->ymin;
-    zmin = boxlistptr[isequence[i]]->zmin;
-    xmax = boxlistptr[isequence[i]]->xmax;
-    ymax = boxlistptr[isequence[i]]->ymax;
-    zmax = boxlistptr[isequence[i]]->zmax;
-
-    if ( xmin < thisbox->xmin ) thisbox->xmin = xmin;
-    if ( ymin < thisbox->ymin ) thisbox->ymin = ymin;
-    if ( zmin < thisbox->zmin ) thisbox->zmin = zmin;    
-    if ( xmax > thisbox->xmax ) thisbox->xmax = xmax;
-    if ( ymax > thisbox->ymax ) thisbox->ymax = ymax;
-    if ( zmax > thisbox->zmax ) thisbox->zmax = zmax;
-     
+    bin = kd_bin(leafboxes[i],dir,cmin,scale,numbins);
+    kd_merge_box(bins[bin],leafboxes[i]);
+    bins[bin].count++;
   }
 
-  return thisbox;
-}
+  //  Sweep up for the areas of the lower children, then down for the costs.
+  best_bin = -1;
+  best_cost = DBL_MAX;
+  lower[0] = bins[0];
+  for ( bin = 1; bin < numbins; bin++ ) {
+    lower[bin] = lower[bin-1];
+    kd_merge_box(lower[bin],bins[bin]);
+  }
+  kd_empty_box(upper);
+  for ( bin = numbins - 1; bin > 0; bin-- ) {
+    kd_merge_box(upper,bins[bin]);
+    left_count = lower[bin-1].count;
+    if ( (left_count == 0) || (left_count == numboxes) ) continue;
+    cost = kd_half_area(lower[bin-1])*left_count + 
+           kd_half_area(upper)*(numboxes - left_count);
+    if ( cost < best_cost ) {
+      best_cost = cost;
+      best_bin = bin - 1;
+    }
+  }
 
-void KDTree::box_kdtree_intersect(FSBoundingBox& bbox, int *count, int *indexlist) const
-{
-int index, i, child;
-std::stack<int> mystack;
-
-  *count = 0;
-  if ( (bbox.xmax < (treebox[0]->xmin - epsilonkd) ) ||
-       (bbox.xmin > (treebox[0]->xmax + epsilonkd) ) ||
-       (bbox.ymax < (treebox[0]->ymin - epsilonkd) ) ||
-       (bbox.ymin > (treebox[0]->ymax + epsilonkd) ) ||
-       (bbox.zmax < (treebox[0]->zmin - epsilonkd) ) ||
-       (bbox.zmin > (treebox[0]->zmax + epsilonkd) ) )
-    return;
-  //  Gotta put something on the stack, so do the root node 
-  //  evaluation here.
-  if ( nextbranch[0] <= 0 ) {
-    indexlist[*count] = -nextbranch[0]; *count += 1;
-    return;
+  if ( best_bin == -1 ) {
+    //  The centers all fall in one bin; split at the median.
+    j = (min + max)/2;
+    find_the_median(j,min,max,dir);
+    getbox(min,j,leftbox);
+    getbox(j+1,max,rightbox);
+    return j + 1;
   }
-  mystack.push(0);
 
-  while ( mystack.size() > 0 ) {
-    index = mystack.top();
-    mystack.pop();
-    child = nextbranch[index];
-    
-    for ( i = 0; i < 2; i++ ) {
-      if ( (bbox.xmax < (treebox[child+i]->xmin - epsilonkd) ) ||
-           (bbox.xmin > (treebox[child+i]->xmax + epsilonkd) ) ||
-           (bbox.ymax < (treebox[child+i]->ymin - epsilonkd) ) ||
-           (bbox.ymin > (treebox[child+i]->ymax + epsilonkd) ) ||
-           (bbox.zmax < (treebox[child+i]->zmin - epsilonkd) ) ||
-           (bbox.zmin > (treebox[child+i]->zmax + epsilonkd) ) )
-      continue;
-      if ( nextbranch[child+i] <= 0 ) {        
-		indexlist[*count] = -nextbranch[child+i]; *count += 1;	
-      } else {            
-        mystack.push(child+i);   
-      }  
+  kd_empty_box(leftbox);
+  kd_empty_box(rightbox);
+  for ( bin = 0; bin < numbins; bin++ ) {
+    if ( bin <= best_bin ) kd_merge_box(leftbox,bins[bin]);
+    else kd_merge_box(rightbox,bins[bin]);
+  }
+  leftbox.count = rightbox.count = 0;
+  
+  i = min;
+  j = max;
+  while ( i <= j ) {
+    bin = kd_bin(leafboxes[i],dir,cmin,scale,numbins);
+    if ( bin <= best_bin ) i++;
+    else {
+      SWAP(leafboxes[i],leafboxes[j]);
+      j--;
+    }
+  }
+  return i;
+}
+
+void KDTree::box_kdtree_intersect(const FSBoundingBox& bbox, 
+                                  std::vector<int>& indexlist) const
+{
+int stack[KD_STACK_SIZE], top, i;
+float qlo[4], qhi[4];
+
+  indexlist.clear();
+  if ( numnodes == 0 ) return;
+
+  kd_query_box(bbox,epsilonkd,qlo,qhi);
+  qlo[3] = qhi[3] = 0.0;
+#ifdef KD_USE_SSE
+  __m128 query_lo = _mm_loadu_ps(qlo);
+  __m128 query_hi = _mm_loadu_ps(qhi);
+#else
+  const float *query_lo = qlo, *query_hi = qhi;
+#endif
+
+  top = 0;
+  stack[top++] = 0;
+  while ( top > 0 ) {
+    const KDTreeBox& node = nodes[stack[--top]];
+    if ( kd_boxes_overlap(query_lo,query_hi,node) == false ) continue;
+    if ( node.count > 0 ) {
+      for ( i = node.ref; i < node.ref + node.count; i++ ) {
+        if ( kd_boxes_overlap(query_lo,query_hi,leafboxes[i]) ) 
+          indexlist.push_back(leafboxes[i].ref);
+      }
+    } else {
+      stack[top++] = node.ref + 1;
+      stack[top++] = node.ref;
     }
   }  
-  return;
 }
 
+void KDTree::ray_kdtree_intersect(const double *start, const double *dir,
+                                  std::vector<int>& indexlist) const
+{
+int stack[KD_STACK_SIZE], top, i;
+double entry;
+
+  indexlist.clear();
+  if ( numnodes == 0 ) return;
+
+  top = 0;
+  stack[top++] = 0;
+  while ( top > 0 ) {
+    const KDTreeBox& node = nodes[stack[--top]];
+    if ( rayintersectsbox(node,start,dir,entry) == false ) continue;
+    if ( node.count > 0 ) {
+      for ( i = node.ref; i < node.ref + node.count; i++ ) {
+        if ( rayintersectsbox(leafboxes[i],start,dir,entry) ) 
+          indexlist.push_back(leafboxes[i].ref);
+      }
+    } else {
+      stack[top++] = node.ref + 1;
+      stack[top++] = node.ref;
+    }
+  }
+}
+
+void KDTree::ray_kdtree_first(const double *start, const double *dir,
+                              KDTreeRay& ray) const
+{
+double entry;
+int i;
 
-void KDTree::find_the_median(int k, int l, int r, double *array, int *ia)
+  for ( i = 0; i < 3; i++ ) {
+    ray.start[i] = start[i];
+    ray.dir[i] = dir[i];
+  }
+  ray.queue.clear();
+  if ( numnodes == 0 ) return;
+  if ( rayintersectsbox(nodes[0],start,dir,entry) )
+    ray.queue.push_back(std::make_pair(entry,0));
+}
+
+int KDTree::ray_kdtree_next(KDTreeRay& ray, double limit, double& entry) const
 {
-int i, j;
+std::greater<std::pair<double,int> > nearer;
 double t;
+int i;
+
+//  Leaf boxes are queued as -1 - their index, and are returned when they
+//  come to the front.  A node's children or leaf boxes are queued when it
+//  does, so each box is returned only after every box the ray enters
+//  before it.  Ties are broken by the queued number, so the order depends
+//  only on the tree and the ray.
+
+  while ( (ray.queue.empty() == false) && (ray.queue.front().first <= limit) ) {
+    std::pair<double,int> next = ray.queue.front();
+    std::pop_heap(ray.queue.begin(),ray.queue.end(),nearer);
+    ray.queue.pop_back();
+    if ( next.second < 0 ) {
+      entry = next.first;
+      return leafboxes[-1 - next.second].ref;
+    }
+    const KDTreeBox& node = nodes[next.second];
+    if ( node.count > 0 ) {
+      for ( i = node.ref; i < node.ref + node.count; i++ ) {
+        if ( rayintersectsbox(leafboxes[i],ray.start,ray.dir,t) ) {
+          ray.queue.push_back(std::make_pair(t,-1 - i));
+          std::push_heap(ray.queue.begin(),ray.queue.end(),nearer);
+        }
+      }
+    } else {
+      for ( i = node.ref; i < node.ref + 2; i++ ) {
+        if ( rayintersectsbox(nodes[i],ray.start,ray.dir,t) ) {
+          ray.queue.push_back(std::make_pair(t,i));
+          std::push_heap(ray.queue.begin(),ray.queue.end(),nearer);
+        }
+      }
+    }
+  }
+  return -1;
+}
+
+void KDTree::find_the_median(int k, int l, int r, int dir)
+{
+int i, j;
+float t;
+
+//  Puts the leaf box with the k'th center along dir at k, those with smaller
+//  centers before it and those with larger ones after it.
 
   while ( r > l ) {
-    t = array[ia[k]];
+    t = kd_center(leafboxes[k],dir);
     i = l;
     j = r;
 
-    SWAP(ia[l],ia[k]);
-    if ( array[ia[r]] > t ) SWAP(ia[l],ia[r]);
+    SWAP(leafboxes[l],leafboxes[k]);
+    if ( kd_center(leafboxes[r],dir) > t ) SWAP(leafboxes[l],leafboxes[r]);
     while ( i < j ) {
-      SWAP(ia[i],ia[j]);
+      SWAP(leafboxes[i],leafboxes[j]);
       i += 1; j -= 1;
-      while ( array[ia[i]] < t ) i++;
-      while ( array[ia[j]] > t ) j--;
+      while ( kd_center(leafboxes[i],dir) < t ) i++;
+      while ( kd_center(leafboxes[j],dir) > t ) j--;
     }
-    if ( array[ia[l]] == t ) SWAP(ia[l],ia[j]);
+    if ( kd_center(leafboxes[l],dir) == t ) SWAP(leafboxes[l],leafboxes[j]);
     else {
       j += 1;
-      SWAP(ia[r],ia[j]);
+      SWAP(leafboxes[r],leafboxes[j]);
     }
     if ( j <= k ) l = j + 1;
     if ( k <= j ) r = j - 1;
@@ -290,13 +485,13 @@ double t;
 
 }
 
-int KDTree::getcuttingdirection(FSBoundingBox* box)
+int KDTree::getcuttingdirection(const KDTreeBox& box)
 {
 double xlen, ylen, zlen;
 
-  xlen = box->xmax - box->xmin;
-  ylen = box->ymax - box->ymin;
-  zlen = box->zmax - box->zmin;
+  xlen = box.hi[0] - box.lo[0];
+  ylen = box.hi[1] - box.lo[1];
+  zlen = box.hi[2] - box.lo[2];
   
   if ( (xlen >= ylen) && (xlen >= zlen) ) return XCUT; 
   else if ( ylen >= zlen ) return YCUT;
@@ -304,43 +499,42 @@ double xlen, ylen, zlen;
 }
 
 
-bool KDTree::rayintersectsbox(FSBoundingBox *box)
+bool KDTree::rayintersectsbox(const KDTreeBox& box, const double *start,
+                              const double *dir, double& entry) const
 {
-double pmin, pmax, tmin, tmax;
-double dtemp;
+double boxmin[3], boxmax[3], pmin, pmax, tmin, tmax, dtemp;
+int i;
 
-//  Get the parametric distance along each direction from the min point to
-//  the min and max box planes.  If the min dist is grater than the max
+//  Get the parametric distance along each direction from the start point
+//  to the min and max box planes.  If the min dist is greater than the max
 //  dist, we have to swap them.  Keep a running total of the max min and the
-//  min max.  The ray intersects the box iff tmin <= tmax and tmax >= 0.0.
-//  Otherwise, the ray misses the box or points away from the box (with the
-//  starting point outside).
-
-  tmin = (box->xmin - rayxstart)/dx;
-  tmax = (box->xmax - rayxstart)/dx;
-  if ( tmin > tmax ) {
-  dtemp = tmin; tmin = tmax; tmax = dtemp;
-  }
-  pmin = (box->ymin - rayystart)/dy;
-  pmax = (box->ymax - rayystart)/dy;
-  if ( pmin > pmax ) {
-  dtemp = pmin; pmin = pmax; pmax = dtemp;
+//  min max.  The ray intersects the box iff tmin <= tmax, where tmin starts
+//  at 0 so boxes behind the start point are missed.  A ray parallel to a
+//  pair of planes hits only if it starts between them.  entry is set to
+//  tmin, the distance at which the ray enters the box.
+
+  for ( i = 0; i < 3; i++ ) {
+    boxmin[i] = box.lo[i] - epsilonkd; 
+    boxmax[i] = box.hi[i] + epsilonkd;
   }
-  tmin = MAXX(pmin,tmin);
-  tmax = MINN(pmax,tmax);
 
-  if ( tmin > tmax ) return false;
-  
-  pmin = (box->zmin - rayzstart)/dz;
-  pmax = (box->zmax - rayzstart)/dz;
-  if ( pmin > pmax ) {
-  dtemp = pmin; pmin = pmax; pmax = dtemp;
+  tmin = 0.0;
+  tmax = 1.e30;
+  for ( i = 0; i < 3; i++ ) {
+    if ( dir[i] == 0.0 ) {
+      if ( (start[i] < boxmin[i]) || (start[i] > boxmax[i]) ) return false;
+      continue;
+    }
+    pmin = (boxmin[i] - start[i])/dir[i];
+    pmax = (boxmax[i] - start[i])/dir[i];
+    if ( pmin > pmax ) {
+      dtemp = pmin; pmin = pmax; pmax = dtemp;
+    }
+    tmin = MAXX(pmin,tmin);
+    tmax = MINN(pmax,tmax);
+    if ( tmin > tmax ) return false;
   }
-  tmin = MAXX(pmin,tmin);
-  tmax = MINN(pmax,tmax);
-  
-  if ( (tmax < 0.0) || (tmin > tmax) ) return false;
-  
+
+  entry = tmin;
   return true;
 }
-  
@@ -27,6 +27,7 @@
 #ifndef _KDTREE
 #define _KDTREE
 #include <vector>
+#include <utility>
 
 #include "FBStructs.hpp"
 
@@ -34,16 +35,40 @@ class TreeStack {
 
 public:
 
-  TreeStack(int imin, int imax, int cut_dir, int iseq) {
-   cuttingdir = cut_dir;
+  TreeStack(int imin, int imax, int idepth, int iseq) {
     min = imin;
     max = imax;
+    depth = idepth;
     sequence = iseq;
   }
   
   ~TreeStack() { }
   
-  int min, max, cuttingdir, sequence;
+  int min, max, depth, sequence;
+};
+
+//  A tree node or a leaf's triangle box.  The layout is two 16-byte halves,
+//  each three coordinates and an int, and the arrays of them are 32-byte
+//  aligned so that each half can be loaded as one SIMD vector.
+class KDTreeBox {
+
+public:
+  float lo[3];
+  int ref;    //  node: index of the first of its two children, or of its 
+              //  first leaf box.  leaf box: the triangle's sequence number.
+  float hi[3];
+  int count;  //  node: the number of leaf boxes, or 0 if it has children.
+};
+
+//  The state of a walk along a ray through the boxes nearest first, for
+//  ray_kdtree_first and ray_kdtree_next.  The queue holds the distance
+//  along the ray to each box waiting to be looked at, and the node, or
+//  -1 - the leaf box, as a heap with the nearest first.
+class KDTreeRay {
+
+public:
+  double start[3], dir[3];
+  std::vector<std::pair<double,int> > queue;
 };
 
 class KDTree
@@ -53,35 +78,51 @@ public:
 
   KDTree();
   ~KDTree();
-  void box_kdtree_intersect(FSBoundingBox& bbox, int *count, int *indexlist) const;
+  void box_kdtree_intersect(const FSBoundingBox& bbox, 
+                            std::vector<int>& indexlist) const;
+    // Finds the boxes that overlap bbox.  indexlist is cleared first; 
+    // callers should keep it between searches so that it seldom grows.
+  void ray_kdtree_intersect(const double *start, const double *dir,
+                            std::vector<int>& indexlist) const;
+    // Finds the boxes that the ray from start along dir passes through.
+    // dir need not be normalized but must not be zero.
+  void ray_kdtree_first(const double *start, const double *dir,
+                        KDTreeRay& ray) const;
+  int ray_kdtree_next(KDTreeRay& ray, double limit, double& entry) const;
+    // Walks the boxes that the ray passes through in the order it enters
+    // them.  ray_kdtree_next returns the next box's sequence number and
+    // sets entry to the distance along dir at which the ray enters it, or
+    // returns -1 when none is left within limit.  Boxes and nodes entered
+    // beyond limit are not looked at, so a caller that lowers limit to
+    // its nearest hit so far stops as soon as no nearer hit is possible.
+    // Callers should keep ray between walks so that it seldom grows.
   int makeKDTree(int npoly, const FSBOXVECTOR& boxlist);
 
 private:
 
   double epsilonkd;
-  int numtris;
-  FSBoundingBox* *treebox; 
-  int *nextbranch;
-  FSBOXVECTOR boxlistptr;
-//  std::vector<FSBoundingBox* > boxlist;
-  int *isequence;
-  FSBoundingBox* getbox(int min, int max);
-  void find_the_median(int k, int l, int r, double *array, int *ia);
-  int getcuttingdirection(FSBoundingBox* box);
-  inline void SWAP(int &x, int &y)
+  int numtris, numnodes;
+  KDTreeBox *nodes, *leafboxes;  // nodes[0] is the root
+  char *nodebuffer, *leafbuffer;
+  void getbox(int min, int max, KDTreeBox& box);
+  int getsplit(int min, int max, const KDTreeBox& box,
+               KDTreeBox& leftbox, KDTreeBox& rightbox);
+  void find_the_median(int k, int l, int r, int dir);
+  int getcuttingdirection(const KDTreeBox& box);
+  inline void SWAP(KDTreeBox &x, KDTreeBox &y)
   {
-  int temp;
+  KDTreeBox temp;
     temp = x;
     x = y;
     y = temp;
   }   
-  double rayxstart, rayystart, rayzstart, dx, dy, dz;
-  bool rayintersectsbox(FSBoundingBox *box);
-  inline double MAXX(double a, double b) {
+  bool rayintersectsbox(const KDTreeBox& box, const double *start,
+                        const double *dir, double& entry) const;
+  inline double MAXX(double a, double b) const {
     if ( a > b ) return a;
     else return b;
   }
-  inline double MINN(double a, double b) {
+  inline double MINN(double a, double b) const {
     if ( a < b ) return a;
     else return b;
   }
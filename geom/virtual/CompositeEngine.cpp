@@ -6,7 +6,7 @@
 #include "DLIList.hpp"
 #include "TDUniqueId.hpp"
 #include "CubitTransformMatrix.hpp"
-#include "RTree.hpp"
+#include "PackedRTree.hpp"
 
 #include "CompositePoint.hpp"
 #include "CompositeCurve.hpp"
@@ -342,8 +342,8 @@ void CompositeEngine::attribute_after_imprinting(DLIList<TopologyBridge*> &tb_li
   double geom_factor = GeometryQueryTool::get_geometry_factor();
   double merge_tol = geom_factor*GEOMETRY_RESABS;
 
-  AbstractTree<TBPoint*> *pt_tree = new RTree<TBPoint*>(merge_tol);
-  AbstractTree<Curve*> *crv_tree = new RTree<Curve*>(merge_tol);
+  AbstractTree<TBPoint*> *pt_tree = new PackedRTree<TBPoint*>(merge_tol);
+  AbstractTree<Curve*> *crv_tree = new PackedRTree<Curve*>(merge_tol);
 
   DLIList<Curve*> all_curves_with_composite_att;
   DLIList<TBPoint*> all_points_with_composite_att;
@@ -365,6 +365,8 @@ void CompositeEngine::attribute_after_imprinting(DLIList<TopologyBridge*> &tb_li
     if(list.size() > 0)
       all_points_with_composite_att.append(cur_point);
   }
+  crv_tree->balance();
+  pt_tree->balance();
 
   DLIList<CubitSimpleAttrib> list;
   while(all_points_with_composite_att.size())
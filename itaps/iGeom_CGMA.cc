@@ -24,6 +24,7 @@
 #include "GMem.hpp"
 #include <iostream>
 #include <math.h>
+#include <algorithm>
 #include "GeometryQueryTool.hpp"
 #include "CubitCompat.hpp"
 
@@ -237,6 +238,9 @@ iGeom_fire_ray( const CubitVector& point,
                 DLIList<RefEntity*>& entities,
                 DLIList<double>& ray_params );
 
+static CubitStatus
+iGeom_ray_targets( DLIList<RefEntity*>& target_entities );
+
 static RefEntity*
 iGeom_get_point_containment( const CubitVector& pt );
 
@@ -3550,25 +3554,11 @@ iGeom_getPntArrRayIntsct( iGeom_Instance instance,
   dy = dx + init;
   dz = dy + init;
   
-  DLIList<RefEntity*> entities, tmp_entities;
-  DLIList<double> params, tmp_params;
-  std::vector<CubitVector> coords;
+  std::vector<CubitVector> origins(count), dirs(count);
   for (int i = 0; i < count; ++i)
   {
-    tmp_entities.clean_out();
-    tmp_params.clean_out();
-    (*offset)[i] = params.size();
-    const CubitVector point(*px, *py, *pz), dir(*dx, *dy, *dz);
-    CubitStatus s = iGeom_fire_ray( point, dir, tmp_entities, tmp_params );
-    if (CUBIT_SUCCESS != s) {
-      RETURN(iBase_FAILURE);
-    }
-
-    entities += tmp_entities;
-    params += tmp_params;
-    tmp_params.reset();
-    for (int j = tmp_params.size(); j > 0; --j) 
-      coords.push_back( tmp_params.get_and_step() * dir + point );
+    origins[i].set( *px, *py, *pz );
+    dirs[i].set( *dx, *dy, *dz );
     
     px += step;
     py += step;
@@ -3578,21 +3568,45 @@ iGeom_getPntArrRayIntsct( iGeom_Instance instance,
     dz += step;
   }
   
-  ALLOC_CHECK_ARRAY_NOFAIL( intersect_entity_handles, entities.size() );
-  ALLOC_CHECK_ARRAY_NOFAIL( intersect_coords, coords.size() );
-  ALLOC_CHECK_ARRAY_NOFAIL( param_coords, params.size() );
-  entities.copy_to( (RefEntity**)*intersect_entity_handles );
-  params.copy_to( *param_coords );
+    // fire all rays as one batch at the free entities
+  DLIList<RefEntity*> target_entities;
+  if (CUBIT_SUCCESS != iGeom_ray_targets( target_entities ))
+    RETURN(iBase_FAILURE);
   
+  std::vector<int> offsets;
+  std::vector<double> params;
+  std::vector<RefEntity*> entities;
+  CubitStatus s = GeometryQueryTool::instance()->
+    fire_rays( origins, dirs, target_entities, offsets, params, 0, 0.0, &entities );
+  if (CUBIT_SUCCESS != s) {
+    RETURN(iBase_FAILURE);
+  }
+  
+  const int num_hits = (int)params.size();
+  ALLOC_CHECK_ARRAY_NOFAIL( intersect_entity_handles, num_hits );
+  ALLOC_CHECK_ARRAY_NOFAIL( intersect_coords, 3*num_hits );
+  ALLOC_CHECK_ARRAY_NOFAIL( param_coords, num_hits );
+  if (num_hits) {
+    std::copy( entities.begin(), entities.end(), (RefEntity**)*intersect_entity_handles );
+    std::copy( params.begin(), params.end(), *param_coords );
+  }
+  std::copy( offsets.begin(), offsets.begin() + count, *offset );
+  
+  if (storage_order == iBase_BLOCKED)
+    init = num_hits;
   double *x = *intersect_coords;
   double *y = x + init;
   double *z = y + init;
-  for (std::vector<CubitVector>::const_iterator k = coords.begin(); k != coords.end(); ++k)
+  for (int i = 0; i < count; ++i)
   {
-    k->get_xyz( *x, *y, *z );
-    x += step;
-    y += step;
-    z += step;
+    for (int j = offsets[i]; j < offsets[i+1]; ++j)
+    {
+      CubitVector pos = params[j] * dirs[i] + origins[i];
+      pos.get_xyz( *x, *y, *z );
+      x += step;
+      y += step;
+      z += step;
+    }
   }
   
   KEEP_ARRAY(offset);
@@ -7012,6 +7026,18 @@ iBase_intersect_ray_box( const CubitBox& box,
 }
 
 
+static CubitStatus
+iGeom_ray_targets( DLIList<RefEntity*>& target_entities )
+{
+    // get all free entities in model
+  CubitStatus s = GeometryQueryTool::instance()->get_free_ref_entities( target_entities );
+  if (CUBIT_SUCCESS != s) return s;
+  DLIList<Body*> bodies;
+  GeometryQueryTool::instance()->bodies( bodies );
+  CAST_LIST_TO_PARENT( bodies, target_entities );
+  return CUBIT_SUCCESS;
+}
+
 static CubitStatus
 iGeom_fire_ray( const CubitVector& point,
                 const CubitVector& direction,
@@ -7022,13 +7048,9 @@ iGeom_fire_ray( const CubitVector& point,
   CubitStatus s;
   CubitVector nc_point(point), nc_direction(direction);
   
-    // get all free entities in model
   DLIList<RefEntity*> target_entities;
-  s = GeometryQueryTool::instance()->get_free_ref_entities( target_entities );
+  s = iGeom_ray_targets( target_entities );
   if (CUBIT_SUCCESS != s) return s;
-  DLIList<Body*> bodies;
-  GeometryQueryTool::instance()->bodies( bodies );
-  CAST_LIST_TO_PARENT( bodies, target_entities );
     
     // do ray fire at list of free entities
   return GeometryQueryTool::instance()->
@@ -2,6 +2,16 @@
 
 #include "TestUtilities.hpp"
 #include "TestConfig.h"
+#include "GeometryQueryTool.hpp"
+#include "FacetModifyEngine.hpp"
+#include "CubitPointData.hpp"
+#include "CubitFacetData.hpp"
+#include "DLIList.hpp"
+#include "Surface.hpp"
+#include "ShellSM.hpp"
+#include "Lump.hpp"
+#include "BodySM.hpp"
+#include "Body.hpp"
 
 std::string data_file(char* filename)
 {
@@ -36,4 +46,46 @@ bool cubit_box_identical(const CubitBox& box1, const CubitBox& box2, double tol,
          box1.minimum().within_tolerance(box2.minimum(), tol);
 }
 
+Body* make_facet_brick(const CubitVector& min_corner, const CubitVector& max_corner,
+    double feature_angle)
+{
+  FacetModifyEngine *fme = FacetModifyEngine::instance();
+  DLIList<CubitFacet*> f_list;
+  DLIList<CubitPoint*> p_list;
 
+  // corners numbered as in facets.cpp
+  CubitPointData* p[8];
+  for(int i=0; i<8; i++)
+  {
+    int ix = ((i & 1) ^ ((i >> 1) & 1)), iy = (i >> 1) & 1, iz = (i >> 2) & 1;
+    p[i] = new CubitPointData(ix ? max_corner.x() : min_corner.x(),
+                              iy ? max_corner.y() : min_corner.y(),
+                              iz ? max_corner.z() : min_corner.z());
+    p_list.append(p[i]);
+  }
+  static const int tris[12][3] = { {0,2,1}, {0,3,2}, {4,5,7}, {5,6,7},
+                                   {0,7,3}, {0,4,7}, {2,6,5}, {2,5,1},
+                                   {0,5,4}, {0,1,5}, {2,3,7}, {2,7,6} };
+  for(int i=0; i<12; i++)
+    f_list.append(new CubitFacetData(p[tris[i][0]], p[tris[i][1]], p[tris[i][2]]));
+
+  DLIList<Surface*> surf_list;
+  if(fme->build_facet_surface(NULL, f_list, p_list, feature_angle, 4,
+                              false, false, surf_list) != CUBIT_SUCCESS ||
+     surf_list.size() == 0)
+    return NULL;
+  ShellSM *shell_ptr = NULL;
+  if(fme->make_facet_shell(surf_list, shell_ptr) != CUBIT_SUCCESS || !shell_ptr)
+    return NULL;
+  DLIList<ShellSM*> shell_list;
+  shell_list.append(shell_ptr);
+  Lump *lump_ptr = NULL;
+  if(fme->make_facet_lump(shell_list, lump_ptr) != CUBIT_SUCCESS || !lump_ptr)
+    return NULL;
+  DLIList<Lump*> lump_list;
+  lump_list.append(lump_ptr);
+  BodySM *bodysm_ptr = NULL;
+  if(fme->make_facet_body(lump_list, bodysm_ptr) != CUBIT_SUCCESS || !bodysm_ptr)
+    return NULL;
+  return GeometryQueryTool::instance()->make_Body(bodysm_ptr);
+}
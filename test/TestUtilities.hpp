@@ -5,6 +5,8 @@
 #include "CubitBox.hpp"
 #include <string>
 
+class Body;
+
 // function to get the path to a data file in the data directory
 std::string data_file(char* filename);
 
@@ -12,6 +14,10 @@ std::string data_file(char* filename);
 bool cubit_box_identical(const CubitBox& box1, const CubitBox& box2, double tol,
     bool print_data = false);
 
+// build a faceted brick body with two triangles per side, one surface
+// per side with the default feature angle
+Body* make_facet_brick(const CubitVector& min_corner, const CubitVector& max_corner,
+    double feature_angle = 135.0);
 
 
 #endif
@@ -0,0 +1,233 @@
+/**
+ * \file compact_facet_mesh.cpp
+ *
+ * \brief Tests of CompactFacetMesh point merging and conversion
+ *
+ * Checks merge_coincident_points against a map of the first point at
+ * each position, and weld_points against GridSearchTree fed the same
+ * points, on both the serial and the parallel (CubitConcurrent) paths.
+ * Also checks that convert_to_facets makes the same facets as
+ * make_facets and leaves the mesh empty.
+ */
+#include "CompactFacetMesh.hpp"
+#include "GridSearchTree.hpp"
+#include "CubitPointData.hpp"
+#include "CubitFacetData.hpp"
+#include "CubitStdConcurrentApi.h"
+#include "DLIList.hpp"
+
+#include <vector>
+#include <map>
+#include <cstdio>
+
+static unsigned int seed = 4711;
+static double next_random()
+{
+  seed = seed * 1103515245u + 12345u;
+  return (double)((seed >> 8) & 0xffff) / 65536.0;
+}
+
+// a triangle soup of num_tris triangles whose vertices are grid points,
+// some repeated exactly and some moved by up to jitter
+static void make_soup(CompactFacetMesh& mesh, int num_tris, double spacing, double jitter)
+{
+  mesh.clear();
+  for(int i=0; i<3*num_tris; i++)
+  {
+    double xyz[3];
+    for(int k=0; k<3; k++)
+      xyz[k] = spacing * (int)(20*next_random());
+    if(next_random() < 0.5)
+      for(int k=0; k<3; k++)
+        xyz[k] += jitter * (next_random() - 0.5);
+    mesh.add_point(xyz[0], xyz[1], xyz[2]);
+  }
+  for(int i=0; i<num_tris; i++)
+    mesh.add_triangle(3*i, 3*i+1, 3*i+2);
+}
+
+// the coordinates of every triangle corner
+static std::vector<double> corner_coords(const CompactFacetMesh& mesh)
+{
+  std::vector<double> result;
+  for(int i=0; i<mesh.num_triangles(); i++)
+    for(int j=0; j<3; j++)
+    {
+      CubitVector p = mesh.point(mesh.triangle(i)[j]);
+      result.push_back(p.x());
+      result.push_back(p.y());
+      result.push_back(p.z());
+    }
+  return result;
+}
+
+int test_merge_coincident(int num_tris)
+{
+  CompactFacetMesh mesh;
+  make_soup(mesh, num_tris, 1.0, 0.1);
+  int num_raw = mesh.num_points();
+
+  // expected: the first point at each position, numbered in order
+  std::map<std::vector<double>, int> first;
+  std::vector<int> expected(num_raw);
+  for(int i=0; i<num_raw; i++)
+  {
+    const double* xyz = mesh.coords() + 3*i;
+    std::vector<double> key(xyz, xyz+3);
+    std::map<std::vector<double>, int>::iterator it = first.find(key);
+    if(it == first.end())
+      it = first.insert(std::make_pair(key, (int)first.size())).first;
+    expected[i] = it->second;
+  }
+
+  int removed = mesh.merge_coincident_points();
+  int errors = 0;
+  if(mesh.num_points() != (int)first.size() || removed != num_raw - (int)first.size())
+  {
+    fprintf(stderr, "merge of %d points kept %d, expected %d\n",
+            num_raw, mesh.num_points(), (int)first.size());
+    errors++;
+  }
+  for(int i=0; i<num_raw && !errors; i++)
+  {
+    if(mesh.connectivity()[i] != expected[i])
+    {
+      fprintf(stderr, "merged point %d is %d, expected %d\n",
+              i, mesh.connectivity()[i], expected[i]);
+      errors++;
+    }
+  }
+  return errors;
+}
+
+int test_weld_against_grid_search(int num_tris, double tolerance)
+{
+  CompactFacetMesh mesh;
+  make_soup(mesh, num_tris, 1.5*tolerance, 1.5*tolerance);
+
+  // every vertex through GridSearchTree, in order
+  GridSearchTree tree(tolerance);
+  std::vector<double> expected;
+  std::vector<CubitPoint*> points;
+  for(int i=0; i<mesh.num_points(); i++)
+  {
+    CubitPoint* pt = new CubitPointData(mesh.point(i));
+    points.push_back(pt);
+    CubitPoint* kept = tree.fix(pt);
+    expected.push_back(kept->x());
+    expected.push_back(kept->y());
+    expected.push_back(kept->z());
+  }
+  for(size_t i=0; i<points.size(); i++)
+    delete points[i];
+
+  mesh.weld_points(tolerance);
+  if(corner_coords(mesh) != expected)
+  {
+    fprintf(stderr, "weld of %d triangles differs from GridSearchTree\n", num_tris);
+    return 1;
+  }
+  return 0;
+}
+
+// a vertex repeated after a nearer point was kept goes to that point, as
+// with GridSearchTree, not to where its earlier copy went
+int test_weld_chain()
+{
+  CompactFacetMesh mesh;
+  mesh.add_point(0.0, 0, 0);
+  mesh.add_point(0.9, 0, 0);   // welded to 0.0
+  mesh.add_point(1.7, 0, 0);   // kept
+  mesh.add_point(0.9, 0, 0);   // nearer to 1.7 than to 0.0
+  mesh.add_triangle(0, 1, 2);
+  mesh.add_triangle(3, 1, 2);
+  mesh.weld_points(1.0);
+
+  const int expected[6] = { 0, 0, 1, 1, 0, 1 };
+  int errors = 0;
+  if(mesh.num_points() != 2)
+  {
+    fprintf(stderr, "chain weld kept %d points, expected 2\n", mesh.num_points());
+    errors++;
+  }
+  for(int i=0; i<6 && !errors; i++)
+  {
+    if(mesh.connectivity()[i] != expected[i])
+    {
+      fprintf(stderr, "chain weld corner %d is point %d, expected %d\n",
+              i, mesh.connectivity()[i], expected[i]);
+      errors++;
+    }
+  }
+  return errors;
+}
+
+int test_convert_to_facets()
+{
+  CompactFacetMesh mesh;
+  make_soup(mesh, 1000, 1.0, 0.0);
+  mesh.merge_coincident_points();
+
+  DLIList<CubitPoint*> points1, points2;
+  DLIList<CubitFacet*> facets1, facets2;
+  mesh.make_facets(points1, facets1);
+  mesh.convert_to_facets(points2, facets2);
+
+  int errors = 0;
+  if(mesh.num_points() || mesh.num_triangles())
+  {
+    fprintf(stderr, "mesh not empty after convert_to_facets\n");
+    errors++;
+  }
+  if(points1.size() != points2.size() || facets1.size() != facets2.size())
+  {
+    fprintf(stderr, "convert_to_facets made %d points and %d facets, "
+            "make_facets %d and %d\n", points2.size(), facets2.size(),
+            points1.size(), facets1.size());
+    return errors + 1;
+  }
+  for(int i=0; i<facets1.size(); i++)
+  {
+    CubitFacet* f1 = facets1.get_and_step();
+    CubitFacet* f2 = facets2.get_and_step();
+    for(int j=0; j<3; j++)
+    {
+      if(f1->point(j)->id() != f2->point(j)->id() ||
+         f1->point(j)->coordinates() != f2->point(j)->coordinates())
+      {
+        fprintf(stderr, "facet %d differs between make_facets and convert_to_facets\n", i);
+        errors++;
+        break;
+      }
+    }
+  }
+  for(int i=0; i<facets1.size(); i++)
+  {
+    delete facets1.get_and_step();
+    delete facets2.get_and_step();
+  }
+  for(int i=0; i<points1.size(); i++)
+  {
+    delete points1.get_and_step();
+    delete points2.get_and_step();
+  }
+  return errors;
+}
+
+int main (int argc, char **argv)
+{
+  int errors = 0;
+
+  // serial: no concurrency instance, and meshes below the parallel size
+  errors += test_merge_coincident(1000);
+  errors += test_weld_against_grid_search(1000, 0.1);
+  errors += test_weld_chain();
+  errors += test_convert_to_facets();
+
+  // parallel: large enough to be split into chunks on the pool
+  CubitStdConcurrent pool(4);
+  errors += test_merge_coincident(40000);
+  errors += test_weld_against_grid_search(40000, 0.1);
+
+  return errors;
+}
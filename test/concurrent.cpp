@@ -0,0 +1,174 @@
+/**
+ * \file concurrent.cpp
+ *
+ * \brief Tests of the built-in CubitConcurrent thread pool
+ *
+ * Checks that CGM installs a concurrency instance at startup, that task
+ * groups run every task exactly once, that tasks can schedule and wait
+ * on nested tasks without deadlocking the pool, and that
+ * parallel_for_ranges covers every item exactly once.
+ */
+#include "InitCGMA.hpp"
+#include "CubitStdConcurrentApi.h"
+
+#include <vector>
+#include <cstdio>
+
+class Summer
+{
+public:
+  Summer(CubitConcurrent* c) : mConcurrent(c) {}
+
+  void square(int v, int& result)
+  {
+    result = v*v;
+  }
+
+  // recursively split [0,n) and sum it, waiting on the nested tasks
+  void sum_range(std::pair<int,int> range, long& result)
+  {
+    if(range.second - range.first <= 4)
+    {
+      result = 0;
+      for(int i=range.first; i<range.second; i++)
+        result += i;
+      return;
+    }
+    int mid = (range.first + range.second) / 2;
+    long left = 0, right = 0;
+    std::pair<int,int> lo(range.first, mid), hi(mid, range.second);
+    CubitConcurrent::Task* t1 = mConcurrent->create_and_schedule(*this, &Summer::sum_range, lo, left);
+    CubitConcurrent::Task* t2 = mConcurrent->create_and_schedule(*this, &Summer::sum_range, hi, right);
+    mConcurrent->wait(t1);
+    mConcurrent->wait(t2);
+    delete t1;
+    delete t2;
+    result = left + right;
+  }
+
+private:
+  CubitConcurrent* mConcurrent;
+};
+
+int test_group(CubitConcurrent* c)
+{
+  Summer s(c);
+  std::vector<int> input(1000);
+  std::vector<int> output(1000, -1);
+  for(size_t i=0; i<input.size(); i++)
+    input[i] = (int)i;
+
+  CubitConcurrent::TaskGroup* tg = c->create_and_schedule_group(s, &Summer::square, input, output);
+  c->wait(tg);
+  if(!c->is_completed(tg))
+    return 1;
+  c->delete_group(tg);
+
+  for(size_t i=0; i<output.size(); i++)
+  {
+    if(output[i] != (int)(i*i))
+    {
+      fprintf(stderr, "task group result %d is %d\n", (int)i, output[i]);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int test_nested(CubitConcurrent* c)
+{
+  Summer s(c);
+  long result = 0;
+  std::pair<int,int> range(0, 10000);
+  CubitConcurrent::Task* t = c->create_and_schedule(s, &Summer::sum_range, range, result);
+  c->wait(t);
+  delete t;
+  if(result != 10000L*9999L/2)
+  {
+    fprintf(stderr, "nested sum is %ld\n", result);
+    return 1;
+  }
+  return 0;
+}
+
+class RangeVisitor
+{
+public:
+  RangeVisitor(size_t n) : visits(n, 0), rangeOf(n, -1) {}
+
+  void visit(std::pair<size_t,size_t> range)
+  {
+    for(size_t i=range.first; i<range.second; i++)
+      visits[i]++;
+  }
+
+  void visit_indexed(size_t index, std::pair<size_t,size_t> range)
+  {
+    for(size_t i=range.first; i<range.second; i++)
+      rangeOf[i] = (int)index;
+  }
+
+  std::vector<int> visits;
+  std::vector<int> rangeOf;
+};
+
+// every item is visited once, and the indexed ranges are numbered in
+// item order from 0 to num_ranges
+int test_ranges(size_t n, size_t min_size)
+{
+  RangeVisitor v(n);
+  CubitConcurrent::parallel_for_ranges(n, v, &RangeVisitor::visit, min_size);
+  CubitConcurrent::parallel_for_ranges(n, v, &RangeVisitor::visit_indexed, min_size);
+  int num_ranges = (int)CubitConcurrent::num_ranges(n, min_size);
+  for(size_t i=0; i<n; i++)
+  {
+    if(v.visits[i] != 1)
+    {
+      fprintf(stderr, "item %d of %d visited %d times\n", (int)i, (int)n, v.visits[i]);
+      return 1;
+    }
+    if(v.rangeOf[i] < (i ? v.rangeOf[i-1] : 0) || v.rangeOf[i] > (i ? v.rangeOf[i-1] + 1 : 0) ||
+       v.rangeOf[i] >= num_ranges)
+    {
+      fprintf(stderr, "item %d of %d is in range %d of %d\n", (int)i, (int)n, v.rangeOf[i],
+              num_ranges);
+      return 1;
+    }
+  }
+  if(n && v.rangeOf[n-1] != num_ranges - 1)
+  {
+    fprintf(stderr, "%d items use %d of %d ranges\n", (int)n, v.rangeOf[n-1] + 1, num_ranges);
+    return 1;
+  }
+  return 0;
+}
+
+int main (int argc, char **argv)
+{
+  CubitStatus status = InitCGMA::initialize_cgma();
+  if (CUBIT_SUCCESS != status) return 1;
+
+  CubitConcurrent* c = CubitConcurrent::instance();
+  if (!c)
+  {
+    fprintf(stderr, "no concurrency instance installed at startup\n");
+    return 1;
+  }
+
+  int result = 0;
+  result += test_group(c);
+  result += test_nested(c);
+  const size_t sizes[] = { 0, 1, 15, 16, 17, 1000, 1024, 1025, 100003 };
+  for(size_t i=0; i<sizeof(sizes)/sizeof(sizes[0]); i++)
+  {
+    result += test_ranges(sizes[i], 16);
+    result += test_ranges(sizes[i], 1);
+  }
+
+  // a single-threaded pool must run everything in the waiting thread
+  CubitStdConcurrent serial(1);
+  result += test_group(&serial);
+  result += test_nested(&serial);
+
+  return result;
+}
@@ -0,0 +1,356 @@
+/**
+ * \file facet_block_file.cpp
+ *
+ * \brief Tests of FacetBlockFile and mesh-based geometry file versions
+ *
+ * Writes FacetBlockWriter sections of incompressible, compressible and
+ * odd sized blocks, including literal runs, match lengths and match
+ * offsets at the limits of the packed format, and checks that every
+ * block reads back unchanged.  Then exports faceted bodies as version 1,
+ * version 2 and compressed version 2 mesh-based geometry files and checks
+ * that each restores to the same facets and surface evaluations.
+ */
+#include "FacetBlockFile.hpp"
+#include "FacetQueryEngine.hpp"
+#include "FacetBody.hpp"
+#include "FacetSurface.hpp"
+#include "CubitFacet.hpp"
+#include "CubitPoint.hpp"
+#include "Body.hpp"
+#include "BodySM.hpp"
+#include "GeometryDefines.h"
+#include "CubitString.hpp"
+#include "DLIList.hpp"
+#include "TestUtilities.hpp"
+
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+static unsigned int seed = 2718;
+static unsigned char next_byte()
+{
+  seed = seed * 1103515245u + 12345u;
+  return (unsigned char)(seed >> 16);
+}
+
+struct TestBlock
+{
+  int type;
+  int elemSize;
+  bool compress;
+  std::vector<char> data;
+};
+
+static void add_random(std::vector<char>& data, size_t n)
+{
+  for(size_t i=0; i<n; i++)
+    data.push_back((char)next_byte());
+}
+
+static std::vector<TestBlock> make_blocks()
+{
+  std::vector<TestBlock> blocks;
+  TestBlock b;
+  b.compress = true;
+
+  // incompressible bytes, stored as they are
+  b.type = 1; b.elemSize = 1;
+  add_random(b.data, 100000);
+  blocks.push_back(b);
+
+  // smooth doubles, which pack well after regrouping
+  b.type = 2; b.elemSize = 8; b.data.clear();
+  for(int i=0; i<20001; i++)
+  {
+    double v = std::sin(0.001*i);
+    b.data.insert(b.data.end(), (char*)&v, (char*)&v + 8);
+  }
+  blocks.push_back(b);
+
+  // a random run repeated at the largest and just past the largest
+  // offset a match may have
+  b.type = 3; b.elemSize = 1; b.data.clear();
+  add_random(b.data, 3000);
+  std::vector<char> run(b.data);
+  b.data.resize(65535, 0);
+  b.data.insert(b.data.end(), run.begin(), run.end());
+  b.data.resize(2*65536 + 1, 0);
+  b.data.insert(b.data.end(), run.begin(), run.end());
+  add_random(b.data, 5);
+  blocks.push_back(b);
+
+  // literal and match lengths on either side of where the length needs
+  // one and two extra bytes
+  static const int lits[] = { 0, 1, 14, 15, 16, 269, 270, 271, 524, 525 };
+  static const int zeros[] = { 17, 18, 19, 20, 273, 274, 275, 4096 };
+  int type = 10;
+  for(size_t i=0; i<sizeof(lits)/sizeof(lits[0]); i++)
+    for(size_t j=0; j<sizeof(zeros)/sizeof(zeros[0]); j++)
+    {
+      b.type = type++; b.elemSize = 1; b.data.clear();
+      add_random(b.data, lits[i]);
+      b.data.resize(b.data.size() + zeros[j], 0);
+      add_random(b.data, 8);
+      blocks.push_back(b);
+    }
+
+  // small blocks either side of the size that is worth packing, an
+  // empty block and blocks that leave the next one unaligned
+  static const int sizes[] = { 0, 1, 7, 63, 64, 65 };
+  for(size_t i=0; i<sizeof(sizes)/sizeof(sizes[0]); i++)
+  {
+    b.type = type++; b.elemSize = 1; b.data.assign(sizes[i], 'a');
+    blocks.push_back(b);
+  }
+  b.type = type++; b.elemSize = 4; b.compress = false; b.data.clear();
+  add_random(b.data, 4*7);
+  blocks.push_back(b);
+  b.type = type++; b.elemSize = 2; b.compress = true; b.data.assign(2*1001, 0);
+  blocks.push_back(b);
+
+  return blocks;
+}
+
+int test_block_round_trip()
+{
+  int errors = 0;
+  std::vector<TestBlock> blocks = make_blocks();
+  FacetBlockWriter writer;
+  size_t raw_bytes = 0;
+  for(size_t i=0; i<blocks.size(); i++)
+  {
+    TestBlock& b = blocks[i];
+    size_t count = b.data.size() / b.elemSize;
+    writer.add_block(b.type, count ? &b.data[0] : NULL, count, b.elemSize, b.compress);
+    raw_bytes += b.data.size();
+  }
+  if(writer.stored_bytes() >= raw_bytes)
+  {
+    fprintf(stderr, "no block was packed: %lu stored bytes for %lu raw\n",
+            (unsigned long)writer.stored_bytes(), (unsigned long)raw_bytes);
+    errors++;
+  }
+
+  // start at an unaligned position, as after a file header
+  FILE* fp = tmpfile();
+  if(!fp)
+  {
+    fprintf(stderr, "cannot open a temporary file\n");
+    return 1;
+  }
+  fwrite("MBG", 1, 3, fp);
+  if(writer.write(fp) != CUBIT_SUCCESS)
+  {
+    fprintf(stderr, "writing the section failed\n");
+    fclose(fp);
+    return 1;
+  }
+
+  long start;
+  size_t size;
+  fseek(fp, 3, SEEK_SET);
+  if(FacetBlockReader::section_size(fp, 0, start, size) != CUBIT_SUCCESS ||
+     start != 8 || size != writer.stored_bytes())
+  {
+    fprintf(stderr, "section found at %ld with %lu bytes\n", start, (unsigned long)size);
+    fclose(fp);
+    return 1;
+  }
+  std::vector<char> buffer(size);
+  if(fread(&buffer[0], 1, size, fp) != size)
+  {
+    fprintf(stderr, "cannot read the section back\n");
+    fclose(fp);
+    return 1;
+  }
+  fclose(fp);
+
+  FacetBlockReader reader;
+  if(reader.open(&buffer[0], size, 0) != CUBIT_SUCCESS)
+  {
+    fprintf(stderr, "cannot open the section\n");
+    return 1;
+  }
+  for(size_t i=0; i<blocks.size(); i++)
+  {
+    TestBlock& b = blocks[i];
+    size_t count;
+    const void* data = reader.block(b.type, count, b.elemSize);
+    if(count != b.data.size() / b.elemSize ||
+       (count && (!data || memcmp(data, &b.data[0], b.data.size()))))
+    {
+      fprintf(stderr, "block %d of %lu bytes did not read back\n",
+              b.type, (unsigned long)b.data.size());
+      errors++;
+    }
+  }
+
+  // headers cut short or giving sizes the section cannot hold; the
+  // section size is words 4 and 5 and the block count word 2
+  std::vector<char> bad(buffer.begin(), buffer.begin() + 24);
+  FacetBlockReader bad_reader;
+  if(bad_reader.open(&bad[0], 20, 0) == CUBIT_SUCCESS)
+  {
+    fprintf(stderr, "a truncated header was accepted\n");
+    errors++;
+  }
+  unsigned int words[6];
+  memcpy(words, &bad[0], sizeof(words));
+  const unsigned int bad_sizes[3][2] = { { 8, 1000 }, { 0, 0 }, { 25, 1000 } };
+  for(int i=0; i<3; i++)
+  {
+    words[4] = bad_sizes[i][0]; words[5] = 0;
+    words[2] = bad_sizes[i][1];
+    memcpy(&bad[0], words, sizeof(words));
+    if(bad_reader.open(&bad[0], bad.size(), 0) == CUBIT_SUCCESS)
+    {
+      fprintf(stderr, "a header giving %u bytes for %u blocks was accepted\n",
+              bad_sizes[i][0], bad_sizes[i][1]);
+      errors++;
+    }
+  }
+
+  size_t count;
+  if(reader.block(1000, count, 1) || count ||
+     reader.block(blocks[0].type, count, 4) || count)
+  {
+    fprintf(stderr, "a missing block or wrong element size was found\n");
+    errors++;
+  }
+  return errors;
+}
+
+static FacetBody* facet_body(Body* body)
+{
+  return body ? CAST_TO(body->get_body_sm_ptr(), FacetBody) : NULL;
+}
+
+// the facets and some closest points of each surface
+static std::vector<double> surface_data(FacetBody* body)
+{
+  std::vector<double> result;
+  DLIList<FacetSurface*> surfaces;
+  body->get_surfaces(surfaces);
+  surfaces.reset();
+  for(int i=0; i<surfaces.size(); i++)
+  {
+    FacetSurface* surf = surfaces.get_and_step();
+    DLIList<CubitFacet*> facets;
+    DLIList<CubitPoint*> points;
+    surf->get_my_facets(facets, points);
+    result.push_back(facets.size());
+    for(int j=0; j<facets.size(); j++)
+    {
+      CubitFacet* facet = facets.get_and_step();
+      for(int k=0; k<3; k++)
+      {
+        CubitVector p = facet->point(k)->coordinates();
+        result.push_back(p.x()); result.push_back(p.y()); result.push_back(p.z());
+      }
+    }
+    for(int j=0; j<5; j++)
+    {
+      CubitVector from(-0.5 + 0.6*j, 1.7 - 0.4*j, 0.3*j - 0.2), closest, normal;
+      surf->closest_point(from, &closest, &normal);
+      result.push_back(closest.x()); result.push_back(closest.y()); result.push_back(closest.z());
+      result.push_back(normal.x()); result.push_back(normal.y()); result.push_back(normal.z());
+    }
+  }
+  return result;
+}
+
+int test_mbg_round_trip(FacetBody* body, int version, bool compress)
+{
+  FacetQueryEngine* fqe = FacetQueryEngine::instance();
+  const char* file_name = "facet_block_file_test.mbg";
+  int errors = 0;
+
+  if(fqe->set_mbg_file_version(version) != CUBIT_SUCCESS)
+  {
+    fprintf(stderr, "cannot select file version %d\n", version);
+    return 1;
+  }
+  FacetQueryEngine::set_compress_facet_blocks(compress ? CUBIT_TRUE : CUBIT_FALSE);
+
+  DLIList<TopologyBridge*> export_list;
+  export_list.append(body);
+  ModelExportOptions export_options;
+  if(fqe->export_solid_model(export_list, file_name, FACET_TYPE, CubitString(""),
+                             export_options) != CUBIT_SUCCESS)
+  {
+    fprintf(stderr, "export of version %d failed\n", version);
+    return 1;
+  }
+
+  // the version follows the file type and byte order
+  unsigned int file_version = 0;
+  FILE* fp = fopen(file_name, "rb");
+  if(!fp || fseek(fp, 23, SEEK_SET) || fread(&file_version, 4, 1, fp) != 1 ||
+     (int)file_version != version)
+  {
+    fprintf(stderr, "file written as version %u, expected %d\n", file_version, version);
+    errors++;
+  }
+  if(fp)
+    fclose(fp);
+
+  DLIList<TopologyBridge*> imported;
+  ModelImportOptions import_options;
+  if(fqe->import_solid_model(file_name, FACET_TYPE, imported, import_options) != CUBIT_SUCCESS ||
+     imported.size() != 1 || !CAST_TO(imported.get(), FacetBody))
+  {
+    fprintf(stderr, "import of version %d failed\n", version);
+    remove(file_name);
+    return errors + 1;
+  }
+  remove(file_name);
+
+  FacetBody* restored = CAST_TO(imported.get(), FacetBody);
+  if(surface_data(restored) != surface_data(body))
+  {
+    fprintf(stderr, "version %d%s file restored different facets\n",
+            version, compress ? " compressed" : "");
+    errors++;
+  }
+  fqe->delete_solid_model_entities(restored);
+  return errors;
+}
+
+int main (int argc, char **argv)
+{
+  int errors = test_block_round_trip();
+  if(FacetQueryEngine::get_mbg_file_version() != 1)
+  {
+    fprintf(stderr, "files are written as version %d by default\n",
+            FacetQueryEngine::get_mbg_file_version());
+    errors++;
+  }
+
+  // one surface per side, and one smooth surface over the whole brick
+  FacetBody* bodies[2];
+  bodies[0] = facet_body(make_facet_brick(CubitVector(0, 0, 0), CubitVector(1, 1, 1)));
+  bodies[1] = facet_body(make_facet_brick(CubitVector(2, 0, 0), CubitVector(3, 2, 1), 10.0));
+  for(int i=0; i<2; i++)
+  {
+    if(!bodies[i])
+    {
+      fprintf(stderr, "could not build brick %d\n", i);
+      return errors + 1;
+    }
+    errors += test_mbg_round_trip(bodies[i], 1, false);
+    errors += test_mbg_round_trip(bodies[i], 2, false);
+    errors += test_mbg_round_trip(bodies[i], 2, true);
+  }
+
+  if(FacetQueryEngine::set_mbg_file_version(3) == CUBIT_SUCCESS)
+  {
+    fprintf(stderr, "file version 3 was accepted\n");
+    errors++;
+  }
+  FacetQueryEngine::set_mbg_file_version(1);
+  FacetQueryEngine::set_compress_facet_blocks(CUBIT_FALSE);
+
+  return errors;
+}
@@ -0,0 +1,133 @@
+/**
+ * \file facet_closest_points.cpp
+ *
+ * \brief Tests of projecting many points at once with FacetEvalTool
+ *
+ * Builds a curved grid of facets and projects random points near it with
+ * closest_points, on a CubitConcurrent pool of four threads and with no
+ * pool, and one at a time with closest_point.  The points are further
+ * from the facets than the projection tolerance, so the facet each
+ * projection starts from does not change its result, and every closest
+ * point and normal must be the same.
+ */
+#include "FacetEvalTool.hpp"
+#include "CubitPointData.hpp"
+#include "CubitFacetData.hpp"
+#include "CubitStdConcurrentApi.h"
+#include "DLIList.hpp"
+
+#include <vector>
+#include <cstdio>
+
+static unsigned int seed = 7919;
+static double next_random()
+{
+  seed = seed * 1103515245u + 12345u;
+  return (double)((seed >> 8) & 0xffff) / 65536.0;
+}
+
+// an n by n grid of facets over [0,4] x [0,4], curved into a bowl
+static FacetEvalTool* make_bowl(int n, int interp_order)
+{
+  DLIList<CubitPoint*> points;
+  DLIList<CubitFacet*> facets;
+  std::vector<CubitPoint*> grid;
+  for(int j=0; j<=n; j++)
+    for(int i=0; i<=n; i++)
+    {
+      double x = 4.0*i/n, y = 4.0*j/n;
+      CubitPoint* pt = new CubitPointData(x, y, 0.1*((x-2)*(x-2) + (y-2)*(y-2)));
+      grid.push_back(pt);
+      points.append(pt);
+    }
+  for(int j=0; j<n; j++)
+    for(int i=0; i<n; i++)
+    {
+      int p = j*(n+1) + i;
+      facets.append(new CubitFacetData(grid[p], grid[p+1], grid[p+n+2]));
+      facets.append(new CubitFacetData(grid[p], grid[p+n+2], grid[p+n+1]));
+    }
+  return new FacetEvalTool(facets, points, interp_order, 0.707106781185);
+}
+
+// project the points one at a time, then all at once with no pool, which
+// projects them in order, and on a pool of four threads
+static int check_points(FacetEvalTool* tool, const std::vector<double>& xyz,
+                        const char* name)
+{
+  size_t num_points = xyz.size()/3;
+  std::vector<double> serial_xyz, serial_normals;
+  int errors = 0;
+  for(size_t i=0; i<num_points; i++)
+  {
+    CubitVector point(&xyz[3*i]), closest, normal;
+    if(tool->closest_point(point, &closest, &normal) != CUBIT_SUCCESS)
+    {
+      fprintf(stderr, "%s: closest_point failed for point %d\n", name, (int)i);
+      errors++;
+    }
+    serial_xyz.push_back(closest.x()); serial_xyz.push_back(closest.y());
+    serial_xyz.push_back(closest.z());
+    serial_normals.push_back(normal.x()); serial_normals.push_back(normal.y());
+    serial_normals.push_back(normal.z());
+  }
+
+  for(int pass=0; pass<2; pass++)
+  {
+    std::vector<double> out_xyz(xyz.size()), out_normals(xyz.size());
+    CubitStdConcurrent* pool = pass ? new CubitStdConcurrent(4) : NULL;
+    if(pool && CubitConcurrent::instance() != pool)
+    {
+      fprintf(stderr, "%s: the pool is not the concurrency instance\n", name);
+      errors++;
+    }
+    const char* how = pool ? "on the pool" : "with no pool";
+    if(tool->closest_points(&xyz[0], num_points, &out_xyz[0], &out_normals[0]) !=
+       CUBIT_SUCCESS)
+    {
+      fprintf(stderr, "%s: closest_points failed %s\n", name, how);
+      errors++;
+    }
+    delete pool;
+
+    for(size_t i=0; i<num_points; i++)
+    {
+      CubitVector closest(&out_xyz[3*i]), normal(&out_normals[3*i]);
+      if(closest != CubitVector(&serial_xyz[3*i]) ||
+         normal != CubitVector(&serial_normals[3*i]))
+      {
+        fprintf(stderr, "%s: point %d projects to (%g %g %g) %s, closest_point gives "
+                "(%g %g %g)\n", name, (int)i, closest.x(), closest.y(), closest.z(), how,
+                serial_xyz[3*i], serial_xyz[3*i+1], serial_xyz[3*i+2]);
+        errors++;
+      }
+    }
+  }
+  return errors;
+}
+
+int test_bowl(int interp_order, const char* name)
+{
+  FacetEvalTool* tool = make_bowl(30, interp_order);
+
+  // above and below the bowl, between 0.02 and 0.3 from it
+  std::vector<double> xyz;
+  for(int i=0; i<2000; i++)
+  {
+    double x = 0.2 + 3.6*next_random(), y = 0.2 + 3.6*next_random();
+    double offset = 0.02 + 0.28*next_random();
+    double z = 0.1*((x-2)*(x-2) + (y-2)*(y-2)) + ((i % 2) ? offset : -offset);
+    xyz.push_back(x); xyz.push_back(y); xyz.push_back(z);
+  }
+  int errors = check_points(tool, xyz, name);
+  delete tool;
+  return errors;
+}
+
+int main (int argc, char **argv)
+{
+  int errors = 0;
+  errors += test_bowl(0, "linear facets");
+  errors += test_bowl(4, "spline patches");
+  return errors;
+}
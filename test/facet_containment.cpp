@@ -0,0 +1,284 @@
+/**
+ * \file facet_containment.cpp
+ *
+ * \brief Tests of FacetContainmentTool and FacetLump point containment
+ *
+ * Checks the tree-summed winding number against the exact sum over all
+ * triangles on closed and holed meshes, including points whose winding
+ * number is near the 0.5 threshold; classifies points against closed
+ * and open cubes; checks that near distances apply only around the
+ * facets given them; and checks that a lump's cached containment tool
+ * follows the body when it moves.
+ */
+#include "FacetContainmentTool.hpp"
+#include "FacetQueryEngine.hpp"
+#include "FacetBody.hpp"
+#include "FacetLump.hpp"
+#include "CubitPointData.hpp"
+#include "CubitFacetData.hpp"
+#include "Body.hpp"
+#include "BodySM.hpp"
+#include "CubitVector.hpp"
+#include "DLIList.hpp"
+#include "TestUtilities.hpp"
+
+#include <vector>
+#include <cmath>
+#include <cstdio>
+
+static unsigned int seed = 8191;
+static double next_random()
+{
+  seed = seed * 1103515245u + 12345u;
+  return (double)((seed >> 8) & 0xffff) / 65536.0;
+}
+
+// an ellipsoid of 2*n*n*2 triangles, with a hole of about hole*hole
+// quads cut out of one side
+static void make_ellipsoid(int n, int hole, std::vector<double>& coords,
+                           std::vector<int>& conn)
+{
+  int nu = 2*n, nv = n;
+  for(int j=0; j<=nv; j++)
+    for(int i=0; i<nu; i++)
+    {
+      double theta = CUBIT_PI*j/nv, phi = 2*CUBIT_PI*i/nu + 0.3*j;
+      coords.push_back(sin(theta)*cos(phi));
+      coords.push_back(0.7*sin(theta)*sin(phi));
+      coords.push_back(1.3*cos(theta));
+    }
+  for(int j=0; j<nv; j++)
+    for(int i=0; i<nu; i++)
+    {
+      if(hole && j > nv/2 && j < nv/2 + hole && i < hole)
+        continue;
+      int a = j*nu + i, b = j*nu + (i+1)%nu;
+      int c = (j+1)*nu + i, d = (j+1)*nu + (i+1)%nu;
+      conn.push_back(a); conn.push_back(c); conn.push_back(b);
+      conn.push_back(b); conn.push_back(c); conn.push_back(d);
+    }
+}
+
+int test_winding_number(int hole)
+{
+  std::vector<double> coords;
+  std::vector<int> conn;
+  make_ellipsoid(40, hole, coords, conn);
+  FacetContainmentTool tool;
+  tool.build(&coords[0], (int)coords.size()/3, &conn[0], (int)conn.size()/3);
+
+  int errors = 0, num_near_half = 0;
+  double max_error = 0.0;
+  for(int i=0; i<2000; i++)
+  {
+    CubitVector point(4*next_random()-2, 4*next_random()-2, 4*next_random()-2);
+    if(i % 2)
+      point *= 0.55;
+    // points in the mouth of the hole
+    if(hole && i % 5 == 0)
+    {
+      CubitVector mouth(&coords[3*((20 + hole/2)*80 + hole/2)]);
+      CubitVector offset(next_random(), next_random(), next_random());
+      point = (0.8 + 0.4*next_random()) * mouth + 0.1 * offset;
+    }
+    double approx = tool.winding_number(point);
+    double exact = tool.exact_winding_number(point);
+    max_error = CUBIT_MAX(max_error, fabs(approx - exact));
+    if(fabs(exact - 0.5) < 0.1)
+      num_near_half++;
+    if(fabs(exact - 0.5) > 2e-3 && (approx > 0.5) != (exact > 0.5))
+    {
+      fprintf(stderr, "winding number %g at (%g %g %g) is on the other side of 0.5 "
+              "from the exact %g\n", approx, point.x(), point.y(), point.z(), exact);
+      errors++;
+    }
+  }
+  if(max_error > 2e-3)
+  {
+    fprintf(stderr, "winding number differs from the exact sum by up to %g\n", max_error);
+    errors++;
+  }
+  if(hole && num_near_half == 0)
+  {
+    fprintf(stderr, "no point near the 0.5 threshold was tested\n");
+    errors++;
+  }
+  return errors;
+}
+
+// a cube from 0 to size, two outward triangles per side
+static const int cube_tris[12][3] = { {0,2,1}, {1,2,3}, {4,5,6}, {5,7,6},
+                                      {0,1,4}, {1,5,4}, {2,6,3}, {3,6,7},
+                                      {0,4,2}, {2,4,6}, {1,3,5}, {3,7,5} };
+static CubitVector cube_corner(int i, double size)
+{
+  return CubitVector(size*(i & 1), size*((i >> 1) & 1), size*((i >> 2) & 1));
+}
+
+int check_classification(const FacetContainmentTool& tool, const CubitVector& point,
+                         CubitPointContainment expected, const char* name)
+{
+  CubitPointContainment result = tool.point_containment(point);
+  if(result != expected)
+  {
+    fprintf(stderr, "%s: (%g %g %g) classified %d, expected %d\n", name,
+            point.x(), point.y(), point.z(), (int)result, (int)expected);
+    return 1;
+  }
+  return 0;
+}
+
+int test_cube()
+{
+  int errors = 0;
+  std::vector<double> coords;
+  for(int i=0; i<8; i++)
+  {
+    CubitVector corner = cube_corner(i, 1.0);
+    coords.push_back(corner.x()); coords.push_back(corner.y()); coords.push_back(corner.z());
+  }
+
+  FacetContainmentTool closed;
+  closed.build(&coords[0], 8, &cube_tris[0][0], 12);
+  if(!closed.is_closed())
+  {
+    fprintf(stderr, "closed cube is not closed\n");
+    errors++;
+  }
+  errors += check_classification(closed, CubitVector(0.5, 0.5, 0.5), CUBIT_PNT_INSIDE, "closed cube");
+  errors += check_classification(closed, CubitVector(0.2, 0.7, 0.9), CUBIT_PNT_INSIDE, "closed cube");
+  errors += check_classification(closed, CubitVector(1.5, 0.5, 0.5), CUBIT_PNT_OUTSIDE, "closed cube");
+  errors += check_classification(closed, CubitVector(0.5, 0.5, 1.0), CUBIT_PNT_BOUNDARY, "closed cube");
+  errors += check_classification(closed, CubitVector(1.0, 1.0, 0.3), CUBIT_PNT_BOUNDARY, "closed cube");
+
+  // without its top the winding number decides: 5/6 at the center
+  FacetContainmentTool open;
+  open.build(&coords[0], 8, &cube_tris[0][0], 10);
+  if(open.is_closed())
+  {
+    fprintf(stderr, "open cube is closed\n");
+    errors++;
+  }
+  errors += check_classification(open, CubitVector(0.5, 0.5, 0.5), CUBIT_PNT_INSIDE, "open cube");
+  errors += check_classification(open, CubitVector(0.5, 0.5, 0.3), CUBIT_PNT_INSIDE, "open cube");
+  errors += check_classification(open, CubitVector(0.5, 0.5, 2.0), CUBIT_PNT_OUTSIDE, "open cube");
+  errors += check_classification(open, CubitVector(-1.0, 0.5, 0.5), CUBIT_PNT_OUTSIDE, "open cube");
+  return errors;
+}
+
+// a near distance given to one side's facets must not reach the others
+int test_local_near_distance()
+{
+  int errors = 0;
+  CubitPointData* points[8];
+  for(int i=0; i<8; i++)
+    points[i] = new CubitPointData(cube_corner(i, 10.0));
+  DLIList<CubitFacet*> bottom, rest;
+  for(int i=0; i<12; i++)
+  {
+    CubitFacet* facet = new CubitFacetData(points[cube_tris[i][0]], points[cube_tris[i][1]],
+                                           points[cube_tris[i][2]]);
+    if(i < 2)
+      bottom.append(facet);
+    else
+      rest.append(facet);
+  }
+
+  FacetContainmentTool tool;
+  tool.add_facets(rest, CUBIT_FORWARD);
+  tool.add_facets(bottom, CUBIT_FORWARD, 0.1);
+  tool.build();
+  if(!tool.is_closed())
+  {
+    fprintf(stderr, "cube from facets is not closed\n");
+    errors++;
+  }
+
+  // the bottom facets' longest edge is about 14, so 1.4 from them is near
+  errors += check_classification(tool, CubitVector(5, 5, 1.0), CUBIT_PNT_UNKNOWN, "near bottom");
+  errors += check_classification(tool, CubitVector(5, 5, -1.0), CUBIT_PNT_UNKNOWN, "near bottom");
+  errors += check_classification(tool, CubitVector(5, 5, 2.0), CUBIT_PNT_INSIDE, "near bottom");
+  errors += check_classification(tool, CubitVector(5, 5, 9.0), CUBIT_PNT_INSIDE, "near top");
+  errors += check_classification(tool, CubitVector(5, 5, 11.0), CUBIT_PNT_OUTSIDE, "near top");
+  errors += check_classification(tool, CubitVector(1.0, 5, 5), CUBIT_PNT_INSIDE, "near side");
+  errors += check_classification(tool, CubitVector(5, 5, 0.0), CUBIT_PNT_BOUNDARY, "on bottom");
+
+  for(int i=0; i<bottom.size(); i++)
+    delete bottom.get_and_step();
+  for(int i=0; i<rest.size(); i++)
+    delete rest.get_and_step();
+  for(int i=0; i<8; i++)
+    delete points[i];
+  return errors;
+}
+
+// the batch classification of a lump against one point at a time
+int check_lump(FacetLump* lump, const std::vector<CubitVector>& points,
+               const CubitPointContainment* expected, const char* name)
+{
+  int errors = 0;
+  std::vector<double> xyz;
+  for(size_t i=0; i<points.size(); i++)
+  {
+    xyz.push_back(points[i].x()); xyz.push_back(points[i].y()); xyz.push_back(points[i].z());
+  }
+  std::vector<CubitPointContainment> results(points.size());
+  lump->point_containment(&xyz[0], points.size(), &results[0]);
+  for(size_t i=0; i<points.size(); i++)
+  {
+    if(results[i] != expected[i] || lump->point_containment(points[i]) != expected[i])
+    {
+      fprintf(stderr, "%s: point %d classified %d, one at a time %d, expected %d\n",
+              name, (int)i, (int)results[i], (int)lump->point_containment(points[i]),
+              (int)expected[i]);
+      errors++;
+    }
+  }
+  return errors;
+}
+
+int test_lump_cache()
+{
+  int errors = 0;
+  Body* body = make_facet_brick(CubitVector(0, 0, 0), CubitVector(1, 1, 1));
+  FacetBody* f_body = body ? CAST_TO(body->get_body_sm_ptr(), FacetBody) : NULL;
+  DLIList<FacetLump*> lumps;
+  if(f_body)
+    f_body->get_lumps(lumps);
+  if(lumps.size() != 1)
+  {
+    fprintf(stderr, "could not build the brick\n");
+    return 1;
+  }
+  FacetLump* lump = lumps.get();
+
+  std::vector<CubitVector> points;
+  points.push_back(CubitVector(0.5, 0.5, 0.5));
+  points.push_back(CubitVector(5.5, 0.5, 0.5));
+  points.push_back(CubitVector(-3.0, 0.5, 0.5));
+  points.push_back(CubitVector(1.0, 0.5, 0.5));
+
+  const CubitPointContainment before[4] = { CUBIT_PNT_INSIDE, CUBIT_PNT_OUTSIDE,
+                                            CUBIT_PNT_OUTSIDE, CUBIT_PNT_BOUNDARY };
+  errors += check_lump(lump, points, before, "brick");
+  errors += check_lump(lump, points, before, "brick again");
+
+  // a tool left over from before the move would put the second point
+  // outside, far from the old facets
+  FacetQueryEngine::instance()->translate(f_body, CubitVector(5, 0, 0));
+  const CubitPointContainment after[4] = { CUBIT_PNT_OUTSIDE, CUBIT_PNT_INSIDE,
+                                           CUBIT_PNT_OUTSIDE, CUBIT_PNT_OUTSIDE };
+  errors += check_lump(lump, points, after, "moved brick");
+  return errors;
+}
+
+int main (int argc, char **argv)
+{
+  int errors = 0;
+  errors += test_winding_number(0);
+  errors += test_winding_number(8);
+  errors += test_cube();
+  errors += test_local_near_distance();
+  errors += test_lump_cache();
+  return errors;
+}
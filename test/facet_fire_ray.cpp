@@ -0,0 +1,150 @@
+/**
+ * \file facet_fire_ray.cpp
+ *
+ * \brief Tests of FacetQueryEngine::fire_ray
+ *
+ * Fires rays at a faceted brick through the middle of faces, through
+ * curves and points shared by two or three surfaces, and through a
+ * facet edge inside a surface, with the body, its lump and single
+ * surfaces as targets.  Each crossing must be reported once, at the
+ * right distance and on a surface of the target.
+ */
+#include "FacetQueryEngine.hpp"
+#include "FacetBody.hpp"
+#include "FacetLump.hpp"
+#include "FacetSurface.hpp"
+#include "Body.hpp"
+#include "BodySM.hpp"
+#include "CubitVector.hpp"
+#include "DLIList.hpp"
+#include "TestUtilities.hpp"
+
+#include <cmath>
+#include <cstdio>
+
+// fire a ray at target and compare the hits with the expected distances
+int check_ray(TopologyBridge* target, DLIList<FacetSurface*>& surfaces,
+              const CubitVector& origin, const CubitVector& direction,
+              int max_hits, int num_expected, const double* expected,
+              const char* name)
+{
+  CubitVector from = origin, dir = direction;
+  DLIList<TopologyBridge*> targets;
+  targets.append(target);
+  DLIList<double> params;
+  DLIList<TopologyBridge*> hit_entities;
+  FacetQueryEngine::instance()->fire_ray(from, dir, targets, params,
+                                         max_hits, 0.0, &hit_entities);
+
+  if(params.size() != num_expected || hit_entities.size() != num_expected)
+  {
+    fprintf(stderr, "%s: %d hits, expected %d\n", name, params.size(), num_expected);
+    return 1;
+  }
+  int errors = 0;
+  params.reset();
+  hit_entities.reset();
+  for(int i=0; i<num_expected; i++)
+  {
+    double param = params.get_and_step();
+    FacetSurface* surf = CAST_TO(hit_entities.get_and_step(), FacetSurface);
+    if(fabs(param - expected[i]) > 1e-6)
+    {
+      fprintf(stderr, "%s: hit %d at %g, expected %g\n", name, i, param, expected[i]);
+      errors++;
+    }
+    if(!surf || !surfaces.is_in_list(surf))
+    {
+      fprintf(stderr, "%s: hit %d is not on a surface of the target\n", name, i);
+      errors++;
+    }
+  }
+  return errors;
+}
+
+int test_rays(TopologyBridge* target, DLIList<FacetSurface*>& surfaces, const char* name)
+{
+  int errors = 0;
+  char label[128];
+  const double r2 = sqrt(2.0), r3 = sqrt(3.0);
+
+  // through the middle of two faces
+  const double faces[2] = { 1.0, 2.0 };
+  sprintf(label, "%s, face centres", name);
+  errors += check_ray(target, surfaces, CubitVector(-1, 0.3, 0.6), CubitVector(1, 0, 0),
+                      0, 2, faces, label);
+
+  // through the curves shared by the x=0 and z=0 sides and the x=1 and
+  // z=1 sides
+  const double curves[2] = { r2, 2*r2 };
+  sprintf(label, "%s, shared curves", name);
+  errors += check_ray(target, surfaces, CubitVector(-1, 0.5, -1), CubitVector(1, 0, 1),
+                      0, 2, curves, label);
+
+  // through opposite corners, each shared by three sides
+  const double corners[2] = { r3, 2*r3 };
+  sprintf(label, "%s, corners", name);
+  errors += check_ray(target, surfaces, CubitVector(-1, -1, -1), CubitVector(1, 1, 1),
+                      0, 2, corners, label);
+
+  // through the facet edge across each z side
+  const double diagonal[2] = { 1.0, 2.0 };
+  sprintf(label, "%s, facet diagonals", name);
+  errors += check_ray(target, surfaces, CubitVector(0.5, 0.5, -1), CubitVector(0, 0, 1),
+                      0, 2, diagonal, label);
+
+  // max_hits counts crossings, not surfaces hit
+  sprintf(label, "%s, first shared curve", name);
+  errors += check_ray(target, surfaces, CubitVector(-1, 0.5, -1), CubitVector(1, 0, 1),
+                      1, 1, curves, label);
+
+  // missing the brick
+  sprintf(label, "%s, miss", name);
+  errors += check_ray(target, surfaces, CubitVector(-1, 2, 0.5), CubitVector(1, 0, 0),
+                      0, 0, NULL, label);
+  return errors;
+}
+
+int main (int argc, char **argv)
+{
+  Body* body = make_facet_brick(CubitVector(0, 0, 0), CubitVector(1, 1, 1));
+  FacetBody* f_body = body ? CAST_TO(body->get_body_sm_ptr(), FacetBody) : NULL;
+  if(!f_body)
+  {
+    fprintf(stderr, "could not build the brick\n");
+    return 1;
+  }
+
+  DLIList<FacetSurface*> surfaces;
+  f_body->get_surfaces(surfaces);
+  DLIList<FacetLump*> lumps;
+  f_body->get_lumps(lumps);
+  if(surfaces.size() != 6 || lumps.size() != 1)
+  {
+    fprintf(stderr, "brick has %d surfaces and %d lumps\n", surfaces.size(), lumps.size());
+    return 1;
+  }
+
+  int errors = 0;
+  errors += test_rays(f_body, surfaces, "body");
+  errors += test_rays(lumps.get(), surfaces, "lump");
+
+  // a single surface reports the shared curve it bounds once
+  surfaces.reset();
+  for(int i=0; i<surfaces.size(); i++)
+  {
+    FacetSurface* surf = surfaces.get_and_step();
+    CubitVector from(-1, 0.5, -1), dir(1, 0, 1);
+    DLIList<TopologyBridge*> targets;
+    targets.append(surf);
+    DLIList<double> params;
+    FacetQueryEngine::instance()->fire_ray(from, dir, targets, params, 0, 0.0, NULL);
+    if(params.size() > 1)
+    {
+      fprintf(stderr, "surface %d reports %d hits on one crossing\n", i, params.size());
+      errors++;
+    }
+  }
+
+  return errors;
+}
@@ -0,0 +1,210 @@
+/**
+ * \file facet_stitch.cpp
+ *
+ * \brief Tests of grouping facets into shells and merging their points
+ *
+ * Builds square tiles of two facets, each with its own points, so that
+ * split_into_shells makes a shell of each, and places them so that the
+ * points along the edges they share are apart by exactly tol or 3*tol,
+ * by just over 3*tol, or either side of the edge of a search cell.
+ * merge_coincident_vertices must merge the points up to 3*tol apart in
+ * each direction and no others, and join the shells they belong to.
+ * A grid of tiles with points moved at random, some of them too far to
+ * merge, must give the same shells and counts as the kd-tree search
+ * did, serially and on a CubitConcurrent pool.
+ */
+#include "FacetDataUtil.hpp"
+#include "CubitPointData.hpp"
+#include "CubitFacetData.hpp"
+#include "CubitQuadFacet.hpp"
+#include "CubitStdConcurrentApi.h"
+#include "DLIList.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+
+static unsigned int seed = 6007;
+static double next_random()
+{
+  seed = seed * 1103515245u + 12345u;
+  return (double)((seed >> 8) & 0xffff) / 65536.0;
+}
+
+// a power of two, so the offsets below are exact; the search cells are
+// 3*tol wide
+static const double tol = 1.0/1024;
+
+// the unit square tile with its lower corner at (x,y,z), in the plane
+// z = const, with each corner moved by offsets[corner] if given
+static void add_tile(DLIList<CubitFacet*>& facets, double x, double y, double z,
+                     const double (*offsets)[3] = NULL)
+{
+  CubitPoint* pts[4];
+  for(int i=0; i<4; i++)
+  {
+    double px = x + (i & 1), py = y + (i >> 1), pz = z;
+    if(offsets)
+    {
+      px += offsets[i][0];
+      py += offsets[i][1];
+      pz += offsets[i][2];
+    }
+    pts[i] = new CubitPointData(px, py, pz);
+  }
+  facets.append(new CubitFacetData(pts[0], pts[1], pts[3]));
+  facets.append(new CubitFacetData(pts[0], pts[3], pts[2]));
+}
+
+struct StitchResult
+{
+  int num_shells;
+  int npmerge;
+  int nemerge;
+  int unmerged;
+  std::vector<int> shell_sizes;
+
+  bool operator==(const StitchResult& other) const
+  {
+    return num_shells == other.num_shells && npmerge == other.npmerge &&
+           nemerge == other.nemerge && unmerged == other.unmerged &&
+           shell_sizes == other.shell_sizes;
+  }
+};
+
+// split the facets into shells and merge them, deleting the facets
+static StitchResult stitch(DLIList<CubitFacet*>& facets)
+{
+  DLIList<CubitQuadFacet*> quads;
+  DLIList<DLIList<CubitFacet*>*> shells;
+  CubitBoolean water_tight;
+  FacetDataUtil::split_into_shells(facets, quads, shells, water_tight);
+
+  StitchResult result;
+  DLIList<CubitPoint*> unmerged;
+  FacetDataUtil::merge_coincident_vertices(shells, tol, result.npmerge, result.nemerge,
+                                           unmerged);
+  result.num_shells = shells.size();
+  result.unmerged = unmerged.size();
+  for(int i=0; i<shells.size(); i++)
+    result.shell_sizes.push_back(shells.get_and_step()->size());
+  std::sort(result.shell_sizes.begin(), result.shell_sizes.end());
+  FacetDataUtil::delete_facets(shells);
+  return result;
+}
+
+static int check(const StitchResult& result, int num_shells, int npmerge, int nemerge,
+                 int unmerged, const char* name)
+{
+  if(result.num_shells == num_shells && result.npmerge == npmerge &&
+     result.nemerge == nemerge && result.unmerged == unmerged)
+    return 0;
+  fprintf(stderr, "%s: %d shells, %d points and %d edges merged, %d unmerged;"
+          " expected %d, %d, %d, %d\n", name, result.num_shells, result.npmerge,
+          result.nemerge, result.unmerged, num_shells, npmerge, nemerge, unmerged);
+  return 1;
+}
+
+// two tiles side by side in x, the second one moved by (dx,dy,dz); the
+// two points of the shared edge merge if the move is at most 3*tol in
+// each direction
+static int check_pair(double x, double dx, double dy, double dz, bool merge,
+                      const char* name)
+{
+  DLIList<CubitFacet*> facets;
+  add_tile(facets, x - 1, 0, 0);
+  add_tile(facets, x + dx, dy, dz);
+  StitchResult result = stitch(facets);
+  return merge ? check(result, 1, 2, 1, 4, name) : check(result, 2, 0, 0, 8, name);
+}
+
+int test_distances()
+{
+  int errors = 0;
+  errors += check_pair(1, 0, 0, 0, true, "coincident");
+  errors += check_pair(1, tol, 0, 0, true, "tol apart");
+  errors += check_pair(1, -tol, tol, -tol, true, "tol apart on each axis");
+  errors += check_pair(1, 3*tol, 0, 0, true, "3*tol apart");
+  errors += check_pair(1, 3*tol, -3*tol, 3*tol, true, "3*tol apart on each axis");
+  errors += check_pair(1, 3.25*tol, 0, 0, false, "just over 3*tol apart");
+  errors += check_pair(1, 0, 0, -3.25*tol, false, "just over 3*tol apart in z");
+  errors += check_pair(1, 2*tol, 3*tol, 3.25*tol, false, "just over 3*tol apart in one axis");
+  return errors;
+}
+
+// the shared edge on a cell boundary: 1023/1024 is exactly 341 cells
+int test_adjacent_cells()
+{
+  int errors = 0;
+  const double edge = 341*3*tol;
+  errors += check_pair(edge - 0.5*tol, tol, 0, 0, true, "either side of a cell face");
+  errors += check_pair(edge, -0.25*tol, 0, 0, true, "just inside the cell below");
+  errors += check_pair(edge - 2*tol, 3*tol, 0, 0, true, "3*tol across a cell face");
+  errors += check_pair(edge - 2*tol, 3.25*tol, 0, 0, false, "over 3*tol across a cell face");
+
+  // across a cell corner: the tiles' corner points are in cells
+  // diagonally apart in x, y and z
+  DLIList<CubitFacet*> facets;
+  add_tile(facets, edge - 1 - 0.5*tol, -0.5*tol, edge - 0.5*tol);
+  add_tile(facets, edge + 0.5*tol, 0.5*tol, edge + 0.5*tol);
+  errors += check(stitch(facets), 1, 2, 1, 4, "across a cell corner");
+  return errors;
+}
+
+// n by n tiles with their corners moved at random by up to tol on each
+// axis, and every seventh tile moved away by 6*tol in z
+static void make_grid(DLIList<CubitFacet*>& facets, int n)
+{
+  for(int j=0; j<n; j++)
+    for(int i=0; i<n; i++)
+    {
+      double offsets[4][3];
+      for(int c=0; c<4; c++)
+        for(int k=0; k<3; k++)
+          offsets[c][k] = tol*(2*next_random() - 1);
+      add_tile(facets, i, j, ((j*n + i) % 7 == 3) ? 6*tol : 0, offsets);
+    }
+}
+
+// the counts the kd-tree search in merge_coincident_vertices gave for
+// the grid, and the sizes of the shells after merging
+int test_grid()
+{
+  int errors = 0;
+  StitchResult results[2];
+  for(int concurrent=0; concurrent<2; concurrent++)
+  {
+    seed = 6007;
+    CubitStdConcurrent* pool = concurrent ? new CubitStdConcurrent(4) : NULL;
+    DLIList<CubitFacet*> facets;
+    make_grid(facets, 12);
+    results[concurrent] = stitch(facets);
+    delete pool;
+  }
+
+  // the 21 tiles moved away stay on their own
+  const StitchResult& result = results[0];
+  errors += check(result, 22, 324, 188, 101, "grid");
+  std::vector<int> sizes(21, 2);
+  sizes.push_back(246);
+  if(result.shell_sizes != sizes)
+  {
+    fprintf(stderr, "grid: the shells have the wrong numbers of facets\n");
+    errors++;
+  }
+  if(!(results[1] == result))
+  {
+    fprintf(stderr, "grid: the shells differ on the pool\n");
+    errors++;
+  }
+  return errors;
+}
+
+int main (int argc, char **argv)
+{
+  int errors = 0;
+  errors += test_distances();
+  errors += test_adjacent_cells();
+  errors += test_grid();
+  return errors;
+}
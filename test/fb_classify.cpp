@@ -0,0 +1,154 @@
+/**
+ * \file fb_classify.cpp
+ *
+ * \brief Tests of classifying facet boolean groups against the other body
+ *
+ * Each group is classified by the first triangle of the other body that
+ * a ray along the group's normal meets.  A large triangle whose centroid
+ * is far from the ray but which the ray meets first must win over a
+ * small one centred on the ray further along.  Groups between and in the
+ * planes of a stack of layers facing alternate ways must take the
+ * orientation of the layer above or the one they lie in, whichever
+ * triangle of a layer the ray meets, on its diagonal included.
+ */
+#include "FBClassify.hpp"
+#include "FBPolyhedron.hpp"
+#include "FBDefines.hpp"
+
+#include <vector>
+#include <cstdio>
+
+// the orientation of each group of the first body's triangles against
+// the second body
+static std::vector<int> classify(const std::vector<double>& coords1,
+                                 const std::vector<int>& conn1,
+                                 const std::vector<double>& coords2,
+                                 const std::vector<int>& conn2)
+{
+  FBPolyhedron poly1, poly2;
+  poly1.makepoly(coords1, conn1, NULL);
+  poly2.makepoly(coords2, conn2, NULL);
+  FBClassify classify;
+  classify.SetPoly(&poly1, &poly2);
+  std::vector<int> *group, *characterization;
+  if(classify.Group(1) != CUBIT_SUCCESS || classify.CharacterizeGroups(1, false) != CUBIT_SUCCESS)
+    return std::vector<int>();
+  classify.get_group(&group, &characterization);
+  return *characterization;
+}
+
+static void add_triangle(std::vector<double>& coords, std::vector<int>& conn,
+                         const double* p0, const double* p1, const double* p2)
+{
+  const double* p[3] = { p0, p1, p2 };
+  for(int i=0; i<3; i++)
+  {
+    conn.push_back((int)coords.size()/3);
+    coords.insert(coords.end(), p[i], p[i] + 3);
+  }
+}
+
+// a square in the plane z = const, facing up or down
+static void add_square(std::vector<double>& coords, std::vector<int>& conn,
+                       double x, double y, double z, double size, bool up)
+{
+  int first = (int)coords.size()/3;
+  const double corners[4][3] = { { x, y, z }, { x + size, y, z }, { x + size, y + size, z },
+                                 { x, y + size, z } };
+  for(int i=0; i<4; i++)
+    coords.insert(coords.end(), corners[i], corners[i] + 3);
+  const int tris[2][3] = { { 0, 1, 2 }, { 0, 2, 3 } };
+  for(int t=0; t<2; t++)
+    for(int k=0; k<3; k++)
+      conn.push_back(first + tris[t][up ? k : 2 - k]);
+}
+
+// a triangle at z = 0 facing up.  The ray from its centroid meets a large
+// triangle facing up at z = 1, whose centroid is more than 20 away, and
+// then a small one facing down at z = 5 centred on the ray.  The nearer
+// hit makes the triangle inside; the nearer centroid would make it outside
+int test_nearest_hit()
+{
+  std::vector<double> coords1, coords2;
+  std::vector<int> conn1, conn2;
+  const double a0[3] = { -0.1, -0.1, 0 }, a1[3] = { 0.2, -0.1, 0 }, a2[3] = { -0.1, 0.2, 0 };
+  add_triangle(coords1, conn1, a0, a1, a2);
+
+  const double b0[3] = { -2, -2, 1 }, b1[3] = { 60, -2, 1 }, b2[3] = { -2, 60, 1 };
+  add_triangle(coords2, conn2, b0, b1, b2);
+  const double c0[3] = { -0.5, -0.5, 5 }, c1[3] = { 0.5, -0.5, 5 }, c2[3] = { 0, 0.5, 5 };
+  add_triangle(coords2, conn2, c0, c2, c1);
+
+  std::vector<int> result = classify(coords1, conn1, coords2, conn2);
+  if(result.size() != 1 || result[0] != FB_ORIENTATION_INSIDE)
+  {
+    fprintf(stderr, "a triangle below a facing-up triangle is classified %d, expected %d\n",
+            result.empty() ? -99 : result[0], FB_ORIENTATION_INSIDE);
+    return 1;
+  }
+
+  // with the far triangle first in the list, and the near one facing down
+  coords2.clear();
+  conn2.clear();
+  add_triangle(coords2, conn2, c0, c1, c2);
+  add_triangle(coords2, conn2, b0, b2, b1);
+  result = classify(coords1, conn1, coords2, conn2);
+  if(result.size() != 1 || result[0] != FB_ORIENTATION_OUTSIDE)
+  {
+    fprintf(stderr, "a triangle below a facing-down triangle is classified %d, expected %d\n",
+            result.empty() ? -99 : result[0], FB_ORIENTATION_OUTSIDE);
+    return 1;
+  }
+  return 0;
+}
+
+// 100 squares at z = 1 to 100 facing alternately up and down, and small
+// separate triangles between them and in their planes, some of them
+// centred on the squares' diagonals
+int test_layers()
+{
+  std::vector<double> coords1, coords2;
+  std::vector<int> conn1, conn2;
+  const int num_layers = 100;
+  for(int k=1; k<=num_layers; k++)
+    add_square(coords2, conn2, 0, 0, k, 4, k % 2 == 0);
+
+  std::vector<int> expected;
+  for(int k=0; k<num_layers; k++)
+  {
+    double x = 1.0 + 0.02*k, y = (k % 3) ? 3.0 - 0.01*k : x;
+    double z = (k % 4 == 3) ? k : k + 0.5;
+    const double p0[3] = { x - 0.1, y - 0.1, z }, p1[3] = { x + 0.2, y - 0.1, z },
+                 p2[3] = { x - 0.1, y + 0.2, z };
+    add_triangle(coords1, conn1, p0, p1, p2);
+    if(z == k)   // in the plane of layer k, facing up like it or not
+      expected.push_back(k % 2 == 0 ? FB_ORIENTATION_SAME : FB_ORIENTATION_OPPOSITE);
+    else         // below layer k+1, inside it if it faces up
+      expected.push_back((k + 1) % 2 == 0 ? FB_ORIENTATION_INSIDE : FB_ORIENTATION_OUTSIDE);
+  }
+
+  std::vector<int> result = classify(coords1, conn1, coords2, conn2);
+  if(result.size() != expected.size())
+  {
+    fprintf(stderr, "%d groups classified, expected %d\n", (int)result.size(),
+            (int)expected.size());
+    return 1;
+  }
+  int errors = 0;
+  for(size_t i=0; i<result.size(); i++)
+    if(result[i] != expected[i])
+    {
+      fprintf(stderr, "triangle %d is classified %d, expected %d\n", (int)i, result[i],
+              expected[i]);
+      errors++;
+    }
+  return errors;
+}
+
+int main (int argc, char **argv)
+{
+  int errors = 0;
+  errors += test_nearest_hit();
+  errors += test_layers();
+  return errors;
+}
@@ -0,0 +1,156 @@
+/**
+ * \file fb_coord_hash.cpp
+ *
+ * \brief Tests of the facetbool coordinate hash
+ *
+ * Checks that FBCoordHash finds coordinates within tolerance that are
+ * stored under a neighbouring cell, across faces, edges and corners of
+ * the cells and either side of zero; that it returns the lowest index
+ * when several coordinates match; and that every coordinate is still
+ * found after the slot array has grown, compared with a search of all
+ * the coordinates.
+ */
+#include "FBCoordHash.hpp"
+
+#include <vector>
+#include <cmath>
+#include <cstdio>
+
+static unsigned int seed = 4093;
+static double next_random()
+{
+  seed = seed * 1103515245u + 12345u;
+  return (double)((seed >> 8) & 0xffff) / 65536.0;
+}
+
+// the cells are 1000 tolerances across
+static const double tol = 1.e-3;
+
+int check_find(const FBCoordHash& hash, double x, double y, double z,
+               int expected, const char* name)
+{
+  int found = hash.find(x, y, z);
+  if(found != expected)
+  {
+    fprintf(stderr, "%s: (%g %g %g) found %d, expected %d\n", name, x, y, z,
+            found, expected);
+    return 1;
+  }
+  return 0;
+}
+
+// a coordinate just to either side of a cell corner, looked for from
+// each of the eight cells around the corner
+int test_neighbour_cells()
+{
+  int errors = 0;
+  const double corners[3][3] = { { 1.0, 1.0, 1.0 }, { 0.0, 0.0, 0.0 }, { -2.0, 3.0, -1.0 } };
+  for(int c=0; c<3; c++)
+    for(int side=-1; side<=1; side+=2)
+    {
+      FBCoordHash hash(0, tol);
+      const double* corner = corners[c];
+      hash.insert(corner[0] + side*0.3*tol, corner[1] + side*0.3*tol,
+                  corner[2] + side*0.3*tol, 7);
+      for(int i=0; i<8; i++)
+      {
+        double qx = corner[0] + side*((i & 1) ? -0.6*tol : 0.1*tol);
+        double qy = corner[1] + side*((i & 2) ? -0.6*tol : 0.1*tol);
+        double qz = corner[2] + side*((i & 4) ? -0.6*tol : 0.1*tol);
+        errors += check_find(hash, qx, qy, qz, 7, "neighbour cell");
+      }
+      // beyond the tolerance in one direction only
+      errors += check_find(hash, corner[0] - side*0.8*tol, corner[1], corner[2], -1,
+                           "outside tolerance");
+      errors += check_find(hash, corner[0], corner[1] + side*1.4*tol, corner[2], -1,
+                           "outside tolerance");
+    }
+  return errors;
+}
+
+// the same and nearby coordinates added with indices in any order
+int test_lowest_index()
+{
+  int errors = 0;
+  FBCoordHash hash(0, tol);
+  hash.insert(0.5, 0.5, 0.5, 12);
+  hash.insert(0.5, 0.5, 0.5, 5);
+  hash.insert(0.5, 0.5, 0.5, 9);
+  errors += check_find(hash, 0.5, 0.5, 0.5, 5, "duplicates");
+
+  // a lower index across the cell boundary from the query
+  hash.insert(1.0 - 0.2*tol, 0.5, 0.5, 30);
+  hash.insert(1.0 + 0.2*tol, 0.5, 0.5, 20);
+  hash.insert(1.0 - 0.4*tol, 0.5, 0.5, 3);
+  errors += check_find(hash, 1.0 + 0.1*tol, 0.5, 0.5, 3, "duplicates across cells");
+  errors += check_find(hash, 1.0 + 0.7*tol, 0.5, 0.5, 20, "duplicates across cells");
+  return errors;
+}
+
+// the lowest index within tolerance of (x,y,z) among all the coordinates
+static int search_all(const std::vector<double>& coords, double x, double y, double z)
+{
+  int found = -1;
+  for(size_t i=0; i<coords.size()/3; i++)
+    if(fabs(coords[3*i] - x) < tol && fabs(coords[3*i+1] - y) < tol &&
+       fabs(coords[3*i+2] - z) < tol && (found == -1 || (int)i < found))
+      found = (int)i;
+  return found;
+}
+
+// add coordinates one at a time from an empty and from a reserved table,
+// many of them near others or near cell boundaries, and check them all at
+// sizes either side of each regrowth
+int test_regrowth(int reserved)
+{
+  int errors = 0;
+  FBCoordHash hash(reserved, tol);
+  std::vector<double> coords;
+  int next_check = 16;
+  for(int n=0; n<3000; n++)
+  {
+    double p[3];
+    int near = n ? (int)(seed % n) : 0;
+    for(int k=0; k<3; k++)
+    {
+      if(n % 2)
+        p[k] = coords[3*near + k] + 3*tol*(next_random() - 0.5);
+      else if(n % 3 == 0)
+        p[k] = floor(8*next_random() - 4) + 2*tol*(next_random() - 0.5);
+      else
+        p[k] = 8*next_random() - 4;
+    }
+    hash.insert(p[0], p[1], p[2], n);
+    coords.insert(coords.end(), p, p + 3);
+
+    if(n + 1 == next_check || n + 1 == next_check + 1 || n == 2999)
+    {
+      for(size_t i=0; i<coords.size()/3; i++)
+      {
+        double x = coords[3*i] + tol*(next_random() - 0.5);
+        double y = coords[3*i+1] + tol*(next_random() - 0.5);
+        double z = coords[3*i+2] + tol*(next_random() - 0.5);
+        int expected = search_all(coords, x, y, z);
+        if(hash.find(x, y, z) != expected)
+        {
+          fprintf(stderr, "after %d coordinates, (%g %g %g) found %d, expected %d\n",
+                  n + 1, x, y, z, hash.find(x, y, z), expected);
+          errors++;
+        }
+      }
+      if(n + 1 == next_check + 1)
+        next_check *= 2;
+    }
+  }
+  return errors;
+}
+
+int main (int argc, char **argv)
+{
+  int errors = 0;
+  errors += test_neighbour_cells();
+  errors += test_lowest_index();
+  errors += test_regrowth(0);
+  errors += test_regrowth(3000);
+  return errors;
+}
@@ -0,0 +1,205 @@
+/**
+ * \file fb_intersect.cpp
+ *
+ * \brief Tests of intersecting facet boolean bodies on the CubitConcurrent pool
+ *
+ * Intersects two overlapping spheres, and two bricks whose faces lie in
+ * the same planes, with no pool and on a pool of four threads.  The
+ * triangle pairs are intersected in ranges on the pool, so the new
+ * points, the intersection edges, the retriangulated facets and the
+ * results of each boolean must be the same either way, and in the same
+ * order.
+ */
+#include "FBIntersect.hpp"
+#include "CubitStdConcurrentApi.h"
+
+#include <vector>
+#include <map>
+#include <cmath>
+#include <cstdio>
+
+// a sphere of rings and segments about the z axis, outward facing
+static void make_sphere(double radius, const double* center, int rings, int segments,
+                        std::vector<double>& coords, std::vector<int>& conn)
+{
+  coords.push_back(center[0]); coords.push_back(center[1]); coords.push_back(center[2] - radius);
+  for(int i=1; i<rings; i++)
+  {
+    double theta = M_PI*i/rings;
+    for(int j=0; j<segments; j++)
+    {
+      double phi = 2*M_PI*j/segments;
+      coords.push_back(center[0] + radius*sin(theta)*cos(phi));
+      coords.push_back(center[1] + radius*sin(theta)*sin(phi));
+      coords.push_back(center[2] - radius*cos(theta));
+    }
+  }
+  coords.push_back(center[0]); coords.push_back(center[1]); coords.push_back(center[2] + radius);
+  int top = (int)coords.size()/3 - 1;
+
+  for(int j=0; j<segments; j++)
+  {
+    int j1 = (j + 1) % segments;
+    conn.push_back(0); conn.push_back(1 + j1); conn.push_back(1 + j);
+    for(int i=1; i<rings-1; i++)
+    {
+      int a = 1 + (i-1)*segments, b = 1 + i*segments;
+      conn.push_back(a + j); conn.push_back(a + j1); conn.push_back(b + j1);
+      conn.push_back(a + j); conn.push_back(b + j1); conn.push_back(b + j);
+    }
+    int last = 1 + (rings-2)*segments;
+    conn.push_back(last + j); conn.push_back(last + j1); conn.push_back(top);
+  }
+}
+
+// a brick with each side split into n by n squares of two outward
+// facing triangles, sharing its points with the sides next to it
+static void make_brick(const double* lo, const double* hi, int n, std::vector<double>& coords,
+                       std::vector<int>& conn)
+{
+  std::map<int, int> points;   // grid point (i,j,k) to point index
+  for(int side=0; side<6; side++)
+  {
+    int axis = side/2, u = (axis + 1) % 3, v = (axis + 2) % 3;
+    bool high = side % 2;
+    int corner[4];
+    for(int a=0; a<n; a++)
+      for(int b=0; b<n; b++)
+      {
+        const int du[4] = { 0, 1, 1, 0 }, dv[4] = { 0, 0, 1, 1 };
+        for(int c=0; c<4; c++)
+        {
+          int ijk[3];
+          ijk[axis] = high ? n : 0;
+          ijk[u] = a + du[c];
+          ijk[v] = b + dv[c];
+          int key = (ijk[0]*(n+1) + ijk[1])*(n+1) + ijk[2];
+          std::map<int, int>::iterator found = points.find(key);
+          if(found == points.end())
+          {
+            found = points.insert(std::make_pair(key, (int)coords.size()/3)).first;
+            for(int k=0; k<3; k++)
+              coords.push_back(lo[k] + (hi[k] - lo[k])*ijk[k]/n);
+          }
+          corner[c] = found->second;
+        }
+        // u, v, axis is right handed, so the corners in order face +axis
+        const int tris[2][3] = { { 0, 1, 2 }, { 0, 2, 3 } };
+        for(int t=0; t<2; t++)
+          for(int k=0; k<3; k++)
+            conn.push_back(corner[tris[t][high ? k : 2 - k]]);
+      }
+  }
+}
+
+// everything intersect and the booleans give for a pair of bodies
+struct IntersectResult
+{
+  std::vector<int> dudded1, dudded2, facets1, facets2, index1, index2, edges1, edges2;
+  std::vector<double> points1, points2;
+  std::vector<double> out_coords[3];
+  std::vector<int> out_conn[3];
+};
+
+static void intersect(const std::vector<double>& coords1, const std::vector<int>& conn1,
+                      const std::vector<double>& coords2, const std::vector<int>& conn2,
+                      IntersectResult& result)
+{
+  FBIntersect edges;
+  edges.intersect(coords1, conn1, coords2, conn2, result.dudded1, result.dudded2,
+                  result.facets1, result.facets2, result.index1, result.index2,
+                  result.points1, result.points2, result.edges1, result.edges2);
+
+  const CubitFacetboolOp ops[3] = { CUBIT_FB_UNION, CUBIT_FB_INTERSECTION,
+                                    CUBIT_FB_SUBTRACTION };
+  for(int op=0; op<3; op++)
+  {
+    FBIntersect boolean;
+    boolean.set_classify_flag(true);
+    std::vector<int> new_facets1, new_facets2;
+    boolean.intersect(coords1, conn1, coords2, conn2, new_facets1, new_facets2, NULL, NULL);
+    boolean.gather_by_boolean(result.out_coords[op], result.out_conn[op], NULL, NULL, NULL,
+                              ops[op]);
+  }
+}
+
+template <class T>
+static int compare(const std::vector<T>& serial, const std::vector<T>& concurrent,
+                   const char* what, const char* name)
+{
+  if(serial == concurrent)
+    return 0;
+  fprintf(stderr, "%s: %d %s serially, %d on the pool, or in another order\n", name,
+          (int)serial.size(), what, (int)concurrent.size());
+  return 1;
+}
+
+static int check_pair(const std::vector<double>& coords1, const std::vector<int>& conn1,
+                      const std::vector<double>& coords2, const std::vector<int>& conn2,
+                      const char* name)
+{
+  IntersectResult results[2];
+  for(int concurrent=0; concurrent<2; concurrent++)
+  {
+    CubitStdConcurrent* pool = concurrent ? new CubitStdConcurrent(4) : NULL;
+    intersect(coords1, conn1, coords2, conn2, results[concurrent]);
+    delete pool;
+  }
+
+  const IntersectResult &serial = results[0], &concurrent = results[1];
+  int errors = 0;
+  if(serial.edges1.empty() || serial.edges2.empty() || serial.out_conn[0].empty())
+  {
+    fprintf(stderr, "%s: the bodies do not intersect\n", name);
+    errors++;
+  }
+  errors += compare(serial.points1, concurrent.points1, "new points on the first body", name);
+  errors += compare(serial.points2, concurrent.points2, "new points on the second body", name);
+  errors += compare(serial.edges1, concurrent.edges1, "edges on the first body", name);
+  errors += compare(serial.edges2, concurrent.edges2, "edges on the second body", name);
+  errors += compare(serial.dudded1, concurrent.dudded1, "dudded facets on the first body", name);
+  errors += compare(serial.dudded2, concurrent.dudded2, "dudded facets on the second body", name);
+  errors += compare(serial.facets1, concurrent.facets1, "new facets on the first body", name);
+  errors += compare(serial.facets2, concurrent.facets2, "new facets on the second body", name);
+  errors += compare(serial.index1, concurrent.index1, "facet indices on the first body", name);
+  errors += compare(serial.index2, concurrent.index2, "facet indices on the second body", name);
+  const char* ops[3] = { "union coordinates", "intersection coordinates",
+                         "subtraction coordinates" };
+  for(int op=0; op<3; op++)
+  {
+    errors += compare(serial.out_coords[op], concurrent.out_coords[op], ops[op], name);
+    errors += compare(serial.out_conn[op], concurrent.out_conn[op], "triangle corners", name);
+  }
+  return errors;
+}
+
+int test_spheres()
+{
+  std::vector<double> coords1, coords2;
+  std::vector<int> conn1, conn2;
+  const double center1[3] = { 0, 0, 0 }, center2[3] = { 0.7, 0.123, 0.0456 };
+  make_sphere(1.0, center1, 24, 48, coords1, conn1);
+  make_sphere(0.8, center2, 20, 40, coords2, conn2);
+  return check_pair(coords1, conn1, coords2, conn2, "spheres");
+}
+
+// the second brick shares the first's top and bottom planes, so those
+// faces are intersected as coplanar triangles
+int test_coplanar_bricks()
+{
+  std::vector<double> coords1, coords2;
+  std::vector<int> conn1, conn2;
+  const double lo1[3] = { 0, 0, 0 }, hi1[3] = { 1, 1, 1 };
+  const double lo2[3] = { 0.5, 0.25, 0 }, hi2[3] = { 1.5, 0.75, 1 };
+  make_brick(lo1, hi1, 8, coords1, conn1);
+  make_brick(lo2, hi2, 6, coords2, conn2);
+  return check_pair(coords1, conn1, coords2, conn2, "coplanar bricks");
+}
+
+int main (int argc, char **argv)
+{
+  int errors = 0;
+  errors += test_spheres();
+  errors += test_coplanar_bricks();
+  return errors;
+}
@@ -0,0 +1,186 @@
+/**
+ * \file fb_kdtree.cpp
+ *
+ * \brief Tests of the facetbool KDTree searches
+ *
+ * Builds trees of small random triangles' boxes around 1000, where floats
+ * are spaced about 6e-5 apart, and fires rays and searches with boxes
+ * through each triangle's extreme vertices.  Every search must find the
+ * triangle, however its box rounds to the tree's floats, and must find
+ * no box it does not reach.  Walking a ray through the boxes nearest
+ * first must give the boxes the ray passes through in the order it
+ * enters them, and stop at the limit.
+ */
+#include "KdTree.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+static unsigned int seed = 65521;
+static double next_random()
+{
+  seed = seed * 1103515245u + 12345u;
+  return (double)((seed >> 8) & 0xffff) / 65536.0;
+}
+
+// fire a ray through an extreme vertex of each triangle from each of a
+// few directions and look for the triangle among the hits
+int test_extreme_vertices(double offset)
+{
+  const int num_tris = 500;
+  std::vector<double> verts(9*num_tris);
+  std::vector<FSBoundingBox> boxes(num_tris);
+  FSBOXVECTOR boxlist;
+  for(int i=0; i<num_tris; i++)
+  {
+    double* v = &verts[9*i];
+    for(int k=0; k<3; k++)
+    {
+      double center = offset + 10*next_random();
+      for(int j=0; j<3; j++)
+        v[3*j + k] = center + 0.1*next_random() + 1e-9*next_random();
+    }
+    FSBoundingBox& box = boxes[i];
+    box.xmin = box.ymin = box.zmin = 1e30;
+    box.xmax = box.ymax = box.zmax = -1e30;
+    for(int j=0; j<3; j++)
+    {
+      box.xmin = std::min(box.xmin, v[3*j]); box.xmax = std::max(box.xmax, v[3*j]);
+      box.ymin = std::min(box.ymin, v[3*j+1]); box.ymax = std::max(box.ymax, v[3*j+1]);
+      box.zmin = std::min(box.zmin, v[3*j+2]); box.zmax = std::max(box.zmax, v[3*j+2]);
+    }
+    boxlist.push_back(&box);
+  }
+
+  KDTree tree;
+  tree.makeKDTree(num_tris, boxlist);
+
+  int errors = 0;
+  std::vector<int> hits;
+  const double dirs[4][3] = { { 1, 0, 0 }, { 0, -1, 0 }, { 0.3, -0.5, 1 }, { -1, -1, -1 } };
+  for(int i=0; i<num_tris; i++)
+    for(int j=0; j<3; j++)
+    {
+      const double* v = &verts[9*i + 3*j];
+      for(int d=0; d<4; d++)
+      {
+        double start[3] = { v[0] - 5*dirs[d][0], v[1] - 5*dirs[d][1], v[2] - 5*dirs[d][2] };
+        tree.ray_kdtree_intersect(start, dirs[d], hits);
+        if(std::find(hits.begin(), hits.end(), i) == hits.end())
+        {
+          fprintf(stderr, "a ray through vertex %d of triangle %d near %g misses it\n",
+                  j, i, offset);
+          errors++;
+        }
+      }
+
+      FSBoundingBox point(v[0], v[1], v[2], v[0], v[1], v[2]);
+      tree.box_kdtree_intersect(point, hits);
+      if(std::find(hits.begin(), hits.end(), i) == hits.end())
+      {
+        fprintf(stderr, "a box at vertex %d of triangle %d near %g misses it\n",
+                j, i, offset);
+        errors++;
+      }
+    }
+
+  // a box clear of every triangle finds none
+  FSBoundingBox outside(offset - 1, offset - 1, offset - 1, offset - 0.5, offset - 0.5,
+                        offset - 0.5);
+  tree.box_kdtree_intersect(outside, hits);
+  if(!hits.empty())
+  {
+    fprintf(stderr, "a box clear of the triangles finds %d\n", (int)hits.size());
+    errors++;
+  }
+  return errors;
+}
+
+// walk rays through the boxes nearest first, with no limit and with the
+// limit at the middle box entered, and compare with the boxes found by
+// ray_kdtree_intersect
+int test_nearest_first()
+{
+  const int num_boxes = 2000;
+  std::vector<FSBoundingBox> boxes(num_boxes);
+  FSBOXVECTOR boxlist;
+  for(int i=0; i<num_boxes; i++)
+  {
+    double x = 10*next_random(), y = 10*next_random(), z = 10*next_random();
+    double size = 0.05 + 0.5*next_random();
+    boxes[i] = FSBoundingBox(x, y, z, x + size, y + size*next_random(), z + size);
+    boxlist.push_back(&boxes[i]);
+  }
+  KDTree tree;
+  tree.makeKDTree(num_boxes, boxlist);
+
+  int errors = 0;
+  std::vector<int> hits, walked, within;
+  std::vector<double> entries;
+  KDTreeRay ray;
+  for(int r=0; r<200; r++)
+  {
+    double start[3] = { 12*next_random() - 1, 12*next_random() - 1, 12*next_random() - 1 };
+    double dir[3] = { next_random() - 0.5, next_random() - 0.5, (r % 5) ? next_random() - 0.5 : 0 };
+    tree.ray_kdtree_intersect(start, dir, hits);
+    std::sort(hits.begin(), hits.end());
+
+    walked.clear();
+    entries.clear();
+    double entry;
+    int box;
+    tree.ray_kdtree_first(start, dir, ray);
+    while((box = tree.ray_kdtree_next(ray, 1e30, entry)) >= 0)
+    {
+      if(!entries.empty() && entry < entries.back())
+      {
+        fprintf(stderr, "ray %d enters box %d at %g, before the box walked before it\n",
+                r, box, entry);
+        errors++;
+      }
+      walked.push_back(box);
+      entries.push_back(entry);
+    }
+    std::vector<int> sorted(walked);
+    std::sort(sorted.begin(), sorted.end());
+    if(sorted != hits)
+    {
+      fprintf(stderr, "ray %d walks %d boxes, it passes through %d\n", r,
+              (int)walked.size(), (int)hits.size());
+      errors++;
+    }
+    if(walked.empty())
+      continue;
+
+    // a limit walks the boxes entered up to it and no further
+    double limit = entries[entries.size()/2];
+    within.clear();
+    tree.ray_kdtree_first(start, dir, ray);
+    while((box = tree.ray_kdtree_next(ray, limit, entry)) >= 0)
+      within.push_back(box);
+    size_t expected = 0;
+    while(expected < entries.size() && entries[expected] <= limit)
+      expected++;
+    std::sort(within.begin(), within.end());
+    sorted.assign(walked.begin(), walked.begin() + expected);
+    std::sort(sorted.begin(), sorted.end());
+    if(within != sorted)
+    {
+      fprintf(stderr, "ray %d walks %d boxes within %g, expected %d\n", r,
+              (int)within.size(), limit, (int)expected);
+      errors++;
+    }
+  }
+  return errors;
+}
+
+int main (int argc, char **argv)
+{
+  int errors = 0;
+  errors += test_extreme_vertices(1000.0);
+  errors += test_extreme_vertices(-1000.0);
+  errors += test_nearest_first();
+  return errors;
+}
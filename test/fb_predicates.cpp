@@ -0,0 +1,195 @@
+/**
+ * \file fb_predicates.cpp
+ *
+ * \brief Tests of the facetbool orientation predicates
+ *
+ * Checks the signs of FBPredicates::orient2d and orient3d on grids of
+ * points a few units in the last place either side of a line or plane,
+ * where the plain floating-point determinant often has the wrong sign;
+ * on exactly collinear and coplanar points with large coordinates, which
+ * must give zero; and on points just off a line or plane that the old
+ * EPSILON and EPSILON2 tests took to be on it.
+ */
+#include "FBPredicates.hpp"
+#include "FBDefines.hpp"
+
+#include <cmath>
+#include <cstdio>
+
+static int sign(double value)
+{
+  return (value > 0.0) - (value < 0.0);
+}
+
+static double naive_orient2d(const double *pa, const double *pb, const double *pc)
+{
+  return (pa[0]-pc[0])*(pb[1]-pc[1]) - (pa[1]-pc[1])*(pb[0]-pc[0]);
+}
+
+static double naive_orient3d(const double *pa, const double *pb, const double *pc,
+                             const double *pd)
+{
+  double adx = pa[0]-pd[0], ady = pa[1]-pd[1], adz = pa[2]-pd[2];
+  double bdx = pb[0]-pd[0], bdy = pb[1]-pd[1], bdz = pb[2]-pd[2];
+  double cdx = pc[0]-pd[0], cdy = pc[1]-pd[1], cdz = pc[2]-pd[2];
+  return adz*(bdx*cdy - cdx*bdy) + bdz*(cdx*ady - adx*cdy) + cdz*(adx*bdy - bdx*ady);
+}
+
+// points (0.5 + i*u, 0.5 + j*u), u the spacing of doubles just under 1,
+// against the line y = x through (12,12) and (24,24); the exact sign is
+// that of j - i
+int test_orient2d_grid()
+{
+  const double u = ldexp(1.0, -53);
+  const double pb[2] = { 12.0, 12.0 }, pc[2] = { 24.0, 24.0 };
+  int errors = 0, naive_wrong = 0;
+  for(int i=0; i<64; i++)
+    for(int j=0; j<64; j++)
+    {
+      double pa[2] = { 0.5 + i*u, 0.5 + j*u };
+      int expected = (j > i) - (j < i);
+      if(sign(naive_orient2d(pa, pb, pc)) != expected)
+        naive_wrong++;
+      if(sign(FBPredicates::orient2d(pa, pb, pc)) != expected ||
+         sign(FBPredicates::orient2d(pb, pa, pc)) != -expected)
+      {
+        fprintf(stderr, "orient2d has the wrong sign at grid point %d %d\n", i, j);
+        errors++;
+      }
+    }
+  if(naive_wrong == 0)
+  {
+    fprintf(stderr, "the orient2d grid is not close enough to the line\n");
+    errors++;
+  }
+  return errors;
+}
+
+// as above against the plane x = z; a, b, c are counterclockwise seen
+// from x > z, so the exact sign is that of dx - dz
+int test_orient3d_grid()
+{
+  const double u = ldexp(1.0, -53);
+  const double pa[3] = { 12.0, 0.0, 12.0 }, pb[3] = { 24.0, 0.0, 24.0 },
+               pc[3] = { 12.0, 24.0, 12.0 };
+  int errors = 0, naive_wrong = 0;
+  for(int i=0; i<64; i++)
+    for(int j=0; j<64; j++)
+    {
+      double pd[3] = { 0.5 + i*u, 0.5 + (i^j)*u, 0.5 + j*u };
+      int expected = (i > j) - (i < j);
+      if(sign(naive_orient3d(pa, pb, pc, pd)) != expected)
+        naive_wrong++;
+      if(sign(FBPredicates::orient3d(pa, pb, pc, pd)) != expected ||
+         sign(FBPredicates::orient3d(pb, pa, pc, pd)) != -expected)
+      {
+        fprintf(stderr, "orient3d has the wrong sign at grid point %d %d\n", i, j);
+        errors++;
+      }
+    }
+  if(naive_wrong == 0)
+  {
+    fprintf(stderr, "the orient3d grid is not close enough to the plane\n");
+    errors++;
+  }
+  return errors;
+}
+
+// integer points on y = 3x + 1 and z = 2x + 3y + 1, large enough that the
+// products in the determinants are rounded but every coordinate is exact
+int test_exact_zero()
+{
+  int errors = 0;
+  const double xs[5] = { 1.0e15, -7.0e14, 3.0, 123456789.0, -2.5e14 + 1.0 };
+  for(int i=0; i<5; i++)
+    for(int j=0; j<5; j++)
+      for(int k=0; k<5; k++)
+      {
+        double pa[2] = { xs[i], 3*xs[i] + 1 }, pb[2] = { xs[j], 3*xs[j] + 1 },
+               pc[2] = { xs[k], 3*xs[k] + 1 };
+        if(FBPredicates::orient2d(pa, pb, pc) != 0.0)
+        {
+          fprintf(stderr, "collinear points %d %d %d have orient2d %g\n", i, j, k,
+                  FBPredicates::orient2d(pa, pb, pc));
+          errors++;
+        }
+      }
+
+  const double ps[5][2] = { { 1.0e14, 2.0e14 }, { -3.0e14, 1.0 }, { 7.0, -5.0e13 },
+                            { 123456789.0, 987654321.0 }, { -1.0e14, -1.0e14 } };
+  double pt[5][3];
+  for(int i=0; i<5; i++)
+  {
+    pt[i][0] = ps[i][0]; pt[i][1] = ps[i][1];
+    pt[i][2] = 2*ps[i][0] + 3*ps[i][1] + 1;
+  }
+  for(int i=0; i<5; i++)
+    for(int j=0; j<5; j++)
+    {
+      double value = FBPredicates::orient3d(pt[i], pt[j], pt[(i+2)%5], pt[(j+3)%5]);
+      if(value != 0.0)
+      {
+        fprintf(stderr, "coplanar points %d %d have orient3d %g\n", i, j, value);
+        errors++;
+      }
+    }
+  return errors;
+}
+
+// points off a line or plane by less than the old tolerances must still
+// be on the right side of it
+int test_old_tolerances()
+{
+  int errors = 0;
+
+  // FBRetriangulate took segments at an angle below about sqrt(EPSILON2)
+  // to cross; these two never meet, and each has both ends of the other
+  // on one side
+  const double s0[2] = { 0.0, 0.0 }, s1[2] = { 1.0, 0.0 };
+  const double s2[2] = { 0.0, 1.0e-9 }, s3[2] = { 1.0, 2.0e-9 };
+  if(FBPredicates::orient2d(s0, s1, s2) <= 0.0 || FBPredicates::orient2d(s0, s1, s3) <= 0.0 ||
+     FBPredicates::orient2d(s2, s3, s0) >= 0.0 || FBPredicates::orient2d(s2, s3, s1) >= 0.0)
+  {
+    fprintf(stderr, "nearly parallel segments are taken to cross\n");
+    errors++;
+  }
+
+  // FBIntersect took points within EPSILON2 of a triangle's plane to be on it
+  const double pa[3] = { 0.0, 0.0, 0.0 }, pb[3] = { 1.0, 0.0, 0.0 }, pc[3] = { 0.0, 1.0, 0.0 };
+  for(int i=-3; i<=3; i++)
+  {
+    double pd[3] = { 0.25, 0.25, i*0.1*EPSILON2 };
+    int expected = (i < 0) - (i > 0);
+    if(sign(FBPredicates::orient3d(pa, pb, pc, pd)) != expected)
+    {
+      fprintf(stderr, "a point %g from the plane has orient3d %g\n", pd[2],
+              FBPredicates::orient3d(pa, pb, pc, pd));
+      errors++;
+    }
+  }
+
+  // FBClassify took a ray within EPSILON of a needle triangle's edge to
+  // hit it; this one passes outside
+  const double ra[3] = { 0.0, 0.0, -1.0 }, rb[3] = { 0.0, 0.0, 1.0 };
+  const double ta[3] = { -1.0, 1.0e-9, 0.0 }, tb[3] = { 1.0, 1.0e-9, 0.0 },
+               tc[3] = { 0.0, 2.0e-9, 0.0 };
+  double o0 = FBPredicates::orient3d(ra, rb, ta, tb);
+  double o1 = FBPredicates::orient3d(ra, rb, tb, tc);
+  double o2 = FBPredicates::orient3d(ra, rb, tc, ta);
+  if( (o0 >= 0.0 && o1 >= 0.0 && o2 >= 0.0) || (o0 <= 0.0 && o1 <= 0.0 && o2 <= 0.0) )
+  {
+    fprintf(stderr, "a ray beside a needle triangle is taken to hit it\n");
+    errors++;
+  }
+  return errors;
+}
+
+int main (int argc, char **argv)
+{
+  int errors = 0;
+  errors += test_orient2d_grid();
+  errors += test_orient3d_grid();
+  errors += test_exact_zero();
+  errors += test_old_tolerances();
+  return errors;
+}
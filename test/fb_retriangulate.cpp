@@ -0,0 +1,197 @@
+/**
+ * \file fb_retriangulate.cpp
+ *
+ * \brief Tests of retriangulating intersected facet boolean triangles on
+ * the CubitConcurrent pool
+ *
+ * Cuts a flat grid of triangles with a sphere, with no pool and on a pool
+ * of four threads.  The triangles the sphere crosses are retriangulated
+ * in ranges, and the new facets must come back grouped in the order of
+ * the triangles they replace, as if retriangulated one by one: each group
+ * must lie in its triangle and cover it.  The facets, groups and new
+ * points must be the same on the pool as with no pool.
+ */
+#include "FBIntersect.hpp"
+#include "CubitStdConcurrentApi.h"
+#include "CubitVector.hpp"
+
+#include <vector>
+#include <cmath>
+#include <cstdio>
+
+// a flat n by n grid over [-size,size]^2 at z = 0, facing up
+static void make_plate(double size, int n, std::vector<double>& coords, std::vector<int>& conn)
+{
+  for(int j=0; j<=n; j++)
+    for(int i=0; i<=n; i++)
+    {
+      coords.push_back(-size + 2*size*i/n);
+      coords.push_back(-size + 2*size*j/n);
+      coords.push_back(0.0);
+    }
+  for(int j=0; j<n; j++)
+    for(int i=0; i<n; i++)
+    {
+      int p = j*(n+1) + i;
+      conn.push_back(p); conn.push_back(p + 1); conn.push_back(p + n + 2);
+      conn.push_back(p); conn.push_back(p + n + 2); conn.push_back(p + n + 1);
+    }
+}
+
+// a sphere of rings and segments about the z axis, outward facing
+static void make_sphere(double radius, const double* center, int rings, int segments,
+                        std::vector<double>& coords, std::vector<int>& conn)
+{
+  coords.push_back(center[0]); coords.push_back(center[1]); coords.push_back(center[2] - radius);
+  for(int i=1; i<rings; i++)
+  {
+    double theta = M_PI*i/rings;
+    for(int j=0; j<segments; j++)
+    {
+      double phi = 2*M_PI*j/segments;
+      coords.push_back(center[0] + radius*sin(theta)*cos(phi));
+      coords.push_back(center[1] + radius*sin(theta)*sin(phi));
+      coords.push_back(center[2] - radius*cos(theta));
+    }
+  }
+  coords.push_back(center[0]); coords.push_back(center[1]); coords.push_back(center[2] + radius);
+  int top = (int)coords.size()/3 - 1;
+
+  for(int j=0; j<segments; j++)
+  {
+    int j1 = (j + 1) % segments;
+    conn.push_back(0); conn.push_back(1 + j1); conn.push_back(1 + j);
+    for(int i=1; i<rings-1; i++)
+    {
+      int a = 1 + (i-1)*segments, b = 1 + i*segments;
+      conn.push_back(a + j); conn.push_back(a + j1); conn.push_back(b + j1);
+      conn.push_back(a + j); conn.push_back(b + j1); conn.push_back(b + j);
+    }
+    int last = 1 + (rings-2)*segments;
+    conn.push_back(last + j); conn.push_back(last + j1); conn.push_back(top);
+  }
+}
+
+// what retriangulating one body gives
+struct BodyResult
+{
+  std::vector<int> dudded, facets, index;
+  std::vector<double> points;
+
+  bool operator==(const BodyResult& other) const
+  {
+    return dudded == other.dudded && facets == other.facets && index == other.index &&
+           points == other.points;
+  }
+};
+
+// a point of the body's facets: one of its own, or one intersecting made
+static CubitVector facet_point(const std::vector<double>& coords, const BodyResult& result,
+                               int vert)
+{
+  int num_verts = (int)coords.size()/3;
+  if(vert < num_verts)
+    return CubitVector(&coords[3*vert]);
+  return CubitVector(&result.points[3*(vert - num_verts)]);
+}
+
+// the groups of new facets follow the dudded triangles in order, and
+// each group lies in and covers its triangle
+static int check_groups(const std::vector<double>& coords, const std::vector<int>& conn,
+                        const BodyResult& result, const char* name)
+{
+  int num_groups = (int)result.dudded.size();
+  if(num_groups < 32 || (int)result.index.size() != num_groups + 1 || result.index[0] != 0 ||
+     result.index[num_groups] != (int)result.facets.size())
+  {
+    fprintf(stderr, "%s: %d triangles retriangulated into %d groups of %d corners\n", name,
+            num_groups, (int)result.index.size() - 1, (int)result.facets.size());
+    return 1;
+  }
+
+  int errors = 0;
+  for(int g=0; g<num_groups; g++)
+  {
+    int tri = result.dudded[g];
+    if(g > 0 && tri <= result.dudded[g-1])
+    {
+      fprintf(stderr, "%s: triangle %d is retriangulated after triangle %d\n", name, tri,
+              result.dudded[g-1]);
+      errors++;
+    }
+    CubitVector a(&coords[3*conn[3*tri]]), b(&coords[3*conn[3*tri+1]]),
+                c(&coords[3*conn[3*tri+2]]);
+    CubitVector normal = (b - a) * (c - a);
+    double area = normal.length();
+    normal /= area;
+
+    double group_area = 0.0;
+    bool outside = false;
+    for(int f=result.index[g]; f<result.index[g+1]; f += 3)
+    {
+      CubitVector p0 = facet_point(coords, result, result.facets[f]),
+                  p1 = facet_point(coords, result, result.facets[f+1]),
+                  p2 = facet_point(coords, result, result.facets[f+2]);
+      group_area += ((p1 - p0) * (p2 - p0)).length();
+      CubitVector centroid = (p0 + p1 + p2) / 3.0;
+      double height = (centroid - a) % normal;
+      if(fabs(height) > 1e-9 || ((b - a) * (centroid - a)) % normal < -1e-12 ||
+         ((c - b) * (centroid - b)) % normal < -1e-12 ||
+         ((a - c) * (centroid - c)) % normal < -1e-12)
+        outside = true;
+    }
+    if(outside || fabs(group_area - area) > 1e-9*area)
+    {
+      fprintf(stderr, "%s: group %d does not cover triangle %d\n", name, g, tri);
+      errors++;
+    }
+  }
+  return errors;
+}
+
+int test_plate_and_sphere()
+{
+  std::vector<double> coords1, coords2;
+  std::vector<int> conn1, conn2;
+  const double center[3] = { 0.0123, 0.0456, 0.3 };
+  make_plate(1.5, 40, coords1, conn1);
+  make_sphere(1.0, center, 24, 48, coords2, conn2);
+
+  BodyResult results[2][2];
+  int errors = 0;
+  for(int concurrent=0; concurrent<2; concurrent++)
+  {
+    CubitStdConcurrent* pool = concurrent ? new CubitStdConcurrent(4) : NULL;
+    BodyResult &plate = results[concurrent][0], &sphere = results[concurrent][1];
+    std::vector<int> edges1, edges2;
+    FBIntersect intersector;
+    if(intersector.intersect(coords1, conn1, coords2, conn2, plate.dudded, sphere.dudded,
+                             plate.facets, sphere.facets, plate.index, sphere.index,
+                             plate.points, sphere.points, edges1, edges2) != CUBIT_SUCCESS)
+    {
+      fprintf(stderr, "intersecting the plate and sphere failed %s\n",
+              pool ? "on the pool" : "with no pool");
+      errors++;
+    }
+    delete pool;
+  }
+
+  errors += check_groups(coords1, conn1, results[0][0], "plate");
+  errors += check_groups(coords2, conn2, results[0][1], "sphere");
+  if(!(results[1][0] == results[0][0]))
+  {
+    fprintf(stderr, "plate: the retriangulation differs on the pool\n");
+    errors++;
+  }
+  if(!(results[1][1] == results[0][1]))
+  {
+    fprintf(stderr, "sphere: the retriangulation differs on the pool\n");
+    errors++;
+  }
+  return errors;
+}
+
+int main (int argc, char **argv)
+{
+  return test_plate_and_sphere();
+}
@@ -0,0 +1,171 @@
+/**
+ * \file merge_concurrent.cpp
+ *
+ * \brief Tests of comparing merge candidates on the CubitConcurrent pool
+ *
+ * Builds faceted bricks that share a whole face, and bricks whose faces
+ * share only one edge, so that comparing those faces matches part of a
+ * loop and marks the shared curve and vertices before failing.  Finding
+ * the mergeable surfaces must leave the same compare partners on every
+ * curve and vertex, and finding the mergeable surfaces, curves and
+ * vertices must give the same lists, with the surfaces compared serially
+ * and on the pool.
+ */
+#include "GeometryQueryTool.hpp"
+#include "MergeTool.hpp"
+#include "CubitStdConcurrentApi.h"
+#include "Body.hpp"
+#include "RefFace.hpp"
+#include "RefEdge.hpp"
+#include "RefVertex.hpp"
+#include "DLIList.hpp"
+#include "TestUtilities.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+
+typedef std::vector<std::vector<int> > IdLists;
+
+// the ids in each list, sorted, and the lists sorted, deleting the lists
+template <class T>
+static IdLists take_ids(DLIList<DLIList<T*>*>& lists)
+{
+  IdLists ids;
+  for(int i=0; i<lists.size(); i++)
+  {
+    DLIList<T*>* list = lists.get_and_step();
+    std::vector<int> list_ids;
+    for(int j=0; j<list->size(); j++)
+      list_ids.push_back(list->get_and_step()->id());
+    std::sort(list_ids.begin(), list_ids.end());
+    ids.push_back(list_ids);
+    delete list;
+  }
+  lists.clean_out();
+  std::sort(ids.begin(), ids.end());
+  return ids;
+}
+
+static void all_bodies(DLIList<RefEntity*>& entities)
+{
+  DLIList<Body*> bodies;
+  GeometryQueryTool::instance()->bodies(bodies);
+  CAST_LIST_TO_PARENT(bodies, entities);
+}
+
+// the compare partner of every curve and vertex after finding the
+// mergeable surfaces, 0 for none
+static std::vector<int> find_partners()
+{
+  DLIList<RefEntity*> entities;
+  all_bodies(entities);
+  DLIList<DLIList<RefFace*>*> face_lists;
+  MergeTool::instance()->find_mergeable_reffaces(entities, face_lists, false);
+  take_ids(face_lists);
+
+  DLIList<RefEdge*> edges;
+  DLIList<RefVertex*> vertices;
+  GeometryQueryTool::instance()->ref_edges(edges);
+  GeometryQueryTool::instance()->ref_vertices(vertices);
+  DLIList<RefEntity*> children;
+  CAST_LIST_TO_PARENT(edges, children);
+  for(int i=0; i<vertices.size(); i++)
+    children.append(vertices.get_and_step());
+
+  std::vector<int> partners;
+  for(int i=0; i<children.size(); i++)
+  {
+    RefEntity* partner = children.get_and_step()->get_compare_partner();
+    partners.push_back(partner ? partner->id() : 0);
+  }
+  MergeTool::instance()->remove_compare_data();
+  return partners;
+}
+
+static void find_mergeable(IdLists& faces, IdLists& edges, IdLists& vertices)
+{
+  DLIList<RefEntity*> entities;
+  all_bodies(entities);
+
+  DLIList<DLIList<RefFace*>*> face_lists;
+  DLIList<DLIList<RefEdge*>*> edge_lists;
+  DLIList<DLIList<RefVertex*>*> vertex_lists;
+  MergeTool::instance()->find_mergeable_refentities(entities, face_lists, edge_lists,
+                                                    vertex_lists);
+  MergeTool::instance()->remove_compare_data();
+  faces = take_ids(face_lists);
+  edges = take_ids(edge_lists);
+  vertices = take_ids(vertex_lists);
+}
+
+static int compare_lists(const IdLists& serial, const IdLists& concurrent, const char* name)
+{
+  if(serial == concurrent)
+    return 0;
+  fprintf(stderr, "%d lists of mergeable %s found serially, %d on the pool:\n",
+          (int)serial.size(), name, (int)concurrent.size());
+  for(int pass=0; pass<2; pass++)
+  {
+    const IdLists& lists = pass ? concurrent : serial;
+    for(size_t i=0; i<lists.size(); i++)
+    {
+      fprintf(stderr, "  %s:", pass ? "pool" : "serial");
+      for(size_t j=0; j<lists[i].size(); j++)
+        fprintf(stderr, " %d", lists[i][j]);
+      fprintf(stderr, "\n");
+    }
+  }
+  return 1;
+}
+
+int main (int argc, char **argv)
+{
+  // a and b share the face x = 1; the others each share one edge of
+  // their face y = 1 with a's, a different edge each, so that whichever
+  // coedge a loop comparison starts from matches for some of them
+  const double corners[6][6] = { { 0, 0, 0, 1, 1, 1 }, { 1, 0, 0, 2, 1, 1 },
+                                 { 0, 1, 0, 1, 2, 2 }, { 0, 1, -1, 1, 2, 1 },
+                                 { 0, 1, 0, 2, 2, 1 }, { -1, 1, 0, 1, 2, 1 } };
+  for(int i=0; i<6; i++)
+  {
+    const double* c = corners[i];
+    if(!make_facet_brick(CubitVector(c[0], c[1], c[2]), CubitVector(c[3], c[4], c[5])))
+    {
+      fprintf(stderr, "could not build brick %d\n", i);
+      return 1;
+    }
+  }
+
+  CubitStdConcurrent pool(4);
+  int errors = 0;
+  IdLists faces[2], edges[2], vertices[2];
+  std::vector<int> partners[2];
+  for(int concurrent=0; concurrent<2; concurrent++)
+  {
+    MergeTool::set_concurrent_compare(concurrent ? CUBIT_TRUE : CUBIT_FALSE);
+    partners[concurrent] = find_partners();
+    find_mergeable(faces[concurrent], edges[concurrent], vertices[concurrent]);
+  }
+  MergeTool::set_concurrent_compare(CUBIT_FALSE);
+
+  for(size_t i=0; i<partners[0].size(); i++)
+  {
+    if(partners[0][i] != partners[1][i])
+    {
+      fprintf(stderr, "curve or vertex %d has partner %d serially, %d on the pool\n",
+              (int)i, partners[0][i], partners[1][i]);
+      errors++;
+    }
+  }
+
+  if(faces[0].size() != 1)
+  {
+    fprintf(stderr, "%d lists of mergeable surfaces, expected 1\n", (int)faces[0].size());
+    errors++;
+  }
+  errors += compare_lists(faces[0], faces[1], "surfaces");
+  errors += compare_lists(edges[0], edges[1], "curves");
+  errors += compare_lists(vertices[0], vertices[1], "vertices");
+  return errors;
+}
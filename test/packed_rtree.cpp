@@ -0,0 +1,186 @@
+/**
+ * \file packed_rtree.cpp
+ *
+ * \brief Tests of PackedRTree searches
+ *
+ * Checks box and ray searches against a linear scan and against RTree,
+ * and that members are returned in the order they were added both
+ * before and after remove/add and repacking.
+ */
+#include "PackedRTree.hpp"
+#include "RTree.hpp"
+#include "CubitBox.hpp"
+#include "CubitVector.hpp"
+#include "DLIList.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+
+struct TestBox
+{
+  CubitBox box;
+  int id;
+  CubitBox bounding_box() { return box; }
+};
+
+static unsigned int seed = 12345;
+static double next_random()
+{
+  seed = seed * 1103515245u + 12345u;
+  return (double)((seed >> 8) & 0xffff) / 65536.0;
+}
+
+static TestBox* random_box(int id)
+{
+  CubitVector lo(100*next_random(), 100*next_random(), 100*next_random());
+  CubitVector size(0.1+3*next_random(), 0.1+3*next_random(), 0.1+3*next_random());
+  TestBox* b = new TestBox;
+  b->box = CubitBox(lo, lo+size);
+  b->id = id;
+  return b;
+}
+
+static bool overlaps(const CubitBox& a, const CubitBox& b, double tol)
+{
+  for(int i=0; i<3; i++)
+    if(a.minimum()[i] - b.maximum()[i] > tol || b.minimum()[i] - a.maximum()[i] > tol)
+      return false;
+  return true;
+}
+
+static bool id_less(TestBox* a, TestBox* b)
+{
+  return a->id < b->id;
+}
+
+// compare the tree against a scan of the live boxes, which are in add order
+int check_searches(PackedRTree<TestBox*>& tree, std::vector<TestBox*>& live,
+                   RTree<TestBox*>* rtree)
+{
+  int errors = 0;
+  double tol = tree.get_tol();
+  for(int q=0; q<100; q++)
+  {
+    CubitVector lo(100*next_random(), 100*next_random(), 100*next_random());
+    CubitVector size(10*next_random(), 10*next_random(), 10*next_random());
+    CubitBox range(lo, lo+size);
+
+    DLIList<TestBox*> found;
+    tree.find(range, found);
+    std::vector<TestBox*> expected;
+    for(size_t i=0; i<live.size(); i++)
+      if(overlaps(live[i]->box, range, tol))
+        expected.push_back(live[i]);
+
+    found.reset();
+    bool same = found.size() == (int)expected.size();
+    for(int i=0; same && i<found.size(); i++)
+      same = found.get_and_step() == expected[i];
+    if(!same)
+    {
+      fprintf(stderr, "box search %d found %d boxes, expected %d in add order\n",
+              q, found.size(), (int)expected.size());
+      errors++;
+    }
+
+    if(rtree)
+    {
+      DLIList<TestBox*> rfound;
+      rtree->find(range, rfound);
+      std::vector<TestBox*> rsorted;
+      for(int i=0; i<rfound.size(); i++)
+        rsorted.push_back(rfound.get_and_step());
+      std::sort(rsorted.begin(), rsorted.end(), id_less);
+      if(rsorted != expected)
+      {
+        fprintf(stderr, "box search %d: RTree found %d boxes, PackedRTree %d\n",
+                q, (int)rsorted.size(), (int)expected.size());
+        errors++;
+      }
+    }
+
+    CubitVector origin(-10, 100*next_random(), 100*next_random());
+    CubitVector direction(1, next_random()-0.5, next_random()-0.5);
+    found.clean_out();
+    tree.find(origin, direction, found);
+    expected.clear();
+    for(size_t i=0; i<live.size(); i++)
+      if(live[i]->box.intersect(&origin, &direction))
+        expected.push_back(live[i]);
+    found.reset();
+    same = found.size() == (int)expected.size();
+    for(int i=0; same && i<found.size(); i++)
+      same = found.get_and_step() == expected[i];
+    if(!same)
+    {
+      fprintf(stderr, "ray search %d found %d boxes, expected %d in add order\n",
+              q, found.size(), (int)expected.size());
+      errors++;
+    }
+  }
+  return errors;
+}
+
+int test_searches()
+{
+  int errors = 0;
+  std::vector<TestBox*> boxes;
+  PackedRTree<TestBox*> tree;
+  RTree<TestBox*> rtree;
+  int next_id = 0;
+  for(int i=0; i<2000; i++)
+  {
+    boxes.push_back(random_box(next_id++));
+    tree.add(boxes.back());
+    rtree.add(boxes.back());
+  }
+  errors += check_searches(tree, boxes, &rtree);
+
+  // removed members leave holes and new ones go in the unpacked tail
+  std::vector<TestBox*> live;
+  for(size_t i=0; i<boxes.size(); i++)
+  {
+    if(i % 7 == 3)
+    {
+      if(!tree.remove(boxes[i]))
+      {
+        fprintf(stderr, "box %d was not removed\n", boxes[i]->id);
+        errors++;
+      }
+    }
+    else
+      live.push_back(boxes[i]);
+  }
+  for(int i=0; i<100; i++)
+  {
+    boxes.push_back(random_box(next_id++));
+    live.push_back(boxes.back());
+    tree.add(boxes.back());
+  }
+  if(tree.size() != (int)live.size())
+  {
+    fprintf(stderr, "tree holds %d boxes, expected %d\n", tree.size(), (int)live.size());
+    errors++;
+  }
+  errors += check_searches(tree, live, NULL);
+
+  // repacking must not change the order either
+  for(int i=0; i<1000; i++)
+  {
+    boxes.push_back(random_box(next_id++));
+    live.push_back(boxes.back());
+    tree.add(boxes.back());
+  }
+  tree.balance();
+  errors += check_searches(tree, live, NULL);
+
+  for(size_t i=0; i<boxes.size(); i++)
+    delete boxes[i];
+  return errors;
+}
+
+int main (int argc, char **argv)
+{
+  return test_searches();
+}
@@ -0,0 +1,229 @@
+/**
+ * \file topology_snapshot.cpp
+ *
+ * \brief Tests of TopologySnapshot
+ *
+ * Builds a few faceted bricks and checks that every downward and upward
+ * adjacency in the snapshot matches the live topology queries, that the
+ * volume face senses match the CoFaces, and that the snapshot goes stale
+ * when a body is deleted.
+ */
+#include "GeometryQueryTool.hpp"
+#include "TopologySnapshot.hpp"
+#include "Body.hpp"
+#include "RefVolume.hpp"
+#include "RefFace.hpp"
+#include "RefEdge.hpp"
+#include "RefVertex.hpp"
+#include "CoFace.hpp"
+#include "DLIList.hpp"
+#include "TestUtilities.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+
+static const char* level_names[] = { "vertex", "edge", "face", "volume", "body" };
+
+template <class T>
+static std::vector<RefEntity*> sorted_entities(DLIList<T*>& list)
+{
+  std::vector<RefEntity*> result;
+  for(int i=0; i<list.size(); i++)
+    result.push_back(list.get_and_step());
+  std::sort(result.begin(), result.end());
+  result.erase(std::unique(result.begin(), result.end()), result.end());
+  return result;
+}
+
+static std::vector<RefEntity*> live_children(TopologySnapshot::Level level, RefEntity* entity)
+{
+  switch(level)
+  {
+    case TopologySnapshot::BODY:
+    { DLIList<RefVolume*> l; static_cast<Body*>(entity)->ref_volumes(l); return sorted_entities(l); }
+    case TopologySnapshot::VOLUME:
+    { DLIList<RefFace*> l; static_cast<RefVolume*>(entity)->ref_faces(l); return sorted_entities(l); }
+    case TopologySnapshot::FACE:
+    { DLIList<RefEdge*> l; static_cast<RefFace*>(entity)->ref_edges(l); return sorted_entities(l); }
+    case TopologySnapshot::EDGE:
+    { DLIList<RefVertex*> l; static_cast<RefEdge*>(entity)->ref_vertices(l); return sorted_entities(l); }
+    default:
+      return std::vector<RefEntity*>();
+  }
+}
+
+static std::vector<RefEntity*> live_parents(TopologySnapshot::Level level, RefEntity* entity)
+{
+  switch(level)
+  {
+    case TopologySnapshot::VERTEX:
+    { DLIList<RefEdge*> l; static_cast<RefVertex*>(entity)->ref_edges(l); return sorted_entities(l); }
+    case TopologySnapshot::EDGE:
+    { DLIList<RefFace*> l; static_cast<RefEdge*>(entity)->ref_faces(l); return sorted_entities(l); }
+    case TopologySnapshot::FACE:
+    { DLIList<RefVolume*> l; static_cast<RefFace*>(entity)->ref_volumes(l); return sorted_entities(l); }
+    case TopologySnapshot::VOLUME:
+    { DLIList<Body*> l; static_cast<RefVolume*>(entity)->bodies(l); return sorted_entities(l); }
+    default:
+      return std::vector<RefEntity*>();
+  }
+}
+
+static std::vector<RefEntity*> snapshot_entities(const TopologySnapshot& snap,
+                                                 TopologySnapshot::Level level,
+                                                 const TopologySnapshot::IndexRange& range)
+{
+  std::vector<RefEntity*> result;
+  for(int i=0; i<range.size(); i++)
+    result.push_back(snap.entity(level, range[i]));
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+// compare every adjacency in the snapshot with the live queries
+int check_against_live(const TopologySnapshot& snap, int num_bodies)
+{
+  int errors = 0;
+  if(snap.num_entities(TopologySnapshot::BODY) != num_bodies)
+  {
+    fprintf(stderr, "snapshot has %d bodies, expected %d\n",
+            snap.num_entities(TopologySnapshot::BODY), num_bodies);
+    errors++;
+  }
+
+  for(int l=TopologySnapshot::VERTEX; l<=TopologySnapshot::BODY; l++)
+  {
+    TopologySnapshot::Level level = (TopologySnapshot::Level)l;
+    for(int i=0; i<snap.num_entities(level); i++)
+    {
+      RefEntity* entity = snap.entity(level, i);
+      TopologySnapshot::Level found_level;
+      if(snap.index(entity, found_level) != i || found_level != level)
+      {
+        fprintf(stderr, "%s %d is not found by index()\n", level_names[l], i);
+        errors++;
+      }
+
+      if(level != TopologySnapshot::VERTEX)
+      {
+        std::vector<RefEntity*> snap_children =
+          snapshot_entities(snap, (TopologySnapshot::Level)(l-1), snap.children(level, i));
+        if(snap_children != live_children(level, entity))
+        {
+          fprintf(stderr, "children of %s %d differ from the live topology\n",
+                  level_names[l], i);
+          errors++;
+        }
+      }
+
+      if(level != TopologySnapshot::BODY)
+      {
+        std::vector<RefEntity*> snap_parents =
+          snapshot_entities(snap, (TopologySnapshot::Level)(l+1), snap.parents(level, i));
+        if(snap_parents != live_parents(level, entity))
+        {
+          fprintf(stderr, "parents of %s %d differ from the live topology\n",
+                  level_names[l], i);
+          errors++;
+        }
+      }
+    }
+  }
+
+    // face senses of each volume, UNKNOWN for a face used both ways
+  for(int i=0; i<snap.num_entities(TopologySnapshot::VOLUME); i++)
+  {
+    DLIList<CoFace*> co_faces;
+    snap.ref_volume(i)->co_faces(co_faces);
+    TopologySnapshot::IndexRange faces = snap.children(TopologySnapshot::VOLUME, i);
+    const CubitSense* senses = snap.child_senses(TopologySnapshot::VOLUME, i);
+    for(int k=0; k<faces.size(); k++)
+    {
+      RefFace* face = snap.ref_face(faces[k]);
+      int num_uses = 0;
+      CubitSense sense = CUBIT_UNKNOWN;
+      for(int j=0; j<co_faces.size(); j++)
+      {
+        CoFace* co_face = co_faces.get_and_step();
+        if(co_face->get_ref_face_ptr() != face)
+          continue;
+        if(num_uses++ == 0)
+          sense = co_face->get_sense();
+        else if(sense != co_face->get_sense())
+          sense = CUBIT_UNKNOWN;
+      }
+      if(senses[k] != sense)
+      {
+        fprintf(stderr, "sense of face %d of volume %d is %d, CoFaces give %d\n",
+                k, i, (int)senses[k], (int)sense);
+        errors++;
+      }
+    }
+  }
+
+    // an edge's vertices come start first
+  for(int i=0; i<snap.num_entities(TopologySnapshot::EDGE); i++)
+  {
+    RefEdge* edge = snap.ref_edge(i);
+    TopologySnapshot::IndexRange verts = snap.children(TopologySnapshot::EDGE, i);
+    if(verts.size() != 2 || snap.ref_vertex(verts[0]) != edge->start_vertex() ||
+       snap.ref_vertex(verts[1]) != edge->end_vertex())
+    {
+      fprintf(stderr, "vertices of edge %d are not start then end\n", i);
+      errors++;
+    }
+  }
+  return errors;
+}
+
+int main (int argc, char **argv)
+{
+  int errors = 0;
+  GeometryQueryTool* gqt = GeometryQueryTool::instance();
+  for(int i=0; i<3; i++)
+  {
+    if(!make_facet_brick(CubitVector(2*i, 0, 0), CubitVector(2*i+1, 1, 1)))
+    {
+      fprintf(stderr, "could not build brick %d\n", i);
+      return 1;
+    }
+  }
+
+  TopologySnapshot snap;
+  if(!snap.is_stale())
+  {
+    fprintf(stderr, "an unbuilt snapshot is not stale\n");
+    errors++;
+  }
+  snap.build();
+  if(snap.is_stale())
+  {
+    fprintf(stderr, "a built snapshot is stale\n");
+    errors++;
+  }
+  errors += check_against_live(snap, 3);
+  if(snap.num_entities(TopologySnapshot::FACE) != 18 ||
+     snap.num_entities(TopologySnapshot::EDGE) != 36 ||
+     snap.num_entities(TopologySnapshot::VERTEX) != 24)
+  {
+    fprintf(stderr, "snapshot has %d faces, %d edges, %d vertices\n",
+            snap.num_entities(TopologySnapshot::FACE),
+            snap.num_entities(TopologySnapshot::EDGE),
+            snap.num_entities(TopologySnapshot::VERTEX));
+    errors++;
+  }
+
+  DLIList<Body*> bodies;
+  gqt->bodies(bodies);
+  gqt->delete_Body(bodies.get());
+  if(!snap.is_stale())
+  {
+    fprintf(stderr, "snapshot is not stale after deleting a body\n");
+    errors++;
+  }
+  snap.build();
+  errors += check_against_live(snap, 2);
+
+  return errors;
+}
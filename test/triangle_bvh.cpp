@@ -0,0 +1,257 @@
+/**
+ * \file triangle_bvh.cpp
+ *
+ * \brief Tests of the TriangleBVH nearest-triangle searches
+ *
+ * Builds trees over random triangles, among them needles, triangles
+ * collapsed to a segment or a point, and duplicates, and over a regular
+ * grid where many triangles are equally near a query point.  The
+ * triangles closest_triangle and triangles_within find are compared with
+ * a search of every triangle, and the distance to each triangle with one
+ * worked out from its edges and plane.
+ */
+#include "TriangleBVH.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+static unsigned int seed = 1021;
+static double next_random()
+{
+  seed = seed * 1103515245u + 12345u;
+  return (double)((seed >> 8) & 0xffff) / 65536.0;
+}
+
+static double segment_distance(const CubitVector& p, const CubitVector& a, const CubitVector& b)
+{
+  CubitVector ab = b - a;
+  double len_sq = ab.length_squared();
+  double t = len_sq > 0.0 ? ((p - a) % ab) / len_sq : 0.0;
+  t = std::max(0.0, std::min(1.0, t));
+  return (p - (a + t*ab)).length();
+}
+
+// the distance from p to the triangle: to its plane if p projects inside
+// it, otherwise to the nearest edge; a triangle thinner than TriangleBVH
+// works out a plane for is only its edges
+static double reference_distance(const CubitVector& p, const CubitVector& a,
+                                 const CubitVector& b, const CubitVector& c)
+{
+  double dist = std::min(segment_distance(p, a, b),
+                         std::min(segment_distance(p, b, c), segment_distance(p, c, a)));
+  CubitVector normal = (b - a) * (c - a);
+  double len = normal.length();
+  if(len > 1e-6 * (b - a).length() * (c - a).length())
+  {
+    normal /= len;
+    double height = (p - a) % normal;
+    CubitVector q = p - height*normal;
+    if(((b - a) * (q - a)) % normal >= 0 && ((c - b) * (q - b)) % normal >= 0 &&
+       ((a - c) * (q - c)) % normal >= 0)
+      dist = std::min(dist, fabs(height));
+  }
+  return dist;
+}
+
+class Mesh
+{
+public:
+  std::vector<double> coords;
+  std::vector<int> conn;
+
+  int add_point(double x, double y, double z)
+  {
+    coords.push_back(x); coords.push_back(y); coords.push_back(z);
+    return (int)coords.size()/3 - 1;
+  }
+  void add_triangle(int p0, int p1, int p2)
+  {
+    conn.push_back(p0); conn.push_back(p1); conn.push_back(p2);
+  }
+  int num_triangles() const { return (int)conn.size()/3; }
+  CubitVector point(int tri, int k) const
+  {
+    return CubitVector(&coords[3*conn[3*tri + k]]);
+  }
+};
+
+// random triangles of assorted sizes, with every fifth one degenerate
+static void random_mesh(Mesh& mesh, int num_tris)
+{
+  for(int i=0; i<num_tris; i++)
+  {
+    double c[3] = { 10*next_random(), 10*next_random(), 10*next_random() };
+    double size = (i % 7) ? 0.5 : 3.0;
+    int p[3];
+    for(int j=0; j<3; j++)
+      p[j] = mesh.add_point(c[0] + size*(next_random() - 0.5), c[1] + size*(next_random() - 0.5),
+                            c[2] + size*(next_random() - 0.5));
+    switch(i % 20)
+    {
+      case 0:   // all three corners at one point
+        mesh.add_triangle(p[0], p[0], p[0]);
+        break;
+      case 5:   // two corners at one point
+        mesh.add_triangle(p[0], p[1], p[1]);
+        break;
+      case 10:  // three collinear corners
+      {
+        const double* a = &mesh.coords[3*p[0]];
+        const double* b = &mesh.coords[3*p[1]];
+        int mid = mesh.add_point(0.3*a[0] + 0.7*b[0], 0.3*a[1] + 0.7*b[1], 0.3*a[2] + 0.7*b[2]);
+        mesh.add_triangle(p[0], mid, p[1]);
+        break;
+      }
+      case 15:  // a duplicate of the triangle before, and a needle
+      {
+        int prev = mesh.num_triangles() - 1;
+        mesh.add_triangle(mesh.conn[3*prev], mesh.conn[3*prev + 1], mesh.conn[3*prev + 2]);
+        for(int k=0; k<3; k++)
+          mesh.coords[3*p[2] + k] = mesh.coords[3*p[1] + k] + 1e-9*k;
+        mesh.add_triangle(p[0], p[1], p[2]);
+        break;
+      }
+      default:
+        mesh.add_triangle(p[0], p[1], p[2]);
+    }
+  }
+}
+
+// a flat n by n grid of unit squares, each split into two triangles
+static void grid_mesh(Mesh& mesh, int n)
+{
+  for(int j=0; j<=n; j++)
+    for(int i=0; i<=n; i++)
+      mesh.add_point(i, j, 0);
+  for(int j=0; j<n; j++)
+    for(int i=0; i<n; i++)
+    {
+      int p = j*(n+1) + i;
+      mesh.add_triangle(p, p + 1, p + n + 2);
+      mesh.add_triangle(p, p + n + 2, p + n + 1);
+    }
+}
+
+// compare each query against every triangle; queries are within a box
+// around the mesh, or on given points
+static int check_queries(const Mesh& mesh, const std::vector<CubitVector>& queries,
+                         const char* name)
+{
+  TriangleBVH tree;
+  tree.build(&mesh.coords[0], (int)mesh.coords.size()/3, &mesh.conn[0], mesh.num_triangles());
+  int errors = 0;
+
+  for(int t=0; t<mesh.num_triangles(); t++)
+    for(size_t q=0; q<queries.size(); q += 17)
+    {
+      double expected = reference_distance(queries[q], mesh.point(t, 0), mesh.point(t, 1),
+                                           mesh.point(t, 2));
+      if(fabs(tree.distance(t, queries[q]) - expected) > 1e-9)
+      {
+        fprintf(stderr, "%s: triangle %d is %.12g from query %d, expected %.12g\n", name, t,
+                tree.distance(t, queries[q]), (int)q, expected);
+        errors++;
+      }
+    }
+
+  std::vector<double> dist(mesh.num_triangles());
+  std::vector<int> found, expected;
+  for(size_t q=0; q<queries.size(); q++)
+  {
+    const CubitVector& point = queries[q];
+    double best = CUBIT_DBL_MAX;
+    for(int t=0; t<mesh.num_triangles(); t++)
+    {
+      dist[t] = tree.distance(t, point);
+      best = std::min(best, dist[t]);
+    }
+
+    CubitVector closest;
+    int tri = tree.closest_triangle(point, closest);
+    if(tri < 0 || dist[tri] != best || fabs(closest.distance_between(point) - best) > 1e-12 ||
+       tree.distance(tri, closest) > 1e-9)
+    {
+      fprintf(stderr, "%s: query %d found triangle %d at %g, the nearest is at %g\n", name,
+              (int)q, tri, tri < 0 ? -1.0 : dist[tri], best);
+      errors++;
+    }
+
+    // a limit just beyond and just short of the nearest triangle
+    if(tree.closest_triangle(point, closest, best*(1 + 1e-9) + 1e-12) < 0 ||
+       (best > 0 && tree.closest_triangle(point, closest, best*(1 - 1e-9)) >= 0))
+    {
+      fprintf(stderr, "%s: query %d is wrong for a limit near %g\n", name, (int)q, best);
+      errors++;
+    }
+
+    // the nearest triangles, all of them when there are ties, and more
+    const double limits[3] = { best*(1 + 1e-9) + 1e-12, best + 0.3, best + 2.0 };
+    for(int l=0; l<3; l++)
+    {
+      found.clear();
+      expected.clear();
+      int count = tree.triangles_within(point, limits[l], found);
+      for(int t=0; t<mesh.num_triangles(); t++)
+        if(dist[t] <= limits[l])
+          expected.push_back(t);
+      std::sort(found.begin(), found.end());
+      if(count != (int)found.size() || found != expected)
+      {
+        fprintf(stderr, "%s: query %d finds %d triangles within %g, expected %d\n", name,
+                (int)q, (int)found.size(), limits[l], (int)expected.size());
+        errors++;
+      }
+    }
+  }
+  return errors;
+}
+
+int test_random()
+{
+  Mesh mesh;
+  random_mesh(mesh, 2000);
+  std::vector<CubitVector> queries;
+  for(int q=0; q<500; q++)
+    queries.push_back(CubitVector(14*next_random() - 2, 14*next_random() - 2,
+                                  14*next_random() - 2));
+  // on corners, edges and inside triangles, degenerate ones included
+  for(int t=0; t<mesh.num_triangles(); t += 13)
+  {
+    queries.push_back(mesh.point(t, 1));
+    queries.push_back(0.5*(mesh.point(t, 0) + mesh.point(t, 2)));
+    queries.push_back((mesh.point(t, 0) + mesh.point(t, 1) + mesh.point(t, 2)) / 3.0);
+  }
+  return check_queries(mesh, queries, "random");
+}
+
+// points above grid corners, edges and cell centres are equally near
+// to up to six triangles
+int test_ties()
+{
+  Mesh mesh;
+  grid_mesh(mesh, 30);
+  std::vector<CubitVector> queries;
+  for(int q=0; q<300; q++)
+  {
+    double x = floor(30*next_random()), y = floor(30*next_random());
+    double h = (q % 3) ? 0.25*(q % 4) : 0.0;
+    switch(q % 4)
+    {
+      case 0: queries.push_back(CubitVector(x, y, h)); break;
+      case 1: queries.push_back(CubitVector(x + 0.5, y, h)); break;
+      case 2: queries.push_back(CubitVector(x + 0.5, y + 0.5, h)); break;
+      default: queries.push_back(CubitVector(x - 0.5, y + 3, -h)); break;
+    }
+  }
+  return check_queries(mesh, queries, "grid");
+}
+
+int main (int argc, char **argv)
+{
+  int errors = 0;
+  errors += test_random();
+  errors += test_ties();
+  return errors;
+}
@@ -8,6 +8,8 @@
 
 #include "CubitUtilConfigure.h"
 #include <vector>
+#include <utility>
+#include <cstddef>
 
 // class to provide a way to run tasks concurrently
 class  CUBIT_UTIL_EXPORT CubitConcurrent 
@@ -302,6 +304,79 @@ public:
     return create_taskgroup2<X, Param1, Param2, const Sequence1, const Sequence2, typename Sequence1::const_iterator, typename Sequence2::const_iterator>(x, fun, seq1, seq2);
   };
 
+  // split the items [0,n) into ranges of at least min_size items, about 64
+  // of them so the pool can balance uneven work, and call a member function
+  // for each range: as a task group on the global instance if there is one
+  // and more than one range, otherwise in order on this thread.  The
+  // function must only write results for the items of its own range.
+  // for example:
+  /*
+    class Foo
+    {
+      void foo(size_t n)
+      {
+        CubitConcurrent::parallel_for_ranges(n, *this, &Foo::square_range);
+      }
+
+      void square_range(std::pair<size_t,size_t> range)
+      {
+        for(size_t i = range.first; i < range.second; i++)
+          result[i] = input[i]*input[i];
+      }
+    };
+  */
+  template <typename X, typename Index>
+  static void parallel_for_ranges(Index n, X& x, void (X::*fun)(std::pair<Index,Index>),
+                                  size_t min_size = 16)
+  {
+    std::vector<std::pair<Index,Index> > ranges;
+    make_ranges(n, min_size, ranges);
+    CubitConcurrent* c = instance();
+    if(c && ranges.size() > 1)
+      {
+      TaskGroup* tg = c->create_and_schedule_group(x, fun, ranges);
+      c->wait(tg);
+      c->delete_group(tg);
+      }
+    else
+      {
+      for(size_t i=0; i<ranges.size(); i++)
+        (x.*fun)(ranges[i]);
+      }
+  }
+
+  // same as above, also passing each range's index, from 0 up to
+  // num_ranges(n, min_size), for functions that keep results per range
+  template <typename X, typename Index>
+  static void parallel_for_ranges(Index n, X& x, void (X::*fun)(size_t, std::pair<Index,Index>),
+                                  size_t min_size = 16)
+  {
+    std::vector<std::pair<Index,Index> > ranges;
+    make_ranges(n, min_size, ranges);
+    CubitConcurrent* c = instance();
+    if(c && ranges.size() > 1)
+      {
+      std::vector<size_t> indices(ranges.size());
+      for(size_t i=0; i<indices.size(); i++)
+        indices[i] = i;
+      TaskGroup* tg = c->create_and_schedule_group(x, fun, indices, ranges);
+      c->wait(tg);
+      c->delete_group(tg);
+      }
+    else
+      {
+      for(size_t i=0; i<ranges.size(); i++)
+        (x.*fun)(i, ranges[i]);
+      }
+  }
+
+  // the number of ranges parallel_for_ranges splits n items into
+  static size_t num_ranges(size_t n, size_t min_size = 16)
+  {
+    size_t size = range_size(n, min_size);
+    return (n + size - 1) / size;
+  }
+
   // delete a task group created by create_and_schedule_group
   void delete_group(TaskGroup* tg)
     {
@@ -435,6 +510,23 @@ protected:
     return t;
   }
 
+  static size_t range_size(size_t n, size_t min_size)
+  {
+    size_t size = (n + 63) / 64;
+    return size > min_size ? size : (min_size ? min_size : 1);
+  }
+
+  template <typename Index>
+  static void make_ranges(Index n, size_t min_size, std::vector<std::pair<Index,Index> >& ranges)
+  {
+    size_t size = range_size(n, min_size);
+    for(size_t start = 0; start < (size_t)n; start += size)
+      {
+      size_t end = (size_t)n - start > size ? start + size : (size_t)n;
+      ranges.push_back(std::make_pair((Index)start, (Index)end));
+      }
+  }
+
   template <typename X, typename Param, typename Sequence, typename Iterator>
   inline TaskGroup* create_taskgroup1(X& x, void (X::*fun)(Param), Sequence& seq)
   {
@@ -25,6 +25,8 @@
   #include <unistd.h>
   #include <pwd.h>
   #include <fnmatch.h>
+  #include <fcntl.h>
+  #include <sys/mman.h>
 #endif
 #include <errno.h>
 
@@ -675,3 +677,134 @@ int CubitFile::error()
 {
   return this->mError;
 }
+
+CubitMappedFile::CubitMappedFile()
+  : mData(NULL), mSize(0), mMapped(false), mError(0),
+    mFileHandle(NULL), mMapHandle(NULL)
+{
+}
+
+CubitMappedFile::CubitMappedFile(const CubitString& file)
+  : mData(NULL), mSize(0), mMapped(false), mError(0),
+    mFileHandle(NULL), mMapHandle(NULL)
+{
+  open(file);
+}
+
+CubitMappedFile::~CubitMappedFile()
+{
+  close();
+}
+
+bool CubitMappedFile::open(const CubitString& file)
+{
+  close();
+
+#ifdef WIN32
+  HANDLE file_handle = CreateFileW(CubitString::toUtf16(file).c_str(),
+                                   GENERIC_READ, FILE_SHARE_READ, NULL,
+                                   OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if(file_handle == INVALID_HANDLE_VALUE)
+  {
+    this->mError = ENOENT;
+    return false;
+  }
+  LARGE_INTEGER file_size;
+  if(!GetFileSizeEx(file_handle, &file_size))
+  {
+    CloseHandle(file_handle);
+    this->mError = EIO;
+    return false;
+  }
+  this->mFileHandle = file_handle;
+  this->mSize = (size_t)file_size.QuadPart;
+  if(this->mSize)
+  {
+    HANDLE map_handle = CreateFileMappingW(file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(map_handle)
+    {
+      this->mMapHandle = map_handle;
+      this->mData = (const char*)MapViewOfFile(map_handle, FILE_MAP_READ, 0, 0, 0);
+    }
+    if(!this->mData)
+    {
+      close();
+      this->mError = ENOMEM;
+      return false;
+    }
+  }
+#else
+  int fd = ::open(file.c_str(), O_RDONLY);
+  if(fd < 0)
+  {
+    this->mError = errno;
+    return false;
+  }
+  struct stat file_info;
+  if(fstat(fd, &file_info) != 0)
+  {
+    this->mError = errno;
+    ::close(fd);
+    return false;
+  }
+  this->mSize = (size_t)file_info.st_size;
+  if(this->mSize)
+  {
+    void* addr = mmap(NULL, this->mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(addr == MAP_FAILED)
+    {
+      this->mError = errno;
+      this->mSize = 0;
+      ::close(fd);
+      return false;
+    }
+    this->mData = (const char*)addr;
+  }
+  // the mapping stays valid after the descriptor is closed
+  ::close(fd);
+#endif
+
+  this->mMapped = true;
+  return true;
+}
+
+void CubitMappedFile::close()
+{
+#ifdef WIN32
+  if(mData)
+    UnmapViewOfFile(mData);
+  if(mMapHandle)
+    CloseHandle((HANDLE)mMapHandle);
+  if(mFileHandle)
+    CloseHandle((HANDLE)mFileHandle);
+#else
+  if(mData)
+    munmap((void*)mData, mSize);
+#endif
+  mData = NULL;
+  mSize = 0;
+  mMapped = false;
+  mError = 0;
+  mFileHandle = NULL;
+  mMapHandle = NULL;
+}
+
+const char* CubitMappedFile::data() const
+{
+  return this->mData;
+}
+
+size_t CubitMappedFile::size() const
+{
+  return this->mSize;
+}
+
+CubitMappedFile::operator bool () const
+{
+  return this->mMapped;
+}
+
+int CubitMappedFile::error()
+{
+  return this->mError;
+}
@@ -67,6 +67,53 @@ protected:
   int mError;
 };
 
+// read-only view of a whole file in memory, using mmap (MapViewOfFile
+// on Windows) so pages are only read as they are touched.
+// Automatically unmaps/closes the file.
+class CUBIT_UTIL_EXPORT CubitMappedFile
+{
+public:
+  // default constructor
+  CubitMappedFile();
+
+  // constructor that also maps the file
+  CubitMappedFile(const CubitString& file);
+
+  // unmaps the file, if mapped
+  virtual ~CubitMappedFile();
+
+  // maps a file
+  bool open(const CubitString& file);
+
+  // unmaps the file
+  void close();
+
+  // Return the file contents, or NULL if the file is not mapped or empty.
+  const char* data() const;
+
+  // Return the file size in bytes.
+  size_t size() const;
+
+  // returns whether the file is mapped
+  operator bool () const;
+
+  // Return status of mapping the file.
+  int error();
+
+protected:
+  const char* mData;
+  size_t mSize;
+  bool mMapped;
+  int mError;
+  void* mFileHandle;  // Windows file and mapping handles
+  void* mMapHandle;
+
+private:
+  // not copyable: a copy would unmap the file a second time
+  CubitMappedFile(const CubitMappedFile&);
+  CubitMappedFile& operator=(const CubitMappedFile&);
+};
+
 
 class CUBIT_UTIL_EXPORT CubitFileUtil
 {
@@ -0,0 +1,424 @@
+//! \file CubitStdConcurrentApi.cpp
+
+#include "CubitStdConcurrentApi.h"
+#include "SettingHandler.hpp"
+#include <cstdlib>
+
+namespace {
+
+  // identifies the pool (and deque) owned by the current thread
+  thread_local CubitStdConcurrent* tPool = 0;
+  thread_local int tWorkerIndex = -1;
+
+  struct StdTLS : public CubitConcurrent::ThreadLocalStorageInterface
+  {
+    StdTLS(void (*cleanup)(void*)) : mCleanup(cleanup)
+    {
+    }
+
+    ~StdTLS()
+    {
+      std::map<std::thread::id, void*>::iterator iter;
+      for(iter = mData.begin(); iter != mData.end(); ++iter)
+        (*mCleanup)(iter->second);
+    }
+
+    void* local_data()
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      std::map<std::thread::id, void*>::iterator iter = mData.find(std::this_thread::get_id());
+      return iter == mData.end() ? NULL : iter->second;
+    }
+
+    void set_local_data(void* p)
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      void*& slot = mData[std::this_thread::get_id()];
+      if(slot && slot != p)
+        (*mCleanup)(slot);
+      slot = p;
+    }
+
+    void (*mCleanup)(void*);
+    std::mutex mMutex;
+    std::map<std::thread::id, void*> mData;
+  };
+}
+
+int CubitStdConcurrent::threadCountSetting = 0;
+
+CubitStdConcurrent::CubitStdConcurrent(int num_threads)
+  : mStop(false), mEpoch(0)
+{
+  _name = "CubitStdConcurrent";
+
+  if(num_threads <= 0)
+    num_threads = thread_count();
+
+  int num_workers = num_threads - 1;
+  if(num_workers < 0)
+    num_workers = 0;
+
+  // one deque per worker and a shared queue for outside threads
+  for(int i=0; i<=num_workers; i++)
+    mQueues.push_back(new WorkQueue);
+
+  for(int i=0; i<num_workers; i++)
+    mThreads.push_back(std::thread(&CubitStdConcurrent::worker_loop, this, i));
+
+    // If there is no global instance, set this object as the instance.
+  if(!CubitConcurrent::mInstance)
+    CubitConcurrent::mInstance = this;
+}
+
+CubitStdConcurrent::~CubitStdConcurrent()
+{
+  // If this is the global instance, clear the pointer.
+  if(this == CubitConcurrent::mInstance)
+    CubitConcurrent::mInstance = 0;
+
+  mStop = true;
+  signal();
+  for(size_t i=0; i<mThreads.size(); i++)
+    mThreads[i].join();
+
+  for(size_t i=0; i<mQueues.size(); i++)
+    delete mQueues[i];
+}
+
+const std::string& CubitStdConcurrent::get_name() const
+{
+    return _name;
+}
+
+const char* CubitStdConcurrent::get_type() const
+{
+    return _name.c_str();
+}
+
+int CubitStdConcurrent::num_workers() const
+{
+  return (int)mThreads.size();
+}
+
+int CubitStdConcurrent::thread_count()
+{
+  if(threadCountSetting > 0)
+    return threadCountSetting;
+
+  const char* env = getenv("CGM_NUM_THREADS");
+  if(env)
+  {
+    int count = atoi(env);
+    if(count > 0)
+      return count;
+  }
+
+  int count = (int)std::thread::hardware_concurrency();
+  return count > 0 ? count : 1;
+}
+
+void CubitStdConcurrent::initialize_settings()
+{
+  SettingHandler::instance()->add_setting("Concurrent Thread Count",
+                                          CubitStdConcurrent::set_thread_count_setting,
+                                          CubitStdConcurrent::get_thread_count_setting);
+}
+
+CubitConcurrent::ThreadLocalStorageInterface* CubitStdConcurrent::create_local_storage(void (*cleanup_function)(void*))
+{
+  return new StdTLS(cleanup_function);
+}
+
+void CubitStdConcurrent::destroy_local_storage(ThreadLocalStorageInterface* i)
+{
+  delete static_cast<StdTLS*>(i);
+}
+
+void CubitStdConcurrent::signal()
+{
+  {
+    std::lock_guard<std::mutex> lock(mSignalMutex);
+    ++mEpoch;
+  }
+  mSignalCond.notify_all();
+}
+
+void CubitStdConcurrent::wait_for_signal(unsigned long epoch)
+{
+  std::unique_lock<std::mutex> lock(mSignalMutex);
+  while(!mStop && mEpoch == epoch)
+    mSignalCond.wait(lock);
+}
+
+void CubitStdConcurrent::push(const WorkItemPtr& item)
+{
+  WorkQueue* queue = (tPool == this && tWorkerIndex >= 0) ?
+    mQueues[tWorkerIndex] : mQueues.back();
+  std::lock_guard<std::mutex> lock(queue->mutex);
+  queue->items.push_back(item);
+}
+
+bool CubitStdConcurrent::run_item(const WorkItemPtr& item)
+{
+  int expected = QUEUED;
+  if(!item->state.compare_exchange_strong(expected, RUNNING))
+    return false;
+
+  if(item->group)
+    item->group->started++;
+
+  item->task->execute();
+
+  item->state = DONE;
+  if(item->group)
+    item->group->remaining--;
+  signal();
+  return true;
+}
+
+bool CubitStdConcurrent::run_one_pending()
+{
+  int num_queues = (int)mQueues.size();
+  int self = (tPool == this) ? tWorkerIndex : -1;
+
+  // own work first, newest first for locality
+  if(self >= 0)
+  {
+    while(true)
+    {
+      WorkItemPtr item;
+      {
+        WorkQueue* queue = mQueues[self];
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        if(queue->items.empty())
+          break;
+        item = queue->items.back();
+        queue->items.pop_back();
+      }
+      if(run_item(item))
+        return true;
+    }
+  }
+
+  // then steal the oldest work of the shared queue and the other workers
+  int start = self >= 0 ? self + 1 : num_queues - 1;
+  for(int i=0; i<num_queues; i++)
+  {
+    int victim = (start + i) % num_queues;
+    if(victim == self)
+      continue;
+    while(true)
+    {
+      WorkItemPtr item;
+      {
+        WorkQueue* queue = mQueues[victim];
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        if(queue->items.empty())
+          break;
+        item = queue->items.front();
+        queue->items.pop_front();
+      }
+      if(run_item(item))
+        return true;
+    }
+  }
+  return false;
+}
+
+void CubitStdConcurrent::worker_loop(int index)
+{
+  tPool = this;
+  tWorkerIndex = index;
+
+  while(!mStop)
+  {
+    unsigned long epoch = mEpoch;
+    if(!run_one_pending())
+      wait_for_signal(epoch);
+  }
+}
+
+void CubitStdConcurrent::schedule(CubitConcurrent::Task* task)
+{
+  WorkItemPtr item(new WorkItem(task));
+  m.lock();
+  taskmap[task] = item;
+  m.unlock();
+  push(item);
+  signal();
+}
+
+void CubitStdConcurrent::schedule(CubitConcurrent::TaskGroup* task_group)
+{
+  std::shared_ptr<GroupRecord> group(new GroupRecord);
+  group->remaining = (int)task_group->tasks.size();
+
+  std::vector<WorkItemPtr> items;
+  m.lock();
+  for(size_t i=0; i<task_group->tasks.size(); i++)
+  {
+    WorkItemPtr item(new WorkItem(task_group->tasks[i]));
+    item->group = group;
+    taskmap[task_group->tasks[i]] = item;
+    items.push_back(item);
+  }
+  m.unlock();
+
+  m2.lock();
+  taskgroupmap[task_group] = group;
+  m2.unlock();
+
+  // queue in reverse so the owning worker pops the tasks in sequence order
+  for(size_t i=items.size(); i>0; i--)
+    push(items[i-1]);
+  signal();
+}
+
+CubitStdConcurrent::WorkItemPtr CubitStdConcurrent::find_item(CubitConcurrent::Task* task)
+{
+  std::lock_guard<std::mutex> lock(m);
+  std::map<Task*, WorkItemPtr>::iterator iter = taskmap.find(task);
+  return iter == taskmap.end() ? WorkItemPtr() : iter->second;
+}
+
+void CubitStdConcurrent::wait(CubitConcurrent::Task* task)
+{
+  WorkItemPtr item = find_item(task);
+  if(!item)
+    return;
+
+  // run the task here if nobody has started it, otherwise help with
+  // other queued work until it finishes
+  while(item->state != DONE)
+  {
+    unsigned long epoch = mEpoch;
+    if(run_item(item))
+      break;
+    if(item->state == DONE)
+      break;
+    if(!run_one_pending())
+      wait_for_signal(epoch);
+  }
+
+  m.lock();
+  taskmap.erase(task);
+  m.unlock();
+}
+
+void CubitStdConcurrent::wait(const std::vector<CubitConcurrent::Task*>& tasks)
+{
+  for(size_t i=0; i<tasks.size(); i++)
+    wait(tasks[i]);
+}
+
+void CubitStdConcurrent::wait_for_any(const std::vector<CubitConcurrent::Task*>& tasks,std::vector<CubitConcurrent::Task*>& finished_tasks)
+{
+  std::vector<WorkItemPtr> items(tasks.size());
+  for(size_t i=0; i<tasks.size(); i++)
+    items[i] = find_item(tasks[i]);
+
+  while(true)
+  {
+    unsigned long epoch = mEpoch;
+    for(size_t i=0; i<tasks.size(); i++)
+    {
+      if(!items[i] || items[i]->state == DONE)
+        finished_tasks.push_back(tasks[i]);
+    }
+    if(!finished_tasks.empty())
+      break;
+    if(!run_one_pending())
+      wait_for_signal(epoch);
+  }
+
+  m.lock();
+  for(size_t i=0; i<finished_tasks.size(); i++)
+    taskmap.erase(finished_tasks[i]);
+  m.unlock();
+}
+
+bool CubitStdConcurrent::is_completed(CubitConcurrent::Task* task)
+{
+  WorkItemPtr item = find_item(task);
+  return !item || item->state == DONE;
+}
+
+bool CubitStdConcurrent::is_running(CubitConcurrent::Task* task)
+{
+  WorkItemPtr item = find_item(task);
+  return item && item->state == RUNNING;
+}
+
+void CubitStdConcurrent::wait(CubitConcurrent::TaskGroup* task_group)
+{
+  m2.lock();
+  std::map<TaskGroup*, std::shared_ptr<GroupRecord> >::iterator iter = taskgroupmap.find(task_group);
+  std::shared_ptr<GroupRecord> group;
+  if(iter != taskgroupmap.end())
+    group = iter->second;
+  m2.unlock();
+
+  if(group)
+  {
+    std::vector<WorkItemPtr> items(task_group->tasks.size());
+    for(size_t i=0; i<task_group->tasks.size(); i++)
+      items[i] = find_item(task_group->tasks[i]);
+
+    // work through the group's own tasks first, then help elsewhere
+    size_t next = 0;
+    while(group->remaining > 0)
+    {
+      unsigned long epoch = mEpoch;
+      bool ran = false;
+      for(; next < items.size() && !ran; next++)
+      {
+        if(items[next])
+          ran = run_item(items[next]);
+      }
+      if(ran || group->remaining <= 0)
+        continue;
+      if(!run_one_pending())
+        wait_for_signal(epoch);
+    }
+  }
+
+  m.lock();
+  for(size_t i=0; i<task_group->tasks.size(); i++)
+    taskmap.erase(task_group->tasks[i]);
+  m.unlock();
+
+  m2.lock();
+  taskgroupmap.erase(task_group);
+  m2.unlock();
+}
+
+bool CubitStdConcurrent::is_completed(CubitConcurrent::TaskGroup* task_group)
+{
+  std::lock_guard<std::mutex> lock(m2);
+  std::map<TaskGroup*, std::shared_ptr<GroupRecord> >::iterator iter = taskgroupmap.find(task_group);
+  return iter == taskgroupmap.end() || iter->second->remaining <= 0;
+}
+
+bool CubitStdConcurrent::is_running(CubitConcurrent::TaskGroup* task_group)
+{
+  std::lock_guard<std::mutex> lock(m2);
+  std::map<TaskGroup*, std::shared_ptr<GroupRecord> >::iterator iter = taskgroupmap.find(task_group);
+  return iter != taskgroupmap.end() && iter->second->started > 0 &&
+    iter->second->remaining > 0;
+}
+
+void CubitStdConcurrent::cancel(CubitConcurrent::TaskGroup* task_group)
+{
+  for(size_t i=0; i<task_group->tasks.size(); i++)
+  {
+    WorkItemPtr item = find_item(task_group->tasks[i]);
+    if(!item)
+      continue;
+    // mark un-started tasks done; their queue entries are skipped when popped
+    int expected = QUEUED;
+    if(item->state.compare_exchange_strong(expected, DONE))
+      item->group->remaining--;
+  }
+  signal();
+}
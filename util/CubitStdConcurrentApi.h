@@ -0,0 +1,154 @@
+//! \file CubitStdConcurrentApi.h
+/*! \brief Api for concurrency based on a built-in work-stealing thread pool
+ *
+ *  Dependency-free implementation of CubitConcurrent using std::thread.
+ *  Each worker owns a deque of tasks; it pops its own work LIFO and steals
+ *  other workers' work FIFO.  Any thread that waits on a task helps run
+ *  queued tasks until the task completes, so tasks may schedule and wait
+ *  on nested tasks without deadlocking the pool.
+ */
+
+#ifndef CUBIT_STD_CONCURRENT_API_H_
+#define CUBIT_STD_CONCURRENT_API_H_
+
+#include "CubitConcurrentApi.h"
+#include "CubitUtilConfigure.h"
+#include <string>
+#include <map>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+
+
+// class to provide a way to run tasks concurrently
+class CUBIT_UTIL_EXPORT CubitStdConcurrent : public CubitConcurrent
+{
+public:
+  // num_threads is the total concurrency including the thread(s) that wait
+  // on tasks; num_threads-1 worker threads are started.  A value <= 0 uses
+  // thread_count().
+  CubitStdConcurrent(int num_threads = 0);
+  virtual ~CubitStdConcurrent();
+
+  const std::string& get_name() const;
+  const char* get_type() const;
+
+  // number of worker threads owned by the pool
+  int num_workers() const;
+
+  ThreadLocalStorageInterface* create_local_storage(void (*cleanup_function)(void*));
+  void destroy_local_storage(ThreadLocalStorageInterface* i);
+
+  // wait for a task to finish, running queued tasks while waiting
+  virtual void wait(Task* task);
+
+  // wait for a set of tasks to finish
+  virtual void wait(const std::vector<Task*>& task);
+
+  //wait for any of a set of tasks to finish
+  void wait_for_any(const std::vector<Task*>& tasks,std::vector<Task*>& finished_tasks);
+
+  // return whether a task is complete
+  virtual bool is_completed(Task* task);
+
+  // return whether a task is currently running (as opposed to waiting in the queue)
+  virtual bool is_running(Task* task);
+
+  // wait for a task group to complete
+  virtual void wait(TaskGroup* task_group);
+
+  // return whether a task group is complete
+  virtual bool is_completed(TaskGroup* task_group);
+
+  // return whether a task group is currently running (as opposed to waiting in the queue)
+  virtual bool is_running(TaskGroup* task_group);
+
+  // cancel a task group's execution
+  // this only un-queues tasks that haven't started, and running tasks will run to completion
+  // after canceling a task group, one still needs to call wait() for completion.
+  virtual void cancel(TaskGroup* task_group);
+
+  // Thread count used when a pool is created with num_threads <= 0.
+  // If the setting is 0 the CGM_NUM_THREADS environment variable is
+  // used, then the hardware concurrency.
+  static int thread_count();
+  static int get_thread_count_setting() {return threadCountSetting;}
+  static void set_thread_count_setting(int count) {threadCountSetting = count;}
+
+  static void initialize_settings();
+
+protected:
+  // schedule a task for execution
+  virtual void schedule(Task* task);
+
+  // schedule a group of tasks for execution
+  virtual void schedule(TaskGroup* task_group);
+
+  enum ItemState { QUEUED, RUNNING, DONE };
+
+  struct GroupRecord
+  {
+    GroupRecord() : remaining(0), started(0) {}
+    std::atomic<int> remaining;
+    std::atomic<int> started;
+  };
+
+  struct WorkItem
+  {
+    WorkItem(Task* t) : task(t), state(QUEUED) {}
+    Task* task;
+    std::atomic<int> state;
+    std::shared_ptr<GroupRecord> group;
+  };
+  typedef std::shared_ptr<WorkItem> WorkItemPtr;
+
+  struct WorkQueue
+  {
+    std::mutex mutex;
+    std::deque<WorkItemPtr> items;
+  };
+
+  void worker_loop(int index);
+
+  // push an item on the calling worker's deque, or on the shared queue
+  // when called from a thread outside the pool
+  void push(const WorkItemPtr& item);
+
+  // pop/steal one queued item and run it; returns false if no work was found
+  bool run_one_pending();
+
+  // claim and execute an item; returns false if it was already claimed
+  bool run_item(const WorkItemPtr& item);
+
+  // block until an item completes or new work is scheduled
+  void wait_for_signal(unsigned long epoch);
+  void signal();
+
+  WorkItemPtr find_item(Task* task);
+
+  std::vector<std::thread> mThreads;
+  std::vector<WorkQueue*> mQueues;   // one per worker, plus the shared queue last
+  std::atomic<bool> mStop;
+
+  std::mutex mSignalMutex;
+  std::condition_variable mSignalCond;
+  std::atomic<unsigned long> mEpoch;
+
+  std::map<Task*, WorkItemPtr> taskmap;
+  std::mutex m;
+
+  std::map<TaskGroup*, std::shared_ptr<GroupRecord> > taskgroupmap;
+  std::mutex m2;
+
+  std::string _name;
+
+  static int threadCountSetting;
+};
+
+
+#endif // CUBIT_STD_CONCURRENT_API_H_
+
@@ -0,0 +1,480 @@
+//---------------------------------------------------------------------------
+// Class Name:  PackedRTree
+// Description: Static rectangle tree bulk loaded with Sort-Tile-Recursive
+//              packing.  See PackedRTree.hpp.
+// Creation Date: 10/17/26
+//---------------------------------------------------------------------------
+
+//---------------------------------
+//Include Files
+//---------------------------------
+#include "PackedRTree.hpp"
+#include "CubitBox.hpp"
+#include "CubitVector.hpp"
+#include "DLIList.hpp"
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <math.h>
+
+#ifdef INLINE_TEMPLATES
+#define MY_INLINE inline
+#else
+#define MY_INLINE
+#endif
+
+template <class Z> MY_INLINE PackedRTree<Z>::PackedRTree (double tol, int node_size)
+{
+  myTolerance = tol;
+  nodeSize = node_size < 2 ? 2 : node_size;
+  isPacked = false;
+  packedCount = 0;
+  numRemoved = 0;
+  nextSequence = 0;
+}
+
+template <class Z> MY_INLINE PackedRTree<Z>::~PackedRTree()
+{
+}
+
+template <class Z> MY_INLINE CubitStatus PackedRTree<Z>::add(Z data)
+{
+  myData.push_back(data);
+  isRemoved.push_back(0);
+  addSequence.push_back(nextSequence++);
+  if ( !isPacked )
+    return CUBIT_SUCCESS;
+
+    //Keep it in the unpacked tail until the tail gets long.
+  dataBoxes.resize(6*myData.size());
+  data_box(data, &dataBoxes[6*(myData.size()-1)]);
+  int tail = (int)myData.size() - packedCount;
+  if ( tail > CUBIT_MAX(4*nodeSize, packedCount/8) )
+    isPacked = false;
+  return CUBIT_SUCCESS;
+}
+
+template <class Z> MY_INLINE CubitBoolean PackedRTree<Z>::remove( Z data )
+{
+  int slot = -1;
+  int ii;
+  if ( isPacked )
+  {
+    double box[6];
+    data_box(data, box);
+    std::vector<int> slots;
+    find_slots(box, box+3, slots);
+    for ( ii = 0; ii < (int)slots.size() && slot < 0; ii++ )
+      if ( myData[slots[ii]] == data )
+        slot = slots[ii];
+  }
+  if ( slot < 0 )
+  {
+      //Not packed, or the box of data has changed since it was added.
+    for ( ii = 0; ii < (int)myData.size() && slot < 0; ii++ )
+      if ( myData[ii] == data && !isRemoved[ii] )
+        slot = ii;
+  }
+  if ( slot < 0 )
+    return CUBIT_FALSE;
+
+  isRemoved[slot] = 1;
+  numRemoved++;
+  if ( 2*numRemoved > (int)myData.size() )
+    isPacked = false;
+  return CUBIT_TRUE;
+}
+
+template <class Z> MY_INLINE CubitStatus PackedRTree<Z>::balance()
+{
+  if ( !isPacked )
+    pack();
+  return CUBIT_SUCCESS;
+}
+
+template <class Z> MY_INLINE
+void PackedRTree<Z>::data_box( Z data, double *box ) const
+{
+    //Grown like RTreeNode's boxes when thinner than the tolerance.
+  CubitBox b_box = data->bounding_box();
+  b_box.minimum().get_xyz(box);
+  b_box.maximum().get_xyz(box+3);
+  for ( int ii = 0; ii < 3; ii++ )
+  {
+    if ( box[3+ii] - box[ii] < myTolerance )
+    {
+      box[ii] -= .6*myTolerance;
+      box[3+ii] += .6*myTolerance;
+    }
+  }
+}
+
+template <class Z> MY_INLINE
+void PackedRTree<Z>::tile( std::vector<int> &order, int begin, int end, int axis,
+                           int slice_size, const std::vector<double> &centers )
+{
+  CenterLess less;
+  less.centers = &centers[0];
+  less.axis = axis;
+  std::sort(order.begin()+begin, order.begin()+end, less);
+  if ( axis == 2 )
+    return;
+
+    //Split into slabs along this axis, each holding an equal share of
+    //the runs, and tile every slab along the remaining axes.
+  int count = end - begin;
+  int runs = (count + slice_size - 1) / slice_size;
+  int slabs = (int)ceil(pow((double)runs, 1.0/(3-axis)) - 1e-9);
+  if ( slabs < 1 )
+    slabs = 1;
+  int slab_size = slice_size * ((runs + slabs - 1) / slabs);
+  for ( int ii = begin; ii < end; ii += slab_size )
+    tile(order, ii, CUBIT_MIN(end, ii+slab_size), axis+1, slice_size, centers);
+}
+
+template <class Z> MY_INLINE
+int PackedRTree<Z>::pack_level( const std::vector<double> &boxes,
+                                std::vector<int> &order, int leaf )
+{
+  int count = (int)order.size();
+  int ii, jj, kk;
+  std::vector<double> centers(3*count);
+  for ( ii = 0; ii < count; ii++ )
+    for ( jj = 0; jj < 3; jj++ )
+      centers[3*ii+jj] = 0.5*(boxes[6*ii+jj] + boxes[6*ii+3+jj]);
+  tile(order, 0, count, 0, nodeSize, centers);
+
+    //Put the entries in tiled order so each node's children are
+    //contiguous.
+  int base;
+  if ( leaf )
+  {
+    std::vector<Z> data(count);
+    std::vector<int> sequence(count);
+    for ( ii = 0; ii < count; ii++ )
+    {
+      data[ii] = myData[order[ii]];
+      sequence[ii] = addSequence[order[ii]];
+      for ( jj = 0; jj < 6; jj++ )
+        dataBoxes[6*ii+jj] = boxes[6*order[ii]+jj];
+    }
+    myData.swap(data);
+    addSequence.swap(sequence);
+    base = 0;
+  }
+  else
+  {
+    base = (int)myNodes.size() - count;
+    std::vector<Node> level(count);
+    for ( ii = 0; ii < count; ii++ )
+      level[ii] = myNodes[base+order[ii]];
+    std::copy(level.begin(), level.end(), myNodes.begin()+base);
+  }
+
+  int first = (int)myNodes.size();
+  for ( ii = 0; ii < count; ii += nodeSize )
+  {
+    Node node;
+    node.first = base + ii;
+    node.count = CUBIT_MIN(nodeSize, count-ii);
+    node.leaf = leaf;
+    for ( jj = 0; jj < 3; jj++ )
+    {
+      node.bmin[jj] = CUBIT_DBL_MAX;
+      node.bmax[jj] = -CUBIT_DBL_MAX;
+    }
+    for ( kk = ii; kk < ii+node.count; kk++ )
+    {
+      const double *b = leaf ? &dataBoxes[6*kk] : myNodes[base+kk].bmin;
+      const double *b_max = leaf ? b+3 : myNodes[base+kk].bmax;
+      for ( jj = 0; jj < 3; jj++ )
+      {
+        node.bmin[jj] = CUBIT_MIN(node.bmin[jj], b[jj]);
+        node.bmax[jj] = CUBIT_MAX(node.bmax[jj], b_max[jj]);
+      }
+    }
+    myNodes.push_back(node);
+  }
+  return first;
+}
+
+template <class Z> MY_INLINE void PackedRTree<Z>::pack()
+{
+  isPacked = true;
+  myNodes.clear();
+
+    //Drop the removed data.
+  int ii, jj;
+  if ( numRemoved )
+  {
+    jj = 0;
+    for ( ii = 0; ii < (int)myData.size(); ii++ )
+      if ( !isRemoved[ii] )
+      {
+        myData[jj] = myData[ii];
+        addSequence[jj++] = addSequence[ii];
+      }
+    myData.resize(jj);
+    addSequence.resize(jj);
+    numRemoved = 0;
+  }
+  int count = (int)myData.size();
+  isRemoved.assign(count, 0);
+  dataBoxes.resize(6*count);
+  packedCount = count;
+  if ( count == 0 )
+    return;
+
+  std::vector<double> boxes(6*count);
+  for ( ii = 0; ii < count; ii++ )
+    data_box(myData[ii], &boxes[6*ii]);
+
+  std::vector<int> order(count);
+  for ( ii = 0; ii < count; ii++ )
+    order[ii] = ii;
+  int level_first = pack_level(boxes, order, 1);
+
+    //Pack each level into the next until a single root remains.
+  int level_count = (int)myNodes.size() - level_first;
+  while ( level_count > 1 )
+  {
+    boxes.resize(6*level_count);
+    order.resize(level_count);
+    for ( ii = 0; ii < level_count; ii++ )
+    {
+      const Node &node = myNodes[level_first+ii];
+      for ( jj = 0; jj < 3; jj++ )
+      {
+        boxes[6*ii+jj] = node.bmin[jj];
+        boxes[6*ii+3+jj] = node.bmax[jj];
+      }
+      order[ii] = ii;
+    }
+    level_first = pack_level(boxes, order, 0);
+    level_count = (int)myNodes.size() - level_first;
+  }
+}
+
+template <class Z> MY_INLINE
+void PackedRTree<Z>::find_slots( const double *rmin, const double *rmax,
+                                 std::vector<int> &slots )
+{
+  const double tol = myTolerance;
+  int ii, jj;
+
+  std::vector<int> stack;
+  if ( !myNodes.empty() )
+    stack.push_back((int)myNodes.size()-1);
+  while ( !stack.empty() )
+  {
+    const Node &node = myNodes[stack.back()];
+    stack.pop_back();
+    for ( jj = 0; jj < 3; jj++ )
+      if ( node.bmin[jj] - rmax[jj] > tol || rmin[jj] - node.bmax[jj] > tol )
+        break;
+    if ( jj < 3 )
+      continue;
+
+    if ( !node.leaf )
+    {
+      for ( ii = node.first + node.count - 1; ii >= node.first; ii-- )
+        stack.push_back(ii);
+      continue;
+    }
+
+    for ( ii = node.first; ii < node.first + node.count; ii++ )
+    {
+      const double *b = &dataBoxes[6*ii];
+      for ( jj = 0; jj < 3; jj++ )
+        if ( b[jj] - rmax[jj] > tol || rmin[jj] - b[3+jj] > tol )
+          break;
+      if ( jj == 3 && !isRemoved[ii] )
+        slots.push_back(ii);
+    }
+  }
+
+    //The unpacked tail.
+  for ( ii = packedCount; ii < (int)myData.size(); ii++ )
+  {
+    const double *b = &dataBoxes[6*ii];
+    for ( jj = 0; jj < 3; jj++ )
+      if ( b[jj] - rmax[jj] > tol || rmin[jj] - b[3+jj] > tol )
+        break;
+    if ( jj == 3 && !isRemoved[ii] )
+      slots.push_back(ii);
+  }
+}
+
+template <class Z> MY_INLINE CubitStatus PackedRTree<Z>::find(const CubitBox &range_box,
+                                                    DLIList <Z> &range_members )
+{
+  if ( !isPacked )
+    pack();
+
+  double rmin[3], rmax[3];
+  range_box.minimum().get_xyz(rmin);
+  range_box.maximum().get_xyz(rmax);
+  std::vector<int> slots;
+  find_slots(rmin, rmax, slots);
+  append_in_add_order(slots, range_members);
+  return CUBIT_SUCCESS;
+}
+
+template <class Z> MY_INLINE
+void PackedRTree<Z>::append_in_add_order( std::vector<int> &slots,
+                                          DLIList<Z> &members )
+{
+  if ( slots.empty() )
+    return;
+  SlotLess less;
+  less.sequence = &addSequence[0];
+  std::sort(slots.begin(), slots.end(), less);
+  for ( size_t ii = 0; ii < slots.size(); ii++ )
+    members.append(myData[slots[ii]]);
+}
+
+template <class Z> MY_INLINE
+CubitStatus PackedRTree<Z>::find( const CubitVector &ray_origin, const CubitVector &ray_direction,
+      DLIList <Z> &range_members)
+{
+  if ( !isPacked )
+    pack();
+
+  int ii;
+  std::vector<int> slots;
+  std::vector<int> stack;
+  if ( !myNodes.empty() )
+    stack.push_back((int)myNodes.size()-1);
+  while ( !stack.empty() )
+  {
+    const Node &node = myNodes[stack.back()];
+    stack.pop_back();
+    CubitBox node_box(node.bmin, node.bmax);
+    if ( !node_box.intersect(&ray_origin, &ray_direction) )
+      continue;
+
+    if ( !node.leaf )
+    {
+      for ( ii = node.first + node.count - 1; ii >= node.first; ii-- )
+        stack.push_back(ii);
+      continue;
+    }
+
+    for ( ii = node.first; ii < node.first + node.count; ii++ )
+    {
+      CubitBox d_box(&dataBoxes[6*ii], &dataBoxes[6*ii+3]);
+      if ( !isRemoved[ii] && d_box.intersect(&ray_origin, &ray_direction) )
+        slots.push_back(ii);
+    }
+  }
+
+    //The unpacked tail.
+  for ( ii = packedCount; ii < (int)myData.size(); ii++ )
+  {
+    CubitBox d_box(&dataBoxes[6*ii], &dataBoxes[6*ii+3]);
+    if ( !isRemoved[ii] && d_box.intersect(&ray_origin, &ray_direction) )
+      slots.push_back(ii);
+  }
+  append_in_add_order(slots, range_members);
+  return CUBIT_SUCCESS;
+}
+
+//--------------------------------------------------------------------------
+//Algorithm: min_dist_sq
+//Description:  Finds the minimum distance squared between the given
+//              point and the box. If the point is on or in the box, the
+//              min distance is zero.
+//--------------------------------------------------------------------------
+template <class Z> MY_INLINE
+double PackedRTree<Z>::min_dist_sq( const CubitVector &q, const double *bmin,
+                                    const double *bmax )
+{
+  double dist = 0.0;
+  for ( int ii = 0; ii < 3; ii++ )
+  {
+    double d = 0.0;
+    if ( q[ii] < bmin[ii] )
+      d = bmin[ii] - q[ii];
+    else if ( q[ii] > bmax[ii] )
+      d = q[ii] - bmax[ii];
+    dist += d*d;
+  }
+  return dist;
+}
+
+//--------------------------------------------------------------------------
+//Algorithm: k_nearest_neighbor
+//Description:  Best-first search.  Entries are nodes (keyed by box
+//              distance), data members keyed by their box distance, and
+//              data members keyed by their exact distance; a data member
+//              is accepted once its exact distance is no larger than
+//              anything left in the queue.
+//--------------------------------------------------------------------------
+template <class Z> MY_INLINE
+CubitStatus PackedRTree<Z>::k_nearest_neighbor(CubitVector &q,
+                                               int k,
+                                               double &closest_dist,
+                                               DLIList<Z> &nearest_neighbors,
+                                               typename PackedRTree<Z>::DistSqFunc dist_sq_point_data)
+{
+  if ( !isPacked )
+    pack();
+
+  enum { NODE, DATA_BOX, DATA_EXACT };
+  typedef std::pair<double, std::pair<int,int> > Entry;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > near_queue;
+  if ( !myNodes.empty() )
+    near_queue.push(Entry(0.0, std::make_pair(NODE, (int)myNodes.size()-1)));
+  int ii;
+  for ( ii = packedCount; ii < (int)myData.size(); ii++ )
+    if ( !isRemoved[ii] )
+      near_queue.push(Entry(min_dist_sq(q, &dataBoxes[6*ii], &dataBoxes[6*ii+3]),
+                            std::make_pair(DATA_BOX, ii)));
+
+  int num_found = 0;
+  while ( !near_queue.empty() )
+  {
+    Entry entry = near_queue.top();
+    near_queue.pop();
+    int kind = entry.second.first;
+    int index = entry.second.second;
+
+    if ( kind == NODE )
+    {
+      const Node &node = myNodes[index];
+      for ( ii = node.first; ii < node.first + node.count; ii++ )
+      {
+        if ( node.leaf && isRemoved[ii] )
+          continue;
+        if ( node.leaf )
+          near_queue.push(Entry(min_dist_sq(q, &dataBoxes[6*ii], &dataBoxes[6*ii+3]),
+                                std::make_pair(DATA_BOX, ii)));
+        else
+          near_queue.push(Entry(min_dist_sq(q, myNodes[ii].bmin, myNodes[ii].bmax),
+                                std::make_pair(NODE, ii)));
+      }
+      continue;
+    }
+
+    double data_dist = entry.first;
+    if ( kind == DATA_BOX )
+    {
+      data_dist = dist_sq_point_data(q, myData[index]);
+      if ( !near_queue.empty() && data_dist > near_queue.top().first )
+      {
+          //Something else may be closer, so check again later with
+          //the exact distance.
+        near_queue.push(Entry(data_dist, std::make_pair(DATA_EXACT, index)));
+        continue;
+      }
+    }
+
+    nearest_neighbors.append(myData[index]);
+    if ( num_found == 0 )
+      closest_dist = data_dist;
+    num_found++;
+    if ( num_found == k )
+      return CUBIT_SUCCESS;
+  }
+  return CUBIT_FAILURE;
+}
@@ -0,0 +1,165 @@
+//---------------------------------------------------------------------------
+// Class Name:  PackedRTree
+// Description: Static rectangle tree, bulk loaded with the Sort-Tile-
+//              Recursive (STR) algorithm:
+//	      Leutenegger, S., Lopez, M. and Edgington, J., "STR: A Simple
+//              and Efficient Algorithm for R-Tree Packing", Proceedings
+//              of the 13th ICDE, 1997, p. 497-506.
+//
+//              Data is collected by add() and the tree is packed by
+//              balance(), which callers should call once the data is
+//              added; a query of an unpacked tree packs it first, which
+//              changes the tree, so queries may only run concurrently
+//              after balance().  Nodes and boxes are
+//              stored in contiguous arrays and all searches are
+//              non-recursive.  Data removed after packing is only marked
+//              as removed, and data added after packing is kept in a short
+//              unpacked tail that is searched linearly; the tree is
+//              repacked once either grows too large.  This suits the
+//              build-then-query usage with occasional remove/add, as in
+//              MergeTool.
+//
+//              find() returns the members in the order they were added,
+//              whatever the packing, so callers see the same order as
+//              with a list of the members filtered by box.
+//
+//              Requires Z to provide bounding_box(), as for RTree.
+// Creation Date: 10/17/26
+//---------------------------------------------------------------------------
+#ifndef PACKEDRTREE_HPP
+#define PACKEDRTREE_HPP
+
+#include "CubitDefines.h"
+#include "GeometryDefines.h"
+#include "AbstractTree.hpp"
+#include <vector>
+
+class CubitBox;
+class CubitVector;
+
+template <class X> class DLIList;
+
+template <class Z> class PackedRTree : public AbstractTree<Z>
+{
+public:
+  PackedRTree(double tol = GEOMETRY_RESABS, int node_size = 8);
+  ~PackedRTree();
+    //- Constructor/Destructor.  node_size is the number of children
+    //- packed into each node.
+
+  CubitStatus add(Z data);
+    //- Adds the data member to the tree.
+
+  CubitStatus find( const CubitBox &range_box, DLIList <Z> &range_members);
+    //- searches the tree for members that intersect this range box
+    //- within the tolerance.  Members are appended in the order they
+    //- were added.
+
+  CubitStatus find( const CubitVector &ray_origin, const CubitVector &ray_direction,
+      DLIList <Z> &range_members);
+    //- searches the tree for members that intersect this ray.  Members
+    //- are appended in the order they were added.
+
+  CubitBoolean remove(Z data );
+    //- Remove the data member's entry in the tree.
+    //- Returns CUBIT_TRUE if item removed.  FALSE if item not
+    //- in tree.
+
+  typedef double (*DistSqFunc)(CubitVector &a, Z& b);
+  CubitStatus k_nearest_neighbor(CubitVector &q,
+                                 int k,
+                                 double &closest_dist,
+                                 DLIList<Z> &nearest_neighbors,
+                                 DistSqFunc dist_sq_point_data);
+
+  CubitStatus balance();
+    //- Packs the tree, if it is not packed.  Call it after adding the
+    //- data, and again after adding or removing more, before any
+    //- concurrent queries.
+
+  void set_tol(double tol)
+    {myTolerance = tol;}
+  double get_tol()
+    {return myTolerance;}
+    //- Sets/Gets the tolerance used for the bounding box overlap test,
+    //- which is used during the range search.
+
+  int size() const
+    {return (int)myData.size() - numRemoved;}
+    //- Number of data members in the tree.
+
+private:
+
+  struct Node
+  {
+    double bmin[3];
+    double bmax[3];
+    int first;   // first child node, or first slot in myData for leaves
+    int count;   // number of children
+    int leaf;
+  };
+
+  struct SlotLess
+  {
+    const int *sequence;
+    bool operator()(int a, int b) const
+      { return sequence[a] < sequence[b]; }
+  };
+    //- Orders slots in myData by when their members were added.
+
+  struct CenterLess
+  {
+    const double *centers;
+    int axis;
+    bool operator()(int a, int b) const
+      { return centers[3*a+axis] < centers[3*b+axis]; }
+  };
+    //- Orders entries by one coordinate of their box centers.
+
+  void pack();
+    //- Sort-Tile-Recursive packing of myData into myNodes.
+
+  void tile( std::vector<int> &order, int begin, int end, int axis,
+             int slice_size, const std::vector<double> &centers );
+    //- Sorts order[begin,end) by the center coordinate on axis and
+    //- recursively tiles the remaining axes so that consecutive runs
+    //- of slice_size entries are spatially compact.
+
+  int pack_level( const std::vector<double> &boxes, std::vector<int> &order,
+                  int leaf );
+    //- Packs one level of entries (boxes: 6 doubles per entry) into
+    //- nodes appended to myNodes; returns the index of the first node.
+
+  void data_box( Z data, double *box ) const;
+    //- Gets the (min,max) box of data, grown to at least the tolerance.
+
+  void find_slots( const double *rmin, const double *rmax,
+                   std::vector<int> &slots );
+    //- Gets the slots in myData of the live members whose boxes are
+    //- within the tolerance of the range (rmin,rmax), in tree order.
+
+  void append_in_add_order( std::vector<int> &slots, DLIList<Z> &members );
+    //- Appends the members in slots to members in the order they were
+    //- added.
+
+  static double min_dist_sq( const CubitVector &q, const double *bmin,
+                             const double *bmax );
+
+  double myTolerance;
+  int nodeSize;
+  bool isPacked;
+
+  std::vector<Z> myData;          // in leaf order once packed, then the tail
+  std::vector<double> dataBoxes;  // 6 doubles per slot in myData
+  std::vector<char> isRemoved;    // per slot in myData
+  std::vector<int> addSequence;   // per slot in myData, order of add()
+  int nextSequence;
+  int packedCount;                // slots [0,packedCount) are in the tree
+  int numRemoved;
+  std::vector<Node> myNodes;      // root is the last node
+};
+
+#include "PackedRTree.cpp"
+
+#endif
+
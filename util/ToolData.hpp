@@ -41,6 +41,10 @@ class CUBIT_UTIL_EXPORT ToolData
     // handy for ToolDataUser::delete_TD, see e.g. DoubletPillower.cc
 
         
+    virtual int user_slot() const { return -1; }
+    //- the slot ToolDataUser keeps for this type of ToolData, from
+    //- ToolDataUser::register_TD_type, or -1 if it has none.
+
     virtual ToolData* propogate(ToolDataUser* new_td_user);
     //- propogate() receives the ToolData User that has been copied or split off from the 
     //- ToolDataUser this TD is on and returns the ToolData that should be put on the new 
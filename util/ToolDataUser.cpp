@@ -5,6 +5,34 @@
 #include "ToolData.hpp"
 #include "DLIList.hpp"
 
+#include <atomic>
+
+// The types given slots, in slot order; each registers itself once, the
+// first time its slot is asked for.
+static IdentityFn slotTypes[ToolDataUser::TD_SLOTS];
+static std::atomic<int> numSlotTypes(0);
+
+int ToolDataUser::register_TD_type( IdentityFn specified_type )
+{
+  int slot = numSlotTypes.fetch_add(1);
+  assert( slot < TD_SLOTS );
+  if (slot >= TD_SLOTS)
+    return -1;
+  slotTypes[slot] = specified_type;
+  return slot;
+}
+
+void ToolDataUser::reset_TD_slot( ToolData *removed_td )
+{
+  int slot = removed_td->user_slot();
+  if (slot < 0 || tdSlots[slot] != removed_td)
+    return;
+  ToolData *td = tool_data();
+  while (td && td->user_slot() != slot)
+    td = td->next_tool_data();
+  tdSlots[slot] = td;
+}
+
 ToolData *ToolDataUser::remove_TD( IdentityFn specified_type )
 {
   ToolData *td = tool_data();
@@ -16,6 +44,7 @@ ToolData *ToolDataUser::remove_TD( IdentityFn specified_type )
       else
         toolData = td->next_tool_data();
       td->next_tool_data( NULL );
+      reset_TD_slot( td );
       return td;
     }
     td_prev = td;
@@ -35,6 +64,7 @@ ToolData *ToolDataUser::remove_TD( ToolData *td_remove )
       else
         toolData = td->next_tool_data();
       td->next_tool_data( NULL );
+      reset_TD_slot( td );
       return td;
     }
     td_prev = td;
@@ -70,6 +100,10 @@ void ToolDataUser::add_TD( ToolData *new_td )
   assert( new_td != NULL );
   new_td->next_tool_data( toolData );
   toolData = new_td;
+  int slot = new_td->user_slot();
+  assert( slot < 0 || (*slotTypes[slot])(new_td) );
+  if (slot >= 0)
+    tdSlots[slot] = new_td;
 }
 
 ToolData *ToolDataUser::get_TD( IdentityFn specified_type )
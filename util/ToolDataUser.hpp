@@ -19,6 +19,10 @@ template <class X> class DLIList;
 
 class CUBIT_UTIL_EXPORT ToolDataUser
 {
+public:
+
+  enum { TD_SLOTS = 8 };
+  //- number of ToolData types that can be given a slot
 
 private:
     ToolDataUser( const ToolDataUser& );
@@ -28,13 +32,25 @@ private:
   //- generic pointer to extra data needed by a particular VolSmoothTool.
   //- see the _TD functions below for how to access this
 
+  ToolData *tdSlots[TD_SLOTS];
+  //- the first ToolData in the chain of each type given a slot by
+  //- register_TD_type, so get_TD of those types needs no search.
+
+  void reset_TD_slot(ToolData *removed_td);
+  //- find the new first ToolData of removed_td's slot, if it held it
+
   void      tool_data(ToolData *set_data) {toolData = set_data;}
   ToolData* tool_data()    const          {return toolData;}
   //- all external access/setting should be done with the _TD functions.
   
 public:
 
-  ToolDataUser () { toolData = NULL; }
+  ToolDataUser ()
+    {
+      toolData = NULL;
+      for (int i = 0; i < TD_SLOTS; i++)
+        tdSlots[i] = NULL;
+    }
 
   virtual ~ToolDataUser();
   //- automatically deletes all the chained ToolDatas
@@ -66,6 +82,24 @@ public:
   virtual void get_all_TDs(DLIList <ToolData *> *all_tds) const;
   //- get the specific type of ToolData in the chain.
   //- returns null if not found.
+
+  ToolData *get_TD(IdentityFn specified_type, int slot)
+    { return slot >= 0 ? tdSlots[slot] : get_TD(specified_type); }
+  ToolData const *get_TD(IdentityFn specified_type, int slot) const
+    { return slot >= 0 ? tdSlots[slot] : get_TD(specified_type); }
+  //- get the first ToolData of a type with the slot returned by
+  //- register_TD_type, without searching; a slot of -1 searches.
+
+  static int register_TD_type(IdentityFn specified_type);
+  //- give the type its own slot and return it.  The type must register
+  //- before any ToolData of it is added, and return the slot from its
+  //- ToolData::user_slot().  Registering more than TD_SLOTS types is an
+  //- error caught by an assert; otherwise -1 is returned and the type
+  //- is searched for in the chain.  Register from a function-local static
+  //- in the type's own source file, the first time the slot is needed,
+  //- rather than from a namespace-scope static: the order those run in is
+  //- not defined across shared libraries, and a static in an inline
+  //- function can be duplicated in each library that uses it.
   
 };
 
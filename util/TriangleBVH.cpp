@@ -0,0 +1,743 @@
+//-----------------------------------------------------------------
+//- Class:   TriangleBVH
+//- Description: Static bounding volume hierarchy over triangles.
+//-----------------------------------------------------------------
+
+#include "TriangleBVH.hpp"
+#include "GeometryDefines.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+  const int BVH_LEAF_SIZE = 4;
+  const int BVH_NUM_BINS = 16;
+  const int BVH_MAX_DEPTH = 64;
+  const int BVH_STACK_SIZE = 2*BVH_MAX_DEPTH + 2;
+
+    // squared sine of the smallest angle at which a triangle's plane is
+    // still worked out; thinner triangles are treated as their edges,
+    // which are within 1e-6 of their longest edge of any point on them
+  const double BVH_FLAT_SIN_SQ = 1.e-12;
+
+    // closest point to pt on the segment from a to b; returns the
+    // squared distance
+  inline double closest_on_segment( const double* a, const double* b,
+                                    const double pt[3], double closest[3] )
+  {
+    double ab[3] = { b[0]-a[0], b[1]-a[1], b[2]-a[2] };
+    double len_sq = ab[0]*ab[0] + ab[1]*ab[1] + ab[2]*ab[2];
+    double s = 0.0;
+    if( len_sq > 0.0 )
+    {
+      s = ((pt[0]-a[0])*ab[0] + (pt[1]-a[1])*ab[1] + (pt[2]-a[2])*ab[2]) / len_sq;
+      s = s < 0.0 ? 0.0 : (s > 1.0 ? 1.0 : s);
+    }
+    double dist_sq = 0.0;
+    for( int k = 0; k < 3; k++ )
+    {
+      closest[k] = a[k] + s*ab[k];
+      double d = pt[k] - closest[k];
+      dist_sq += d*d;
+    }
+    return dist_sq;
+  }
+
+  inline double box_area( const double bmin[3], const double bmax[3] )
+  {
+    double dx = bmax[0]-bmin[0], dy = bmax[1]-bmin[1], dz = bmax[2]-bmin[2];
+    if( dx < 0.0 || dy < 0.0 || dz < 0.0 )
+      return 0.0;
+    return dx*dy + dy*dz + dz*dx;
+  }
+
+  inline void box_empty( double bmin[3], double bmax[3] )
+  {
+    for( int i = 0; i < 3; i++ )
+    {
+      bmin[i] = CUBIT_DBL_MAX;
+      bmax[i] = -CUBIT_DBL_MAX;
+    }
+  }
+
+  inline void box_add( double bmin[3], double bmax[3], const double* box )
+  {
+    for( int i = 0; i < 3; i++ )
+    {
+      if( box[i] < bmin[i] ) bmin[i] = box[i];
+      if( box[i+3] > bmax[i] ) bmax[i] = box[i+3];
+    }
+  }
+
+  struct CentroidLess
+  {
+    CentroidLess( const std::vector<double>& c, int a ) : centroid(c), axis(a) {}
+    bool operator()( int a, int b ) const
+      { return centroid[3*a+axis] < centroid[3*b+axis]; }
+    const std::vector<double>& centroid;
+    int axis;
+  };
+
+  struct HitLess
+  {
+    bool operator()( const TriangleBVH::RayHit& a, const TriangleBVH::RayHit& b ) const
+      { return a.distance < b.distance; }
+  };
+}
+
+TriangleBVH::TriangleBVH()
+{
+}
+
+TriangleBVH::~TriangleBVH()
+{
+}
+
+void TriangleBVH::clear()
+{
+  nodes.clear();
+  triIndex.clear();
+  triSlot.clear();
+  triCoords.clear();
+}
+
+void TriangleBVH::build( const double* coords, int num_points,
+                         const int* connectivity, int num_triangles )
+{
+  clear();
+  if( num_triangles <= 0 || num_points <= 0 )
+    return;
+
+  std::vector<double> tri_box( 6*num_triangles );
+  std::vector<double> centroid( 3*num_triangles );
+  for( int i = 0; i < num_triangles; i++ )
+  {
+    double* box = &tri_box[6*i];
+    box_empty( box, box+3 );
+    for( int j = 0; j < 3; j++ )
+    {
+      const double* pt = coords + 3*connectivity[3*i+j];
+      double pbox[6] = { pt[0], pt[1], pt[2], pt[0], pt[1], pt[2] };
+      box_add( box, box+3, pbox );
+    }
+    for( int k = 0; k < 3; k++ )
+      centroid[3*i+k] = 0.5*(box[k] + box[k+3]);
+  }
+
+  std::vector<int> order( num_triangles );
+  for( int i = 0; i < num_triangles; i++ )
+    order[i] = i;
+
+  nodes.reserve( 2*num_triangles/BVH_LEAF_SIZE + 1 );
+  build_node( order, 0, num_triangles, tri_box, centroid, 0 );
+
+  triIndex = order;
+  triSlot.resize( num_triangles );
+  triCoords.resize( 9*num_triangles );
+  for( int s = 0; s < num_triangles; s++ )
+  {
+    int tri = order[s];
+    triSlot[tri] = s;
+    for( int j = 0; j < 3; j++ )
+    {
+      const double* pt = coords + 3*connectivity[3*tri+j];
+      triCoords[9*s+3*j]   = pt[0];
+      triCoords[9*s+3*j+1] = pt[1];
+      triCoords[9*s+3*j+2] = pt[2];
+    }
+  }
+}
+
+int TriangleBVH::build_node( std::vector<int>& order, int begin, int end,
+                             const std::vector<double>& tri_box,
+                             const std::vector<double>& centroid, int depth )
+{
+  int index = (int)nodes.size();
+  nodes.push_back( Node() );
+
+  double bmin[3], bmax[3], cmin[3], cmax[3];
+  box_empty( bmin, bmax );
+  box_empty( cmin, cmax );
+  for( int i = begin; i < end; i++ )
+  {
+    box_add( bmin, bmax, &tri_box[6*order[i]] );
+    const double* c = &centroid[3*order[i]];
+    double cbox[6] = { c[0], c[1], c[2], c[0], c[1], c[2] };
+    box_add( cmin, cmax, cbox );
+  }
+  for( int k = 0; k < 3; k++ )
+  {
+    nodes[index].bmin[k] = bmin[k];
+    nodes[index].bmax[k] = bmax[k];
+  }
+
+  int count = end - begin;
+  int axis = 0;
+  for( int k = 1; k < 3; k++ )
+    if( cmax[k]-cmin[k] > cmax[axis]-cmin[axis] )
+      axis = k;
+  double extent = cmax[axis] - cmin[axis];
+
+  if( count <= BVH_LEAF_SIZE || extent <= 0.0 )
+  {
+    nodes[index].start = begin;
+    nodes[index].count = count;
+    return index;
+  }
+
+  int mid = -1;
+  if( depth < BVH_MAX_DEPTH )
+  {
+      // binned SAH along the widest centroid axis
+    int bin_count[BVH_NUM_BINS];
+    double bin_box[BVH_NUM_BINS][6];
+    for( int b = 0; b < BVH_NUM_BINS; b++ )
+    {
+      bin_count[b] = 0;
+      box_empty( bin_box[b], bin_box[b]+3 );
+    }
+    double scale = BVH_NUM_BINS / extent;
+    for( int i = begin; i < end; i++ )
+    {
+      int b = (int)((centroid[3*order[i]+axis] - cmin[axis]) * scale);
+      if( b >= BVH_NUM_BINS ) b = BVH_NUM_BINS-1;
+      bin_count[b]++;
+      box_add( bin_box[b], bin_box[b]+3, &tri_box[6*order[i]] );
+    }
+
+    double right_area[BVH_NUM_BINS];
+    int right_count[BVH_NUM_BINS];
+    double acc[6];
+    box_empty( acc, acc+3 );
+    int n = 0;
+    for( int b = BVH_NUM_BINS-1; b > 0; b-- )
+    {
+      box_add( acc, acc+3, bin_box[b] );
+      n += bin_count[b];
+      right_area[b] = box_area( acc, acc+3 );
+      right_count[b] = n;
+    }
+
+    double best_cost = CUBIT_DBL_MAX;
+    int best_bin = -1;
+    box_empty( acc, acc+3 );
+    n = 0;
+    for( int b = 0; b < BVH_NUM_BINS-1; b++ )
+    {
+      box_add( acc, acc+3, bin_box[b] );
+      n += bin_count[b];
+      if( n == 0 || right_count[b+1] == 0 )
+        continue;
+      double cost = n*box_area( acc, acc+3 ) + right_count[b+1]*right_area[b+1];
+      if( cost < best_cost )
+      {
+        best_cost = cost;
+        best_bin = b;
+      }
+    }
+
+    if( best_bin >= 0 )
+    {
+      int* first = &order[0] + begin;
+      int* last = &order[0] + end;
+      int* part = first;
+      for( int* it = first; it != last; ++it )
+      {
+        int b = (int)((centroid[3*(*it)+axis] - cmin[axis]) * scale);
+        if( b >= BVH_NUM_BINS ) b = BVH_NUM_BINS-1;
+        if( b <= best_bin )
+          std::swap( *it, *part++ );
+      }
+      mid = begin + (int)(part - first);
+    }
+  }
+
+  if( mid <= begin || mid >= end )
+  {
+      // degenerate SAH split (or too deep): split at the median
+    mid = (begin + end) / 2;
+    std::nth_element( order.begin()+begin, order.begin()+mid, order.begin()+end,
+                      CentroidLess( centroid, axis ) );
+  }
+
+  build_node( order, begin, mid, tri_box, centroid, depth+1 );
+  int right = build_node( order, mid, end, tri_box, centroid, depth+1 );
+  nodes[index].start = right;
+  nodes[index].count = 0;
+  return index;
+}
+
+CubitBox TriangleBVH::bounding_box() const
+{
+  if( nodes.empty() )
+    return CubitBox();
+  return CubitBox( nodes[0].bmin, nodes[0].bmax );
+}
+
+void TriangleBVH::triangle( int tri, CubitVector& p0, CubitVector& p1,
+                            CubitVector& p2 ) const
+{
+  const double* c = &triCoords[9*triSlot[tri]];
+  p0.set( c[0], c[1], c[2] );
+  p1.set( c[3], c[4], c[5] );
+  p2.set( c[6], c[7], c[8] );
+}
+
+double TriangleBVH::distance( int tri, const CubitVector& point ) const
+{
+  double pt[3] = { point.x(), point.y(), point.z() };
+  double close[3];
+  return sqrt( closest_on_triangle( &triCoords[9*triSlot[tri]], pt, close ) );
+}
+
+bool TriangleBVH::ray_box( const Node& node, const double org[3],
+                           const double inv_dir[3], double tol,
+                           double max_dist, double& t_enter ) const
+{
+  double tmin = -tol, tmax = max_dist;
+  for( int k = 0; k < 3; k++ )
+  {
+    double lo = node.bmin[k] - tol, hi = node.bmax[k] + tol;
+    if( inv_dir[k] == CUBIT_DBL_MAX )
+    {
+        // ray parallel to this slab
+      if( org[k] < lo || org[k] > hi )
+        return false;
+      continue;
+    }
+    double t0 = (lo - org[k]) * inv_dir[k];
+    double t1 = (hi - org[k]) * inv_dir[k];
+    if( t0 > t1 ) std::swap( t0, t1 );
+    if( t0 > tmin ) tmin = t0;
+    if( t1 < tmax ) tmax = t1;
+    if( tmin > tmax )
+      return false;
+  }
+  t_enter = tmin;
+  return true;
+}
+
+int TriangleBVH::fire_ray( const CubitVector& origin,
+                           const CubitVector& direction,
+                           std::vector<RayHit>& hits,
+                           double tolerance,
+                           int max_hits,
+                           double max_distance ) const
+{
+  if( nodes.empty() )
+    return 0;
+
+  double len = direction.length();
+  if( len < CUBIT_RESABS )
+    return 0;
+
+  double org[3] = { origin.x(), origin.y(), origin.z() };
+  double dir[3] = { direction.x()/len, direction.y()/len, direction.z()/len };
+  double inv_dir[3];
+  for( int k = 0; k < 3; k++ )
+    inv_dir[k] = fabs(dir[k]) < CUBIT_RESABS ? CUBIT_DBL_MAX : 1.0/dir[k];
+
+  size_t first_hit = hits.size();
+  double limit = max_distance;
+
+  int stack[BVH_STACK_SIZE];
+  double stack_t[BVH_STACK_SIZE];
+  int top = 0;
+  double t_enter;
+  if( !ray_box( nodes[0], org, inv_dir, tolerance, limit, t_enter ) )
+    return 0;
+  stack[top] = 0;
+  stack_t[top++] = t_enter;
+
+  while( top )
+  {
+    --top;
+    if( stack_t[top] > limit + tolerance )
+      continue;
+    const Node& node = nodes[stack[top]];
+
+    if( node.count )
+    {
+      for( int s = node.start; s < node.start + node.count; s++ )
+      {
+        const double* c = &triCoords[9*s];
+        double e1[3] = { c[3]-c[0], c[4]-c[1], c[5]-c[2] };
+        double e2[3] = { c[6]-c[0], c[7]-c[1], c[8]-c[2] };
+        double p[3] = { dir[1]*e2[2] - dir[2]*e2[1],
+                        dir[2]*e2[0] - dir[0]*e2[2],
+                        dir[0]*e2[1] - dir[1]*e2[0] };
+        double det = e1[0]*p[0] + e1[1]*p[1] + e1[2]*p[2];
+
+        double n[3] = { e1[1]*e2[2] - e1[2]*e2[1],
+                        e1[2]*e2[0] - e1[0]*e2[2],
+                        e1[0]*e2[1] - e1[1]*e2[0] };
+        double area2 = sqrt( n[0]*n[0] + n[1]*n[1] + n[2]*n[2] );
+        if( area2 < CUBIT_RESABS || fabs(det) < CUBIT_RESABS*area2 )
+          continue;   // degenerate, or ray parallel to the triangle
+
+        double inv_det = 1.0/det;
+        double tv[3] = { org[0]-c[0], org[1]-c[1], org[2]-c[2] };
+        double u = (tv[0]*p[0] + tv[1]*p[1] + tv[2]*p[2]) * inv_det;
+
+          // barycentric slack equivalent to 'tolerance' distance
+          // from the longest edge
+        double eps = 0.0;
+        if( tolerance > 0.0 )
+        {
+          double e3[3] = { c[6]-c[3], c[7]-c[4], c[8]-c[5] };
+          double l = e1[0]*e1[0] + e1[1]*e1[1] + e1[2]*e1[2];
+          double l2 = e2[0]*e2[0] + e2[1]*e2[1] + e2[2]*e2[2];
+          double l3 = e3[0]*e3[0] + e3[1]*e3[1] + e3[2]*e3[2];
+          if( l2 > l ) l = l2;
+          if( l3 > l ) l = l3;
+          eps = tolerance * sqrt(l) / area2;
+        }
+        if( u < -eps || u > 1.0 + eps )
+          continue;
+
+        double q[3] = { tv[1]*e1[2] - tv[2]*e1[1],
+                        tv[2]*e1[0] - tv[0]*e1[2],
+                        tv[0]*e1[1] - tv[1]*e1[0] };
+        double v = (dir[0]*q[0] + dir[1]*q[1] + dir[2]*q[2]) * inv_det;
+        if( v < -eps || u + v > 1.0 + eps )
+          continue;
+
+        double t = (e2[0]*q[0] + e2[1]*q[1] + e2[2]*q[2]) * inv_det;
+        if( t < -tolerance || t > limit )
+          continue;
+
+        RayHit hit;
+        hit.triangle = triIndex[s];
+        hit.distance = t;
+        hit.u = u;
+        hit.v = v;
+
+        if( max_hits > 0 )
+        {
+            // keep the nearest max_hits, sorted
+          std::vector<RayHit>::iterator pos =
+            std::upper_bound( hits.begin()+first_hit, hits.end(), hit, HitLess() );
+          hits.insert( pos, hit );
+          if( (int)(hits.size() - first_hit) > max_hits )
+            hits.pop_back();
+          if( (int)(hits.size() - first_hit) == max_hits )
+            limit = hits.back().distance;
+        }
+        else
+          hits.push_back( hit );
+      }
+      continue;
+    }
+
+      // push the far child first so the near one is visited first
+    int left = stack[top] + 1;
+    int right = node.start;
+    double tl, tr;
+    bool hit_l = ray_box( nodes[left], org, inv_dir, tolerance, limit, tl );
+    bool hit_r = ray_box( nodes[right], org, inv_dir, tolerance, limit, tr );
+    if( hit_l && hit_r )
+    {
+      if( tl < tr )
+      {
+        stack[top] = right; stack_t[top++] = tr;
+        stack[top] = left;  stack_t[top++] = tl;
+      }
+      else
+      {
+        stack[top] = left;  stack_t[top++] = tl;
+        stack[top] = right; stack_t[top++] = tr;
+      }
+    }
+    else if( hit_l )
+    {
+      stack[top] = left; stack_t[top++] = tl;
+    }
+    else if( hit_r )
+    {
+      stack[top] = right; stack_t[top++] = tr;
+    }
+  }
+
+  if( max_hits <= 0 )
+    std::sort( hits.begin()+first_hit, hits.end(), HitLess() );
+
+  return (int)(hits.size() - first_hit);
+}
+
+double TriangleBVH::box_distance_sq( const Node& node, const double pt[3] )
+{
+  double dist_sq = 0.0;
+  for( int k = 0; k < 3; k++ )
+  {
+    double d = 0.0;
+    if( pt[k] < node.bmin[k] )
+      d = node.bmin[k] - pt[k];
+    else if( pt[k] > node.bmax[k] )
+      d = pt[k] - node.bmax[k];
+    dist_sq += d*d;
+  }
+  return dist_sq;
+}
+
+//-----------------------------------------------------------------
+// Closest point on a triangle by Voronoi region of the point, see
+// Ericson, "Real-Time Collision Detection", 2005, section 5.1.5.
+//-----------------------------------------------------------------
+double TriangleBVH::closest_on_triangle( const double* tri, const double pt[3],
+                                         double closest[3] )
+{
+  const double* a = tri;
+  const double* b = tri + 3;
+  const double* c = tri + 6;
+  double ab[3], ac[3], ap[3];
+  int k;
+  for( k = 0; k < 3; k++ )
+  {
+    ab[k] = b[k] - a[k];
+    ac[k] = c[k] - a[k];
+    ap[k] = pt[k] - a[k];
+  }
+
+    // the edge region tests below cancel badly for a thin triangle, so
+    // such a triangle is its three edges
+  double n[3] = { ab[1]*ac[2] - ab[2]*ac[1],
+                  ab[2]*ac[0] - ab[0]*ac[2],
+                  ab[0]*ac[1] - ab[1]*ac[0] };
+  double n_sq = n[0]*n[0] + n[1]*n[1] + n[2]*n[2];
+  double ab_sq = ab[0]*ab[0] + ab[1]*ab[1] + ab[2]*ab[2];
+  double ac_sq = ac[0]*ac[0] + ac[1]*ac[1] + ac[2]*ac[2];
+  if( n_sq <= BVH_FLAT_SIN_SQ * ab_sq * ac_sq )
+  {
+    double dist_sq = closest_on_segment( a, b, pt, closest );
+    double edge_pt[3];
+    for( int e = 0; e < 2; e++ )
+    {
+      double edge_sq = e ? closest_on_segment( c, a, pt, edge_pt )
+                         : closest_on_segment( b, c, pt, edge_pt );
+      if( edge_sq < dist_sq )
+      {
+        dist_sq = edge_sq;
+        closest[0] = edge_pt[0]; closest[1] = edge_pt[1]; closest[2] = edge_pt[2];
+      }
+    }
+    return dist_sq;
+  }
+
+  double d1 = ab[0]*ap[0] + ab[1]*ap[1] + ab[2]*ap[2];
+  double d2 = ac[0]*ap[0] + ac[1]*ap[1] + ac[2]*ap[2];
+  double s, t;   // closest = a + s*ab + t*ac
+  if( d1 <= 0.0 && d2 <= 0.0 )
+  {
+    s = 0.0; t = 0.0;   // vertex a
+  }
+  else
+  {
+    double bp[3] = { pt[0]-b[0], pt[1]-b[1], pt[2]-b[2] };
+    double d3 = ab[0]*bp[0] + ab[1]*bp[1] + ab[2]*bp[2];
+    double d4 = ac[0]*bp[0] + ac[1]*bp[1] + ac[2]*bp[2];
+    double cp[3] = { pt[0]-c[0], pt[1]-c[1], pt[2]-c[2] };
+    double d5 = ab[0]*cp[0] + ab[1]*cp[1] + ab[2]*cp[2];
+    double d6 = ac[0]*cp[0] + ac[1]*cp[1] + ac[2]*cp[2];
+    double vc = d1*d4 - d3*d2;
+    double vb = d5*d2 - d1*d6;
+    double va = d3*d6 - d5*d4;
+
+    if( d3 >= 0.0 && d4 <= d3 )
+    {
+      s = 1.0; t = 0.0;   // vertex b
+    }
+    else if( d6 >= 0.0 && d5 <= d6 )
+    {
+      s = 0.0; t = 1.0;   // vertex c
+    }
+    else if( vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0 )
+    {
+      s = d1 / (d1 - d3); t = 0.0;   // edge ab
+    }
+    else if( vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0 )
+    {
+      s = 0.0; t = d2 / (d2 - d6);   // edge ac
+    }
+    else if( va <= 0.0 && (d4 - d3) >= 0.0 && (d5 - d6) >= 0.0 )
+    {
+      t = (d4 - d3) / ((d4 - d3) + (d5 - d6));   // edge bc
+      s = 1.0 - t;
+    }
+    else
+    {
+        // interior.  va + vb + vc is n_sq, but summed from terms that
+        // cancel, so project along the cross product instead.
+      double h = (ap[0]*n[0] + ap[1]*n[1] + ap[2]*n[2]) / n_sq;
+      for( k = 0; k < 3; k++ )
+        closest[k] = pt[k] - h*n[k];
+      return h*h*n_sq;
+    }
+  }
+
+  double dist_sq = 0.0;
+  for( k = 0; k < 3; k++ )
+  {
+    closest[k] = a[k] + s*ab[k] + t*ac[k];
+    double d = pt[k] - closest[k];
+    dist_sq += d*d;
+  }
+  return dist_sq;
+}
+
+int TriangleBVH::closest_triangle( const CubitVector& point,
+                                   CubitVector& closest_point,
+                                   double max_distance ) const
+{
+  if( nodes.empty() )
+    return -1;
+
+  double pt[3] = { point.x(), point.y(), point.z() };
+  double best_sq = max_distance < CUBIT_DBL_MAX ?
+                   max_distance*max_distance : CUBIT_DBL_MAX;
+  int best_slot = -1;
+  double best_pt[3] = { 0.0, 0.0, 0.0 };
+
+  int stack[BVH_STACK_SIZE];
+  double stack_d[BVH_STACK_SIZE];
+  int top = 0;
+  stack[top] = 0;
+  stack_d[top++] = box_distance_sq( nodes[0], pt );
+
+  while( top )
+  {
+    --top;
+    if( stack_d[top] > best_sq )
+      continue;
+    const Node& node = nodes[stack[top]];
+
+    if( node.count )
+    {
+      for( int s = node.start; s < node.start + node.count; s++ )
+      {
+        double close[3];
+        double dist_sq = closest_on_triangle( &triCoords[9*s], pt, close );
+        if( dist_sq < best_sq || (best_slot < 0 && dist_sq == best_sq) )
+        {
+          best_sq = dist_sq;
+          best_slot = s;
+          best_pt[0] = close[0];
+          best_pt[1] = close[1];
+          best_pt[2] = close[2];
+        }
+      }
+      continue;
+    }
+
+      // push the far child first so the near one is visited first
+    int left = stack[top] + 1;
+    int right = node.start;
+    double dl = box_distance_sq( nodes[left], pt );
+    double dr = box_distance_sq( nodes[right], pt );
+    if( dl < dr )
+    {
+      if( dr <= best_sq ) { stack[top] = right; stack_d[top++] = dr; }
+      if( dl <= best_sq ) { stack[top] = left;  stack_d[top++] = dl; }
+    }
+    else
+    {
+      if( dl <= best_sq ) { stack[top] = left;  stack_d[top++] = dl; }
+      if( dr <= best_sq ) { stack[top] = right; stack_d[top++] = dr; }
+    }
+  }
+
+  if( best_slot < 0 )
+    return -1;
+  closest_point.set( best_pt[0], best_pt[1], best_pt[2] );
+  return triIndex[best_slot];
+}
+
+int TriangleBVH::triangles_within( const CubitVector& point, double distance,
+                                   std::vector<int>& triangles ) const
+{
+  if( nodes.empty() || distance < 0.0 )
+    return 0;
+
+  double pt[3] = { point.x(), point.y(), point.z() };
+  double dist_sq = distance*distance;
+  size_t first = triangles.size();
+
+  int stack[BVH_STACK_SIZE];
+  int top = 0;
+  if( box_distance_sq( nodes[0], pt ) <= dist_sq )
+    stack[top++] = 0;
+
+  while( top )
+  {
+    int index = stack[--top];
+    const Node& node = nodes[index];
+
+    if( node.count )
+    {
+      for( int s = node.start; s < node.start + node.count; s++ )
+      {
+        double close[3];
+        if( closest_on_triangle( &triCoords[9*s], pt, close ) <= dist_sq )
+          triangles.push_back( triIndex[s] );
+      }
+      continue;
+    }
+
+    if( box_distance_sq( nodes[index+1], pt ) <= dist_sq )
+      stack[top++] = index + 1;
+    if( box_distance_sq( nodes[node.start], pt ) <= dist_sq )
+      stack[top++] = node.start;
+  }
+
+  return (int)(triangles.size() - first);
+}
+
+int TriangleBVH::triangles_in_box( const CubitBox& box,
+                                   std::vector<int>& triangles ) const
+{
+  if( nodes.empty() )
+    return 0;
+
+  double bmin[3] = { box.min_x(), box.min_y(), box.min_z() };
+  double bmax[3] = { box.max_x(), box.max_y(), box.max_z() };
+  size_t first = triangles.size();
+
+  int stack[BVH_STACK_SIZE];
+  int top = 0;
+  stack[top++] = 0;
+
+  while( top )
+  {
+    int index = stack[--top];
+    const Node& node = nodes[index];
+    int k;
+    for( k = 0; k < 3; k++ )
+      if( node.bmin[k] > bmax[k] || node.bmax[k] < bmin[k] )
+        break;
+    if( k < 3 )
+      continue;
+
+    if( !node.count )
+    {
+      stack[top++] = index + 1;
+      stack[top++] = node.start;
+      continue;
+    }
+
+    for( int s = node.start; s < node.start + node.count; s++ )
+    {
+      const double* tri = &triCoords[9*s];
+      for( k = 0; k < 3; k++ )
+      {
+        double lo = tri[k], hi = tri[k];
+        if( tri[k+3] < lo ) lo = tri[k+3]; else if( tri[k+3] > hi ) hi = tri[k+3];
+        if( tri[k+6] < lo ) lo = tri[k+6]; else if( tri[k+6] > hi ) hi = tri[k+6];
+        if( lo > bmax[k] || hi < bmin[k] )
+          break;
+      }
+      if( k == 3 )
+        triangles.push_back( triIndex[s] );
+    }
+  }
+
+  return (int)(triangles.size() - first);
+}
@@ -0,0 +1,142 @@
+//-----------------------------------------------------------------
+//- Class:   TriangleBVH
+//-
+//- Description:
+//-   Static bounding volume hierarchy over a triangle soup.  The
+//-   tree is built once (binned surface-area heuristic) and stored
+//-   flattened in depth-first order: the left child of an interior
+//-   node immediately follows it and the right child index is
+//-   stored in the node.  Triangle coordinates are copied into
+//-   leaf order so a traversal touches contiguous memory, and all
+//-   queries use an explicit stack so they are reentrant.
+//-
+//-   Triangles are identified by their index in the connectivity
+//-   array passed to build(), so callers can keep a parallel array
+//-   mapping triangles back to the entities they came from.
+//-----------------------------------------------------------------
+
+#ifndef TRIANGLE_BVH_HPP
+#define TRIANGLE_BVH_HPP
+
+#include "CubitDefines.h"
+#include "CubitVector.hpp"
+#include "CubitBox.hpp"
+#include "CubitUtilConfigure.h"
+#include <vector>
+
+class CUBIT_UTIL_EXPORT TriangleBVH
+{
+public:
+
+  struct RayHit
+  {
+    int triangle;      // index of the triangle as given to build()
+    double distance;   // distance from the ray origin
+    double u, v;       // barycentric coordinates of the hit
+  };
+
+  TriangleBVH();
+  ~TriangleBVH();
+
+  void build( const double* coords, int num_points,
+              const int* connectivity, int num_triangles );
+    //- Build the tree.  coords holds x,y,z for each point and
+    //- connectivity holds three point indices per triangle.  Any
+    //- previous contents are discarded.
+
+  void clear();
+    //- Release the tree.
+
+  bool empty() const { return nodes.empty(); }
+  int num_triangles() const { return (int)triIndex.size(); }
+  int num_nodes() const { return (int)nodes.size(); }
+
+  CubitBox bounding_box() const;
+    //- Box around every triangle in the tree.
+
+  void triangle( int tri, CubitVector& p0, CubitVector& p1, CubitVector& p2 ) const;
+    //- Coordinates of a triangle, by its build() index.
+
+  double distance( int tri, const CubitVector& point ) const;
+    //- Distance from point to a triangle, by its build() index.
+
+  int left_child( int node ) const { return node + 1; }
+  int right_child( int node ) const { return nodes[node].start; }
+  int leaf_triangles( int node, const int*& triangles ) const
+    {
+      triangles = nodes[node].count ? &triIndex[nodes[node].start] : NULL;
+      return nodes[node].count;
+    }
+    //- Walk the tree, for callers that keep data per node in an array
+    //- of num_nodes().  The root is node 0 and a node's children
+    //- follow it, so visiting nodes from last to first visits children
+    //- before their parents.  leaf_triangles gives the build() indices
+    //- of a leaf's triangles, or returns 0 for an interior node.
+
+  int fire_ray( const CubitVector& origin,
+                const CubitVector& direction,
+                std::vector<RayHit>& hits,
+                double tolerance = 0.0,
+                int max_hits = 0,
+                double max_distance = CUBIT_DBL_MAX ) const;
+    //- Intersect a ray with the triangles.  Hits are appended to
+    //- hits sorted by distance and the number appended is returned.
+    //- direction need not be unit length; distances are measured
+    //- along the normalized direction.  A positive tolerance makes
+    //- the ray "fat": triangles passing within roughly tolerance
+    //- of the ray are reported too, which callers use to gather
+    //- candidates for exact refinement.  If max_hits > 0 only the
+    //- nearest max_hits hits are kept and farther subtrees are
+    //- pruned.
+
+  int closest_triangle( const CubitVector& point,
+                        CubitVector& closest_point,
+                        double max_distance = CUBIT_DBL_MAX ) const;
+    //- The triangle nearest to point, and the closest point on it, or
+    //- -1 if the tree is empty or no triangle is within max_distance.
+    //- Children are visited nearest box first and subtrees whose box
+    //- is farther than the best triangle so far are pruned.
+
+  int triangles_within( const CubitVector& point, double distance,
+                        std::vector<int>& triangles ) const;
+    //- Append the triangles whose closest point is within distance of
+    //- point, and return the number appended.
+
+  int triangles_in_box( const CubitBox& box, std::vector<int>& triangles ) const;
+    //- Append the triangles whose bounding boxes overlap box, and
+    //- return the number appended.
+
+private:
+
+  struct Node
+  {
+    double bmin[3];
+    double bmax[3];
+    int start;   // leaf: first slot in triIndex; interior: right child
+    int count;   // leaf: number of triangles; interior: 0
+  };
+
+  int build_node( std::vector<int>& order, int begin, int end,
+                  const std::vector<double>& tri_box,
+                  const std::vector<double>& centroid, int depth );
+
+  bool ray_box( const Node& node, const double org[3], const double inv_dir[3],
+                double tol, double max_dist, double& t_enter ) const;
+
+  static double box_distance_sq( const Node& node, const double pt[3] );
+    //- Squared distance from pt to the node's box (0 inside).
+
+  static double closest_on_triangle( const double* tri, const double pt[3],
+                                     double closest[3] );
+    //- Closest point to pt on a triangle (9 doubles); returns the
+    //- squared distance.  A triangle whose angles are all within about
+    //- 1e-6 of 0 or 180 degrees is treated as its three edges.
+
+  std::vector<Node> nodes;
+  std::vector<int> triIndex;      // leaf slot -> build() triangle index
+  std::vector<int> triSlot;       // build() triangle index -> leaf slot
+  std::vector<double> triCoords;  // 9 doubles per triangle in leaf order
+};
+
+#endif
+